@@ -0,0 +1,465 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "Simd.h"
+#include "ThreadPool.h"
+
+/*
+* CPU encoder for the GPU block compressed formats, 4x4 texel blocks:
+*   BC1  8 bytes, RGB, 2 endpoints in 565 + 2 bit indices      (GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+*   BC3 16 bytes, the BC1 color block + an 8 level alpha block (GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+*   BC7 16 bytes, RGBA, mode 6 only: one RGBA 7777+pbit endpoint pair and 4 bit indices (GL_COMPRESSED_RGBA_BPTC_UNORM)
+*
+*     ThreadPool pool;
+*     std::vector<uint8_t> blocks = BlockEncoder::compress(pixels, width, height, components, BLOCK_BC1, &pool);
+*     glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, width, height, 0, (GLsizei)blocks.size(), blocks.data());
+*
+* Every block: endpoints from the principal axis of its texels, nearest palette entry per texel, then a least squares
+* refit of the endpoints to those indices, kept when it lowers the error. The nearest entry search is the hot loop
+* and runs 4 texels at a time with SSE2. Rows of blocks are spread over the pool.
+* 1 and 2 channel images keep GL_RED / GL_RG semantics: the missing channels encode as 0 and alpha as 255.
+*/
+
+enum BlockFormat {
+    BLOCK_BC1,
+    BLOCK_BC3,
+    BLOCK_BC7
+};
+
+class BlockEncoder {
+
+public:
+    static int blockBytes(BlockFormat format) {
+        return format == BLOCK_BC1 ? 8 : 16;
+    }
+
+    static size_t compressedSize(int width, int height, BlockFormat format) {
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(format);
+    }
+
+    // True when every texel has alpha 255 (always for fewer than 4 components)
+    static bool isOpaque(const unsigned char* pixels, int width, int height, int components) {
+        if (components != 4) {
+            return true;
+        }
+        size_t count = (size_t)width * height;
+        for (size_t i = 0; i < count; i++) {
+            if (pixels[i * 4 + 3] != 255) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Encodes a whole image, blocks in row major order. Edge blocks repeat the last row and column
+    static std::vector<uint8_t> compress(const unsigned char* pixels, int width, int height, int components, BlockFormat format,
+        ThreadPool* pool = NULL) {
+        int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        int bytes = blockBytes(format);
+        std::vector<uint8_t> blocks((size_t)blocksX * blocksY * bytes);
+        auto encodeRow = [&](int by) {
+            uint8_t texels[64];
+            for (int bx = 0; bx < blocksX; bx++) {
+                fetchBlock(pixels, width, height, components, bx, by, texels);
+                encodeBlock(texels, format, &blocks[((size_t)by * blocksX + bx) * bytes]);
+            }
+        };
+        if (pool) {
+            pool->parallelFor(blocksY, encodeRow);
+        }
+        else {
+            for (int by = 0; by < blocksY; by++) {
+                encodeRow(by);
+            }
+        }
+        return blocks;
+    }
+
+    // texels: 16 RGBA texels, row major
+    static void encodeBlock(const uint8_t texels[64], BlockFormat format, uint8_t* out) {
+        switch (format) {
+        case BLOCK_BC1:
+            encodeBC1(texels, out);
+            break;
+        case BLOCK_BC3:
+            encodeAlpha(texels, out);
+            encodeBC1(texels, out + 8);
+            break;
+        case BLOCK_BC7:
+            encodeBC7(texels, out);
+            break;
+        }
+    }
+
+private:
+    typedef float BlockChannels[4][16]; // structure of arrays, channel by texel
+
+    static void fetchBlock(const unsigned char* pixels, int width, int height, int components, int bx, int by, uint8_t texels[64]) {
+        for (int y = 0; y < 4; y++) {
+            const unsigned char* row = pixels + (size_t)std::min(by * 4 + y, height - 1) * width * components;
+            for (int x = 0; x < 4; x++) {
+                const unsigned char* texel = row + (size_t)std::min(bx * 4 + x, width - 1) * components;
+                uint8_t* out = texels + (y * 4 + x) * 4;
+                out[0] = texel[0];
+                out[1] = components > 1 ? texel[1] : 0;
+                out[2] = components > 2 ? texel[2] : 0;
+                out[3] = components > 3 ? texel[3] : 255;
+            }
+        }
+    }
+
+    static void toChannels(const uint8_t texels[64], int firstChannel, int channels, BlockChannels& block) {
+        for (int c = 0; c < channels; c++) {
+            for (int i = 0; i < 16; i++) {
+                block[c][i] = texels[i * 4 + firstChannel + c];
+            }
+        }
+    }
+
+    // Nearest palette entry for every texel by squared distance, returns the summed error
+    static float selectIndices(const BlockChannels& block, int channels, const float palette[][4], int paletteSize, uint8_t indices[16]) {
+        float total = 0.0f;
+#ifdef SIMD_SSE2
+        for (int group = 0; group < 16; group += 4) {
+            __m128 best = _mm_set1_ps(FLT_MAX);
+            __m128i bestIndex = _mm_setzero_si128();
+            for (int entry = 0; entry < paletteSize; entry++) {
+                __m128 distance = _mm_setzero_ps();
+                for (int c = 0; c < channels; c++) {
+                    __m128 difference = _mm_sub_ps(_mm_loadu_ps(&block[c][group]), _mm_set1_ps(palette[entry][c]));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+                }
+                __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+                best = _mm_min_ps(distance, best);
+                bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(entry)), _mm_andnot_si128(closer, bestIndex));
+            }
+            alignas(16) float errors[4];
+            alignas(16) int32_t chosen[4];
+            _mm_store_ps(errors, best);
+            _mm_store_si128((__m128i*)chosen, bestIndex);
+            for (int i = 0; i < 4; i++) {
+                indices[group + i] = (uint8_t)chosen[i];
+                total += errors[i];
+            }
+        }
+#else
+        for (int i = 0; i < 16; i++) {
+            float best = FLT_MAX;
+            for (int entry = 0; entry < paletteSize; entry++) {
+                float distance = 0.0f;
+                for (int c = 0; c < channels; c++) {
+                    float difference = block[c][i] - palette[entry][c];
+                    distance += difference * difference;
+                }
+                if (distance < best) {
+                    best = distance;
+                    indices[i] = (uint8_t)entry;
+                }
+            }
+            total += best;
+        }
+#endif
+        return total;
+    }
+
+    // Ends of the texels' spread along their principal axis (power iteration on the covariance)
+    static void principalEndpoints(const BlockChannels& block, int channels, float start[4], float end[4]) {
+        float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f }, low[4], high[4];
+        for (int c = 0; c < channels; c++) {
+            low[c] = high[c] = block[c][0];
+            for (int i = 0; i < 16; i++) {
+                mean[c] += block[c][i] / 16.0f;
+                low[c] = std::min(low[c], block[c][i]);
+                high[c] = std::max(high[c], block[c][i]);
+            }
+        }
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; i++) {
+            for (int a = 0; a < channels; a++) {
+                for (int b = 0; b < channels; b++) {
+                    covariance[a][b] += (block[a][i] - mean[a]) * (block[b][i] - mean[b]);
+                }
+            }
+        }
+        float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int c = 0; c < channels; c++) {
+            axis[c] = high[c] - low[c];
+        }
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            float length = 0.0f;
+            for (int a = 0; a < channels; a++) {
+                for (int b = 0; b < channels; b++) {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length = std::max(length, std::fabs(next[a]));
+            }
+            if (length == 0.0f) {
+                break;
+            }
+            for (int c = 0; c < channels; c++) {
+                axis[c] = next[c] / length;
+            }
+        }
+        float lengthSquared = 0.0f;
+        for (int c = 0; c < channels; c++) {
+            lengthSquared += axis[c] * axis[c];
+        }
+        float lowest = 0.0f, highest = 0.0f;
+        if (lengthSquared > 0.0f) {
+            lowest = FLT_MAX;
+            highest = -FLT_MAX;
+            for (int i = 0; i < 16; i++) {
+                float projection = 0.0f;
+                for (int c = 0; c < channels; c++) {
+                    projection += (block[c][i] - mean[c]) * axis[c];
+                }
+                lowest = std::min(lowest, projection);
+                highest = std::max(highest, projection);
+            }
+            lowest /= lengthSquared;
+            highest /= lengthSquared;
+        }
+        for (int c = 0; c < channels; c++) {
+            start[c] = std::min(std::max(mean[c] + axis[c] * highest, 0.0f), 255.0f);
+            end[c] = std::min(std::max(mean[c] + axis[c] * lowest, 0.0f), 255.0f);
+        }
+    }
+
+    // Endpoints minimizing the squared error for fixed weights, weights[i] = how far texel i sits from start to end.
+    // False when the weights don't pin the line down (all texels on one entry)
+    static bool leastSquaresEndpoints(const BlockChannels& block, int channels, const float weights[16], float start[4], float end[4]) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f }, bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; i++) {
+            float a = 1.0f - weights[i], b = weights[i];
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for (int c = 0; c < channels; c++) {
+                ax[c] += a * block[c][i];
+                bx[c] += b * block[c][i];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f) {
+            return false;
+        }
+        for (int c = 0; c < channels; c++) {
+            start[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / determinant, 0.0f), 255.0f);
+            end[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / determinant, 0.0f), 255.0f);
+        }
+        return true;
+    }
+
+    // --- BC1 ---
+
+    static uint16_t to565(const float color[4]) {
+        int r = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+        int g = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+        int b = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    static void from565(uint16_t packed, float color[4]) {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (float)((r << 3) | (r >> 2));
+        color[1] = (float)((g << 2) | (g >> 4));
+        color[2] = (float)((b << 3) | (b >> 2));
+        color[3] = 255.0f;
+    }
+
+    // Quantizes the endpoints in 4 color order (color0 > color1), picks indices, returns the error
+    static float fitBC1(const BlockChannels& block, const float start[4], const float end[4], uint16_t& color0, uint16_t& color1,
+        uint8_t indices[16]) {
+        color0 = to565(start);
+        color1 = to565(end);
+        if (color0 < color1) {
+            std::swap(color0, color1);
+        }
+        float palette[4][4];
+        from565(color0, palette[0]);
+        from565(color1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+        // equal endpoints decode in 3 color mode where index 3 is black, index 0 is all they need
+        return selectIndices(block, 3, palette, color0 == color1 ? 1 : 4, indices);
+    }
+
+    static void encodeBC1(const uint8_t texels[64], uint8_t out[8]) {
+        static const float weightOfIndex[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        BlockChannels block;
+        toChannels(texels, 0, 3, block);
+
+        float start[4], end[4];
+        principalEndpoints(block, 3, start, end);
+        uint16_t color0, color1;
+        uint8_t indices[16];
+        float error = fitBC1(block, start, end, color0, color1, indices);
+
+        float weights[16];
+        for (int i = 0; i < 16; i++) {
+            weights[i] = weightOfIndex[indices[i]];
+        }
+        uint16_t refined0, refined1;
+        uint8_t refinedIndices[16];
+        if (leastSquaresEndpoints(block, 3, weights, start, end) &&
+            fitBC1(block, start, end, refined0, refined1, refinedIndices) < error) {
+            color0 = refined0;
+            color1 = refined1;
+            memcpy(indices, refinedIndices, 16);
+        }
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; i++) {
+            bits |= (uint32_t)indices[i] << (i * 2);
+        }
+        out[0] = (uint8_t)color0;
+        out[1] = (uint8_t)(color0 >> 8);
+        out[2] = (uint8_t)color1;
+        out[3] = (uint8_t)(color1 >> 8);
+        for (int i = 0; i < 4; i++) {
+            out[4 + i] = (uint8_t)(bits >> (i * 8));
+        }
+    }
+
+    // --- BC3 alpha (BC4 layout) ---
+
+    // alpha0 > alpha1: 8 levels between them. Flat blocks store alpha0 == alpha1, which only ever uses index 0
+    static void encodeAlpha(const uint8_t texels[64], uint8_t out[8]) {
+        BlockChannels block;
+        toChannels(texels, 3, 1, block);
+        float low = block[0][0], high = block[0][0];
+        for (int i = 1; i < 16; i++) {
+            low = std::min(low, block[0][i]);
+            high = std::max(high, block[0][i]);
+        }
+        uint8_t alpha0 = (uint8_t)high, alpha1 = (uint8_t)low;
+        float palette[8][4];
+        palette[0][0] = alpha0;
+        palette[1][0] = alpha1;
+        for (int i = 1; i < 7; i++) {
+            palette[i + 1][0] = (float)(((7 - i) * alpha0 + i * alpha1) / 7);
+        }
+        uint8_t indices[16];
+        selectIndices(block, 1, palette, alpha0 == alpha1 ? 1 : 8, indices);
+
+        uint64_t bits = 0;
+        for (int i = 0; i < 16; i++) {
+            bits |= (uint64_t)indices[i] << (i * 3);
+        }
+        out[0] = alpha0;
+        out[1] = alpha1;
+        for (int i = 0; i < 6; i++) {
+            out[2 + i] = (uint8_t)(bits >> (i * 8));
+        }
+    }
+
+    // --- BC7 mode 6 ---
+
+    static const int* bc7Weights() {
+        static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        return weights;
+    }
+
+    // 7 bits per channel plus a p-bit shared by the endpoint's channels, whichever p-bit fits better
+    static void quantizeBC7Endpoint(const float color[4], uint8_t quantized[4], int& pbit) {
+        float bestError = FLT_MAX;
+        for (int p = 0; p < 2; p++) {
+            uint8_t candidate[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; c++) {
+                int value = (int)((color[c] - p) / 2.0f + 0.5f);
+                candidate[c] = (uint8_t)std::min(std::max(value, 0), 127);
+                float difference = (float)(candidate[c] * 2 + p) - color[c];
+                error += difference * difference;
+            }
+            if (error < bestError) {
+                bestError = error;
+                pbit = p;
+                memcpy(quantized, candidate, 4);
+            }
+        }
+    }
+
+    static float fitBC7(const BlockChannels& block, const float start[4], const float end[4], uint8_t quantized[2][4], int pbits[2],
+        uint8_t indices[16]) {
+        quantizeBC7Endpoint(start, quantized[0], pbits[0]);
+        quantizeBC7Endpoint(end, quantized[1], pbits[1]);
+        int endpoint[2][4];
+        for (int c = 0; c < 4; c++) {
+            endpoint[0][c] = quantized[0][c] * 2 + pbits[0];
+            endpoint[1][c] = quantized[1][c] * 2 + pbits[1];
+        }
+        float palette[16][4];
+        for (int i = 0; i < 16; i++) {
+            for (int c = 0; c < 4; c++) {
+                palette[i][c] = (float)(((64 - bc7Weights()[i]) * endpoint[0][c] + bc7Weights()[i] * endpoint[1][c] + 32) >> 6);
+            }
+        }
+        return selectIndices(block, 4, palette, 16, indices);
+    }
+
+    static void encodeBC7(const uint8_t texels[64], uint8_t out[16]) {
+        BlockChannels block;
+        toChannels(texels, 0, 4, block);
+
+        float start[4], end[4];
+        principalEndpoints(block, 4, start, end);
+        uint8_t quantized[2][4];
+        int pbits[2];
+        uint8_t indices[16];
+        float error = fitBC7(block, start, end, quantized, pbits, indices);
+
+        float weights[16];
+        for (int i = 0; i < 16; i++) {
+            weights[i] = bc7Weights()[indices[i]] / 64.0f;
+        }
+        uint8_t refinedQuantized[2][4];
+        int refinedPbits[2];
+        uint8_t refinedIndices[16];
+        if (leastSquaresEndpoints(block, 4, weights, start, end) &&
+            fitBC7(block, start, end, refinedQuantized, refinedPbits, refinedIndices) < error) {
+            memcpy(quantized, refinedQuantized, sizeof(quantized));
+            memcpy(pbits, refinedPbits, sizeof(pbits));
+            memcpy(indices, refinedIndices, 16);
+        }
+
+        // the first index is stored without its top bit, so it has to be below 8
+        if (indices[0] & 8) {
+            for (int c = 0; c < 4; c++) {
+                std::swap(quantized[0][c], quantized[1][c]);
+            }
+            std::swap(pbits[0], pbits[1]);
+            for (int i = 0; i < 16; i++) {
+                indices[i] = 15 - indices[i];
+            }
+        }
+
+        memset(out, 0, 16);
+        int position = 0;
+        auto write = [&](uint32_t value, int bits) {
+            for (int i = 0; i < bits; i++, position++) {
+                out[position >> 3] |= (uint8_t)(((value >> i) & 1) << (position & 7));
+            }
+        };
+        write(1 << 6, 7); // mode 6
+        for (int c = 0; c < 4; c++) {
+            write(quantized[0][c], 7);
+            write(quantized[1][c], 7);
+        }
+        write(pbits[0], 1);
+        write(pbits[1], 1);
+        write(indices[0], 3);
+        for (int i = 1; i < 16; i++) {
+            write(indices[i], 4);
+        }
+    }
+};
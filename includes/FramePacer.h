@@ -0,0 +1,171 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+/*
+* Holds a render loop to a fixed frame period and measures how steady it was.
+*
+*     FramePacer pacer(1000.0 / 140.0);       // ms per frame, or FramePacer(0.0, FramePacer::Uncapped)
+*     while (...) {
+*         ... render, swap ...
+*         pacer.wait();                       // returns at this frame's deadline
+*     }
+*     pacer.report();
+*
+* Deadlines are a period apart, counted from the first wait rather than from whenever each frame finished, so the
+* time spent rendering comes out of the period instead of being added to it. wait() sleeps until just before the
+* deadline and spins (yielding) for the rest: sleep_for is only as exact as the scheduler, which can be a timer tick
+* late on Windows, so the spin margin follows the worst recent oversleep. A frame that overruns its deadline starts
+* the schedule again from now instead of rushing the next frames to catch up.
+* Uncapped never waits, for benchmarking. FixedSleep is the old sleep_for(period) after every frame, kept so the two
+* can be compared.
+*/
+
+struct FramePacerStats {
+    long long frames;        // intervals measured, between successive wait() returns
+    double meanMs;
+    double varianceMs;       // ms squared
+    double minMs, maxMs;
+    double meanErrorMs;      // how far from its deadline a paced wait() returned
+    double maxErrorMs;
+    long long missed;        // frames already past their deadline when wait() was called
+    double sleepMs, spinMs;  // total time spent waiting each way
+};
+
+class FramePacer {
+
+public:
+    enum Mode { Paced, Uncapped, FixedSleep };
+
+    explicit FramePacer(double periodMs = 1000.0 / 60.0, Mode mode = Paced) {
+        setPeriod(periodMs, mode);
+    }
+
+    // Starts a new schedule and new stats
+    void setPeriod(double periodMs, Mode pacing = Paced) {
+        mode = periodMs > 0.0 ? pacing : Uncapped;
+        period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(std::max(periodMs, 0.0)));
+        spinMargin = std::chrono::duration_cast<clock::duration>(std::chrono::microseconds(MIN_SPIN_MARGIN_US));
+        started = false;
+        paced = 0;
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    void wait() {
+        clock::time_point now = clock::now();
+        bool first = !started;
+        if (first) {
+            started = true;
+            deadline = now;
+            lastWake = now;
+        }
+
+        if (mode == FixedSleep) {
+            std::this_thread::sleep_for(period);
+            clock::time_point woke = clock::now();
+            stats.sleepMs += milliseconds(woke - now);
+            now = woke;
+        }
+        else if (mode == Paced) {
+            deadline += period;
+            if (now >= deadline) {
+                stats.missed++;
+                deadline = now;
+            }
+            else {
+                clock::time_point sleepUntil = deadline - spinMargin;
+                if (now < sleepUntil) {
+                    std::this_thread::sleep_for(sleepUntil - now);
+                    clock::time_point woke = clock::now();
+                    adaptMargin(woke - sleepUntil);
+                    stats.sleepMs += milliseconds(woke - now);
+                    now = woke;
+                }
+                clock::time_point spinStart = now;
+                while (now < deadline) {
+                    std::this_thread::yield();
+                    now = clock::now();
+                }
+                stats.spinMs += milliseconds(now - spinStart);
+
+                double error = milliseconds(now - deadline);
+                paced++;
+                stats.meanErrorMs += (error - stats.meanErrorMs) / paced;
+                stats.maxErrorMs = std::max(stats.maxErrorMs, error);
+            }
+        }
+
+        if (!first) {
+            record(milliseconds(now - lastWake));
+        }
+        lastWake = now;
+    }
+
+    double periodMs() const {
+        return milliseconds(period);
+    }
+
+    const FramePacerStats& getStats() const {
+        return stats;
+    }
+
+    void report() const {
+        static const char* names[] = { "paced to", "uncapped", "fixed sleep of" };
+        char target[32] = "";
+        if (mode != Uncapped) {
+            snprintf(target, sizeof(target), " %.3f ms", milliseconds(period));
+        }
+        printf("frame pacing, %s%s: %lld frames, mean %.3f ms (%.1f fps), stddev %.3f ms, min %.3f, max %.3f\n",
+            names[mode], target, stats.frames, stats.meanMs, stats.meanMs > 0.0 ? 1000.0 / stats.meanMs : 0.0,
+            std::sqrt(stats.varianceMs), stats.minMs, stats.maxMs);
+        if (mode == Paced) {
+            printf("    deadline error mean %.3f ms, max %.3f ms, %lld missed, waited %.1f ms asleep and %.1f ms spinning, spin margin %.3f ms\n",
+                stats.meanErrorMs, stats.maxErrorMs, stats.missed, stats.sleepMs, stats.spinMs, milliseconds(spinMargin));
+        }
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    static constexpr int MIN_SPIN_MARGIN_US = 250;
+
+    Mode mode = Paced;
+    clock::duration period, spinMargin;
+    clock::time_point deadline, lastWake;
+    bool started = false;
+    long long paced = 0;
+    double m2 = 0.0;
+    FramePacerStats stats;
+
+    static double milliseconds(clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    // Oversleeps past the margin widen it straight away, otherwise it shrinks back slowly
+    void adaptMargin(clock::duration oversleep) {
+        clock::duration wanted = oversleep + oversleep / 4;
+        clock::duration decayed = spinMargin - spinMargin / 64;
+        clock::duration minimum = std::chrono::microseconds(MIN_SPIN_MARGIN_US);
+        spinMargin = std::min(std::max({ wanted, decayed, minimum }), period);
+    }
+
+    // Welford's running mean and variance
+    void record(double intervalMs) {
+        if (stats.frames == 0) {
+            stats.minMs = stats.maxMs = intervalMs;
+            m2 = 0.0;
+        }
+        stats.frames++;
+        double delta = intervalMs - stats.meanMs;
+        stats.meanMs += delta / stats.frames;
+        m2 += delta * (intervalMs - stats.meanMs);
+        stats.varianceMs = m2 / stats.frames;
+        stats.minMs = std::min(stats.minMs, intervalMs);
+        stats.maxMs = std::max(stats.maxMs, intervalMs);
+    }
+};
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstring>
+
+/*
+* The glad loader in this project is generated for core 3.3, but the demos ask GLFW for a 4.5 context.
+* Entry points newer than 3.3 are loaded here by hand with the same loader glad uses:
+*
+*     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
+*     loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+*
+* Every pointer stays NULL when the driver doesn't expose it, so check the GLEXT_* flag before use.
+*/
+
+// ARB_get_program_binary (core 4.1)
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+// KHR_parallel_shader_compile / ARB_parallel_shader_compile
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// EXT_texture_compression_s3tc, ARB_texture_compression_bptc (core 4.2)
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+// ARB_sparse_texture
+#ifndef GL_TEXTURE_SPARSE_ARB
+#define GL_TEXTURE_SPARSE_ARB 0x91A6
+#define GL_VIRTUAL_PAGE_SIZE_INDEX_ARB 0x91A7
+#define GL_NUM_VIRTUAL_PAGE_SIZES_ARB 0x91A8
+#define GL_NUM_SPARSE_LEVELS_ARB 0x91AA
+#define GL_VIRTUAL_PAGE_SIZE_X_ARB 0x9195
+#define GL_VIRTUAL_PAGE_SIZE_Y_ARB 0x9196
+#define GL_MAX_SPARSE_TEXTURE_SIZE_ARB 0x9198
+#endif
+
+// ARB_compute_shader, ARB_shader_storage_buffer_object (core 4.3), ARB_shader_image_load_store (core 4.2)
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_MAX_COMPUTE_WORK_GROUP_COUNT 0x91BE
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_MAX_SHADER_STORAGE_BLOCK_SIZE 0x90DE
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+
+// ARB_buffer_storage (core 4.4)
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+
+typedef void (APIENTRYP PFNGLEXTGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLEXTPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLEXTPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+typedef void (APIENTRYP PFNGLEXTDRAWELEMENTSINSTANCEDBASEINSTANCEPROC)(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount, GLuint baseinstance);
+typedef void (APIENTRYP PFNGLEXTTEXSTORAGE2DPROC)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+typedef void (APIENTRYP PFNGLEXTGETINTERNALFORMATIVPROC)(GLenum target, GLenum internalformat, GLenum pname, GLsizei count, GLint* params);
+typedef void (APIENTRYP PFNGLEXTTEXPAGECOMMITMENTPROC)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLboolean commit);
+typedef void (APIENTRYP PFNGLEXTDISPATCHCOMPUTEPROC)(GLuint groupsX, GLuint groupsY, GLuint groupsZ);
+typedef void (APIENTRYP PFNGLEXTMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLEXTBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+inline int GLEXT_ARB_get_program_binary = 0;
+inline PFNGLEXTGETPROGRAMBINARYPROC glext_glGetProgramBinary = NULL;
+inline PFNGLEXTPROGRAMBINARYPROC glext_glProgramBinary = NULL;
+inline PFNGLEXTPROGRAMPARAMETERIPROC glext_glProgramParameteri = NULL;
+
+inline int GLEXT_parallel_shader_compile = 0;
+inline PFNGLEXTMAXSHADERCOMPILERTHREADSPROC glext_glMaxShaderCompilerThreads = NULL;
+
+// ARB_base_instance (core 4.2)
+inline int GLEXT_ARB_base_instance = 0;
+inline PFNGLEXTDRAWELEMENTSINSTANCEDBASEINSTANCEPROC glext_glDrawElementsInstancedBaseInstance = NULL;
+
+// ARB_texture_storage and ARB_internalformat_query (core 4.2)
+inline int GLEXT_ARB_texture_storage = 0;
+inline PFNGLEXTTEXSTORAGE2DPROC glext_glTexStorage2D = NULL;
+inline PFNGLEXTGETINTERNALFORMATIVPROC glext_glGetInternalformativ = NULL;
+
+// ARB_sparse_texture, needs the two above as well
+inline int GLEXT_ARB_sparse_texture = 0;
+inline PFNGLEXTTEXPAGECOMMITMENTPROC glext_glTexPageCommitment = NULL;
+
+// ARB_compute_shader with shader storage buffers to work on, and the barrier between dispatches and draws
+inline int GLEXT_ARB_compute_shader = 0;
+inline PFNGLEXTDISPATCHCOMPUTEPROC glext_glDispatchCompute = NULL;
+inline PFNGLEXTMEMORYBARRIERPROC glext_glMemoryBarrier = NULL;
+
+// ARB_buffer_storage, immutable buffers that can stay mapped while the GL uses them
+inline int GLEXT_ARB_buffer_storage = 0;
+inline PFNGLEXTBUFFERSTORAGEPROC glext_glBufferStorage = NULL;
+
+inline bool hasGLVersion(int major, int minor) {
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+inline bool hasGLExtension(const char* name) {
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (extension && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Call after gladLoadGLLoader, with a current context
+inline void loadGLExtensions(GLADloadproc load) {
+    if (hasGLVersion(4, 1) || hasGLExtension("GL_ARB_get_program_binary")) {
+        glext_glGetProgramBinary = (PFNGLEXTGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+        glext_glProgramBinary = (PFNGLEXTPROGRAMBINARYPROC)load("glProgramBinary");
+        glext_glProgramParameteri = (PFNGLEXTPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+        GLEXT_ARB_get_program_binary = glext_glGetProgramBinary && glext_glProgramBinary && glext_glProgramParameteri;
+    }
+
+    if (hasGLExtension("GL_KHR_parallel_shader_compile")) {
+        glext_glMaxShaderCompilerThreads = (PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)load("glMaxShaderCompilerThreadsKHR");
+    }
+    else if (hasGLExtension("GL_ARB_parallel_shader_compile")) {
+        glext_glMaxShaderCompilerThreads = (PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)load("glMaxShaderCompilerThreadsARB");
+    }
+    GLEXT_parallel_shader_compile = glext_glMaxShaderCompilerThreads != NULL;
+
+    if (hasGLVersion(4, 2) || hasGLExtension("GL_ARB_base_instance")) {
+        glext_glDrawElementsInstancedBaseInstance = (PFNGLEXTDRAWELEMENTSINSTANCEDBASEINSTANCEPROC)load("glDrawElementsInstancedBaseInstance");
+        GLEXT_ARB_base_instance = glext_glDrawElementsInstancedBaseInstance != NULL;
+    }
+
+    if (hasGLVersion(4, 2) || hasGLExtension("GL_ARB_texture_storage")) {
+        glext_glTexStorage2D = (PFNGLEXTTEXSTORAGE2DPROC)load("glTexStorage2D");
+        GLEXT_ARB_texture_storage = glext_glTexStorage2D != NULL;
+    }
+    if (hasGLVersion(4, 2) || hasGLExtension("GL_ARB_internalformat_query")) {
+        glext_glGetInternalformativ = (PFNGLEXTGETINTERNALFORMATIVPROC)load("glGetInternalformativ");
+    }
+
+    if (hasGLExtension("GL_ARB_sparse_texture")) {
+        glext_glTexPageCommitment = (PFNGLEXTTEXPAGECOMMITMENTPROC)load("glTexPageCommitmentARB");
+        GLEXT_ARB_sparse_texture = glext_glTexPageCommitment && glext_glTexStorage2D && glext_glGetInternalformativ;
+    }
+
+    if (hasGLVersion(4, 3) || (hasGLExtension("GL_ARB_compute_shader") && hasGLExtension("GL_ARB_shader_storage_buffer_object"))) {
+        glext_glDispatchCompute = (PFNGLEXTDISPATCHCOMPUTEPROC)load("glDispatchCompute");
+        glext_glMemoryBarrier = (PFNGLEXTMEMORYBARRIERPROC)load("glMemoryBarrier");
+        GLEXT_ARB_compute_shader = glext_glDispatchCompute && glext_glMemoryBarrier;
+    }
+
+    if (hasGLVersion(4, 4) || hasGLExtension("GL_ARB_buffer_storage")) {
+        glext_glBufferStorage = (PFNGLEXTBUFFERSTORAGEPROC)load("glBufferStorage");
+        GLEXT_ARB_buffer_storage = glext_glBufferStorage != NULL;
+    }
+}
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdio>
+
+/*
+* Shadow copy of the GL state the demos change every frame. Each setter compares against the last value it
+* issued and skips the driver call when nothing changes.
+*
+*     GLStateCache glState;
+*     glState.useProgram(shader.ID);           // or shader.use(glState)
+*     glState.bindVertexArray(VAO);
+*     glState.bindTexture(0, GL_TEXTURE_2D, diffuseMap);
+*     glState.setEnabled(GL_DEPTH_TEST, true);
+*     ...
+*     glState.endFrame();                      // per frame issued / filtered counters
+*
+* Everything starts out unknown so the first call always goes through. State changed behind the cache's back
+* (raw gl* calls, deleted objects, another library) has to be followed by invalidate().
+* GL_ELEMENT_ARRAY_BUFFER belongs to the VAO, binding a VAO forgets it.
+*/
+
+enum GLStateCall {
+    GL_STATE_PROGRAM,
+    GL_STATE_VERTEX_ARRAY,
+    GL_STATE_BUFFER,
+    GL_STATE_FRAMEBUFFER,
+    GL_STATE_ACTIVE_TEXTURE,
+    GL_STATE_TEXTURE,
+    GL_STATE_CAPABILITY,
+    GL_STATE_BLEND_FUNC,
+    GL_STATE_DEPTH,
+    GL_STATE_CALL_COUNT
+};
+
+struct GLStateCounters {
+    long long issued[GL_STATE_CALL_COUNT];
+    long long filtered[GL_STATE_CALL_COUNT];
+
+    long long totalIssued() const {
+        long long total = 0;
+        for (int i = 0; i < GL_STATE_CALL_COUNT; i++) {
+            total += issued[i];
+        }
+        return total;
+    }
+
+    long long totalFiltered() const {
+        long long total = 0;
+        for (int i = 0; i < GL_STATE_CALL_COUNT; i++) {
+            total += filtered[i];
+        }
+        return total;
+    }
+};
+
+class GLStateCache {
+
+public:
+    static const int TEXTURE_UNITS = 32;
+
+    GLStateCache() {
+        invalidate();
+        resetCounters();
+    }
+
+    // Forget every cached value, the next call of each kind reaches the driver
+    void invalidate() {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        for (int i = 0; i < BUFFER_TARGETS; i++) {
+            buffers[i] = UNKNOWN;
+        }
+        readFramebuffer = UNKNOWN;
+        drawFramebuffer = UNKNOWN;
+        activeUnit = UNKNOWN;
+        for (int unit = 0; unit < TEXTURE_UNITS; unit++) {
+            for (int i = 0; i < TEXTURE_TARGETS; i++) {
+                textures[unit][i] = UNKNOWN;
+            }
+        }
+        for (int i = 0; i < CAPABILITIES; i++) {
+            capabilityState[i] = -1;
+        }
+        for (int i = 0; i < 4; i++) {
+            blendFactors[i] = UNKNOWN;
+        }
+        depthFunction = UNKNOWN;
+        depthWrite = -1;
+    }
+
+    void useProgram(GLuint id) {
+        if (filter(GL_STATE_PROGRAM, program == id)) {
+            return;
+        }
+        program = id;
+        glUseProgram(id);
+    }
+
+    void bindVertexArray(GLuint id) {
+        if (filter(GL_STATE_VERTEX_ARRAY, vertexArray == id)) {
+            return;
+        }
+        vertexArray = id;
+        buffers[bufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+        glBindVertexArray(id);
+    }
+
+    void bindBuffer(GLenum target, GLuint id) {
+        int index = bufferIndex(target);
+        if (filter(GL_STATE_BUFFER, index >= 0 && buffers[index] == id)) {
+            return;
+        }
+        if (index >= 0) {
+            buffers[index] = id;
+        }
+        glBindBuffer(target, id);
+    }
+
+    void bindFramebuffer(GLenum target, GLuint id) {
+        bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        if (filter(GL_STATE_FRAMEBUFFER, (!read || readFramebuffer == id) && (!draw || drawFramebuffer == id))) {
+            return;
+        }
+        if (read) {
+            readFramebuffer = id;
+        }
+        if (draw) {
+            drawFramebuffer = id;
+        }
+        glBindFramebuffer(target, id);
+    }
+
+    // unit is 0 based, GL_TEXTURE0 + unit
+    void activeTexture(int unit) {
+        if (filter(GL_STATE_ACTIVE_TEXTURE, activeUnit == (GLuint)unit)) {
+            return;
+        }
+        activeUnit = unit;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    // Only switches the active unit when the binding actually changes
+    void bindTexture(int unit, GLenum target, GLuint id) {
+        int index = textureIndex(target);
+        bool known = index >= 0 && unit >= 0 && unit < TEXTURE_UNITS;
+        if (filter(GL_STATE_TEXTURE, known && textures[unit][index] == id)) {
+            return;
+        }
+        activeTexture(unit);
+        if (known) {
+            textures[unit][index] = id;
+        }
+        glBindTexture(target, id);
+    }
+
+    void setEnabled(GLenum capability, bool enabled) {
+        int index = capabilityIndex(capability);
+        if (filter(GL_STATE_CAPABILITY, index >= 0 && capabilityState[index] == (int)enabled)) {
+            return;
+        }
+        if (index >= 0) {
+            capabilityState[index] = enabled;
+        }
+        if (enabled) {
+            glEnable(capability);
+        }
+        else {
+            glDisable(capability);
+        }
+    }
+
+    void blendFunc(GLenum source, GLenum destination) {
+        blendFuncSeparate(source, destination, source, destination);
+    }
+
+    void blendFuncSeparate(GLenum sourceRGB, GLenum destinationRGB, GLenum sourceAlpha, GLenum destinationAlpha) {
+        GLenum factors[4] = { sourceRGB, destinationRGB, sourceAlpha, destinationAlpha };
+        bool same = true;
+        for (int i = 0; i < 4; i++) {
+            same = same && blendFactors[i] == factors[i];
+        }
+        if (filter(GL_STATE_BLEND_FUNC, same)) {
+            return;
+        }
+        for (int i = 0; i < 4; i++) {
+            blendFactors[i] = factors[i];
+        }
+        glBlendFuncSeparate(sourceRGB, destinationRGB, sourceAlpha, destinationAlpha);
+    }
+
+    void depthFunc(GLenum function) {
+        if (filter(GL_STATE_DEPTH, depthFunction == function)) {
+            return;
+        }
+        depthFunction = function;
+        glDepthFunc(function);
+    }
+
+    void depthMask(bool write) {
+        if (filter(GL_STATE_DEPTH, depthWrite == (int)write)) {
+            return;
+        }
+        depthWrite = write;
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+
+    // Closes the frame: its counters become lastFrame() and add to the totals
+    void endFrame() {
+        for (int i = 0; i < GL_STATE_CALL_COUNT; i++) {
+            last.issued[i] = current.issued[i];
+            last.filtered[i] = current.filtered[i];
+            total.issued[i] += current.issued[i];
+            total.filtered[i] += current.filtered[i];
+            current.issued[i] = 0;
+            current.filtered[i] = 0;
+        }
+        frames++;
+    }
+
+    void resetCounters() {
+        for (int i = 0; i < GL_STATE_CALL_COUNT; i++) {
+            current.issued[i] = current.filtered[i] = 0;
+            last.issued[i] = last.filtered[i] = 0;
+            total.issued[i] = total.filtered[i] = 0;
+        }
+        frames = 0;
+    }
+
+    const GLStateCounters& lastFrame() const {
+        return last;
+    }
+
+    const GLStateCounters& totals() const {
+        return total;
+    }
+
+    long long frameCount() const {
+        return frames;
+    }
+
+    // Per frame averages over every endFrame() so far, one line per kind of call that was made
+    void report() const {
+        static const char* names[GL_STATE_CALL_COUNT] = {
+            "program", "vertex array", "buffer", "framebuffer", "active texture", "texture", "enable/disable", "blend func", "depth"
+        };
+        long long divisor = frames > 0 ? frames : 1;
+        printf("GL state over %lld frames: %.1f calls/frame issued, %.1f filtered\n", frames,
+            (double)total.totalIssued() / divisor, (double)total.totalFiltered() / divisor);
+        for (int i = 0; i < GL_STATE_CALL_COUNT; i++) {
+            if (total.issued[i] || total.filtered[i]) {
+                printf("  %-16s %8.1f issued %8.1f filtered\n", names[i], (double)total.issued[i] / divisor, (double)total.filtered[i] / divisor);
+            }
+        }
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const int BUFFER_TARGETS = 6;
+    static const int TEXTURE_TARGETS = 4;
+    static const int CAPABILITIES = 7;
+
+    GLuint program;
+    GLuint vertexArray;
+    GLuint buffers[BUFFER_TARGETS];
+    GLuint readFramebuffer, drawFramebuffer;
+    GLuint activeUnit;
+    GLuint textures[TEXTURE_UNITS][TEXTURE_TARGETS];
+    int capabilityState[CAPABILITIES]; // -1 unknown
+    GLenum blendFactors[4];
+    GLenum depthFunction;
+    int depthWrite;
+
+    GLStateCounters current, last, total;
+    long long frames;
+
+    // Counts the call, true when it can be skipped
+    bool filter(GLStateCall call, bool redundant) {
+        if (redundant) {
+            current.filtered[call]++;
+        }
+        else {
+            current.issued[call]++;
+        }
+        return redundant;
+    }
+
+    // anything else passes straight through
+    static int bufferIndex(GLenum target) {
+        switch (target) {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_ELEMENT_ARRAY_BUFFER: return 1;
+        case GL_UNIFORM_BUFFER: return 2;
+        case GL_COPY_READ_BUFFER: return 3;
+        case GL_COPY_WRITE_BUFFER: return 4;
+        case GL_PIXEL_UNPACK_BUFFER: return 5;
+        default: return -1;
+        }
+    }
+
+    static int textureIndex(GLenum target) {
+        switch (target) {
+        case GL_TEXTURE_2D: return 0;
+        case GL_TEXTURE_2D_ARRAY: return 1;
+        case GL_TEXTURE_CUBE_MAP: return 2;
+        case GL_TEXTURE_3D: return 3;
+        default: return -1;
+        }
+    }
+
+    static int capabilityIndex(GLenum capability) {
+        switch (capability) {
+        case GL_BLEND: return 0;
+        case GL_DEPTH_TEST: return 1;
+        case GL_CULL_FACE: return 2;
+        case GL_SCISSOR_TEST: return 3;
+        case GL_STENCIL_TEST: return 4;
+        case GL_RASTERIZER_DISCARD: return 5;
+        case GL_FRAMEBUFFER_SRGB: return 6;
+        default: return -1;
+        }
+    }
+};
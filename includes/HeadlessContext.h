@@ -0,0 +1,139 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <iostream>
+#if defined(__linux__)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+/*
+* A GL context with no window and no display, for benchmarks that run in containers and on CI machines.
+*
+*     HeadlessContext context;
+*     if (!context.create(4, 5) || !gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) { ... }
+*     ...                                  // render into a framebuffer object, there is no default framebuffer
+*     context.release();
+*
+* On Linux it is an EGL context made current without a surface (EGL_MESA_platform_surfaceless, falling back to the
+* default display), which Mesa's llvmpipe provides without any GPU, X server or Wayland compositor. Link with -lEGL.
+* Everywhere else it is a hidden GLFW window. Asks for a core profile of the version given.
+*/
+
+class HeadlessContext {
+
+public:
+    HeadlessContext() = default;
+
+    ~HeadlessContext() {
+        release();
+    }
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+#if defined(__linux__)
+    bool create(int major = 4, int minor = 5) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        }
+        if (display == EGL_NO_DISPLAY) {
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        }
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+            std::cout << "ERROR::HEADLESS_CONTEXT::NO_EGL_DISPLAY" << std::endl;
+            display = EGL_NO_DISPLAY;
+            return false;
+        }
+
+        // the surface type defaults to windows, which the surfaceless platform has none of
+        const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount < 1 || !eglBindAPI(EGL_OPENGL_API)) {
+            std::cout << "ERROR::HEADLESS_CONTEXT::NO_OPENGL_CONFIG" << std::endl;
+            release();
+            return false;
+        }
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, major,
+            EGL_CONTEXT_MINOR_VERSION, minor,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            std::cout << "ERROR::HEADLESS_CONTEXT::CONTEXT_CREATION_FAILED " << major << "." << minor << std::endl;
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    void release() {
+        if (display == EGL_NO_DISPLAY) {
+            return;
+        }
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT) {
+            eglDestroyContext(display, context);
+            context = EGL_NO_CONTEXT;
+        }
+        eglTerminate(display);
+        display = EGL_NO_DISPLAY;
+    }
+
+    static void* getProcAddress(const char* name) {
+        return (void*)eglGetProcAddress(name);
+    }
+
+    static const char* api() {
+        return "EGL surfaceless";
+    }
+
+private:
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+#else
+    bool create(int major = 4, int minor = 5) {
+        if (!glfwInit()) {
+            std::cout << "ERROR::HEADLESS_CONTEXT::GLFW_INIT_FAILED" << std::endl;
+            return false;
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, major);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        window = glfwCreateWindow(64, 64, "Headless", NULL, NULL);
+        if (window == NULL) {
+            std::cout << "ERROR::HEADLESS_CONTEXT::CONTEXT_CREATION_FAILED " << major << "." << minor << std::endl;
+            glfwTerminate();
+            return false;
+        }
+        glfwMakeContextCurrent(window);
+        return true;
+    }
+
+    void release() {
+        if (window) {
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            window = NULL;
+        }
+    }
+
+    static void* getProcAddress(const char* name) {
+        return (void*)glfwGetProcAddress(name);
+    }
+
+    static const char* api() {
+        return "GLFW hidden window";
+    }
+
+private:
+    GLFWwindow* window = NULL;
+#endif
+};
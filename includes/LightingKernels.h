@@ -0,0 +1,338 @@
+#pragma once
+
+#include <cmath>
+#include <glm/glm.hpp>
+#include "Simd.h"
+
+/*
+* C++ versions of the lighting fragment shaders, for the software rasterizer and as a CPU reference.
+*
+*     shadeDirectionalLight   directionalLightFrag.glsl
+*     shadePointLight         pointLightFrag.glsl
+*     shadeSpotLight          spotlightFrag.glsl
+*     shadeMaterialPhong      materialPhong.glsl
+*
+* Fragments come in SoA form (one array per component, see LightingFragments) and are shaded 8 at a time
+* with AVX2, 4 with SSE2, and 1 at a time for the tail or without SIMD. Every width runs the same template body
+* with the same operation order, so the results are bit identical whichever path shades a fragment
+* (gcc/clang need -ffp-contract=off for that, otherwise they fuse some of the scalar multiply-adds on their own,
+* MSVC's default /fp:precise doesn't).
+* pow(x, 128) is evaluated as 7 squarings, exact for the integer exponent the shaders use.
+*/
+
+struct Lanes1 {
+    static const int width = 1;
+    float v;
+
+    static Lanes1 set(float f) { return { f }; }
+    static Lanes1 load(const float* p) { return { *p }; }
+    void store(float* p) const { *p = v; }
+};
+
+inline Lanes1 operator+(Lanes1 a, Lanes1 b) { return { a.v + b.v }; }
+inline Lanes1 operator-(Lanes1 a, Lanes1 b) { return { a.v - b.v }; }
+inline Lanes1 operator*(Lanes1 a, Lanes1 b) { return { a.v * b.v }; }
+inline Lanes1 operator/(Lanes1 a, Lanes1 b) { return { a.v / b.v }; }
+inline Lanes1 laneMax(Lanes1 a, Lanes1 b) { return { a.v > b.v ? a.v : b.v }; }
+inline Lanes1 laneMin(Lanes1 a, Lanes1 b) { return { a.v < b.v ? a.v : b.v }; }
+inline Lanes1 laneSqrt(Lanes1 a) { return { std::sqrt(a.v) }; }
+#if defined(SIMD_AVX2)
+inline Lanes1 madd(Lanes1 a, Lanes1 b, Lanes1 c) { return { std::fma(a.v, b.v, c.v) }; }
+#else
+inline Lanes1 madd(Lanes1 a, Lanes1 b, Lanes1 c) { return { a.v * b.v + c.v }; }
+#endif
+
+#if defined(SIMD_SSE2)
+struct Lanes4 {
+    static const int width = 4;
+    __m128 v;
+
+    static Lanes4 set(float f) { return { _mm_set1_ps(f) }; }
+    static Lanes4 load(const float* p) { return { _mm_loadu_ps(p) }; }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+};
+
+inline Lanes4 operator+(Lanes4 a, Lanes4 b) { return { _mm_add_ps(a.v, b.v) }; }
+inline Lanes4 operator-(Lanes4 a, Lanes4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline Lanes4 operator*(Lanes4 a, Lanes4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline Lanes4 operator/(Lanes4 a, Lanes4 b) { return { _mm_div_ps(a.v, b.v) }; }
+// maxps/minps return the second operand on NaN, same as the scalar ternaries
+inline Lanes4 laneMax(Lanes4 a, Lanes4 b) { return { _mm_max_ps(a.v, b.v) }; }
+inline Lanes4 laneMin(Lanes4 a, Lanes4 b) { return { _mm_min_ps(a.v, b.v) }; }
+inline Lanes4 laneSqrt(Lanes4 a) { return { _mm_sqrt_ps(a.v) }; }
+#if defined(SIMD_AVX2)
+inline Lanes4 madd(Lanes4 a, Lanes4 b, Lanes4 c) { return { _mm_fmadd_ps(a.v, b.v, c.v) }; }
+#else
+inline Lanes4 madd(Lanes4 a, Lanes4 b, Lanes4 c) { return { _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v) }; }
+#endif
+#endif
+
+#if defined(SIMD_AVX2)
+struct Lanes8 {
+    static const int width = 8;
+    __m256 v;
+
+    static Lanes8 set(float f) { return { _mm256_set1_ps(f) }; }
+    static Lanes8 load(const float* p) { return { _mm256_loadu_ps(p) }; }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+};
+
+inline Lanes8 operator+(Lanes8 a, Lanes8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline Lanes8 operator-(Lanes8 a, Lanes8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline Lanes8 operator*(Lanes8 a, Lanes8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline Lanes8 operator/(Lanes8 a, Lanes8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline Lanes8 laneMax(Lanes8 a, Lanes8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline Lanes8 laneMin(Lanes8 a, Lanes8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline Lanes8 laneSqrt(Lanes8 a) { return { _mm256_sqrt_ps(a.v) }; }
+inline Lanes8 madd(Lanes8 a, Lanes8 b, Lanes8 c) { return { _mm256_fmadd_ps(a.v, b.v, c.v) }; }
+#endif
+
+// widest lanes this build has
+#if defined(SIMD_AVX2)
+typedef Lanes8 LightingLanes;
+#elif defined(SIMD_SSE2)
+typedef Lanes4 LightingLanes;
+#else
+typedef Lanes1 LightingLanes;
+#endif
+
+// Uniform blocks, same fields as the GLSL structs
+struct DirectionalLightParams {
+    glm::vec3 direction;
+    glm::vec3 ambient, diffuse, specular;
+};
+
+struct PointLightParams {
+    glm::vec3 position;
+    glm::vec3 ambient, diffuse, specular;
+    float constant, linear, quadratic;
+};
+
+struct SpotLightParams {
+    glm::vec3 position, direction;
+    float cutOff, outerCutOff;
+    glm::vec3 ambient, diffuse, specular;
+    float constant, linear, quadratic;
+};
+
+struct PhongMaterialParams {
+    glm::vec3 ambient, diffuse, specular;
+    float shininess;
+};
+
+struct PhongLightParams {
+    glm::vec3 ambient, diffuse, specular;
+};
+
+// SoA view of count fragments, every pointer is an array of count floats.
+// The *Map inputs are the already sampled texture colors, materialPhong doesn't read them.
+struct LightingFragments {
+    const float* fragPos[3];
+    const float* normal[3];
+    const float* diffuseMap[3];
+    const float* specularMap[3];
+    const float* emissionMap[3];
+    float* color[3];
+    int count;
+};
+
+template<class Lanes>
+struct LaneVec3 {
+    Lanes x, y, z;
+
+    static LaneVec3 set(glm::vec3 v) { return { Lanes::set(v.x), Lanes::set(v.y), Lanes::set(v.z) }; }
+    static LaneVec3 load(const float* const p[3], int i) { return { Lanes::load(p[0] + i), Lanes::load(p[1] + i), Lanes::load(p[2] + i) }; }
+    void store(float* const p[3], int i) const { x.store(p[0] + i); y.store(p[1] + i); z.store(p[2] + i); }
+
+    LaneVec3 operator+(const LaneVec3& b) const { return { x + b.x, y + b.y, z + b.z }; }
+    LaneVec3 operator-(const LaneVec3& b) const { return { x - b.x, y - b.y, z - b.z }; }
+    LaneVec3 operator*(const LaneVec3& b) const { return { x * b.x, y * b.y, z * b.z }; }
+    LaneVec3 operator*(Lanes s) const { return { x * s, y * s, z * s }; }
+    LaneVec3 operator/(Lanes s) const { return { x / s, y / s, z / s }; }
+};
+
+template<class Lanes>
+inline Lanes dot(const LaneVec3<Lanes>& a, const LaneVec3<Lanes>& b) {
+    return madd(a.x, b.x, madd(a.y, b.y, a.z * b.z));
+}
+
+template<class Lanes>
+inline LaneVec3<Lanes> normalize(const LaneVec3<Lanes>& v) {
+    return v / laneSqrt(dot(v, v));
+}
+
+// reflect(-lightDir, norm) = 2 * dot(norm, lightDir) * norm - lightDir
+template<class Lanes>
+inline LaneVec3<Lanes> reflectIncoming(const LaneVec3<Lanes>& lightDir, const LaneVec3<Lanes>& norm, Lanes normDotLight) {
+    Lanes twice = normDotLight + normDotLight;
+    return { madd(twice, norm.x, Lanes::set(0.0f) - lightDir.x), madd(twice, norm.y, Lanes::set(0.0f) - lightDir.y), madd(twice, norm.z, Lanes::set(0.0f) - lightDir.z) };
+}
+
+// pow(max(dot(viewDir, reflectDir), 0.0), 128)
+template<class Lanes>
+inline Lanes specularPower128(const LaneVec3<Lanes>& viewDir, const LaneVec3<Lanes>& reflectDir) {
+    Lanes spec = laneMax(dot(viewDir, reflectDir), Lanes::set(0.0f));
+    for (int i = 0; i < 7; i++) {
+        spec = spec * spec;
+    }
+    return spec;
+}
+
+// 1.0 / (constant + linear * distance + quadratic * (distance * distance))
+template<class Lanes>
+inline Lanes attenuation(Lanes distance, float constant, float linear, float quadratic) {
+    return Lanes::set(1.0f) / madd(Lanes::set(quadratic), distance * distance, madd(Lanes::set(linear), distance, Lanes::set(constant)));
+}
+
+template<class Lanes>
+void directionalLightLanes(const DirectionalLightParams& light, const LaneVec3<Lanes>& viewPos, const LaneVec3<Lanes>& lightDir,
+    float emmisiveness, const LightingFragments& fragments, int i) {
+
+    LaneVec3<Lanes> fragPos = LaneVec3<Lanes>::load(fragments.fragPos, i);
+    LaneVec3<Lanes> diffuseMap = LaneVec3<Lanes>::load(fragments.diffuseMap, i);
+
+    LaneVec3<Lanes> ambient = diffuseMap * LaneVec3<Lanes>::set(light.ambient);
+
+    LaneVec3<Lanes> norm = normalize(LaneVec3<Lanes>::load(fragments.normal, i));
+    Lanes normDotLight = dot(norm, lightDir);
+    Lanes diff = laneMax(normDotLight, Lanes::set(0.0f));
+    LaneVec3<Lanes> diffuse = LaneVec3<Lanes>::set(light.diffuse) * diff * diffuseMap;
+
+    LaneVec3<Lanes> viewDir = normalize(viewPos - fragPos);
+    Lanes spec = specularPower128(viewDir, reflectIncoming(lightDir, norm, normDotLight));
+    LaneVec3<Lanes> specular = LaneVec3<Lanes>::load(fragments.specularMap, i) * spec * LaneVec3<Lanes>::set(light.specular);
+
+    LaneVec3<Lanes> emission = LaneVec3<Lanes>::load(fragments.emissionMap, i) * Lanes::set(emmisiveness);
+
+    (ambient + diffuse + specular + emission).store(fragments.color, i);
+}
+
+template<class Lanes>
+void pointLightLanes(const PointLightParams& light, const LaneVec3<Lanes>& viewPos, float emmisiveness, const LightingFragments& fragments, int i) {
+    LaneVec3<Lanes> fragPos = LaneVec3<Lanes>::load(fragments.fragPos, i);
+    LaneVec3<Lanes> diffuseMap = LaneVec3<Lanes>::load(fragments.diffuseMap, i);
+
+    LaneVec3<Lanes> ambient = diffuseMap * LaneVec3<Lanes>::set(light.ambient);
+
+    LaneVec3<Lanes> norm = normalize(LaneVec3<Lanes>::load(fragments.normal, i));
+    LaneVec3<Lanes> toLight = LaneVec3<Lanes>::set(light.position) - fragPos;
+    Lanes distance = laneSqrt(dot(toLight, toLight));
+    LaneVec3<Lanes> lightDir = toLight / distance;
+    Lanes normDotLight = dot(norm, lightDir);
+    Lanes diff = laneMax(normDotLight, Lanes::set(0.0f));
+    LaneVec3<Lanes> diffuse = LaneVec3<Lanes>::set(light.diffuse) * diff * diffuseMap;
+
+    LaneVec3<Lanes> viewDir = normalize(viewPos - fragPos);
+    Lanes spec = specularPower128(viewDir, reflectIncoming(lightDir, norm, normDotLight));
+    LaneVec3<Lanes> specular = LaneVec3<Lanes>::load(fragments.specularMap, i) * spec * LaneVec3<Lanes>::set(light.specular);
+
+    LaneVec3<Lanes> emission = LaneVec3<Lanes>::load(fragments.emissionMap, i) * Lanes::set(emmisiveness);
+
+    Lanes falloff = attenuation(distance, light.constant, light.linear, light.quadratic);
+    ambient = ambient * falloff;
+    diffuse = diffuse * falloff;
+    specular = specular * falloff;
+
+    (ambient + diffuse + specular + emission).store(fragments.color, i);
+}
+
+template<class Lanes>
+void spotLightLanes(const SpotLightParams& light, const LaneVec3<Lanes>& viewPos, const LaneVec3<Lanes>& spotDir,
+    float emmisiveness, const LightingFragments& fragments, int i) {
+
+    LaneVec3<Lanes> fragPos = LaneVec3<Lanes>::load(fragments.fragPos, i);
+    LaneVec3<Lanes> toLight = LaneVec3<Lanes>::set(light.position) - fragPos;
+    Lanes distance = laneSqrt(dot(toLight, toLight));
+    LaneVec3<Lanes> lightDir = toLight / distance;
+
+    LaneVec3<Lanes> diffuseMap = LaneVec3<Lanes>::load(fragments.diffuseMap, i);
+    LaneVec3<Lanes> ambient = diffuseMap * LaneVec3<Lanes>::set(light.ambient);
+    LaneVec3<Lanes> emission = LaneVec3<Lanes>::load(fragments.emissionMap, i) * Lanes::set(emmisiveness);
+
+    LaneVec3<Lanes> norm = normalize(LaneVec3<Lanes>::load(fragments.normal, i));
+    Lanes normDotLight = dot(norm, lightDir);
+    Lanes diff = laneMax(normDotLight, Lanes::set(0.0f));
+    LaneVec3<Lanes> diffuse = LaneVec3<Lanes>::set(light.diffuse) * diff * diffuseMap;
+
+    LaneVec3<Lanes> viewDir = normalize(viewPos - fragPos);
+    Lanes spec = specularPower128(viewDir, reflectIncoming(lightDir, norm, normDotLight));
+    LaneVec3<Lanes> specular = LaneVec3<Lanes>::load(fragments.specularMap, i) * spec * LaneVec3<Lanes>::set(light.specular);
+
+    Lanes falloff = attenuation(distance, light.constant, light.linear, light.quadratic);
+    diffuse = diffuse * falloff;
+    specular = specular * falloff;
+
+    // smooth edge between the inner and outer cone
+    Lanes theta = dot(lightDir, spotDir);
+    Lanes intensity = (theta - Lanes::set(light.outerCutOff)) / Lanes::set(light.cutOff - light.outerCutOff);
+    intensity = laneMin(laneMax(intensity, Lanes::set(0.0f)), Lanes::set(1.0f));
+
+    (ambient + (diffuse + specular + emission) * intensity).store(fragments.color, i);
+}
+
+template<class Lanes>
+void materialPhongLanes(const PhongMaterialParams& material, const PhongLightParams& light, const LaneVec3<Lanes>& lightPos,
+    const LaneVec3<Lanes>& viewPos, const LightingFragments& fragments, int i) {
+
+    LaneVec3<Lanes> fragPos = LaneVec3<Lanes>::load(fragments.fragPos, i);
+
+    LaneVec3<Lanes> ambient = LaneVec3<Lanes>::set(material.ambient * light.ambient);
+
+    LaneVec3<Lanes> norm = normalize(LaneVec3<Lanes>::load(fragments.normal, i));
+    LaneVec3<Lanes> lightDir = normalize(lightPos - fragPos);
+    Lanes normDotLight = dot(norm, lightDir);
+    Lanes diff = laneMax(normDotLight, Lanes::set(0.0f));
+    LaneVec3<Lanes> diffuse = LaneVec3<Lanes>::set(material.diffuse) * diff * LaneVec3<Lanes>::set(light.diffuse);
+
+    LaneVec3<Lanes> viewDir = normalize(viewPos - fragPos);
+    Lanes spec = specularPower128(viewDir, reflectIncoming(lightDir, norm, normDotLight));
+    LaneVec3<Lanes> specular = LaneVec3<Lanes>::set(material.specular) * spec * LaneVec3<Lanes>::set(light.specular);
+
+    (ambient + diffuse + specular).store(fragments.color, i);
+}
+
+// Full Lanes wide groups first, the remainder one fragment at a time through the same code
+template<class Lanes, class Kernel>
+inline void forEachLaneGroup(int count, Kernel kernel) {
+    int i = 0;
+    for (; i + Lanes::width <= count; i += Lanes::width) {
+        kernel(Lanes(), i);
+    }
+    for (; i < count; i++) {
+        kernel(Lanes1(), i);
+    }
+}
+
+template<class Lanes = LightingLanes>
+void shadeDirectionalLight(const DirectionalLightParams& light, glm::vec3 viewPos, float emmisiveness, const LightingFragments& fragments) {
+    glm::vec3 lightDir = glm::normalize(-light.direction);
+    forEachLaneGroup<Lanes>(fragments.count, [&](auto lanes, int i) {
+        typedef decltype(lanes) L;
+        directionalLightLanes<L>(light, LaneVec3<L>::set(viewPos), LaneVec3<L>::set(lightDir), emmisiveness, fragments, i);
+    });
+}
+
+template<class Lanes = LightingLanes>
+void shadePointLight(const PointLightParams& light, glm::vec3 viewPos, float emmisiveness, const LightingFragments& fragments) {
+    forEachLaneGroup<Lanes>(fragments.count, [&](auto lanes, int i) {
+        typedef decltype(lanes) L;
+        pointLightLanes<L>(light, LaneVec3<L>::set(viewPos), emmisiveness, fragments, i);
+    });
+}
+
+template<class Lanes = LightingLanes>
+void shadeSpotLight(const SpotLightParams& light, glm::vec3 viewPos, float emmisiveness, const LightingFragments& fragments) {
+    glm::vec3 spotDir = glm::normalize(-light.direction);
+    forEachLaneGroup<Lanes>(fragments.count, [&](auto lanes, int i) {
+        typedef decltype(lanes) L;
+        spotLightLanes<L>(light, LaneVec3<L>::set(viewPos), LaneVec3<L>::set(spotDir), emmisiveness, fragments, i);
+    });
+}
+
+template<class Lanes = LightingLanes>
+void shadeMaterialPhong(const PhongMaterialParams& material, const PhongLightParams& light, glm::vec3 lightPos, glm::vec3 viewPos, const LightingFragments& fragments) {
+    forEachLaneGroup<Lanes>(fragments.count, [&](auto lanes, int i) {
+        typedef decltype(lanes) L;
+        materialPhongLanes<L>(material, light, LaneVec3<L>::set(lightPos), LaneVec3<L>::set(viewPos), fragments, i);
+    });
+}
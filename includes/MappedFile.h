@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+* Read only view of a whole file through the OS page cache (mmap / MapViewOfFile).
+*
+*     MappedFile file("resources/container2.png.tex");
+*     if (file.isOpen()) {
+*         const unsigned char* bytes = file.data();   // valid until file goes out of scope
+*         ...
+*     }
+*
+* Nothing is read up front, pages come in on first touch, so handing data() straight to GL
+* skips the copy into a heap buffer that fread would need.
+*/
+
+class MappedFile {
+
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const char* path) {
+        open(path);
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Prints an error and leaves the file closed when path can't be mapped
+    bool open(const char* path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED " << path << std::endl;
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        size = (size_t)fileSize.QuadPart;
+        if (size > 0) {
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (mapping) {
+                view = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            }
+        }
+#else
+        descriptor = ::open(path, O_RDONLY);
+        if (descriptor < 0) {
+            std::cout << "ERROR::MAPPED_FILE::OPEN_FAILED " << path << std::endl;
+            return false;
+        }
+        struct stat status;
+        fstat(descriptor, &status);
+        size = (size_t)status.st_size;
+        if (size > 0) {
+            void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            view = mapped == MAP_FAILED ? NULL : (const unsigned char*)mapped;
+        }
+#endif
+        if (!view) {
+            std::cout << "ERROR::MAPPED_FILE::MAP_FAILED " << path << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (view) {
+            UnmapViewOfFile(view);
+        }
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (view) {
+            munmap((void*)view, size);
+        }
+        if (descriptor >= 0) {
+            ::close(descriptor);
+        }
+        descriptor = -1;
+#endif
+        view = NULL;
+        size = 0;
+    }
+
+    bool isOpen() const {
+        return view != NULL;
+    }
+
+    const unsigned char* data() const {
+        return view;
+    }
+
+    size_t fileSize() const {
+        return size;
+    }
+
+private:
+    const unsigned char* view = NULL;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#else
+    int descriptor = -1;
+#endif
+};
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+/*
+* Turns the demos' glDrawArrays triangle lists into indexed meshes for glDrawElements.
+*
+*     MeshBuilder cube(8);                     // floats per vertex: pos, normal, uv
+*     cube.addTriangles(vertices, 36);         // welds identical vertices, 36 -> 24
+*     cube.optimize();                         // triangle order for the post transform cache
+*     glBindBuffer(GL_ARRAY_BUFFER, VBO);
+*     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+*     cube.upload();
+*     glDrawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0);
+*
+* Indices are 16 bit while the vertex count allows it. ACMR (average cache miss ratio) is vertex shader runs
+* per triangle on a simulated FIFO post transform cache: 3.0 for unindexed draws, about 0.5-0.7 is the best
+* a regular grid can get.
+*/
+
+class MeshBuilder {
+
+public:
+    explicit MeshBuilder(int stride) : stride(stride) {
+    }
+
+    // Appends a non indexed triangle list (the glDrawArrays layout), vertices with identical bits become one
+    void addTriangles(const float* data, int count) {
+        std::vector<float> vertex(stride);
+        for (int i = 0; i < count; i++) {
+            for (int k = 0; k < stride; k++) {
+                vertex[k] = data[i * stride + k] + 0.0f; // -0.0 and 0.0 weld together
+            }
+            indices.push_back(weld(vertex.data()));
+        }
+    }
+
+    // Forsyth's linear speed vertex cache optimization, then vertices renumbered in first use order for fetch locality
+    void optimize(int cacheSize = 32) {
+        orderTriangles(cacheSize);
+        orderVertices();
+    }
+
+    // Vertex shader invocations per triangle with a FIFO cache of cacheSize entries
+    double acmr(int cacheSize = 32) const {
+        return triangleCount() ? (double)vertexShaderInvocations(cacheSize) / triangleCount() : 0.0;
+    }
+
+    int vertexShaderInvocations(int cacheSize = 32) const {
+        std::vector<int64_t> insertedAt(vertexCount(), -(int64_t)cacheSize - 1);
+        int64_t time = 0;
+        int misses = 0;
+        for (uint32_t index : indices) {
+            // in the cache while fewer than cacheSize other vertices were inserted since
+            if (time - insertedAt[index] > cacheSize) {
+                insertedAt[index] = time++;
+                misses++;
+            }
+        }
+        return misses;
+    }
+
+    int vertexCount() const {
+        return (int)vertices.size() / stride;
+    }
+
+    int indexCount() const {
+        return (int)indices.size();
+    }
+
+    int triangleCount() const {
+        return (int)indices.size() / 3;
+    }
+
+    GLenum indexType() const {
+        return vertexCount() <= 0xFFFF ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+
+    int indexSize() const {
+        return indexType() == GL_UNSIGNED_SHORT ? 2 : 4;
+    }
+
+    const std::vector<float>& getVertices() const {
+        return vertices;
+    }
+
+    const std::vector<uint32_t>& getIndices() const {
+        return indices;
+    }
+
+    // Fills the bound GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER
+    void upload(GLenum usage = GL_STATIC_DRAW) const {
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), usage);
+        uploadIndices(usage);
+    }
+
+    // Only the bound GL_ELEMENT_ARRAY_BUFFER, for vertices that get packed into another format first
+    void uploadIndices(GLenum usage = GL_STATIC_DRAW) const {
+        if (indexType() == GL_UNSIGNED_SHORT) {
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(uint16_t), shortIndices.data(), usage);
+        }
+        else {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), usage);
+        }
+    }
+
+private:
+    int stride;
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+
+    // open addressing, slot holds vertex index + 1, 0 is empty
+    std::vector<uint32_t> slots;
+
+    static uint32_t hashVertex(const float* vertex, int stride) {
+        uint32_t hash = 2166136261u;
+        const unsigned char* bytes = (const unsigned char*)vertex;
+        for (size_t i = 0; i < stride * sizeof(float); i++) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    uint32_t weld(const float* vertex) {
+        if ((vertexCount() + 1) * 2 > (int)slots.size()) {
+            rehash(std::max<size_t>(64, slots.size() * 2));
+        }
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hashVertex(vertex, stride) & mask;; slot = (slot + 1) & mask) {
+            if (slots[slot] == 0) {
+                uint32_t index = (uint32_t)vertexCount();
+                vertices.insert(vertices.end(), vertex, vertex + stride);
+                slots[slot] = index + 1;
+                return index;
+            }
+            if (memcmp(&vertices[(slots[slot] - 1) * (size_t)stride], vertex, stride * sizeof(float)) == 0) {
+                return slots[slot] - 1;
+            }
+        }
+    }
+
+    void rehash(size_t capacity) {
+        slots.assign(capacity, 0);
+        size_t mask = capacity - 1;
+        for (int i = 0; i < vertexCount(); i++) {
+            size_t slot = hashVertex(&vertices[(size_t)i * stride], stride) & mask;
+            while (slots[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = i + 1;
+        }
+    }
+
+    // Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+    static float vertexScore(int cachePosition, int remainingTriangles, int cacheSize) {
+        if (remainingTriangles == 0) {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                // the triangle just drawn, deliberately below the fresher cache entries
+                score = 0.75f;
+            }
+            else {
+                score = std::pow(1.0f - (float)(cachePosition - 3) / (cacheSize - 3), 1.5f);
+            }
+        }
+        // favour vertices with few triangles left so they don't get stranded
+        return score + 2.0f * std::pow((float)remainingTriangles, -0.5f);
+    }
+
+    void orderTriangles(int cacheSize) {
+        int triangles = triangleCount();
+        int verts = vertexCount();
+        if (triangles == 0) {
+            return;
+        }
+
+        // vertex -> triangles adjacency, compacted
+        std::vector<int> adjacencyStart(verts + 1, 0), remaining(verts, 0);
+        for (uint32_t index : indices) {
+            adjacencyStart[index + 1]++;
+        }
+        for (int v = 0; v < verts; v++) {
+            adjacencyStart[v + 1] += adjacencyStart[v];
+        }
+        std::vector<int> adjacency(indices.size()), fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (int t = 0; t < triangles; t++) {
+            for (int k = 0; k < 3; k++) {
+                adjacency[fill[indices[t * 3 + k]]++] = t;
+            }
+        }
+        for (int v = 0; v < verts; v++) {
+            remaining[v] = adjacencyStart[v + 1] - adjacencyStart[v];
+        }
+
+        std::vector<int> cachePosition(verts, -1);
+        std::vector<float> score(verts), triangleScore(triangles, 0.0f);
+        std::vector<bool> emitted(triangles, false);
+        for (int v = 0; v < verts; v++) {
+            score[v] = vertexScore(-1, remaining[v], cacheSize);
+        }
+        for (int t = 0; t < triangles; t++) {
+            for (int k = 0; k < 3; k++) {
+                triangleScore[t] += score[indices[t * 3 + k]];
+            }
+        }
+
+        std::vector<uint32_t> ordered;
+        ordered.reserve(indices.size());
+        std::vector<int> cache, nextCache;
+        int cursor = 0;
+        int best = -1;
+
+        while ((int)ordered.size() < (int)indices.size()) {
+            if (best < 0) {
+                // nothing in the cache touches a remaining triangle, take the best scored one left
+                while (emitted[cursor]) {
+                    cursor++;
+                }
+                best = cursor;
+                for (int t = cursor + 1; t < triangles; t++) {
+                    if (!emitted[t] && triangleScore[t] > triangleScore[best]) {
+                        best = t;
+                    }
+                }
+            }
+
+            emitted[best] = true;
+            nextCache.clear();
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[best * 3 + k];
+                ordered.push_back(v);
+                nextCache.push_back((int)v);
+
+                // drop the triangle from the vertex's remaining list
+                int* begin = &adjacency[adjacencyStart[v]];
+                int* end = begin + remaining[v];
+                *std::find(begin, end, best) = end[-1];
+                remaining[v]--;
+            }
+            for (int v : cache) {
+                if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+                    nextCache.push_back(v);
+                }
+            }
+
+            // rescore everything whose cache position changed, including the vertices that fell out
+            for (int i = 0; i < (int)nextCache.size(); i++) {
+                int v = nextCache[i];
+                cachePosition[v] = i < cacheSize ? i : -1;
+                float newScore = vertexScore(cachePosition[v], remaining[v], cacheSize);
+                float delta = newScore - score[v];
+                score[v] = newScore;
+                for (int a = 0; a < remaining[v]; a++) {
+                    triangleScore[adjacency[adjacencyStart[v] + a]] += delta;
+                }
+            }
+            nextCache.resize(std::min((int)nextCache.size(), cacheSize));
+            cache.swap(nextCache);
+
+            best = -1;
+            float bestScore = -1.0f;
+            for (int v : cache) {
+                for (int a = 0; a < remaining[v]; a++) {
+                    int t = adjacency[adjacencyStart[v] + a];
+                    if (triangleScore[t] > bestScore) {
+                        bestScore = triangleScore[t];
+                        best = t;
+                    }
+                }
+            }
+        }
+
+        indices.swap(ordered);
+    }
+
+    void orderVertices() {
+        std::vector<int> remap(vertexCount(), -1);
+        std::vector<float> ordered;
+        ordered.reserve(vertices.size());
+        for (uint32_t& index : indices) {
+            if (remap[index] < 0) {
+                remap[index] = (int)ordered.size() / stride;
+                ordered.insert(ordered.end(), &vertices[(size_t)index * stride], &vertices[(size_t)index * stride] + stride);
+            }
+            index = remap[index];
+        }
+        vertices.swap(ordered);
+        rehash(slots.size());
+    }
+};
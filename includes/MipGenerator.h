@@ -0,0 +1,340 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "Simd.h"
+#include "ThreadPool.h"
+
+/*
+* CPU mip chain for stb_image buffers (1 to 4 channels, any size), so the chain no longer depends on
+* glGenerateMipmap's driver defined filter and exists where there is no GL at all.
+*
+*     ThreadPool pool;
+*     MipGenerator mips(MIP_FILTER_KAISER, true, &pool);
+*     std::vector<std::vector<unsigned char>> levels = mips.generate(pixels, width, height, nrComponents);
+*     // levels[0] is mip level 1, every level is floor(size / 2) but at least 1 texel, like GL
+*
+* With srgb the color channels are decoded to linear light before filtering and encoded again afterwards,
+* alpha is always filtered as stored. The chain is carried in linear float from level to level, only the output
+* is rounded to 8 bits.
+* Box averages the source area under each output texel, which for odd sizes means fractional edge weights instead
+* of dropping a row. Kaiser is a windowed sinc (alpha 4, 3 output texels each way): sharper, with slight ringing
+* that is clamped on output.
+* Filtering is separable and runs in bands of output rows spread over the pool, each band decoding and narrowing only
+* the source rows it reads. The horizontal pass runs one texel per SSE2 register, the vertical pass runs along whole
+* rows with SSE2 or AVX2.
+*/
+
+enum MipFilter {
+    MIP_FILTER_BOX,
+    MIP_FILTER_KAISER
+};
+
+class MipGenerator {
+
+public:
+    explicit MipGenerator(MipFilter filter = MIP_FILTER_BOX, bool srgb = true, ThreadPool* pool = NULL)
+        : filter(filter), srgb(srgb), pool(pool) {
+    }
+
+    static int levelCount(int width, int height) {
+        int levels = 1;
+        while (width > 1 || height > 1) {
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+            levels++;
+        }
+        return levels;
+    }
+
+    // Levels 1 and below of pixels, largest first, at most maxLevels of them when it is above 0
+    std::vector<std::vector<unsigned char>> generate(const unsigned char* pixels, int width, int height, int components,
+        int maxLevels = 0) const {
+        // grey + alpha has one color channel, RGB(A) three
+        int colorChannels = !srgb ? 0 : components == 2 ? 1 : std::min(components, 3);
+        const float* decode[4];
+        for (int c = 0; c < components; c++) {
+            decode[c] = decodeTable(c < colorChannels);
+        }
+
+        std::vector<std::vector<unsigned char>> levels;
+        std::vector<float> level, next;
+        while ((width > 1 || height > 1) && (maxLevels <= 0 || (int)levels.size() < maxLevels)) {
+            int nextWidth = std::max(width / 2, 1), nextHeight = std::max(height / 2, 1);
+            // level 0 rows are decoded as bands need them, the levels after it stay in linear float
+            bool fromPixels = levels.empty();
+            int rowFloats = width * components;
+            auto sourceRow = [&](int y, float* buffer) -> const float* {
+                if (!fromPixels) {
+                    return &level[(size_t)y * rowFloats];
+                }
+                const unsigned char* in = pixels + (size_t)y * rowFloats;
+                for (int i = 0; i < rowFloats; i += components) {
+                    for (int c = 0; c < components; c++) {
+                        buffer[i + c] = decode[c][in[i + c]];
+                    }
+                }
+                return buffer;
+            };
+
+            levels.emplace_back((size_t)nextWidth * nextHeight * components);
+            // padded so the 3 channel SSE path can read a float past the last texel
+            next.resize((size_t)nextWidth * nextHeight * components + 4);
+            downsample(sourceRow, width, height, components, next.data(), levels.back().data(), nextWidth, nextHeight, colorChannels);
+            level.swap(next);
+            width = nextWidth;
+            height = nextHeight;
+        }
+        return levels;
+    }
+
+private:
+    static const int BAND_ROWS = 16;
+    static constexpr float KAISER_RADIUS = 3.0f; // in output texels
+    static constexpr float KAISER_ALPHA = 4.0f;
+    static const int LINEAR_TABLE_SIZE = 1 << 14;
+
+    // Source texels and weights for every output coordinate along one axis, taps padded to the same count
+    struct Kernel {
+        int taps;
+        std::vector<int> indices;
+        std::vector<float> weights;
+    };
+
+    MipFilter filter;
+    bool srgb;
+    ThreadPool* pool;
+
+    // Runs func(begin, end) over bands of rows, on the pool when there is one and enough rows to share
+    void forBands(int rows, const std::function<void(int, int)>& func) const {
+        int bands = (rows + BAND_ROWS - 1) / BAND_ROWS;
+        if (!pool || bands < 2) {
+            func(0, rows);
+            return;
+        }
+        pool->parallelFor(bands, [&](int band) {
+            func(band * BAND_ROWS, std::min((band + 1) * BAND_ROWS, rows));
+        });
+    }
+
+    static float besselI0(float x) {
+        float sum = 1.0f, term = 1.0f;
+        for (int k = 1; k < 20; k++) {
+            term *= (x / (2.0f * k)) * (x / (2.0f * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    static float kaiser(float t) {
+        if (std::fabs(t) >= KAISER_RADIUS) {
+            return 0.0f;
+        }
+        float sinc = t == 0.0f ? 1.0f : std::sin(3.14159265f * t) / (3.14159265f * t);
+        float window = t / KAISER_RADIUS;
+        return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0f - window * window)) / besselI0(KAISER_ALPHA);
+    }
+
+    Kernel buildKernel(int sourceSize, int destinationSize) const {
+        float scale = (float)sourceSize / destinationSize;
+        std::vector<std::vector<std::pair<int, float>>> taps(destinationSize);
+        for (int x = 0; x < destinationSize; x++) {
+            if (filter == MIP_FILTER_BOX) {
+                float begin = x * scale, end = (x + 1) * scale;
+                for (int s = (int)std::floor(begin); s < (int)std::ceil(end); s++) {
+                    float overlap = std::min(end, s + 1.0f) - std::max(begin, (float)s);
+                    if (overlap > 0.0f) {
+                        taps[x].push_back({ std::min(s, sourceSize - 1), overlap });
+                    }
+                }
+            }
+            else {
+                float center = (x + 0.5f) * scale;
+                int first = (int)std::floor(center - KAISER_RADIUS * scale), last = (int)std::ceil(center + KAISER_RADIUS * scale);
+                for (int s = first; s <= last; s++) {
+                    float weight = kaiser((s + 0.5f - center) / scale);
+                    if (weight != 0.0f) {
+                        // clamp to edge, repeated edge texels just collect more weight
+                        taps[x].push_back({ std::min(std::max(s, 0), sourceSize - 1), weight });
+                    }
+                }
+            }
+        }
+
+        Kernel kernel;
+        kernel.taps = 1;
+        for (const auto& list : taps) {
+            kernel.taps = std::max(kernel.taps, (int)list.size());
+        }
+        kernel.indices.assign((size_t)destinationSize * kernel.taps, 0);
+        kernel.weights.assign((size_t)destinationSize * kernel.taps, 0.0f);
+        for (int x = 0; x < destinationSize; x++) {
+            float sum = 0.0f;
+            for (const auto& tap : taps[x]) {
+                sum += tap.second;
+            }
+            for (size_t k = 0; k < taps[x].size(); k++) {
+                kernel.indices[(size_t)x * kernel.taps + k] = taps[x][k].first;
+                kernel.weights[(size_t)x * kernel.taps + k] = taps[x][k].second / sum;
+            }
+            // padding taps repeat the first index with weight 0
+            for (size_t k = taps[x].size(); k < (size_t)kernel.taps; k++) {
+                kernel.indices[(size_t)x * kernel.taps + k] = kernel.indices[(size_t)x * kernel.taps];
+            }
+        }
+        return kernel;
+    }
+
+    // One level down. Each band of output rows narrows just the source rows its vertical taps read into thread local
+    // scratch, so the only full size buffers are the output ones: linear floats for the next level and the 8 bit level
+    template <class SourceRow>
+    void downsample(SourceRow sourceRow, int width, int height, int components, float* destination, unsigned char* encoded,
+        int destinationWidth, int destinationHeight, int colorChannels) const {
+        Kernel horizontal = buildKernel(width, destinationWidth);
+        Kernel vertical = buildKernel(height, destinationHeight);
+        int rowFloats = destinationWidth * components;
+
+        forBands(destinationHeight, [&](int begin, int end) {
+            int firstRow = height, lastRow = 0;
+            for (size_t i = (size_t)begin * vertical.taps; i < (size_t)end * vertical.taps; i++) {
+                firstRow = std::min(firstRow, vertical.indices[i]);
+                lastRow = std::max(lastRow, vertical.indices[i]);
+            }
+            static thread_local std::vector<float> narrowed, rowBuffer;
+            narrowed.resize((size_t)(lastRow - firstRow + 1) * rowFloats + 4);
+            rowBuffer.resize((size_t)width * components + 4);
+
+            // horizontal: the source rows narrowed to destinationWidth
+            for (int y = firstRow; y <= lastRow; y++) {
+                const float* in = sourceRow(y, rowBuffer.data());
+                float* out = &narrowed[(size_t)(y - firstRow) * rowFloats];
+                for (int x = 0; x < destinationWidth; x++) {
+                    const int* indices = &horizontal.indices[(size_t)x * horizontal.taps];
+                    const float* weights = &horizontal.weights[(size_t)x * horizontal.taps];
+#ifdef SIMD_SSE2
+                    // 3 channels carry a fourth lane of junk that the next texel overwrites, except at the end of the row
+                    if (components == 4 || (components == 3 && x < destinationWidth - 1)) {
+                        __m128 sum = _mm_setzero_ps();
+                        for (int k = 0; k < horizontal.taps; k++) {
+                            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]), _mm_loadu_ps(in + indices[k] * components)));
+                        }
+                        _mm_storeu_ps(out + x * components, sum);
+                        continue;
+                    }
+#endif
+                    for (int c = 0; c < components; c++) {
+                        float sum = 0.0f;
+                        for (int k = 0; k < horizontal.taps; k++) {
+                            sum += weights[k] * in[indices[k] * components + c];
+                        }
+                        out[x * components + c] = sum;
+                    }
+                }
+            }
+
+            // vertical: weighted sums of whole narrowed rows, the first tap stores and the rest accumulate
+            for (int y = begin; y < end; y++) {
+                float* out = destination + (size_t)y * rowFloats;
+                for (int k = 0; k < vertical.taps; k++) {
+                    float weight = vertical.weights[(size_t)y * vertical.taps + k];
+                    const float* in = &narrowed[(size_t)(vertical.indices[(size_t)y * vertical.taps + k] - firstRow) * rowFloats];
+                    if (k == 0) {
+                        for (int i = 0; i < rowFloats; i++) {
+                            out[i] = weight * in[i];
+                        }
+                        continue;
+                    }
+                    if (weight == 0.0f) {
+                        continue;
+                    }
+                    int i = 0;
+#ifdef SIMD_AVX2
+                    __m256 weight8 = _mm256_set1_ps(weight);
+                    for (; i + 8 <= rowFloats; i += 8) {
+                        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(weight8, _mm256_loadu_ps(in + i), _mm256_loadu_ps(out + i)));
+                    }
+#endif
+#ifdef SIMD_SSE2
+                    __m128 weight4 = _mm_set1_ps(weight);
+                    for (; i + 4 <= rowFloats; i += 4) {
+                        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(weight4, _mm_loadu_ps(in + i))));
+                    }
+#endif
+                    for (; i < rowFloats; i++) {
+                        out[i] += weight * in[i];
+                    }
+                }
+            }
+
+            encode(destination + (size_t)begin * rowFloats, encoded + (size_t)begin * rowFloats, (size_t)(end - begin) * destinationWidth,
+                components, colorChannels);
+        });
+    }
+
+    static int tableIndex(float value) {
+        return (int)(std::min(std::max(value, 0.0f), 1.0f) * LINEAR_TABLE_SIZE + 0.5f);
+    }
+
+    // Linear floats back to 8 bits, sRGB encoded for the first colorChannels of every texel
+    static void encode(const float* in, unsigned char* out, size_t texels, int components, int colorChannels) {
+        const unsigned char* color = encodeTable(true);
+        const unsigned char* plain = encodeTable(false);
+        size_t count = texels * components, i = 0;
+        if (colorChannels == 0 || colorChannels == components) {
+            const unsigned char* table = colorChannels ? color : plain;
+#ifdef SIMD_SSE2
+            const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), scale = _mm_set1_ps((float)LINEAR_TABLE_SIZE);
+            alignas(16) int32_t indices[4];
+            for (; i + 4 <= count; i += 4) {
+                __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), zero), one);
+                _mm_store_si128((__m128i*)indices, _mm_cvtps_epi32(_mm_mul_ps(value, scale)));
+                out[i] = table[indices[0]];
+                out[i + 1] = table[indices[1]];
+                out[i + 2] = table[indices[2]];
+                out[i + 3] = table[indices[3]];
+            }
+#endif
+            for (; i < count; i++) {
+                out[i] = table[tableIndex(in[i])];
+            }
+            return;
+        }
+        for (; i < count; i += components) {
+            for (int c = 0; c < components; c++) {
+                out[i + c] = (c < colorChannels ? color : plain)[tableIndex(in[i + c])];
+            }
+        }
+    }
+
+    // 8 bit value to linear float, through the sRGB curve or not
+    static const float* decodeTable(bool srgbCurve) {
+        static const std::vector<float> table = [] {
+            std::vector<float> values(512);
+            for (int i = 0; i < 256; i++) {
+                float c = i / 255.0f;
+                values[i] = c;
+                values[256 + i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            return values;
+        }();
+        return table.data() + (srgbCurve ? 256 : 0);
+    }
+
+    // Over 14 bit linear values, fine enough that the steep part of the sRGB curve near black stays below half a step
+    static const unsigned char* encodeTable(bool srgbCurve) {
+        static const std::vector<unsigned char> table = [] {
+            std::vector<unsigned char> values(2 * (LINEAR_TABLE_SIZE + 1));
+            for (int i = 0; i <= LINEAR_TABLE_SIZE; i++) {
+                float l = (float)i / LINEAR_TABLE_SIZE;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                values[i] = (unsigned char)(l * 255.0f + 0.5f);
+                values[LINEAR_TABLE_SIZE + 1 + i] = (unsigned char)(c * 255.0f + 0.5f);
+            }
+            return values;
+        }();
+        return table.data() + (srgbCurve ? LINEAR_TABLE_SIZE + 1 : 0);
+    }
+};
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+/*
+* CPU zones and GPU timer queries, summarised with report() or written out as a Chrome trace
+* (chrome://tracing or https://ui.perfetto.dev).
+*
+*     Profiler::setEnabled(true);
+*     Profiler::setThreadName("GL thread");
+*     while (...) {
+*         PROFILE_ZONE("update");                 // CPU time until the end of the scope
+*         {
+*             PROFILE_GPU_ZONE("lines");          // CPU zone plus a GL_TIME_ELAPSED query around the same scope
+*             glDrawArrays(...);
+*         }
+*         Profiler::endFrame();                   // GL thread, once per frame
+*     }
+*     Profiler::release();                        // before the context goes away
+*     Profiler::exportTrace("trace.json");
+*
+* Zone names have to outlive the profiler, string literals. Zones cost nothing but a relaxed load while disabled.
+* Every thread records into its own ring buffer of the last RING_SIZE zones, only the owning thread writes to it so
+* recording takes no lock. Readers (report, exportTrace) copy a ring and throw away whatever the owner overwrote while
+* they were copying.
+* GPU zones can't nest, GL_TIME_ELAPSED queries don't: a GPU zone opened inside another only times its CPU side.
+* Each frame's queries are read back at the end of the frame after it and only if the driver has them ready, results
+* that aren't are dropped rather than waited for. The durations are the GPU's, a zone's place on the trace's GPU track is
+* where it was issued, pushed back past the previous zone's end.
+*/
+
+struct ProfileEvent {
+    const char* name;
+    uint64_t start;   // nanoseconds since the profiler's first timestamp
+    uint64_t end;
+};
+
+struct ProfileZoneSummary {
+    const char* name;
+    bool gpu;
+    int calls;
+    double totalMs;
+    double maxMs;
+};
+
+class Profiler {
+
+public:
+    static const int RING_SIZE = 1 << 16; // events per thread, a power of two
+    static const int QUERY_SETS = 2;      // frames of GPU queries in flight
+
+    static void setEnabled(bool enable) {
+        active.store(enable, std::memory_order_relaxed);
+    }
+
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    static uint64_t now() {
+        static const auto epoch = std::chrono::steady_clock::now();
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    // Label for the calling thread's track in the trace
+    static void setThreadName(const char* name) {
+        ThreadBuffer* buffer = localBuffer();
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        buffer->name = name;
+    }
+
+    static void record(const char* name, uint64_t start, uint64_t end) {
+        ThreadBuffer* buffer = localBuffer();
+        uint64_t index = buffer->written.load(std::memory_order_relaxed);
+        buffer->events[index & (RING_SIZE - 1)] = { name, start, end };
+        buffer->written.store(index + 1, std::memory_order_release);
+    }
+
+    // GL thread only, pair with endGpu(). Returns false when not timed (disabled, or inside another GPU zone)
+    static bool beginGpu(const char* name) {
+        if (!enabled() || gpuOpen) {
+            return false;
+        }
+        std::vector<GpuQuery>& set = querySets[frame % QUERY_SETS];
+        if (queriesUsed == (int)set.size()) {
+            GpuQuery query = { 0, NULL, 0 };
+            glGenQueries(1, &query.id);
+            set.push_back(query);
+        }
+        GpuQuery& query = set[queriesUsed++];
+        query.name = name;
+        query.issued = now();
+        glBeginQuery(GL_TIME_ELAPSED, query.id);
+        gpuOpen = true;
+        return true;
+    }
+
+    static void endGpu() {
+        glEndQuery(GL_TIME_ELAPSED);
+        gpuOpen = false;
+    }
+
+    // Records a "frame" zone since the last call, then collects the query set about to be reused
+    static void endFrame() {
+        uint64_t time = now();
+        if (enabled() && frameStart) {
+            record("frame", frameStart, time);
+        }
+        frameStart = time;
+
+        querySetUsed[frame % QUERY_SETS] = queriesUsed;
+        frame++;
+        std::vector<GpuQuery>& set = querySets[frame % QUERY_SETS];
+        for (int i = 0; i < querySetUsed[frame % QUERY_SETS]; i++) {
+            GLint available = 0;
+            glGetQueryObjectiv(set[i].id, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                gpuDropped++;
+                continue;
+            }
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(set[i].id, GL_QUERY_RESULT, &elapsed);
+            uint64_t start = std::max(set[i].issued, gpuEnd);
+            gpuEnd = start + elapsed;
+            gpuEvents[gpuWritten++ & (RING_SIZE - 1)] = { set[i].name, start, gpuEnd };
+        }
+        queriesUsed = 0;
+    }
+
+    // Deletes the query objects, recorded zones stay readable
+    static void release() {
+        for (std::vector<GpuQuery>& set : querySets) {
+            for (GpuQuery& query : set) {
+                glDeleteQueries(1, &query.id);
+            }
+            set.clear();
+        }
+        for (int& used : querySetUsed) {
+            used = 0;
+        }
+        queriesUsed = 0;
+        gpuOpen = false;
+    }
+
+    // Every zone still in the rings, by name, most total time first
+    static std::vector<ProfileZoneSummary> summarize() {
+        std::vector<ProfileZoneSummary> summaries;
+        std::unordered_map<const char*, size_t> cpuIndex, gpuIndex;
+        auto add = [&summaries](std::unordered_map<const char*, size_t>& index, const ProfileEvent& event, bool gpu) {
+            auto found = index.find(event.name);
+            if (found == index.end()) {
+                found = index.emplace(event.name, summaries.size()).first;
+                summaries.push_back({ event.name, gpu, 0, 0.0, 0.0 });
+            }
+            ProfileZoneSummary& summary = summaries[found->second];
+            double ms = (event.end - event.start) / 1e6;
+            summary.calls++;
+            summary.totalMs += ms;
+            summary.maxMs = std::max(summary.maxMs, ms);
+        };
+        for (const ThreadSnapshot& thread : snapshotThreads()) {
+            for (const ProfileEvent& event : thread.events) {
+                add(cpuIndex, event, false);
+            }
+        }
+        for (const ProfileEvent& event : snapshotGpu()) {
+            add(gpuIndex, event, true);
+        }
+        std::sort(summaries.begin(), summaries.end(), [](const ProfileZoneSummary& a, const ProfileZoneSummary& b) {
+            return a.totalMs > b.totalMs;
+        });
+        return summaries;
+    }
+
+    static void report() {
+        std::vector<ProfileZoneSummary> summaries = summarize();
+        printf("profiler: %llu frames, %d GPU results dropped (not ready %d frame later)\n", (unsigned long long)frame,
+            gpuDropped, QUERY_SETS - 1);
+        printf("  %-28s %4s %9s %11s %11s %11s\n", "zone", "", "calls", "total ms", "mean us", "max us");
+        for (const ProfileZoneSummary& summary : summaries) {
+            printf("  %-28s %4s %9d %11.3f %11.2f %11.2f\n", summary.name, summary.gpu ? "gpu" : "cpu", summary.calls,
+                summary.totalMs, summary.totalMs * 1000.0 / summary.calls, summary.maxMs * 1000.0);
+        }
+    }
+
+    // Chrome trace_event JSON, one track per thread plus one for the GPU
+    static bool exportTrace(const char* path) {
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            std::cout << "ERROR::PROFILER::FILE_NOT_WRITTEN " << path << std::endl;
+            return false;
+        }
+        fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        const char* separator = "";
+        auto writeEvent = [&](const ProfileEvent& event, int tid, const char* category) {
+            fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", separator,
+                escape(event.name).c_str(), category, tid, event.start / 1000.0, (event.end - event.start) / 1000.0);
+            separator = ",\n";
+        };
+        auto writeName = [&](int tid, const std::string& name) {
+            fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", separator, tid,
+                escape(name.c_str()).c_str());
+            separator = ",\n";
+        };
+
+        size_t events = 0;
+        for (const ThreadSnapshot& thread : snapshotThreads()) {
+            writeName(thread.tid, thread.name);
+            for (const ProfileEvent& event : thread.events) {
+                writeEvent(event, thread.tid, "cpu");
+            }
+            events += thread.events.size();
+        }
+        std::vector<ProfileEvent> gpu = snapshotGpu();
+        writeName(0, "GPU");
+        for (const ProfileEvent& event : gpu) {
+            writeEvent(event, 0, "gpu");
+        }
+        events += gpu.size();
+        fprintf(file, "\n]}\n");
+        bool written = !ferror(file);
+        fclose(file);
+        if (!written) {
+            std::cout << "ERROR::PROFILER::FILE_NOT_WRITTEN " << path << std::endl;
+            return false;
+        }
+        printf("profiler: %zu zones written to %s\n", events, path);
+        return true;
+    }
+
+private:
+    struct ThreadBuffer {
+        std::atomic<uint64_t> written{ 0 };
+        std::unique_ptr<ProfileEvent[]> events{ new ProfileEvent[RING_SIZE] };
+        int tid = 0;
+        std::string name;
+    };
+
+    struct ThreadSnapshot {
+        int tid;
+        std::string name;
+        std::vector<ProfileEvent> events;
+    };
+
+    struct GpuQuery {
+        unsigned int id;
+        const char* name;
+        uint64_t issued;
+    };
+
+    inline static std::atomic<bool> active{ false };
+
+    // buffers live as long as the process, a thread that exits leaves its zones readable
+    inline static std::mutex threadsMutex;
+    inline static std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+    // GL thread state
+    inline static std::vector<GpuQuery> querySets[QUERY_SETS];
+    inline static int querySetUsed[QUERY_SETS] = {};
+    inline static int queriesUsed = 0;
+    inline static bool gpuOpen = false;
+    inline static uint64_t frame = 0;
+    inline static uint64_t frameStart = 0;
+    inline static uint64_t gpuEnd = 0;
+    inline static int gpuDropped = 0;
+    inline static std::unique_ptr<ProfileEvent[]> gpuEvents{ new ProfileEvent[RING_SIZE] };
+    inline static uint64_t gpuWritten = 0;
+
+    static ThreadBuffer* localBuffer() {
+        thread_local ThreadBuffer* buffer = NULL;
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(threadsMutex);
+            threads.push_back(std::make_unique<ThreadBuffer>());
+            buffer = threads.back().get();
+            buffer->tid = (int)threads.size();
+            buffer->name = "thread " + std::to_string(buffer->tid);
+        }
+        return buffer;
+    }
+
+    // The newest RING_SIZE events, minus any the owner overwrote during the copy
+    static std::vector<ThreadSnapshot> snapshotThreads() {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        std::vector<ThreadSnapshot> snapshots;
+        for (const std::unique_ptr<ThreadBuffer>& buffer : threads) {
+            ThreadSnapshot snapshot = { buffer->tid, buffer->name, {} };
+            uint64_t end = buffer->written.load(std::memory_order_acquire);
+            uint64_t begin = end > (uint64_t)RING_SIZE ? end - RING_SIZE : 0;
+            std::vector<ProfileEvent> copied;
+            for (uint64_t i = begin; i < end; i++) {
+                copied.push_back(buffer->events[i & (RING_SIZE - 1)]);
+            }
+            uint64_t after = buffer->written.load(std::memory_order_acquire);
+            // the owner may be writing event number after right now, which shares a slot with after - RING_SIZE
+            uint64_t firstIntact = after + 1 > (uint64_t)RING_SIZE ? after + 1 - RING_SIZE : 0;
+            for (uint64_t i = std::max(begin, firstIntact); i < end; i++) {
+                snapshot.events.push_back(copied[i - begin]);
+            }
+            snapshots.push_back(std::move(snapshot));
+        }
+        return snapshots;
+    }
+
+    static std::vector<ProfileEvent> snapshotGpu() {
+        uint64_t begin = gpuWritten > (uint64_t)RING_SIZE ? gpuWritten - RING_SIZE : 0;
+        std::vector<ProfileEvent> events;
+        for (uint64_t i = begin; i < gpuWritten; i++) {
+            events.push_back(gpuEvents[i & (RING_SIZE - 1)]);
+        }
+        return events;
+    }
+
+    static std::string escape(const char* text) {
+        std::string escaped;
+        for (const char* c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                escaped += '\\';
+                escaped += *c;
+            }
+            else if ((unsigned char)*c < 0x20) {
+                escaped += ' ';
+            }
+            else {
+                escaped += *c;
+            }
+        }
+        return escaped;
+    }
+};
+
+// CPU time from construction to the end of the scope
+class ProfileZone {
+
+public:
+    explicit ProfileZone(const char* name) : name(name), recording(Profiler::enabled()), start(recording ? Profiler::now() : 0) {
+    }
+
+    ~ProfileZone() {
+        if (recording) {
+            Profiler::record(name, start, Profiler::now());
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    bool recording;
+    uint64_t start;
+};
+
+// ProfileZone plus a GL_TIME_ELAPSED query over the same scope, GL thread only
+class GpuProfileZone {
+
+public:
+    explicit GpuProfileZone(const char* name) : cpu(name), timed(Profiler::beginGpu(name)) {
+    }
+
+    ~GpuProfileZone() {
+        if (timed) {
+            Profiler::endGpu();
+        }
+    }
+
+    GpuProfileZone(const GpuProfileZone&) = delete;
+    GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+
+private:
+    ProfileZone cpu;
+    bool timed;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name) GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(name)
@@ -0,0 +1,503 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include "Shader.h"
+#include "GLStateCache.h"
+#include "Profiler.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+/*
+* Deferred draw submission. Draws are recorded as packets in a linear arena during the frame, sorted on a
+* 64 bit key and submitted in one pass through a GLStateCache.
+*
+*     RenderQueue queue;
+*     queue.setDepthRange(0.1f, 100.0f);
+*     queue.frameUniform(shader.ID, viewUniform, view);      // once per program per flush
+*     queue.begin(shader.ID, VAO, glm::length(position - camera.Pos));
+*     queue.texture(0, diffuseMap);
+*     queue.uniform(modelUniform, model);
+*     queue.drawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType());
+*     ...
+*     queue.flush(glState);
+*
+* Opaque key, most significant first: layer 2 | program 12 | texture set 12 | vertex array 12 | depth 24 | 2 unused,
+* so programs switch least, then textures, then VAOs, and each run of equal state draws front to back for early Z.
+* The transparent layer puts depth right after the layer, inverted, for back to front blending.
+* Program, texture set and VAO fields are slots numbered in first seen order, not the GL names.
+*
+* Uniforms set by a packet stay set on its program for the packets after it, whatever order they end up in,
+* so anything a packet changes has to be set by every packet of that program.
+* With the Profiler enabled every draw is a GPU zone, named with name() after begin().
+*/
+
+enum RenderLayer {
+    RENDER_LAYER_OPAQUE = 0,
+    RENDER_LAYER_TRANSPARENT = 1
+};
+
+// State changes the sorted order needed against the order the draws were recorded in
+struct RenderQueueStats {
+    int packets;
+    int uniforms;
+    int programSwitches, recordedProgramSwitches;
+    int vertexArraySwitches, recordedVertexArraySwitches;
+    int textureBinds, recordedTextureBinds;
+    double sortMicroseconds;
+    double submitMicroseconds;
+    size_t arenaBytes;
+
+    int saved() const {
+        return recordedProgramSwitches + recordedVertexArraySwitches + recordedTextureBinds
+            - programSwitches - vertexArraySwitches - textureBinds;
+    }
+};
+
+// Bump allocator that is reset instead of freed. Hands out offsets, not pointers, so growing it keeps them valid
+class LinearArena {
+
+public:
+    uint32_t allocate(size_t size, size_t alignment = 8) {
+        size_t offset = (used + alignment - 1) & ~(alignment - 1);
+        if (offset + size > memory.size()) {
+            memory.resize(std::max(memory.size() * 2, std::max<size_t>(offset + size, 4096)));
+        }
+        used = offset + size;
+        return (uint32_t)offset;
+    }
+
+    template<class T>
+    T* at(uint32_t offset) {
+        return (T*)&memory[offset];
+    }
+
+    void reset() {
+        used = 0;
+    }
+
+    size_t size() const {
+        return used;
+    }
+
+    size_t capacity() const {
+        return memory.size();
+    }
+
+private:
+    std::vector<unsigned char> memory;
+    size_t used = 0;
+};
+
+class RenderQueue {
+
+public:
+    static const int MAX_TEXTURES = 4;
+
+    RenderQueue() {
+        memset(&stats, 0, sizeof(stats));
+        beginFrame();
+    }
+
+    // Depth is quantized to 24 bits across this range, anything outside is clamped
+    void setDepthRange(float nearDistance, float farDistance) {
+        depthNear = nearDistance;
+        depthFar = farDistance;
+    }
+
+    // Uniforms shared by every packet of a program (view, projection, lights), uploaded once when the program is first bound
+    template<class T>
+    void frameUniform(GLuint program, UniformHandle handle, const T& value) {
+        if (!handle.valid()) {
+            return;
+        }
+        ProgramUniforms* entry = NULL;
+        for (ProgramUniforms& candidate : programUniforms) {
+            if (candidate.program == program) {
+                entry = &candidate;
+            }
+        }
+        if (!entry) {
+            programUniforms.push_back({ program, NONE, NONE });
+            entry = &programUniforms.back();
+        }
+        appendUniform(entry->first, entry->last, handle.location, value);
+    }
+
+    // Starts a packet, texture() and uniform() calls belong to it until the draw call closes it
+    void begin(GLuint program, GLuint vertexArray, float depth = 0.0f, RenderLayer layer = RENDER_LAYER_OPAQUE) {
+        open = arena.allocate(sizeof(Packet));
+        Packet* packet = arena.at<Packet>(open);
+        memset(packet, 0, sizeof(Packet));
+        packet->program = program;
+        packet->vertexArray = vertexArray;
+        packet->depth = depth;
+        packet->layer = layer;
+        packet->firstUniform = NONE;
+        packet->lastUniform = NONE;
+        packet->name = "RenderQueue::draw";
+    }
+
+    // Profiler zone name for the open packet's draw, a string literal
+    void name(const char* zone) {
+        arena.at<Packet>(open)->name = zone;
+    }
+
+    void texture(int unit, GLuint id, GLenum target = GL_TEXTURE_2D) {
+        Packet* packet = arena.at<Packet>(open);
+        if (packet->textureCount == MAX_TEXTURES) {
+            std::cout << "ERROR::RENDER_QUEUE::TOO_MANY_TEXTURES" << std::endl;
+            return;
+        }
+        packet->textures[packet->textureCount++] = { unit, target, id };
+    }
+
+    template<class T>
+    void uniform(UniformHandle handle, const T& value) {
+        if (!handle.valid()) {
+            return;
+        }
+        Packet* packet = arena.at<Packet>(open);
+        uint32_t first = packet->firstUniform, last = packet->lastUniform;
+        appendUniform(first, last, handle.location, value);
+        // the arena may have moved
+        packet = arena.at<Packet>(open);
+        packet->firstUniform = first;
+        packet->lastUniform = last;
+    }
+
+    // indexType 0 draws arrays from first
+    void drawElements(GLenum mode, int count, GLenum indexType, int instances = 1) {
+        close(mode, 0, count, indexType, instances);
+    }
+
+    void drawArrays(GLenum mode, int first, int count, int instances = 1) {
+        close(mode, first, count, 0, instances);
+    }
+
+    // Sorts and submits everything recorded since the last flush, then resets the arena
+    const RenderQueueStats& flush(GLStateCache& state) {
+        PROFILE_ZONE("RenderQueue::flush");
+        memset(&stats, 0, sizeof(stats));
+        stats.packets = (int)packets.size();
+        stats.arenaBytes = arena.size();
+
+        countSwitches(packets, stats.recordedProgramSwitches, stats.recordedVertexArraySwitches, stats.recordedTextureBinds);
+
+        auto sortStart = std::chrono::high_resolution_clock::now();
+        radixSort();
+        auto sortEnd = std::chrono::high_resolution_clock::now();
+
+        std::vector<uint32_t>& sorted = sortedPackets;
+        sorted.resize(packets.size());
+        for (size_t i = 0; i < packets.size(); i++) {
+            sorted[i] = packets[sortIndices[i]];
+        }
+        countSwitches(sorted, stats.programSwitches, stats.vertexArraySwitches, stats.textureBinds);
+
+        GLuint currentProgram = NONE;
+        for (uint32_t offset : sorted) {
+            Packet* packet = arena.at<Packet>(offset);
+            if (packet->program != currentProgram) {
+                currentProgram = packet->program;
+                state.useProgram(currentProgram);
+                PROFILE_ZONE("RenderQueue::frameUniforms");
+                for (ProgramUniforms& entry : programUniforms) {
+                    if (entry.program == currentProgram && entry.first != NONE) {
+                        applyUniforms(entry.first);
+                        entry.first = NONE; // applied, the program keeps them for the rest of the flush
+                    }
+                }
+            }
+            GpuProfileZone drawZone(packet->name);
+            state.bindVertexArray(packet->vertexArray);
+            for (int t = 0; t < packet->textureCount; t++) {
+                state.bindTexture(packet->textures[t].unit, packet->textures[t].target, packet->textures[t].id);
+            }
+            {
+                PROFILE_ZONE("RenderQueue::uniforms");
+                applyUniforms(packet->firstUniform);
+            }
+
+            if (packet->indexType) {
+                if (packet->instances > 1) {
+                    glDrawElementsInstanced(packet->mode, packet->count, packet->indexType, 0, packet->instances);
+                }
+                else {
+                    glDrawElements(packet->mode, packet->count, packet->indexType, 0);
+                }
+            }
+            else if (packet->instances > 1) {
+                glDrawArraysInstanced(packet->mode, packet->first, packet->count, packet->instances);
+            }
+            else {
+                glDrawArrays(packet->mode, packet->first, packet->count);
+            }
+        }
+        auto submitEnd = std::chrono::high_resolution_clock::now();
+
+        stats.sortMicroseconds = std::chrono::duration<double, std::micro>(sortEnd - sortStart).count();
+        stats.submitMicroseconds = std::chrono::duration<double, std::micro>(submitEnd - sortEnd).count();
+        stats.uniforms = uniformsApplied;
+
+        frames++;
+        totalSaved += stats.saved();
+        totalRecorded += stats.recordedProgramSwitches + stats.recordedVertexArraySwitches + stats.recordedTextureBinds;
+        beginFrame();
+        return stats;
+    }
+
+    const RenderQueueStats& lastStats() const {
+        return stats;
+    }
+
+    // The last flush, plus the switches saved over every flush so far
+    void report() const {
+        printf("render queue: %d packets, %d uniforms, arena %zu bytes, sort %.1f us, submit %.1f us\n", stats.packets,
+            stats.uniforms, stats.arenaBytes, stats.sortMicroseconds, stats.submitMicroseconds);
+        printf("  state switches recorded -> sorted: program %d -> %d, vertex array %d -> %d, texture %d -> %d\n",
+            stats.recordedProgramSwitches, stats.programSwitches, stats.recordedVertexArraySwitches, stats.vertexArraySwitches,
+            stats.recordedTextureBinds, stats.textureBinds);
+        printf("  %lld flushes, %.2f switches saved per frame of %.2f\n", frames, frames ? (double)totalSaved / frames : 0.0,
+            frames ? (double)totalRecorded / frames : 0.0);
+    }
+
+private:
+    static const uint32_t NONE = 0xFFFFFFFFu;
+
+    enum UniformType : uint16_t {
+        UNIFORM_FLOAT,
+        UNIFORM_INT,
+        UNIFORM_VEC3,
+        UNIFORM_VEC4,
+        UNIFORM_MAT3,
+        UNIFORM_MAT4
+    };
+
+    // followed by the value
+    struct UniformRecord {
+        int location;
+        UniformType type;
+        uint32_t next;
+    };
+
+    struct TextureBinding {
+        int unit;
+        GLenum target;
+        GLuint id;
+    };
+
+    struct Packet {
+        GLuint program;
+        GLuint vertexArray;
+        TextureBinding textures[MAX_TEXTURES];
+        int textureCount;
+        float depth;
+        RenderLayer layer;
+        uint32_t firstUniform, lastUniform;
+        GLenum mode;
+        GLenum indexType;
+        int first, count, instances;
+        const char* name;   // profiler zone of the draw
+    };
+
+    struct ProgramUniforms {
+        GLuint program;
+        uint32_t first, last;
+    };
+
+    LinearArena arena;
+    uint32_t open = NONE;
+    std::vector<uint32_t> packets;       // arena offsets in recorded order
+    std::vector<uint64_t> keys, keyScratch;
+    std::vector<uint32_t> sortIndices, indexScratch, sortedPackets;
+    std::vector<ProgramUniforms> programUniforms;
+
+    // first seen order slots for the key
+    std::vector<GLuint> programSlots, vertexArraySlots;
+    std::vector<uint64_t> textureSetSlots;
+
+    float depthNear = 0.1f, depthFar = 100.0f;
+    int uniformsApplied = 0;
+
+    RenderQueueStats stats;
+    long long frames = 0, totalSaved = 0, totalRecorded = 0;
+
+    void beginFrame() {
+        arena.reset();
+        packets.clear();
+        keys.clear();
+        programUniforms.clear();
+        programSlots.clear();
+        vertexArraySlots.clear();
+        textureSetSlots.clear();
+        open = NONE;
+        uniformsApplied = 0;
+    }
+
+    static size_t uniformSize(const float&) { return sizeof(float); }
+    static size_t uniformSize(const int&) { return sizeof(int); }
+    static size_t uniformSize(const glm::vec3&) { return sizeof(glm::vec3); }
+    static size_t uniformSize(const glm::vec4&) { return sizeof(glm::vec4); }
+    static size_t uniformSize(const glm::mat3&) { return sizeof(glm::mat3); }
+    static size_t uniformSize(const glm::mat4&) { return sizeof(glm::mat4); }
+
+    static UniformType uniformType(const float&) { return UNIFORM_FLOAT; }
+    static UniformType uniformType(const int&) { return UNIFORM_INT; }
+    static UniformType uniformType(const glm::vec3&) { return UNIFORM_VEC3; }
+    static UniformType uniformType(const glm::vec4&) { return UNIFORM_VEC4; }
+    static UniformType uniformType(const glm::mat3&) { return UNIFORM_MAT3; }
+    static UniformType uniformType(const glm::mat4&) { return UNIFORM_MAT4; }
+
+    template<class T>
+    void appendUniform(uint32_t& first, uint32_t& last, int location, const T& value) {
+        uint32_t offset = arena.allocate(sizeof(UniformRecord) + uniformSize(value));
+        UniformRecord* record = arena.at<UniformRecord>(offset);
+        record->location = location;
+        record->type = uniformType(value);
+        record->next = NONE;
+        memcpy(record + 1, &value, uniformSize(value));
+        if (last != NONE) {
+            arena.at<UniformRecord>(last)->next = offset;
+        }
+        else {
+            first = offset;
+        }
+        last = offset;
+    }
+
+    void applyUniforms(uint32_t offset) {
+        while (offset != NONE) {
+            UniformRecord* record = arena.at<UniformRecord>(offset);
+            const float* value = (const float*)(record + 1);
+            switch (record->type) {
+            case UNIFORM_FLOAT: glUniform1f(record->location, *value); break;
+            case UNIFORM_INT: glUniform1i(record->location, *(const int*)value); break;
+            case UNIFORM_VEC3: glUniform3fv(record->location, 1, value); break;
+            case UNIFORM_VEC4: glUniform4fv(record->location, 1, value); break;
+            case UNIFORM_MAT3: glUniformMatrix3fv(record->location, 1, GL_FALSE, value); break;
+            case UNIFORM_MAT4: glUniformMatrix4fv(record->location, 1, GL_FALSE, value); break;
+            }
+            uniformsApplied++;
+            offset = record->next;
+        }
+    }
+
+    template<class T>
+    static uint64_t slot(std::vector<T>& slots, T value) {
+        for (size_t i = 0; i < slots.size(); i++) {
+            if (slots[i] == value) {
+                return i;
+            }
+        }
+        slots.push_back(value);
+        return slots.size() - 1;
+    }
+
+    void close(GLenum mode, int first, int count, GLenum indexType, int instances) {
+        Packet* packet = arena.at<Packet>(open);
+        packet->mode = mode;
+        packet->first = first;
+        packet->count = count;
+        packet->indexType = indexType;
+        packet->instances = instances;
+
+        // FNV-1a over the bindings stands in for the texture set
+        uint64_t textureSet = 14695981039346656037ull;
+        for (int t = 0; t < packet->textureCount; t++) {
+            uint64_t words[3] = { (uint64_t)packet->textures[t].unit, packet->textures[t].target, packet->textures[t].id };
+            for (uint64_t word : words) {
+                textureSet = (textureSet ^ word) * 1099511628211ull;
+            }
+        }
+
+        const uint64_t fieldMask = 0xFFF;
+        uint64_t program = slot(programSlots, packet->program) & fieldMask;
+        uint64_t textures = slot(textureSetSlots, textureSet) & fieldMask;
+        uint64_t vertexArray = slot(vertexArraySlots, packet->vertexArray) & fieldMask;
+        float range = depthFar > depthNear ? depthFar - depthNear : 1.0f;
+        uint64_t depth = (uint64_t)(glm::clamp((packet->depth - depthNear) / range, 0.0f, 1.0f) * 16777215.0f);
+
+        uint64_t key = (uint64_t)packet->layer << 62;
+        if (packet->layer == RENDER_LAYER_TRANSPARENT) {
+            key |= ((16777215 - depth) << 38) | (program << 26) | (textures << 14) | (vertexArray << 2);
+        }
+        else {
+            key |= (program << 50) | (textures << 38) | (vertexArray << 26) | (depth << 2);
+        }
+
+        packets.push_back(open);
+        keys.push_back(key);
+        open = NONE;
+    }
+
+    // LSD radix sort of the keys, 8 bits per pass, skipping the passes where every key has the same digit
+    void radixSort() {
+        size_t count = keys.size();
+        sortIndices.resize(count);
+        indexScratch.resize(count);
+        keyScratch.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            sortIndices[i] = (uint32_t)i;
+        }
+
+        for (int shift = 0; shift < 64; shift += 8) {
+            size_t histogram[256] = {};
+            for (size_t i = 0; i < count; i++) {
+                histogram[(keys[i] >> shift) & 0xFF]++;
+            }
+            if (count == 0 || histogram[(keys[0] >> shift) & 0xFF] == count) {
+                continue;
+            }
+            size_t offset = 0;
+            for (int digit = 0; digit < 256; digit++) {
+                size_t bucket = histogram[digit];
+                histogram[digit] = offset;
+                offset += bucket;
+            }
+            for (size_t i = 0; i < count; i++) {
+                size_t destination = histogram[(keys[i] >> shift) & 0xFF]++;
+                keyScratch[destination] = keys[i];
+                indexScratch[destination] = sortIndices[i];
+            }
+            keys.swap(keyScratch);
+            sortIndices.swap(indexScratch);
+        }
+    }
+
+    // Driver calls a submission in this order would make without any filtering below it
+    void countSwitches(const std::vector<uint32_t>& order, int& programSwitches, int& vertexArraySwitches, int& textureBinds) {
+        programSwitches = vertexArraySwitches = textureBinds = 0;
+        GLuint program = NONE, vertexArray = NONE;
+        std::vector<std::pair<int, GLuint>> bound;
+        for (uint32_t offset : order) {
+            Packet* packet = arena.at<Packet>(offset);
+            programSwitches += packet->program != program;
+            vertexArraySwitches += packet->vertexArray != vertexArray;
+            program = packet->program;
+            vertexArray = packet->vertexArray;
+            for (int t = 0; t < packet->textureCount; t++) {
+                const TextureBinding& binding = packet->textures[t];
+                bool found = false;
+                for (auto& unit : bound) {
+                    if (unit.first == binding.unit) {
+                        textureBinds += unit.second != binding.id;
+                        unit.second = binding.id;
+                        found = true;
+                    }
+                }
+                if (!found) {
+                    bound.push_back({ binding.unit, binding.id });
+                    textureBinds++;
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+
+#include <glm/glm.hpp>
+
+/*
+* A colour render target that follows the window size without reallocating on every resize event.
+*
+*     ResizableTarget target;
+*     target.create(width, height, glState);
+*     ... framebuffer size callback:  target.resize(width, height);   // only records the size
+*     while (...) {
+*         target.update(glState);                 // once per frame, before drawing into it
+*         target.bind(glState);                   // its framebuffer and a viewport of the used region
+*         ... draw ...
+*         glState.bindTexture(0, GL_TEXTURE_2D, target.texture());
+*         ... sample with texture coordinates scaled by target.region() ...
+*     }
+*     target.report();
+*
+* Storage comes in buckets, the next power of two or one and a half times a power of two on each side (800x600 gets
+* 1024x768), and the target only draws into the window sized corner of it, so most resizes just move the viewport.
+* Growing past the bucket, or shrinking to a quarter of its area, reallocates, but not until the resize events have
+* stopped for debounceMs: a drag resize fires dozens of them a second. Until then the region is clamped to the old
+* storage and stretched over the window, for at most maxDeferMs. Storage is immutable (glTexStorage2D) where available, and what was drawn so
+* far is blitted across so accumulated content survives the reallocation.
+* Exact is the old behaviour, glTexImage2D at the window size every time the size changes (so mutable storage and
+* no copy), kept to compare against.
+* Allocating binds through the state cache, the texture on unit 0.
+*/
+
+struct ResizableTargetStats {
+    long long requests;      // resize() calls
+    long long applied;       // sizes the region actually changed to
+    long long allocations;   // storage (re)allocations, including the first
+    long long deferred;      // updates that drew clamped while a reallocation waited for the events to settle
+    double allocationMs;     // CPU time spent in allocations, the driver may do more later
+    double maxAllocationMs;
+    size_t storageBytes;
+    size_t allocatedBytes;   // summed over every allocation
+};
+
+class ResizableTarget {
+
+public:
+    enum Policy { Bucketed, Exact };
+
+    double debounceMs = 100.0;
+    double maxDeferMs = 500.0;   // a drag that never pauses still gets its storage this often
+    int minimumBucket = 256;
+
+    bool create(int width, int height, GLStateCache& state, Policy resizePolicy = Bucketed) {
+        release();
+        policy = resizePolicy;
+        memset(&stats, 0, sizeof(stats));
+        viewWidth = std::max(width, 1);
+        viewHeight = std::max(height, 1);
+        pending = deferring = false;
+        if (policy == Exact) {
+            allocate(viewWidth, viewHeight, state);
+        }
+        else {
+            allocate(bucket(viewWidth), bucket(viewHeight), state);
+        }
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    void release() {
+        if (FBO) {
+            glDeleteFramebuffers(1, &FBO);
+            glDeleteTextures(1, &colorTexture);
+        }
+        FBO = colorTexture = 0;
+        storageWidth = storageHeight = 0;
+    }
+
+    // Cheap enough to call from the size callback, the work happens in update()
+    void resize(int width, int height) {
+        stats.requests++;
+        if (width <= 0 || height <= 0) {
+            return; // minimised
+        }
+        pendingWidth = width;
+        pendingHeight = height;
+        pending = true;
+        lastRequest = clock::now();
+    }
+
+    // True when the storage was reallocated
+    bool update(GLStateCache& state) {
+        if (!pending) {
+            return false;
+        }
+        bool allocated = false;
+        if (policy == Exact) {
+            respecify(pendingWidth, pendingHeight, state);
+            allocated = true;
+            pending = false;
+        }
+        else {
+            int wantedWidth = bucket(pendingWidth), wantedHeight = bucket(pendingHeight);
+            bool grow = pendingWidth > storageWidth || pendingHeight > storageHeight;
+            bool shrink = (size_t)wantedWidth * wantedHeight * 4 <= (size_t)storageWidth * storageHeight;
+            if (grow || shrink) {
+                clock::time_point now = clock::now();
+                if (!deferring) {
+                    deferring = true;
+                    deferredSince = now;
+                }
+                double sinceRequest = std::chrono::duration<double, std::milli>(now - lastRequest).count();
+                double sinceDeferred = std::chrono::duration<double, std::milli>(now - deferredSince).count();
+                if (sinceRequest >= debounceMs || sinceDeferred >= maxDeferMs) {
+                    allocate(wantedWidth, wantedHeight, state);
+                    allocated = true;
+                }
+                else {
+                    stats.deferred++;
+                }
+            }
+            pending = (grow || shrink) && !allocated;
+            deferring = pending;
+        }
+        setView(std::min(pendingWidth, storageWidth), std::min(pendingHeight, storageHeight));
+        return allocated;
+    }
+
+    // The framebuffer, with the viewport over the region in use
+    void bind(GLStateCache& state) const {
+        state.bindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glViewport(0, 0, viewWidth, viewHeight);
+    }
+
+    // Texture coordinates of the region's far corner, scale a full [0, 1] quad by this
+    glm::vec2 region() const {
+        return glm::vec2((float)viewWidth / storageWidth, (float)viewHeight / storageHeight);
+    }
+
+    unsigned int framebuffer() const {
+        return FBO;
+    }
+
+    unsigned int texture() const {
+        return colorTexture;
+    }
+
+    int width() const {
+        return viewWidth;
+    }
+
+    int height() const {
+        return viewHeight;
+    }
+
+    const ResizableTargetStats& getStats() const {
+        return stats;
+    }
+
+    void report() const {
+        printf("resizable target, %s: %lld resize events, %lld sizes applied, %lld allocations (%.3f ms, max %.3f ms), %lld deferred updates\n",
+            policy == Exact ? "exact" : "bucketed", stats.requests, stats.applied, stats.allocations,
+            stats.allocationMs, stats.maxAllocationMs, stats.deferred);
+        printf("    %dx%d in use of %dx%d storage, %.1f MB, %.1f MB allocated in total\n", viewWidth, viewHeight,
+            storageWidth, storageHeight, stats.storageBytes / 1048576.0, stats.allocatedBytes / 1048576.0);
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    static const size_t TEXEL_BYTES = 4; // GL_RGBA8
+
+    Policy policy = Bucketed;
+    unsigned int FBO = 0, colorTexture = 0;
+    int storageWidth = 0, storageHeight = 0;
+    int viewWidth = 0, viewHeight = 0;
+    int pendingWidth = 0, pendingHeight = 0;
+    bool pending = false, deferring = false;
+    clock::time_point lastRequest, deferredSince;
+    ResizableTargetStats stats;
+
+    // Smallest 2^n or 1.5 * 2^n that holds size
+    int bucket(int size) const {
+        int power = std::max(minimumBucket, 1);
+        while (true) {
+            if (power >= size) {
+                return power;
+            }
+            if (power + power / 2 >= size && power > 1) {
+                return power + power / 2;
+            }
+            power *= 2;
+        }
+    }
+
+    void setView(int width, int height) {
+        if (width != viewWidth || height != viewHeight) {
+            stats.applied++;
+        }
+        viewWidth = width;
+        viewHeight = height;
+    }
+
+    static void setParameters() {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    // A new texture and framebuffer, with the old region copied over
+    void allocate(int width, int height, GLStateCache& state) {
+        auto start = clock::now();
+        unsigned int texture, framebuffer;
+        glGenTextures(1, &texture);
+        state.bindTexture(0, GL_TEXTURE_2D, texture);
+        if (GLEXT_ARB_texture_storage && policy == Bucketed) {
+            glext_glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+        }
+        else {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+        setParameters();
+        glGenFramebuffers(1, &framebuffer);
+        state.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+        float transparent[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, transparent);
+
+        if (FBO) {
+            int copyWidth = std::min(viewWidth, width), copyHeight = std::min(viewHeight, height);
+            state.bindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+            glBlitFramebuffer(0, 0, copyWidth, copyHeight, 0, 0, copyWidth, copyHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            state.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glDeleteFramebuffers(1, &FBO);
+            glDeleteTextures(1, &colorTexture);
+        }
+        FBO = framebuffer;
+        colorTexture = texture;
+        storageWidth = width;
+        storageHeight = height;
+        recordAllocation(start);
+    }
+
+    // Exact: the same texture respecified at the new size, its content is lost
+    void respecify(int width, int height, GLStateCache& state) {
+        auto start = clock::now();
+        state.bindTexture(0, GL_TEXTURE_2D, colorTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        state.bindFramebuffer(GL_FRAMEBUFFER, FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+        storageWidth = width;
+        storageHeight = height;
+        recordAllocation(start);
+    }
+
+    void recordAllocation(clock::time_point start) {
+        double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        stats.allocations++;
+        stats.allocationMs += ms;
+        stats.maxAllocationMs = std::max(stats.maxAllocationMs, ms);
+        stats.storageBytes = (size_t)storageWidth * storageHeight * TEXEL_BYTES;
+        stats.allocatedBytes += stats.storageBytes;
+    }
+};
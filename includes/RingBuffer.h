@@ -0,0 +1,231 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <iostream>
+#include <algorithm>
+#include "GLExtensions.h"
+
+/*
+* Per frame data streamed through one persistently mapped buffer, split into a section per frame in flight.
+*
+*     RingBuffer ring;
+*     ring.create(64 * 1024);                                  // bytes per frame, 3 frames in flight
+*     while (...) {
+*         ring.beginFrame();                                   // waits for the GPU to be done with this section
+*         RingAllocation frame = ring.push(frameUniforms, ring.uniformAlignment());
+*         glBindBufferRange(GL_UNIFORM_BUFFER, 0, ring.buffer(), frame.offset, frame.size);
+*         RingAllocation vertices = ring.allocate(bytes, sizeof(Vertex));  // write through vertices.data
+*         ring.flush();                                        // before the draws that read it
+*         ... draws ...
+*         ring.endFrame();                                     // fences the section
+*     }
+*     ring.report();
+*
+* The buffer is created once with glBufferStorage(GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT) and mapped for its
+* whole life, so a frame's data is a memcpy into the mapping and a bind of a range: no glUniform* per value, no
+* glBufferData reallocation and no map/unmap. Coherent mapping makes the writes visible to commands issued after
+* them, so flush() has nothing to do. The CPU is never writing a section the GPU may still be reading, the fence
+* from the last time the section was used is waited on in beginFrame(); with three sections the wait only happens
+* when the GPU is more than two frames behind.
+* Without ARB_buffer_storage the sections live in a CPU copy and flush() uploads what the frame wrote with
+* glBufferSubData, leaving the synchronisation to the driver.
+* create(), release() and the fallback's flush() bind GL_COPY_WRITE_BUFFER directly, not through a GLStateCache.
+*/
+
+struct RingAllocation {
+    void* data;       // where to write, NULL when the section was full
+    GLintptr offset;  // in buffer()
+    GLsizeiptr size;
+
+    bool valid() const {
+        return data != NULL;
+    }
+};
+
+struct RingBufferStats {
+    long long frames;
+    long long allocations;
+    long long overflows;  // allocations that didn't fit their section
+    size_t bytes;         // handed out, alignment padding included
+    size_t maxFrameBytes;
+    long long waits;      // beginFrame() calls that found the GPU still using the section
+    double waitMs;
+};
+
+class RingBuffer {
+
+public:
+    static const int DEFAULT_FRAMES = 3;
+
+    bool create(size_t bytesPerFrame, int framesInFlight = DEFAULT_FRAMES) {
+        release();
+        memset(&stats, 0, sizeof(stats));
+        frames = std::max(framesInFlight, 1);
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        uniformAlign = std::max(alignment, 1);
+        // every section starts aligned for anything that is allocated from it
+        sectionSize = align(bytesPerFrame, std::max(MIN_SECTION_ALIGNMENT, uniformAlign));
+        fences.assign(frames, (GLsync)0);
+
+        glGenBuffers(1, &ringBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ringBuffer);
+        size_t total = sectionSize * frames;
+        persistent = GLEXT_ARB_buffer_storage != 0;
+        if (persistent) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glext_glBufferStorage(GL_COPY_WRITE_BUFFER, total, NULL, flags);
+            mapping = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags);
+            if (!mapping) {
+                std::cout << "ERROR::RING_BUFFER::MAP_FAILED" << std::endl;
+                release();
+                return false;
+            }
+        }
+        else {
+            glBufferData(GL_COPY_WRITE_BUFFER, total, NULL, GL_STREAM_DRAW);
+            shadow.resize(total);
+            mapping = shadow.data();
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        section = 0;
+        head = flushed = 0;
+        return true;
+    }
+
+    void release() {
+        for (GLsync& fence : fences) {
+            if (fence) {
+                glDeleteSync(fence);
+            }
+            fence = 0;
+        }
+        if (ringBuffer) {
+            if (persistent) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, ringBuffer);
+                glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &ringBuffer);
+        }
+        ringBuffer = 0;
+        mapping = NULL;
+        shadow = std::vector<unsigned char>();
+    }
+
+    // Moves on to the next section, once the GPU has finished the frame that last used it
+    void beginFrame() {
+        section = (section + 1) % frames;
+        head = flushed = 0;
+        GLsync& fence = fences[section];
+        if (!fence) {
+            return;
+        }
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            auto start = std::chrono::high_resolution_clock::now();
+            do {
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT_NS);
+            } while (result == GL_TIMEOUT_EXPIRED);
+            stats.waits++;
+            stats.waitMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        }
+        glDeleteSync(fence);
+        fence = 0;
+    }
+
+    // alignment must be a power of two, at most 256 or uniformAlignment() if that is larger
+    RingAllocation allocate(size_t bytes, size_t alignment = 16) {
+        RingAllocation allocation = { NULL, 0, (GLsizeiptr)bytes };
+        size_t start = align(head, alignment);
+        if (!ringBuffer || start + bytes > sectionSize) {
+            stats.overflows++;
+            return allocation;
+        }
+        stats.allocations++;
+        stats.bytes += start + bytes - head;
+        head = start + bytes;
+        stats.maxFrameBytes = std::max(stats.maxFrameBytes, head);
+        allocation.offset = (GLintptr)(section * sectionSize + start);
+        allocation.data = mapping + allocation.offset;
+        return allocation;
+    }
+
+    template<class T>
+    RingAllocation push(const T& value, size_t alignment = 16) {
+        RingAllocation allocation = allocate(sizeof(T), alignment);
+        if (allocation.valid()) {
+            memcpy(allocation.data, &value, sizeof(T));
+        }
+        return allocation;
+    }
+
+    // Makes what was written since the last flush visible to the GL, only uploads without persistent mapping
+    void flush() {
+        if (!persistent && head > flushed) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, ringBuffer);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, section * sectionSize + flushed, head - flushed, mapping + section * sectionSize + flushed);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        }
+        flushed = head;
+    }
+
+    // After the frame's last command that reads from this section
+    void endFrame() {
+        flush();
+        if (persistent) {
+            fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        stats.frames++;
+    }
+
+    unsigned int buffer() const {
+        return ringBuffer;
+    }
+
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, for ranges bound with glBindBufferRange(GL_UNIFORM_BUFFER, ...)
+    size_t uniformAlignment() const {
+        return uniformAlign;
+    }
+
+    bool isPersistent() const {
+        return persistent;
+    }
+
+    const RingBufferStats& getStats() const {
+        return stats;
+    }
+
+    void report() const {
+        long long divisor = stats.frames > 0 ? stats.frames : 1;
+        printf("ring buffer, %s, %d x %.1f KB: %lld frames, %.1f allocations and %.1f KB per frame (max %.1f KB), %lld overflows\n",
+            persistent ? "persistent coherent mapping" : "glBufferSubData fallback", frames, sectionSize / 1024.0, stats.frames,
+            (double)stats.allocations / divisor, stats.bytes / 1024.0 / divisor, stats.maxFrameBytes / 1024.0, stats.overflows);
+        printf("    waited on the GPU %lld times, %.3f ms\n", stats.waits, stats.waitMs);
+    }
+
+private:
+    static constexpr size_t MIN_SECTION_ALIGNMENT = 256;
+    static const GLuint64 WAIT_TIMEOUT_NS = 1000000; // 1 ms per glClientWaitSync, looped until signalled
+
+    unsigned int ringBuffer = 0;
+    unsigned char* mapping = NULL;
+    std::vector<unsigned char> shadow;
+    std::vector<GLsync> fences;
+    bool persistent = false;
+    int frames = DEFAULT_FRAMES;
+    int section = 0;
+    size_t sectionSize = 0;
+    size_t head = 0, flushed = 0;
+    size_t uniformAlign = 256;
+    RingBufferStats stats;
+
+    static size_t align(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+};
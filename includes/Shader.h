@@ -5,8 +5,22 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "ShaderCache.h"
+#include "GLStateCache.h"
+#include "Profiler.h"
+
+// Resolved uniform location. Fetch once with Shader::getUniform outside the render loop,
+// then the handle setters go straight to glUniform* with no string hashing or driver lookups
+struct UniformHandle {
+    int location = -1;
+
+    bool valid() const {
+        return location >= 0;
+    }
+};
 
 class Shader {
 
@@ -14,6 +28,7 @@ public:
     unsigned int ID;
 
     Shader(const char* vertexPath, const char* fragmentPath) {
+        PROFILE_ZONE("Shader");
         std::string vertexCode, fragmentCode;
         std::ifstream vertexFile, fragmentFile;
 
@@ -41,6 +56,20 @@ public:
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ CODE:" << e.code() << std::endl;
         }
 
+        //Program binary cache, skips compiling and linking entirely on a hit
+        unsigned long long cacheKey = 0;
+        if (ShaderCache::available()) {
+            cacheKey = ShaderCache::key(vertexCode, fragmentCode);
+            ID = glCreateProgram();
+            if (ShaderCache::load(ID, cacheKey)) {
+                reflectUniforms();
+                return;
+            }
+            glDeleteProgram(ID);
+        }
+
+        PROFILE_ZONE("Shader::compile");
+
         //string to const char*
         const char* vertexCodeChar = vertexCode.c_str();
         const char* fragmentCodeChar = fragmentCode.c_str();
@@ -80,6 +109,9 @@ public:
         ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
+        if (ShaderCache::available()) {
+            ShaderCache::prepare(ID);
+        }
         glLinkProgram(ID);
         
         //Failure Log
@@ -88,11 +120,61 @@ public:
             glGetProgramInfoLog(ID, 512, NULL, infoLog);
             std::cout << "ERROR::LINK_FAILURE\n" << infoLog << std::endl;
         }
+        else if (ShaderCache::available()) {
+            ShaderCache::save(ID, cacheKey);
+        }
 
         //Cleanup
         glDeleteShader(vertex);
         glDeleteShader(fragment);
 
+        reflectUniforms();
+    }
+
+    // Adopts an already linked program, used by ShaderLibrary
+    explicit Shader(unsigned int program) : ID(program) {
+        reflectUniforms();
+    }
+
+    // A compute program from one file, needs GLEXT_ARB_compute_shader. Not kept in the ShaderCache.
+    static Shader compute(const char* computePath) {
+        PROFILE_ZONE("Shader::compute");
+        std::string computeCode;
+        std::ifstream computeFile;
+        computeFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try {
+            computeFile.open(computePath);
+            std::stringstream computeStream;
+            computeStream << computeFile.rdbuf();
+            computeFile.close();
+            computeCode = computeStream.str();
+        }
+        catch (std::ifstream::failure& e) {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ CODE:" << e.code() << std::endl;
+        }
+
+        const char* computeCodeChar = computeCode.c_str();
+        int success;
+        char infoLog[512];
+        unsigned int shader = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(shader, 1, &computeCodeChar, NULL);
+        glCompileShader(shader);
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(shader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILURE \n" << infoLog << std::endl;
+        }
+
+        unsigned int program = glCreateProgram();
+        glAttachShader(program, shader);
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::LINK_FAILURE\n" << infoLog << std::endl;
+        }
+        glDeleteShader(shader);
+        return Shader(program);
     }
 
     void free() {
@@ -103,23 +185,155 @@ public:
         glUseProgram(ID);
     }
 
+    // Skips the glUseProgram when the program is already current
+    void use(GLStateCache& state) {
+        state.useProgram(ID);
+    }
+
+    // Looks the name up in the reflected uniform table, no driver round-trip
+    UniformHandle getUniform(const std::string& name) const {
+        UniformHandle handle;
+        handle.location = findUniform(name.c_str());
+        return handle;
+    }
+
+    int uniformCount() const {
+        return uniformEntries;
+    }
+
     void setBool(const std::string& name, bool value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(findUniform(name.c_str()), value);
     }
 
     void setInt(const std::string& name, int value) const {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1i(findUniform(name.c_str()), value);
     }
 
     void setFloat(const std::string& name, float value) const {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        glUniform1f(findUniform(name.c_str()), value);
     }
 
     void setMat4(const std::string& name, const glm::mat4 mat) const {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
+        glUniformMatrix4fv(findUniform(name.c_str()), 1, GL_FALSE, glm::value_ptr(mat));
     }
 
     void setVec3(const std::string& name, const glm::vec3 value) const {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()),1, glm::value_ptr(value));
+        glUniform3fv(findUniform(name.c_str()),1, glm::value_ptr(value));
+    }
+
+    // Handle setters for hot loops
+    void setBool(UniformHandle handle, bool value) const {
+        glUniform1i(handle.location, value);
+    }
+
+    void setInt(UniformHandle handle, int value) const {
+        glUniform1i(handle.location, value);
+    }
+
+    void setFloat(UniformHandle handle, float value) const {
+        glUniform1f(handle.location, value);
+    }
+
+    void setMat4(UniformHandle handle, const glm::mat4& mat) const {
+        glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(mat));
+    }
+
+    void setVec3(UniformHandle handle, const glm::vec3& value) const {
+        glUniform3fv(handle.location, 1, glm::value_ptr(value));
+    }
+
+private:
+    /*
+    * Flat open addressing table of every active uniform, filled once after linking.
+    * Array uniforms are stored under "name", "name[0]" and every "name[i]" so lookups
+    * match what glGetUniformLocation would have accepted.
+    */
+    struct UniformEntry {
+        unsigned int hash;
+        int location;
+        std::string name;
+    };
+
+    std::vector<UniformEntry> uniformTable;
+    int uniformEntries = 0;
+
+    // FNV-1a
+    static unsigned int hashName(const char* name) {
+        unsigned int hash = 2166136261u;
+        for (const char* c = name; *c; c++) {
+            hash ^= (unsigned char)*c;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    void reflectUniforms() {
+        int activeUniforms = 0, maxNameLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &activeUniforms);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+        std::vector<std::string> names;
+        std::vector<int> locations;
+        std::vector<char> nameBuffer(maxNameLength + 1);
+
+        for (int i = 0; i < activeUniforms; i++) {
+            int length = 0, size = 0;
+            GLenum type;
+            glGetActiveUniform(ID, i, (int)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+            std::string name(nameBuffer.data(), length);
+
+            // uniforms inside blocks have no location
+            int location = glGetUniformLocation(ID, name.c_str());
+            if (location < 0) {
+                continue;
+            }
+
+            names.push_back(name);
+            locations.push_back(location);
+
+            size_t bracket = name.find("[0]");
+            if (bracket != std::string::npos && bracket + 3 == name.size()) {
+                std::string base = name.substr(0, bracket);
+                names.push_back(base);
+                locations.push_back(location);
+                for (int j = 1; j < size; j++) {
+                    std::string element = base + "[" + std::to_string(j) + "]";
+                    names.push_back(element);
+                    locations.push_back(glGetUniformLocation(ID, element.c_str()));
+                }
+            }
+        }
+
+        // keep the load factor at or below one half
+        size_t capacity = 8;
+        while (capacity < names.size() * 2) {
+            capacity *= 2;
+        }
+        uniformTable.assign(capacity, UniformEntry{ 0, -1, std::string() });
+        uniformEntries = (int)names.size();
+
+        for (size_t i = 0; i < names.size(); i++) {
+            unsigned int hash = hashName(names[i].c_str());
+            size_t slot = hash & (capacity - 1);
+            while (!uniformTable[slot].name.empty()) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            uniformTable[slot] = UniformEntry{ hash, locations[i], names[i] };
+        }
+    }
+
+    // Returns -1 for unknown names, which glUniform* silently ignores just like before
+    int findUniform(const char* name) const {
+        if (uniformTable.empty()) {
+            return -1;
+        }
+        unsigned int hash = hashName(name);
+        size_t mask = uniformTable.size() - 1;
+        for (size_t slot = hash & mask; !uniformTable[slot].name.empty(); slot = (slot + 1) & mask) {
+            if (uniformTable[slot].hash == hash && uniformTable[slot].name == name) {
+                return uniformTable[slot].location;
+            }
+        }
+        return -1;
     }
 };
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include "GLExtensions.h"
+
+/*
+* On-disk cache of linked program binaries.
+*
+* Programs are keyed by a hash of both GLSL sources plus the GL vendor, renderer and version strings,
+* so a driver update or an edited shader simply misses instead of loading a stale binary.
+* The driver is free to reject a binary it produced earlier (glProgramBinary then fails to link),
+* in that case the file is dropped and Shader falls back to a full compile.
+*
+* Only active once loadGLExtensions found ARB_get_program_binary.
+*/
+
+class ShaderCache {
+
+public:
+    inline static std::string directory = "shadercache";
+    inline static bool enabled = true;
+
+    // startup counters
+    inline static int hits = 0;
+    inline static int misses = 0;
+    inline static int rejected = 0;
+
+    static bool available() {
+        return enabled && GLEXT_ARB_get_program_binary;
+    }
+
+    static unsigned long long key(const std::string& vertexCode, const std::string& fragmentCode) {
+        unsigned long long hash = 14695981039346656037ull;
+        hashBytes(hash, vertexCode.data(), vertexCode.size());
+        hashBytes(hash, "\0", 1);
+        hashBytes(hash, fragmentCode.data(), fragmentCode.size());
+
+        const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+        for (GLenum name : driverStrings) {
+            const char* value = (const char*)glGetString(name);
+            if (value) {
+                hashBytes(hash, "\0", 1);
+                hashBytes(hash, value, strlen(value));
+            }
+        }
+        return hash;
+    }
+
+    // Returns true when program now holds a linked binary
+    static bool load(unsigned int program, unsigned long long key) {
+        std::ifstream file(path(key), std::ios::binary);
+        if (!file) {
+            misses++;
+            return false;
+        }
+
+        Header header;
+        file.read((char*)&header, sizeof(header));
+        std::vector<char> binary;
+        if (file && header.magic == MAGIC && header.key == key && header.length > 0) {
+            binary.resize(header.length);
+            file.read(binary.data(), header.length);
+        }
+        file.close();
+
+        int success = 0;
+        if (!binary.empty() && file) {
+            glext_glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+            glGetProgramiv(program, GL_LINK_STATUS, &success);
+        }
+
+        if (!success) {
+            rejected++;
+            misses++;
+            std::error_code error;
+            std::filesystem::remove(path(key), error);
+            return false;
+        }
+
+        hits++;
+        return true;
+    }
+
+    // Call before glLinkProgram so the driver keeps a retrievable binary around
+    static void prepare(unsigned int program) {
+        glext_glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    static void save(unsigned int program, unsigned long long key) {
+        int length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+
+        Header header;
+        header.key = key;
+        std::vector<char> binary(length);
+        glext_glGetProgramBinary(program, length, &length, &header.format, binary.data());
+        header.length = (unsigned int)length;
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+
+        std::ofstream file(path(key), std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cout << "ERROR::SHADER_CACHE::WRITE_FAILED " << path(key) << std::endl;
+            return;
+        }
+        file.write((const char*)&header, sizeof(header));
+        file.write(binary.data(), length);
+    }
+
+    static void report() {
+        printf("shader cache: %d hits, %d misses, %d rejected\n", hits, misses, rejected);
+    }
+
+private:
+    static const unsigned int MAGIC = 0x42474c4f; // "OLGB"
+
+    struct Header {
+        unsigned int magic = MAGIC;
+        GLenum format = 0;
+        unsigned long long key = 0;
+        unsigned int length = 0;
+        unsigned int padding = 0;
+    };
+
+    // FNV-1a, 64 bit
+    static void hashBytes(unsigned long long& hash, const char* data, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            hash ^= (unsigned char)data[i];
+            hash *= 1099511628211ull;
+        }
+    }
+
+    static std::string path(unsigned long long key) {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", key);
+        return directory + "/" + name;
+    }
+};
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include "Shader.h"
+#include "ShaderCache.h"
+#include "GLExtensions.h"
+#include "Profiler.h"
+
+/*
+* Builds every program of a scene up front instead of one Shader constructor at a time.
+*
+*     ShaderLibrary library;
+*     int lines = library.add("shaders/lineTrailVert.glsl", "shaders/lineTrailFrag.glsl");
+*     ... other startup work, the files are read on a background thread meanwhile ...
+*     library.submit();                    // compile + link everything that has been read, no status queries
+*     Shader lineShader = library.get(lines); // only blocks here, the first time the program is needed
+*
+* With KHR/ARB_parallel_shader_compile the driver compiles on its own threads and ready() can poll
+* GL_COMPLETION_STATUS_KHR, otherwise the driver still gets to pipeline all compiles before the first status query.
+* All GL calls stay on the thread that owns the context, only file reads happen in the background.
+*/
+
+class ShaderLibrary {
+
+public:
+    ShaderLibrary() {
+        if (GLEXT_parallel_shader_compile) {
+            // let the driver pick how many threads to use
+            glext_glMaxShaderCompilerThreads(0xFFFFFFFF);
+        }
+        ioThread = std::thread(&ShaderLibrary::ioLoop, this);
+    }
+
+    ~ShaderLibrary() {
+        {
+            std::lock_guard<std::mutex> lock(ioMutex);
+            stopping = true;
+        }
+        ioWake.notify_all();
+        ioThread.join();
+    }
+
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+    // Queues the file reads and returns the id used by ready() and get()
+    int add(const char* vertexPath, const char* fragmentPath) {
+        std::unique_ptr<Program> program(new Program());
+        program->vertexPath = vertexPath;
+        program->fragmentPath = fragmentPath;
+
+        {
+            std::lock_guard<std::mutex> lock(ioMutex);
+            ioQueue.push_back(program.get());
+        }
+        ioWake.notify_one();
+
+        programs.push_back(std::move(program));
+        return (int)programs.size() - 1;
+    }
+
+    // Starts compiling every program whose sources have arrived, never blocks on the driver
+    void submit() {
+        for (auto& program : programs) {
+            if (program->state == READING && isRead(*program)) {
+                compile(*program);
+            }
+        }
+    }
+
+    // True when get() would not stall
+    bool ready(int id) {
+        Program& program = *programs[id];
+        if (program.state == READING) {
+            if (!isRead(program)) {
+                return false;
+            }
+            compile(program);
+        }
+        if (program.state == COMPILING && GLEXT_parallel_shader_compile) {
+            int complete = 0;
+            glGetProgramiv(program.ID, GL_COMPLETION_STATUS_KHR, &complete);
+            return complete != 0;
+        }
+        return true;
+    }
+
+    Shader& get(int id) {
+        Program& program = *programs[id];
+        if (program.state == READING) {
+            std::unique_lock<std::mutex> lock(ioMutex);
+            ioDone.wait(lock, [&program] { return program.read; });
+            lock.unlock();
+
+            submit();
+        }
+        if (program.state == COMPILING) {
+            finish(program);
+        }
+        return *program.shader;
+    }
+
+    // Blocks until every program is linked
+    void wait() {
+        for (int i = 0; i < (int)programs.size(); i++) {
+            get(i);
+        }
+    }
+
+private:
+    enum ProgramState {
+        READING,
+        COMPILING,
+        LINKED
+    };
+
+    struct Program {
+        std::string vertexPath, fragmentPath;
+        std::string vertexCode, fragmentCode;
+        bool read = false; // guarded by ioMutex until set
+
+        ProgramState state = READING;
+        unsigned int ID = 0, vertex = 0, fragment = 0;
+        unsigned long long cacheKey = 0;
+        std::unique_ptr<Shader> shader;
+    };
+
+    std::vector<std::unique_ptr<Program>> programs;
+
+    std::thread ioThread;
+    std::mutex ioMutex;
+    std::condition_variable ioWake, ioDone;
+    std::deque<Program*> ioQueue;
+    bool stopping = false;
+
+    void ioLoop() {
+        while (true) {
+            Program* program;
+            {
+                std::unique_lock<std::mutex> lock(ioMutex);
+                ioWake.wait(lock, [this] { return stopping || !ioQueue.empty(); });
+                if (ioQueue.empty()) {
+                    return;
+                }
+                program = ioQueue.front();
+                ioQueue.pop_front();
+            }
+
+            PROFILE_ZONE("ShaderLibrary::read");
+            std::string vertexCode = readFile(program->vertexPath);
+            std::string fragmentCode = readFile(program->fragmentPath);
+
+            {
+                std::lock_guard<std::mutex> lock(ioMutex);
+                program->vertexCode = std::move(vertexCode);
+                program->fragmentCode = std::move(fragmentCode);
+                program->read = true;
+            }
+            ioDone.notify_all();
+        }
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try {
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            return stream.str();
+        }
+        catch (std::ifstream::failure& e) {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+        }
+        return std::string();
+    }
+
+    bool isRead(Program& program) {
+        std::lock_guard<std::mutex> lock(ioMutex);
+        return program.read;
+    }
+
+    void compile(Program& program) {
+        PROFILE_ZONE("ShaderLibrary::compile");
+        if (ShaderCache::available()) {
+            program.cacheKey = ShaderCache::key(program.vertexCode, program.fragmentCode);
+            program.ID = glCreateProgram();
+            if (ShaderCache::load(program.ID, program.cacheKey)) {
+                program.shader.reset(new Shader(program.ID));
+                program.state = LINKED;
+                return;
+            }
+            glDeleteProgram(program.ID);
+        }
+
+        const char* vertexCodeChar = program.vertexCode.c_str();
+        const char* fragmentCodeChar = program.fragmentCode.c_str();
+
+        program.vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(program.vertex, 1, &vertexCodeChar, NULL);
+        glCompileShader(program.vertex);
+
+        program.fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(program.fragment, 1, &fragmentCodeChar, NULL);
+        glCompileShader(program.fragment);
+
+        // linking straight away is fine, a failed compile just shows up as a failed link later
+        program.ID = glCreateProgram();
+        glAttachShader(program.ID, program.vertex);
+        glAttachShader(program.ID, program.fragment);
+        if (ShaderCache::available()) {
+            ShaderCache::prepare(program.ID);
+        }
+        glLinkProgram(program.ID);
+
+        program.state = COMPILING;
+    }
+
+    // First status query for the program, this is where the driver may block
+    void finish(Program& program) {
+        PROFILE_ZONE("ShaderLibrary::finish");
+        int success;
+        char infoLog[512];
+
+        glGetShaderiv(program.vertex, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(program.vertex, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILURE " << program.vertexPath << "\n" << infoLog << std::endl;
+        }
+
+        glGetShaderiv(program.fragment, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            glGetShaderInfoLog(program.fragment, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILURE " << program.fragmentPath << "\n" << infoLog << std::endl;
+        }
+
+        glGetProgramiv(program.ID, GL_LINK_STATUS, &success);
+        if (!success) {
+            glGetProgramInfoLog(program.ID, 512, NULL, infoLog);
+            std::cout << "ERROR::LINK_FAILURE\n" << infoLog << std::endl;
+        }
+        else if (ShaderCache::available()) {
+            ShaderCache::save(program.ID, program.cacheKey);
+        }
+
+        glDeleteShader(program.vertex);
+        glDeleteShader(program.fragment);
+        program.vertex = program.fragment = 0;
+
+        program.shader.reset(new Shader(program.ID));
+        program.state = LINKED;
+    }
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+/*
+* Compile time SIMD selection for the CPU side code.
+* SIMD_SSE2 is on for every x64 build, SIMD_AVX2 needs /arch:AVX2 (MSVC) or -mavx2 -mfma (gcc/clang).
+* Define SIMD_FORCE_SCALAR to test the plain C++ paths.
+*/
+
+#if !defined(SIMD_FORCE_SCALAR)
+#   if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define SIMD_SSE2 1
+#       include <emmintrin.h>
+#   endif
+#   if defined(__AVX2__) && defined(__FMA__)
+#       define SIMD_AVX2 1
+#       include <immintrin.h>
+#   elif defined(_MSC_VER) && defined(__AVX2__)
+#       define SIMD_AVX2 1
+#       include <immintrin.h>
+#   endif
+#endif
@@ -0,0 +1,337 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "Simd.h"
+#include "ThreadPool.h"
+#include "TrailParticles.h"
+#include "SoftwareRasterizer.h"
+
+#include <glm/glm.hpp>
+
+/*
+* LineTrails' three passes on the CPU, as a reference for the GL output and to run the effect without a GPU.
+*
+*     fade()        fade.frag over the trail buffer, blended ONE, ONE_MINUS_SRC_ALPHA / ONE, ONE
+*     drawLines()   lineTrailVert.glsl + lineTrailFrag.glsl, white lines blended the same way
+*     threshold()   texFragFloor.glsl from the trail buffer onto the screen, which the demo clears to opaque black
+*
+*     SoftwareLineTrails effect(800, 600, pool);
+*     effect.frame(trails, time);             // all three
+*     effect.screen.savePPM("trails.ppm");
+*
+* Both buffers are RGBA8 SoftwareFramebuffers, bottom row first like glReadPixels, so they compare directly.
+* Every pass splits the image into bands of rows, one parallelFor index per band. The fade and threshold work on
+* 8 pixels at a time with AVX2, 4 with SSE2; the fade does the blend in 8 bit fixed point like the GL blender
+* (dst * (255 - opacity) / 255, rounded), so every path gives the same bytes. The line ends are computed first in
+* parallel chunks, then every band draws the part of each line that falls in its rows, in line order. As with
+* LightingKernels, gcc/clang builds with FMA need -ffp-contract=off for the line ends to land on the same pixels.
+* Lines are 1 pixel wide and aliased like GL's default lines, one pixel per column (or row, for steep lines) at the
+* pixel centres. antialias switches to coverage weighted lines two pixels thick across the minor axis, which GL
+* would only draw with GL_LINE_SMOOTH.
+*/
+
+struct SoftwareLineTrailsStats {
+    long long frames;
+    long long linePixels; // written by drawLines
+    double fadeMs, linesMs, thresholdMs;
+};
+
+class SoftwareLineTrails {
+
+public:
+    // LineTrails' uniforms
+    float opacity = 0.1f;     // u_opacity
+    float floor = 0.1f;       // u_floor
+    float trailLength = 0.1f; // u_trail_length
+    float aspect;             // u_aspect_ratio
+    bool antialias = false;
+
+    SoftwareFramebuffer trails, screen;
+
+    SoftwareLineTrails(int width, int height, ThreadPool& pool)
+        : aspect((float)width / (float)height), trails(width, height), screen(width, height), pool(pool) {
+        bandHeight = std::max((height + pool.size() * BANDS_PER_THREAD - 1) / (pool.size() * BANDS_PER_THREAD), MIN_BAND_HEIGHT);
+        bandCount = (height + bandHeight - 1) / bandHeight;
+        bandPixels.resize(bandCount);
+        clear();
+    }
+
+    void clear() {
+        trails.clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        screen.clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    void frame(const TrailParticles& particles, float time) {
+        fade();
+        drawLines(particles, time);
+        threshold();
+        stats.frames++;
+    }
+
+    // dst.rgb *= 1 - opacity, dst.a += opacity
+    void fade() {
+        auto start = std::chrono::high_resolution_clock::now();
+        uint32_t alpha = (uint32_t)(std::min(std::max(opacity, 0.0f), 1.0f) * 255.0f + 0.5f);
+        uint32_t keep = 255 - alpha;
+        forEachBand([&](int begin, int end) {
+            uint32_t* pixels = &trails.color[(size_t)begin * trails.width];
+            size_t count = (size_t)(end - begin) * trails.width, i = 0;
+#ifdef SIMD_AVX2
+            const __m256i zero8 = _mm256_setzero_si256();
+            const __m256i scale8 = _mm256_set_epi16(255, keep, keep, keep, 255, keep, keep, keep, 255, keep, keep, keep, 255, keep, keep, keep);
+            const __m256i round8 = _mm256_set1_epi16(128);
+            const __m256i alpha8 = _mm256_set1_epi32((int)(alpha << 24));
+            for (; i + 8 <= count; i += 8) {
+                __m256i c = _mm256_loadu_si256((const __m256i*)(pixels + i));
+                __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(c, zero8), scale8), round8);
+                __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(c, zero8), scale8), round8);
+                lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+                hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+                _mm256_storeu_si256((__m256i*)(pixels + i), _mm256_adds_epu8(_mm256_packus_epi16(lo, hi), alpha8));
+            }
+#endif
+#ifdef SIMD_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i scale = _mm_set_epi16(255, keep, keep, keep, 255, keep, keep, keep);
+            const __m128i round = _mm_set1_epi16(128);
+            const __m128i alpha4 = _mm_set1_epi32((int)(alpha << 24));
+            for (; i + 4 <= count; i += 4) {
+                __m128i c = _mm_loadu_si128((const __m128i*)(pixels + i));
+                __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(c, zero), scale), round);
+                __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(c, zero), scale), round);
+                lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+                hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+                _mm_storeu_si128((__m128i*)(pixels + i), _mm_adds_epu8(_mm_packus_epi16(lo, hi), alpha4));
+            }
+#endif
+            for (; i < count; i++) {
+                uint32_t c = pixels[i];
+                uint32_t faded = std::min((c >> 24) + alpha, 255u) << 24;
+                for (int shift = 0; shift < 24; shift += 8) {
+                    faded |= mul255((c >> shift) & 0xff, keep) << shift;
+                }
+                pixels[i] = faded;
+            }
+        });
+        stats.fadeMs += millisecondsSince(start);
+    }
+
+    void drawLines(const TrailParticles& particles, float time) {
+        auto start = std::chrono::high_resolution_clock::now();
+        int count = particles.count();
+        for (std::vector<float>* end : { &x0, &y0, &x1, &y1 }) {
+            end->resize(count);
+        }
+
+        // lineTrailVert.glsl: each end in pixels, head at time + offset, tail trailLength further round
+        float halfWidth = trails.width * 0.5f, halfHeight = trails.height * 0.5f;
+        pool.parallelFor((count + LINE_CHUNK - 1) / LINE_CHUNK, [&](int chunk) {
+            int end = std::min((chunk + 1) * LINE_CHUNK, count);
+            for (int i = chunk * LINE_CHUNK; i < end; i++) {
+                glm::vec2 centre = particles.centre[i];
+                float radius = particles.radius[i];
+                float t = time + particles.offset[i];
+                x0[i] = (centre.x + radius * std::cos(t) + 1.0f) * halfWidth;
+                y0[i] = (centre.y + aspect * radius * std::sin(t) + 1.0f) * halfHeight;
+                x1[i] = (centre.x + radius * std::cos(t + trailLength) + 1.0f) * halfWidth;
+                y1[i] = (centre.y + aspect * radius * std::sin(t + trailLength) + 1.0f) * halfHeight;
+            }
+        });
+
+        forEachBand([&](int bandY0, int bandY1) {
+            long long pixels = 0;
+            // rows a line can touch, the antialiased ones reach one row further
+            float top = (float)bandY0 - (antialias ? 1.0f : 0.0f), bottom = (float)bandY1 + (antialias ? 1.0f : 0.0f);
+            for (int i = 0; i < count; i++) {
+                if (std::max(y0[i], y1[i]) < top || std::min(y0[i], y1[i]) >= bottom) {
+                    continue;
+                }
+                pixels += antialias ? drawSmoothLine(x0[i], y0[i], x1[i], y1[i], bandY0, bandY1)
+                    : drawLine(x0[i], y0[i], x1[i], y1[i], bandY0, bandY1);
+            }
+            bandPixels[bandY0 / bandHeight] = pixels;
+        });
+        for (long long pixels : bandPixels) {
+            stats.linePixels += pixels;
+        }
+        stats.linesMs += millisecondsSince(start);
+    }
+
+    // Trail pixels whose channels add up to floor * 4 or more land on the screen, the rest become black
+    void threshold() {
+        auto start = std::chrono::high_resolution_clock::now();
+        // the smallest channel sum that passes, found with the shader's float comparison
+        uint32_t limit = 0;
+        while (limit <= 1020 && (float)limit / 255.0f < floor * 4.0f) {
+            limit++;
+        }
+        forEachBand([&](int begin, int end) {
+            const uint32_t* in = &trails.color[(size_t)begin * trails.width];
+            uint32_t* out = &screen.color[(size_t)begin * screen.width];
+            size_t count = (size_t)(end - begin) * trails.width, i = 0;
+#ifdef SIMD_AVX2
+            const __m256i byte8 = _mm256_set1_epi32(0xff), below8 = _mm256_set1_epi32((int)limit - 1);
+            const __m256i opaque8 = _mm256_set1_epi32((int)0xff000000);
+            for (; i + 8 <= count; i += 8) {
+                __m256i c = _mm256_loadu_si256((const __m256i*)(in + i));
+                __m256i sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_and_si256(c, byte8), _mm256_and_si256(_mm256_srli_epi32(c, 8), byte8)),
+                    _mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(c, 16), byte8), _mm256_srli_epi32(c, 24)));
+                __m256i pass = _mm256_cmpgt_epi32(sum, below8);
+                _mm256_storeu_si256((__m256i*)(out + i), _mm256_or_si256(_mm256_and_si256(c, pass), opaque8));
+            }
+#endif
+#ifdef SIMD_SSE2
+            const __m128i byte4 = _mm_set1_epi32(0xff), below4 = _mm_set1_epi32((int)limit - 1);
+            const __m128i opaque4 = _mm_set1_epi32((int)0xff000000);
+            for (; i + 4 <= count; i += 4) {
+                __m128i c = _mm_loadu_si128((const __m128i*)(in + i));
+                __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(c, byte4), _mm_and_si128(_mm_srli_epi32(c, 8), byte4)),
+                    _mm_add_epi32(_mm_and_si128(_mm_srli_epi32(c, 16), byte4), _mm_srli_epi32(c, 24)));
+                __m128i pass = _mm_cmpgt_epi32(sum, below4);
+                _mm_storeu_si128((__m128i*)(out + i), _mm_or_si128(_mm_and_si128(c, pass), opaque4));
+            }
+#endif
+            for (; i < count; i++) {
+                uint32_t c = in[i];
+                uint32_t sum = (c & 0xff) + ((c >> 8) & 0xff) + ((c >> 16) & 0xff) + (c >> 24);
+                out[i] = (sum >= limit ? c : 0) | 0xff000000;
+            }
+        });
+        stats.thresholdMs += millisecondsSince(start);
+    }
+
+    const SoftwareLineTrailsStats& getStats() const {
+        return stats;
+    }
+
+    void report() const {
+        double frames = (double)std::max(stats.frames, 1ll);
+        printf("software line trails: %lld frames at %dx%d in %d bands, fade %.3f ms, lines %.3f ms (%.0f pixels), threshold %.3f ms per frame\n",
+            stats.frames, trails.width, trails.height, bandCount, stats.fadeMs / frames, stats.linesMs / frames,
+            stats.linePixels / frames, stats.thresholdMs / frames);
+    }
+
+private:
+    static constexpr int BANDS_PER_THREAD = 4;
+    static constexpr int MIN_BAND_HEIGHT = 16;
+    static constexpr int LINE_CHUNK = 1 << 14;
+
+    ThreadPool& pool;
+    int bandHeight, bandCount;
+    std::vector<long long> bandPixels;
+    std::vector<float> x0, y0, x1, y1; // line ends in pixels
+    SoftwareLineTrailsStats stats;
+
+    static double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // x * y / 255 rounded, exact for 8 bit x and y
+    static uint32_t mul255(uint32_t x, uint32_t y) {
+        uint32_t t = x * y + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+
+    template<class Band>
+    void forEachBand(Band band) {
+        pool.parallelFor(bandCount, [&](int i) {
+            band(i * bandHeight, std::min((i + 1) * bandHeight, trails.height));
+        });
+    }
+
+    // White with coverage in [0, 255], premultiplied: rgb = c + dst * (1 - c), a = min(a + c, 1)
+    void blend(int x, int y, uint32_t coverage) {
+        uint32_t& pixel = trails.color[(size_t)y * trails.width + x];
+        uint32_t c = pixel, blended = std::min((c >> 24) + coverage, 255u) << 24;
+        for (int shift = 0; shift < 24; shift += 8) {
+            blended |= (coverage + mul255((c >> shift) & 0xff, 255 - coverage)) << shift;
+        }
+        pixel = blended;
+    }
+
+    // One pixel per column (or row) whose centre the line crosses, from the first end up to but not including the
+    // second, rows outside [bandY0, bandY1) skipped. Full coverage white is just white.
+    int drawLine(float ax, float ay, float bx, float by, int bandY0, int bandY1) {
+        int width = trails.width, pixels = 0;
+        uint32_t* color = trails.color.data();
+        float dx = bx - ax, dy = by - ay;
+        if (std::fabs(dx) >= std::fabs(dy)) {
+            if (dx == 0.0f) {
+                return 0;
+            }
+            float slope = dy / dx;
+            int first = (int)std::ceil(std::min(ax, bx) - 0.5f), last = (int)std::ceil(std::max(ax, bx) - 0.5f) - 1;
+            first = std::max(first, 0);
+            last = std::min(last, width - 1);
+            for (int x = first; x <= last; x++) {
+                int y = (int)std::floor(ay + (x + 0.5f - ax) * slope);
+                if (y >= bandY0 && y < bandY1) {
+                    color[(size_t)y * width + x] = 0xffffffff;
+                    pixels++;
+                }
+            }
+        }
+        else {
+            float slope = dx / dy;
+            int first = (int)std::ceil(std::min(ay, by) - 0.5f), last = (int)std::ceil(std::max(ay, by) - 0.5f) - 1;
+            first = std::max(first, bandY0);
+            last = std::min(last, bandY1 - 1);
+            for (int y = first; y <= last; y++) {
+                int x = (int)std::floor(ax + (y + 0.5f - ay) * slope);
+                if (x >= 0 && x < width) {
+                    color[(size_t)y * width + x] = 0xffffffff;
+                    pixels++;
+                }
+            }
+        }
+        return pixels;
+    }
+
+    // Xiaolin Wu style: along the major axis every pixel the segment overlaps, weighted by the overlap, split
+    // between the two pixels nearest the line across the minor axis
+    int drawSmoothLine(float ax, float ay, float bx, float by, int bandY0, int bandY1) {
+        bool steep = std::fabs(by - ay) > std::fabs(bx - ax);
+        if (steep) {
+            std::swap(ax, ay);
+            std::swap(bx, by);
+        }
+        if (ax > bx) {
+            std::swap(ax, bx);
+            std::swap(ay, by);
+        }
+        int majorSize = steep ? trails.height : trails.width, minorSize = steep ? trails.width : trails.height;
+        float slope = bx > ax ? (by - ay) / (bx - ax) : 0.0f;
+        int first = std::max((int)std::floor(ax), steep ? bandY0 : 0);
+        int last = std::min((int)std::floor(bx), (steep ? bandY1 : majorSize) - 1);
+        int pixels = 0;
+        for (int major = first; major <= last; major++) {
+            float overlap = std::min(bx, major + 1.0f) - std::max(ax, (float)major);
+            if (overlap <= 0.0f) {
+                continue;
+            }
+            float middle = (std::min(bx, major + 1.0f) + std::max(ax, (float)major)) * 0.5f;
+            float minor = ay + (middle - ax) * slope - 0.5f;
+            int low = (int)std::floor(minor);
+            float upper = minor - low;
+            for (int k = 0; k < 2; k++) {
+                int m = low + k;
+                uint32_t coverage = (uint32_t)(overlap * (k ? upper : 1.0f - upper) * 255.0f + 0.5f);
+                if (coverage == 0 || m < 0 || m >= minorSize) {
+                    continue;
+                }
+                int x = steep ? m : major, y = steep ? major : m;
+                if (y >= bandY0 && y < bandY1) {
+                    blend(x, y, coverage);
+                    pixels++;
+                }
+            }
+        }
+        return pixels;
+    }
+};
@@ -0,0 +1,612 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <glm/glm.hpp>
+#include "ThreadPool.h"
+#include "Simd.h"
+#include "stb_image.h"
+
+/*
+* Tile based software rasterizer, a CPU stand-in for the GL pipeline the demos use so scenes can run without a GPU.
+*
+* A draw goes through three parallel passes:
+*   1. vertex shading      - chunks of vertices run the vertex shader into clip space + varyings
+*   2. setup and binning   - near plane clipping, viewport transform, edge/attribute plane equations,
+*                            every triangle is appended to the bins of the 64x64 tiles its bounds touch
+*   3. tile rasterization  - each tile walks its bins in submission order, so the output never depends on thread count
+*
+* Shaders are plain callables, vertices use the same interleaved float layout as the GL buffers:
+*
+*     glm::vec4 vertexShader(const float* vertex, float* varyings)   // returns clip space position
+*     glm::vec4 fragmentShader(const float* varyings)                // returns RGBA in [0, 1]
+*
+* The *Batched draws hand fragments to the fragment shader RASTER_FRAGMENT_BATCH at a time in SoA form instead,
+* for shaders written with SIMD (see LightingKernels.h):
+*
+*     void fragmentShader(SoftwareRasterizer::FragmentBatch& batch) // reads batch.varyings, writes batch.color
+*
+* Depth test is GL_LESS with depth writes, no blending, no face culling (the GL defaults the demos run with).
+* Varyings are interpolated perspective correct, depth is interpolated linearly in screen space.
+*/
+
+const int RASTER_TILE_SIZE = 64;
+const int RASTER_MAX_VARYINGS = 16;
+const int RASTER_FRAGMENT_BATCH = 16;
+
+struct SoftwareFramebuffer {
+    int width = 0, height = 0;
+    std::vector<uint32_t> color; // RGBA8, bottom row first like glReadPixels
+    std::vector<float> depth;
+
+    SoftwareFramebuffer(int width, int height) : width(width), height(height), color(width * height), depth(width * height) {
+    }
+
+    void clear(glm::vec4 clearColor, float clearDepth = 1.0f) {
+        std::fill(color.begin(), color.end(), packColor(clearColor));
+        std::fill(depth.begin(), depth.end(), clearDepth);
+    }
+
+    static uint32_t packColor(glm::vec4 c) {
+        c = glm::clamp(c, 0.0f, 1.0f) * 255.0f + 0.5f;
+        return (uint32_t)c.r | ((uint32_t)c.g << 8) | ((uint32_t)c.b << 16) | ((uint32_t)c.a << 24);
+    }
+
+    // Binary PPM, flipped so the image is upright
+    bool savePPM(const char* path) const {
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            return false;
+        }
+        fprintf(file, "P6\n%d %d\n255\n", width, height);
+        std::vector<unsigned char> row(width * 3);
+        for (int y = height - 1; y >= 0; y--) {
+            for (int x = 0; x < width; x++) {
+                uint32_t c = color[y * width + x];
+                row[x * 3] = c & 0xff;
+                row[x * 3 + 1] = (c >> 8) & 0xff;
+                row[x * 3 + 2] = (c >> 16) & 0xff;
+            }
+            fwrite(row.data(), 1, row.size(), file);
+        }
+        fclose(file);
+        return true;
+    }
+};
+
+// Base level only, bilinear filtering with GL_REPEAT wrapping, rows in file order like loadImage uploads them
+struct SoftwareTexture {
+    int width = 0, height = 0, channels = 0;
+    std::vector<unsigned char> pixels;
+
+    bool load(const char* path) {
+        unsigned char* data = stbi_load(path, &width, &height, &channels, 0);
+        if (!data) {
+            printf("Texture failed to load at path: %s\n", path);
+            return false;
+        }
+        pixels.assign(data, data + width * height * channels);
+        stbi_image_free(data);
+        return true;
+    }
+
+    glm::vec4 texel(int x, int y) const {
+        const unsigned char* p = &pixels[(y * width + x) * channels];
+        switch (channels) {
+        case 1:
+            return glm::vec4(p[0] / 255.0f, 0.0f, 0.0f, 1.0f);
+        case 3:
+            return glm::vec4(p[0], p[1], p[2], 255.0f) / 255.0f;
+        case 4:
+            return glm::vec4(p[0], p[1], p[2], p[3]) / 255.0f;
+        }
+        return glm::vec4(0.0f);
+    }
+
+    glm::vec4 sample(glm::vec2 uv) const {
+        if (pixels.empty()) {
+            return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        }
+        float u = uv.x * width - 0.5f;
+        float v = uv.y * height - 0.5f;
+        float fu = std::floor(u), fv = std::floor(v);
+        int x0 = wrap((int)fu, width), y0 = wrap((int)fv, height);
+        int x1 = wrap(x0 + 1, width), y1 = wrap(y0 + 1, height);
+        float tu = u - fu, tv = v - fv;
+
+        glm::vec4 top = glm::mix(texel(x0, y0), texel(x1, y0), tu);
+        glm::vec4 bottom = glm::mix(texel(x0, y1), texel(x1, y1), tu);
+        return glm::mix(top, bottom, tv);
+    }
+
+private:
+    static int wrap(int i, int size) {
+        i %= size;
+        return i < 0 ? i + size : i;
+    }
+};
+
+class SoftwareRasterizer {
+
+public:
+    struct Stats {
+        long long triangles = 0;  // submitted
+        long long rasterized = 0; // survived clipping and zero area rejection
+        long long fragments = 0;  // passed depth test and were shaded
+    };
+
+    // SoA fragments for the batched draws, lanes past count hold stale but finite data
+    struct FragmentBatch {
+        alignas(32) float varyings[RASTER_MAX_VARYINGS][RASTER_FRAGMENT_BATCH];
+        alignas(32) float color[4][RASTER_FRAGMENT_BATCH];
+        int pixel[RASTER_FRAGMENT_BATCH];
+        int count;
+    };
+
+    bool depthTest = true;
+    Stats stats;
+
+    explicit SoftwareRasterizer(ThreadPool& pool) : pool(pool) {
+    }
+
+    void setFramebuffer(SoftwareFramebuffer* target) {
+        framebuffer = target;
+        tilesX = (target->width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+        tilesY = (target->height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    }
+
+    // glDrawArrays(GL_TRIANGLES, first, count), stride in floats
+    template<class VertexShader, class FragmentShader>
+    void drawArrays(const float* vertices, int stride, int first, int count, int varyingCount, VertexShader vertexShader, FragmentShader fragmentShader) {
+        shadeVertices(vertices + first * stride, stride, count, varyingCount, vertexShader);
+        assemble(NULL, count / 3, varyingCount);
+        rasterize<false>(varyingCount, fragmentShader);
+    }
+
+    // glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, indices), each vertex is shaded once
+    template<class VertexShader, class FragmentShader>
+    void drawElements(const float* vertices, int stride, int vertexCount, const uint32_t* indices, int indexCount, int varyingCount, VertexShader vertexShader, FragmentShader fragmentShader) {
+        shadeVertices(vertices, stride, vertexCount, varyingCount, vertexShader);
+        assemble(indices, indexCount / 3, varyingCount);
+        rasterize<false>(varyingCount, fragmentShader);
+    }
+
+    template<class VertexShader, class BatchFragmentShader>
+    void drawArraysBatched(const float* vertices, int stride, int first, int count, int varyingCount, VertexShader vertexShader, BatchFragmentShader fragmentShader) {
+        shadeVertices(vertices + first * stride, stride, count, varyingCount, vertexShader);
+        assemble(NULL, count / 3, varyingCount);
+        rasterize<true>(varyingCount, fragmentShader);
+    }
+
+    template<class VertexShader, class BatchFragmentShader>
+    void drawElementsBatched(const float* vertices, int stride, int vertexCount, const uint32_t* indices, int indexCount, int varyingCount, VertexShader vertexShader, BatchFragmentShader fragmentShader) {
+        shadeVertices(vertices, stride, vertexCount, varyingCount, vertexShader);
+        assemble(indices, indexCount / 3, varyingCount);
+        rasterize<true>(varyingCount, fragmentShader);
+    }
+
+private:
+    // Screen space triangle, every interpolated value is a plane a*x + b*y + c over window coordinates
+    struct Triangle {
+        float edgeA[3], edgeB[3];
+        double edgeC[3];
+        bool topLeft[3];
+        int minX, minY, maxX, maxY;
+        int planes; // offset into Chunk::planes, (2 + varyingCount) * 3 floats: depth, 1/w, varying/w...
+    };
+
+    struct Chunk {
+        std::vector<Triangle> triangles;
+        std::vector<float> planes;
+        std::vector<std::vector<int>> bins;
+        long long rasterized = 0;
+    };
+
+    ThreadPool& pool;
+    SoftwareFramebuffer* framebuffer = NULL;
+    int tilesX = 0, tilesY = 0;
+
+    // post vertex shader data, 4 clip floats + varyings per vertex
+    std::vector<float> shaded;
+    std::vector<Chunk> chunks;
+
+    template<class VertexShader>
+    void shadeVertices(const float* vertices, int stride, int count, int varyingCount, VertexShader& vertexShader) {
+        int vertexSize = 4 + varyingCount;
+        shaded.resize((size_t)count * vertexSize);
+        const int chunkSize = 1024;
+        int chunkCount = (count + chunkSize - 1) / chunkSize;
+        pool.parallelFor(chunkCount, [&](int chunk) {
+            int end = std::min(count, (chunk + 1) * chunkSize);
+            for (int i = chunk * chunkSize; i < end; i++) {
+                float* out = &shaded[(size_t)i * vertexSize];
+                glm::vec4 clip = vertexShader(vertices + (size_t)i * stride, out + 4);
+                out[0] = clip.x;
+                out[1] = clip.y;
+                out[2] = clip.z;
+                out[3] = clip.w;
+            }
+        });
+    }
+
+    void assemble(const uint32_t* indices, int triangleCount, int varyingCount) {
+        stats.triangles += triangleCount;
+
+        const int minChunk = 256;
+        int chunkCount = std::max(1, std::min((triangleCount + minChunk - 1) / minChunk, pool.size() * 4));
+        int perChunk = (triangleCount + chunkCount - 1) / chunkCount;
+        chunks.resize(chunkCount);
+
+        pool.parallelFor(chunkCount, [&](int c) {
+            Chunk& chunk = chunks[c];
+            chunk.triangles.clear();
+            chunk.planes.clear();
+            chunk.bins.resize(tilesX * tilesY);
+            for (std::vector<int>& bin : chunk.bins) {
+                bin.clear();
+            }
+            chunk.rasterized = 0;
+
+            int vertexSize = 4 + varyingCount;
+            int end = std::min(triangleCount, (c + 1) * perChunk);
+            for (int t = c * perChunk; t < end; t++) {
+                const float* v[3];
+                for (int k = 0; k < 3; k++) {
+                    size_t index = indices ? indices[t * 3 + k] : (size_t)t * 3 + k;
+                    v[k] = &shaded[index * vertexSize];
+                }
+                clipAndSetup(chunk, v, varyingCount);
+            }
+        });
+
+        for (Chunk& chunk : chunks) {
+            stats.rasterized += chunk.rasterized;
+        }
+    }
+
+    // Clips against the near plane (z >= -w), the only plane that matters for the perspective divide,
+    // the rest is handled by clamping the bounds to the viewport
+    void clipAndSetup(Chunk& chunk, const float* v[3], int varyingCount) {
+        int vertexSize = 4 + varyingCount;
+
+        // trivially outside one of the frustum planes
+        for (int axis = 0; axis < 3; axis++) {
+            if (v[0][axis] > v[0][3] && v[1][axis] > v[1][3] && v[2][axis] > v[2][3]) {
+                return;
+            }
+            if (v[0][axis] < -v[0][3] && v[1][axis] < -v[1][3] && v[2][axis] < -v[2][3]) {
+                return;
+            }
+        }
+
+        bool inside[3];
+        int insideCount = 0;
+        for (int k = 0; k < 3; k++) {
+            inside[k] = v[k][2] >= -v[k][3];
+            insideCount += inside[k];
+        }
+        if (insideCount == 3) {
+            setupTriangle(chunk, v[0], v[1], v[2], varyingCount);
+            return;
+        }
+
+        // Sutherland-Hodgman against one plane gives at most 4 vertices
+        float clipped[4][4 + RASTER_MAX_VARYINGS];
+        int clippedCount = 0;
+        for (int k = 0; k < 3; k++) {
+            const float* a = v[k];
+            const float* b = v[(k + 1) % 3];
+            if (inside[k]) {
+                memcpy(clipped[clippedCount++], a, vertexSize * sizeof(float));
+            }
+            if (inside[k] != inside[(k + 1) % 3]) {
+                float da = a[2] + a[3], db = b[2] + b[3];
+                float t = da / (da - db);
+                for (int i = 0; i < vertexSize; i++) {
+                    clipped[clippedCount][i] = a[i] + (b[i] - a[i]) * t;
+                }
+                clippedCount++;
+            }
+        }
+        for (int k = 1; k + 1 < clippedCount; k++) {
+            setupTriangle(chunk, clipped[0], clipped[k], clipped[k + 1], varyingCount);
+        }
+    }
+
+    void setupTriangle(Chunk& chunk, const float* v0, const float* v1, const float* v2, int varyingCount) {
+        const float* v[3] = { v0, v1, v2 };
+        float x[3], y[3], z[3], invW[3];
+        for (int k = 0; k < 3; k++) {
+            invW[k] = 1.0f / v[k][3];
+            // window coordinates, snapped to 1/256 of a pixel so shared edges evaluate identically
+            x[k] = std::round((v[k][0] * invW[k] * 0.5f + 0.5f) * framebuffer->width * 256.0f) / 256.0f;
+            y[k] = std::round((v[k][1] * invW[k] * 0.5f + 0.5f) * framebuffer->height * 256.0f) / 256.0f;
+            z[k] = v[k][2] * invW[k] * 0.5f + 0.5f;
+        }
+
+        // edge k is opposite vertex k
+        double a[3], b[3], c[3];
+        for (int k = 0; k < 3; k++) {
+            int i = (k + 1) % 3, j = (k + 2) % 3;
+            a[k] = (double)y[i] - y[j];
+            b[k] = (double)x[j] - x[i];
+            c[k] = -(a[k] * x[i] + b[k] * y[i]);
+        }
+        double area = a[0] * x[0] + b[0] * y[0] + c[0];
+        if (area == 0.0) {
+            return;
+        }
+        if (area < 0.0) {
+            for (int k = 0; k < 3; k++) {
+                a[k] = -a[k];
+                b[k] = -b[k];
+                c[k] = -c[k];
+            }
+            area = -area;
+        }
+
+        // pixel centers sit at i + 0.5
+        Triangle triangle;
+        triangle.minX = std::max(0, (int)std::ceil(std::min({ x[0], x[1], x[2] }) - 0.5f));
+        triangle.minY = std::max(0, (int)std::ceil(std::min({ y[0], y[1], y[2] }) - 0.5f));
+        triangle.maxX = std::min(framebuffer->width - 1, (int)std::floor(std::max({ x[0], x[1], x[2] }) - 0.5f));
+        triangle.maxY = std::min(framebuffer->height - 1, (int)std::floor(std::max({ y[0], y[1], y[2] }) - 0.5f));
+        if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) {
+            return;
+        }
+
+        for (int k = 0; k < 3; k++) {
+            triangle.edgeA[k] = (float)a[k];
+            triangle.edgeB[k] = (float)b[k];
+            triangle.edgeC[k] = c[k];
+            triangle.topLeft[k] = a[k] > 0.0 || (a[k] == 0.0 && b[k] < 0.0);
+        }
+
+        // attribute planes from the normalized barycentrics E_k / area
+        triangle.planes = (int)chunk.planes.size();
+        auto addPlane = [&](float f0, float f1, float f2) {
+            double f[3] = { f0, f1, f2 };
+            double pa = 0.0, pb = 0.0, pc = 0.0;
+            for (int k = 0; k < 3; k++) {
+                pa += a[k] * f[k];
+                pb += b[k] * f[k];
+                pc += c[k] * f[k];
+            }
+            chunk.planes.push_back((float)(pa / area));
+            chunk.planes.push_back((float)(pb / area));
+            chunk.planes.push_back((float)(pc / area));
+        };
+        addPlane(z[0], z[1], z[2]);
+        addPlane(invW[0], invW[1], invW[2]);
+        for (int i = 0; i < varyingCount; i++) {
+            addPlane(v0[4 + i] * invW[0], v1[4 + i] * invW[1], v2[4 + i] * invW[2]);
+        }
+
+        int index = (int)chunk.triangles.size();
+        chunk.triangles.push_back(triangle);
+        chunk.rasterized++;
+
+        for (int ty = triangle.minY / RASTER_TILE_SIZE; ty <= triangle.maxY / RASTER_TILE_SIZE; ty++) {
+            for (int tx = triangle.minX / RASTER_TILE_SIZE; tx <= triangle.maxX / RASTER_TILE_SIZE; tx++) {
+                chunk.bins[ty * tilesX + tx].push_back(index);
+            }
+        }
+    }
+
+    // Tile local copy of the framebuffer, padded to full tile size so 4 wide loads never run off the edge
+    struct TileBuffer {
+        alignas(16) float depth[RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+        alignas(16) uint32_t color[RASTER_TILE_SIZE * RASTER_TILE_SIZE];
+    };
+
+    template<bool Batched, class FragmentShader>
+    void rasterize(int varyingCount, FragmentShader& fragmentShader) {
+        std::atomic<long long> fragments{ 0 };
+
+        pool.parallelFor(tilesX * tilesY, [&](int tile) {
+            int tileX = (tile % tilesX) * RASTER_TILE_SIZE;
+            int tileY = (tile / tilesX) * RASTER_TILE_SIZE;
+            int tileWidth = std::min(RASTER_TILE_SIZE, framebuffer->width - tileX);
+            int tileHeight = std::min(RASTER_TILE_SIZE, framebuffer->height - tileY);
+
+            bool empty = true;
+            for (Chunk& chunk : chunks) {
+                empty = empty && chunk.bins[tile].empty();
+            }
+            if (empty) {
+                return;
+            }
+
+            TileBuffer buffer;
+            for (int y = 0; y < tileHeight; y++) {
+                size_t row = (size_t)(tileY + y) * framebuffer->width + tileX;
+                memcpy(&buffer.depth[y * RASTER_TILE_SIZE], &framebuffer->depth[row], tileWidth * sizeof(float));
+                memcpy(&buffer.color[y * RASTER_TILE_SIZE], &framebuffer->color[row], tileWidth * sizeof(uint32_t));
+            }
+
+            long long tileFragments = 0;
+            if constexpr (Batched) {
+                // colors land in queue order, so a later triangle still overwrites an earlier one
+                FragmentBatch batch = {};
+                auto flush = [&] {
+                    fragmentShader(batch);
+                    for (int lane = 0; lane < batch.count; lane++) {
+                        glm::vec4 color(batch.color[0][lane], batch.color[1][lane], batch.color[2][lane], batch.color[3][lane]);
+                        buffer.color[batch.pixel[lane]] = SoftwareFramebuffer::packColor(color);
+                    }
+                    batch.count = 0;
+                };
+                auto emit = [&](int pixel, const float* varyings) {
+                    for (int i = 0; i < varyingCount; i++) {
+                        batch.varyings[i][batch.count] = varyings[i];
+                    }
+                    batch.pixel[batch.count++] = pixel;
+                    if (batch.count == RASTER_FRAGMENT_BATCH) {
+                        flush();
+                    }
+                };
+                for (Chunk& chunk : chunks) {
+                    for (int index : chunk.bins[tile]) {
+                        tileFragments += rasterizeTriangle(buffer, tileX, tileY, tileWidth, tileHeight,
+                            chunk.triangles[index], &chunk.planes[chunk.triangles[index].planes], varyingCount, emit);
+                    }
+                }
+                if (batch.count > 0) {
+                    flush();
+                }
+            }
+            else {
+                auto emit = [&](int pixel, const float* varyings) {
+                    buffer.color[pixel] = SoftwareFramebuffer::packColor(fragmentShader(varyings));
+                };
+                for (Chunk& chunk : chunks) {
+                    for (int index : chunk.bins[tile]) {
+                        tileFragments += rasterizeTriangle(buffer, tileX, tileY, tileWidth, tileHeight,
+                            chunk.triangles[index], &chunk.planes[chunk.triangles[index].planes], varyingCount, emit);
+                    }
+                }
+            }
+            fragments += tileFragments;
+
+            for (int y = 0; y < tileHeight; y++) {
+                size_t row = (size_t)(tileY + y) * framebuffer->width + tileX;
+                memcpy(&framebuffer->depth[row], &buffer.depth[y * RASTER_TILE_SIZE], tileWidth * sizeof(float));
+                memcpy(&framebuffer->color[row], &buffer.color[y * RASTER_TILE_SIZE], tileWidth * sizeof(uint32_t));
+            }
+        });
+
+        stats.fragments += fragments;
+    }
+
+    // Calls emit(pixel, varyings) for every fragment that passes the depth test, pixel indexes the tile buffer
+    template<class Emit>
+    long long rasterizeTriangle(TileBuffer& buffer, int tileX, int tileY, int tileWidth, int tileHeight,
+        const Triangle& triangle, const float* planes, int varyingCount, Emit& emit) {
+
+        // bounds relative to the tile
+        int x0 = std::max(triangle.minX - tileX, 0);
+        int y0 = std::max(triangle.minY - tileY, 0);
+        int x1 = std::min(triangle.maxX - tileX, tileWidth - 1);
+        int y1 = std::min(triangle.maxY - tileY, tileHeight - 1);
+        if (x0 > x1 || y0 > y1) {
+            return 0;
+        }
+
+        // rebase every plane on the tile origin, keeps the per pixel math small and precise
+        float edgeC[3];
+        for (int k = 0; k < 3; k++) {
+            edgeC[k] = (float)(triangle.edgeC[k] + (double)triangle.edgeA[k] * tileX + (double)triangle.edgeB[k] * tileY);
+        }
+        int planeCount = 2 + varyingCount;
+        float planeA[2 + RASTER_MAX_VARYINGS], planeB[2 + RASTER_MAX_VARYINGS], planeC[2 + RASTER_MAX_VARYINGS];
+        for (int i = 0; i < planeCount; i++) {
+            planeA[i] = planes[i * 3];
+            planeB[i] = planes[i * 3 + 1];
+            planeC[i] = planes[i * 3 + 2] + planeA[i] * tileX + planeB[i] * tileY;
+        }
+
+        long long fragments = 0;
+        float varyings[RASTER_MAX_VARYINGS];
+
+        auto shade = [&](int x, int y, float px, float py) {
+            float w = 1.0f / (planeA[1] * px + planeB[1] * py + planeC[1]);
+            for (int i = 0; i < varyingCount; i++) {
+                varyings[i] = (planeA[i + 2] * px + planeB[i + 2] * py + planeC[i + 2]) * w;
+            }
+            emit(y * RASTER_TILE_SIZE + x, varyings);
+            fragments++;
+        };
+
+#if defined(SIMD_SSE2)
+        const __m128 zero = _mm_setzero_ps();
+        __m128 edgeA[3], topLeftMask[3];
+        for (int k = 0; k < 3; k++) {
+            edgeA[k] = _mm_set1_ps(triangle.edgeA[k]);
+            topLeftMask[k] = _mm_castsi128_ps(_mm_set1_epi32(triangle.topLeft[k] ? -1 : 0));
+        }
+        const __m128 depthA = _mm_set1_ps(planeA[0]);
+        const __m128 spanStep = _mm_set1_ps(4.0f);
+        const __m128i laneStep = _mm_set1_epi32(4);
+
+        // 4 pixel wide spans, x0 rounded down so depth/color loads stay 16 byte aligned
+        int spanStart = x0 & ~3;
+        const __m128 startX = _mm_add_ps(_mm_set1_ps((float)spanStart), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+        const __m128i startLanes = _mm_add_epi32(_mm_set1_epi32(spanStart), _mm_set_epi32(3, 2, 1, 0));
+        const __m128i beforeFirst = _mm_set1_epi32(x0 - 1), afterLast = _mm_set1_epi32(x1 + 1);
+
+        for (int y = y0; y <= y1; y++) {
+            float py = y + 0.5f;
+            // every span evaluates the planes directly instead of stepping them, so shared edges stay watertight
+            __m128 rowE[3];
+            for (int k = 0; k < 3; k++) {
+                rowE[k] = _mm_set1_ps(triangle.edgeB[k] * py + edgeC[k]);
+            }
+            __m128 rowZ = _mm_set1_ps(planeB[0] * py + planeC[0]);
+            __m128 px = startX;
+            __m128i lanes = startLanes;
+
+            for (int x = spanStart; x <= x1; x += 4) {
+                // lanes inside all three edges and inside the clamped bounds
+                __m128 mask = _mm_castsi128_ps(_mm_and_si128(_mm_cmpgt_epi32(lanes, beforeFirst), _mm_cmplt_epi32(lanes, afterLast)));
+                for (int k = 0; k < 3; k++) {
+                    __m128 e = _mm_add_ps(_mm_mul_ps(edgeA[k], px), rowE[k]);
+                    __m128 covered = _mm_or_ps(_mm_cmpgt_ps(e, zero), _mm_and_ps(_mm_cmpeq_ps(e, zero), topLeftMask[k]));
+                    mask = _mm_and_ps(mask, covered);
+                }
+                __m128 spanZ = _mm_add_ps(_mm_mul_ps(depthA, px), rowZ);
+                px = _mm_add_ps(px, spanStep);
+                lanes = _mm_add_epi32(lanes, laneStep);
+
+                if (!_mm_movemask_ps(mask)) {
+                    continue;
+                }
+
+                if (depthTest) {
+                    float* depthRow = &buffer.depth[y * RASTER_TILE_SIZE + x];
+                    __m128 stored = _mm_load_ps(depthRow);
+                    mask = _mm_and_ps(mask, _mm_cmplt_ps(spanZ, stored));
+                    _mm_store_ps(depthRow, _mm_or_ps(_mm_and_ps(mask, spanZ), _mm_andnot_ps(mask, stored)));
+                }
+
+                int laneMask = _mm_movemask_ps(mask);
+                while (laneMask) {
+                    int lane = laneMask & 1 ? 0 : laneMask & 2 ? 1 : laneMask & 4 ? 2 : 3;
+                    laneMask &= laneMask - 1;
+                    shade(x + lane, y, x + lane + 0.5f, py);
+                }
+            }
+        }
+#else
+        for (int y = y0; y <= y1; y++) {
+            float py = y + 0.5f;
+            for (int x = x0; x <= x1; x++) {
+                float px = x + 0.5f;
+                bool inside = true;
+                for (int k = 0; k < 3; k++) {
+                    float e = triangle.edgeA[k] * px + triangle.edgeB[k] * py + edgeC[k];
+                    inside = inside && (e > 0.0f || (e == 0.0f && triangle.topLeft[k]));
+                }
+                if (!inside) {
+                    continue;
+                }
+
+                float z = planeA[0] * px + planeB[0] * py + planeC[0];
+                float& stored = buffer.depth[y * RASTER_TILE_SIZE + x];
+                if (depthTest) {
+                    if (!(z < stored)) {
+                        continue;
+                    }
+                    stored = z;
+                }
+                shade(x, y, px, py);
+            }
+        }
+#endif
+        return fragments;
+    }
+};
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "ThreadPool.h"
+#include "MipGenerator.h"
+#include "stb_image.h"
+
+/*
+* Packs many textures into the layers of one GL_TEXTURE_2D_ARRAY, so objects with different maps can share a single
+* bound texture and be drawn in one instanced call.
+*
+*     TextureArray atlas;                                          // 2048 x 2048 layers, 8 texel gutters
+*     int diffuse = atlas.add("resources/container2.png");        // region index, the same path gives the same index
+*     int specular = atlas.add("resources/container2_specular.png");
+*     atlas.build(&pool);                                          // packs, builds the mips and uploads
+*     glBindTexture(GL_TEXTURE_2D_ARRAY, atlas.id());
+*     const TextureArrayRegion& region = atlas.region(diffuse);    // layer plus uv scale and offset for the shader
+*
+* Regions are placed with a skyline packer (tallest first, lowest then leftmost fit), trying every layer before
+* opening a new one. Each image gets a gutter of padding texels filled from its own edges, and positions and sizes
+* are rounded to padding, so down to mip level log2(padding) box filtering never mixes two regions and bilinear
+* filtering still reads the region's own gutter. The chain stops there (GL_TEXTURE_MAX_LEVEL), smaller levels would
+* bleed. Layers grow to the next power of two when an image doesn't fit the size asked for.
+* Everything is stored RGBA8. A shader repeats a region with fract() and samples with textureGrad() on the unwrapped
+* uv so the seam doesn't pick the smallest mip, see shaders/arraySpotlightFrag.glsl.
+*/
+
+struct TextureArrayRegion {
+    int layer = 0;
+    int x = 0, y = 0;            // first texel of the image in the layer, gutter excluded
+    int width = 0, height = 0;
+    glm::vec4 scaleOffset;       // layer uv = uv * xy + zw
+};
+
+struct TextureArrayStats {
+    int textures;
+    int layers;
+    int layerSize;
+    int levels;
+    size_t imageTexels;    // the images themselves
+    size_t paddedTexels;   // with gutters and rounding
+    size_t layerTexels;    // every layer allocated
+    size_t bytes;          // uploaded, mips included
+    double packMs;
+    double mipMs;
+    double uploadMs;
+};
+
+class TextureArray {
+
+public:
+    explicit TextureArray(int layerSize = 2048, int padding = 8, bool flipVertically = false)
+        : requestedSize(layerSize), padding(std::max(1, padding)), flipVertically(flipVertically) {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    ~TextureArray() {
+        release();
+    }
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    // Region index for the image at path, -1 if it can't be decoded or the array is already built
+    int add(const char* path) {
+        for (size_t i = 0; i < images.size(); i++) {
+            if (images[i].path == path) {
+                return (int)i;
+            }
+        }
+        int width, height, components;
+        stbi_set_flip_vertically_on_load_thread(flipVertically);
+        unsigned char* data = stbi_load(path, &width, &height, &components, 4);
+        if (!data) {
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+            return -1;
+        }
+        int index = add(data, width, height, 4);
+        stbi_image_free(data);
+        if (index < 0) {
+            return -1;
+        }
+        images[index].path = path;
+        return index;
+    }
+
+    // Region index for pixels (1 to 4 channels, expanded to RGBA like GL does: grey, grey and alpha)
+    int add(const unsigned char* pixels, int width, int height, int components) {
+        if (built) {
+            std::cout << "ERROR::TEXTURE_ARRAY::ALREADY_BUILT" << std::endl;
+            return -1;
+        }
+        Image image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize((size_t)width * height * 4);
+        for (size_t i = 0; i < (size_t)width * height; i++) {
+            const unsigned char* in = &pixels[i * components];
+            unsigned char* out = &image.pixels[i * 4];
+            out[0] = in[0];
+            out[1] = components >= 3 ? in[1] : in[0];
+            out[2] = components >= 3 ? in[2] : in[0];
+            out[3] = components == 4 ? in[3] : components == 2 ? in[1] : 255;
+        }
+        images.push_back(std::move(image));
+        regions.push_back(TextureArrayRegion());
+        return (int)images.size() - 1;
+    }
+
+    // Packs everything added into the array texture, once. The decoded images are released afterwards.
+    // srgb filters the mips in linear light, like TextureCooker does by default; false when the layers hold data
+    bool build(ThreadPool* pool = NULL, bool srgb = true) {
+        if (built) {
+            std::cout << "ERROR::TEXTURE_ARRAY::ALREADY_BUILT" << std::endl;
+            return false;
+        }
+        if (images.empty()) {
+            std::cout << "ERROR::TEXTURE_ARRAY::EMPTY" << std::endl;
+            return false;
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        int levels = 1;
+        while ((1 << levels) <= padding) {
+            levels++;
+        }
+        int size = std::max(requestedSize, 1);
+        for (const Image& image : images) {
+            size = std::max(size, std::max(footprint(image.width), footprint(image.height)));
+        }
+        int layerSize = 1;
+        while (layerSize < size) {
+            layerSize *= 2;
+        }
+        levels = std::min(levels, MipGenerator::levelCount(layerSize, layerSize));
+
+        std::vector<int> order(images.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = (int)i;
+        }
+        std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+            return images[a].height != images[b].height ? images[a].height > images[b].height : images[a].width > images[b].width;
+        });
+
+        std::vector<std::vector<Segment>> skylines;
+        memset(&stats, 0, sizeof(stats));
+        for (int index : order) {
+            int width = footprint(images[index].width), height = footprint(images[index].height);
+            int layer = 0, x = 0, y = 0;
+            for (; layer < (int)skylines.size(); layer++) {
+                if (place(skylines[layer], layerSize, width, height, x, y)) {
+                    break;
+                }
+            }
+            if (layer == (int)skylines.size()) {
+                skylines.push_back({ { 0, 0, layerSize } });
+                place(skylines[layer], layerSize, width, height, x, y);
+            }
+            TextureArrayRegion& region = regions[index];
+            region.layer = layer;
+            region.x = x + padding;
+            region.y = y + padding;
+            region.width = images[index].width;
+            region.height = images[index].height;
+            region.scaleOffset = glm::vec4((float)region.width / layerSize, (float)region.height / layerSize,
+                (float)region.x / layerSize, (float)region.y / layerSize);
+            stats.imageTexels += (size_t)region.width * region.height;
+            stats.paddedTexels += (size_t)width * height;
+        }
+        stats.textures = (int)images.size();
+        stats.layers = (int)skylines.size();
+        stats.layerSize = layerSize;
+        stats.levels = levels;
+        stats.layerTexels = (size_t)layerSize * layerSize * stats.layers;
+        stats.packMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        for (int level = 0; level < levels; level++) {
+            int levelSize = std::max(layerSize >> level, 1);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, levelSize, levelSize, stats.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+
+        MipGenerator mips(MIP_FILTER_BOX, srgb, pool);
+        std::vector<unsigned char> layerPixels((size_t)layerSize * layerSize * 4);
+        for (int layer = 0; layer < stats.layers; layer++) {
+            auto mipStart = std::chrono::high_resolution_clock::now();
+            std::fill(layerPixels.begin(), layerPixels.end(), 0);
+            auto copyRows = [&](int index) {
+                if (regions[index].layer == layer) {
+                    blit(images[index], regions[index], layerPixels.data(), layerSize);
+                }
+            };
+            if (pool) {
+                pool->parallelFor((int)images.size(), copyRows);
+            }
+            else {
+                for (int i = 0; i < (int)images.size(); i++) {
+                    copyRows(i);
+                }
+            }
+            std::vector<std::vector<unsigned char>> chain;
+            if (levels > 1) {
+                chain = mips.generate(layerPixels.data(), layerSize, layerSize, 4, levels - 1);
+            }
+            auto uploadStart = std::chrono::high_resolution_clock::now();
+            stats.mipMs += std::chrono::duration<double, std::milli>(uploadStart - mipStart).count();
+
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, layerSize, layerSize, 1, GL_RGBA, GL_UNSIGNED_BYTE, layerPixels.data());
+            stats.bytes += layerPixels.size();
+            for (int level = 1; level < levels; level++) {
+                int levelSize = std::max(layerSize >> level, 1);
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, levelSize, levelSize, 1, GL_RGBA, GL_UNSIGNED_BYTE, chain[level - 1].data());
+                stats.bytes += chain[level - 1].size();
+            }
+            stats.uploadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - uploadStart).count();
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // paths stay, add() of a known path still returns its region
+        for (Image& image : images) {
+            image.pixels.clear();
+            image.pixels.shrink_to_fit();
+        }
+        built = true;
+        return true;
+    }
+
+    // Deletes the texture, for when the array outlives the context
+    void release() {
+        if (texture) {
+            glDeleteTextures(1, &texture);
+            texture = 0;
+        }
+    }
+
+    unsigned int id() const {
+        return texture;
+    }
+
+    int count() const {
+        return (int)regions.size();
+    }
+
+    // Only placed after build()
+    const TextureArrayRegion& region(int index) const {
+        return regions[index];
+    }
+
+    // Image texels over allocated layer texels
+    float efficiency() const {
+        return stats.layerTexels ? (float)stats.imageTexels / stats.layerTexels : 0.0f;
+    }
+
+    const TextureArrayStats& getStats() const {
+        return stats;
+    }
+
+    void report() const {
+        printf("texture array: %d textures in %d layers of %d x %d (%d levels), %.1f%% of the texels are images (%.1f%% with gutters), "
+            "%.1f MB, packed in %.3f ms, mips %.3f ms, upload %.3f ms\n", stats.textures, stats.layers, stats.layerSize,
+            stats.layerSize, stats.levels, efficiency() * 100.0f,
+            stats.layerTexels ? 100.0 * stats.paddedTexels / stats.layerTexels : 0.0, stats.bytes / (1024.0 * 1024.0),
+            stats.packMs, stats.mipMs, stats.uploadMs);
+    }
+
+private:
+    struct Image {
+        std::string path;
+        int width = 0, height = 0;
+        std::vector<unsigned char> pixels;   // RGBA, until build()
+    };
+
+    // A horizontal run of the skyline: everything below y is taken from x to x + width
+    struct Segment {
+        int x, y, width;
+    };
+
+    int requestedSize;
+    int padding;
+    bool flipVertically;
+    bool built = false;
+    unsigned int texture = 0;
+    std::vector<Image> images;
+    std::vector<TextureArrayRegion> regions;
+    TextureArrayStats stats;
+
+    // Image plus gutters on both sides, rounded up to padding so every region starts on a padding boundary
+    int footprint(int size) const {
+        return (size + 2 * padding + padding - 1) / padding * padding;
+    }
+
+    // Lowest top, then narrowest waste, over every segment the rectangle could start at. Updates the skyline
+    static bool place(std::vector<Segment>& skyline, int layerSize, int width, int height, int& x, int& y) {
+        int best = -1, bestY = 0, bestWaste = 0;
+        for (int i = 0; i < (int)skyline.size(); i++) {
+            int left = skyline[i].x;
+            if (left + width > layerSize) {
+                break;
+            }
+            // the rectangle rests on the highest segment it spans
+            int top = 0, waste = 0, covered = 0;
+            for (int j = i; j < (int)skyline.size() && covered < width; j++) {
+                top = std::max(top, skyline[j].y);
+                covered = skyline[j].x + skyline[j].width - left;
+            }
+            if (top + height > layerSize) {
+                continue;
+            }
+            covered = 0;
+            for (int j = i; j < (int)skyline.size() && covered < width; j++) {
+                int span = std::min(skyline[j].x + skyline[j].width, left + width) - std::max(skyline[j].x, left);
+                waste += span * (top - skyline[j].y);
+                covered = skyline[j].x + skyline[j].width - left;
+            }
+            if (best < 0 || top < bestY || (top == bestY && waste < bestWaste)) {
+                best = i;
+                bestY = top;
+                bestWaste = waste;
+            }
+        }
+        if (best < 0) {
+            return false;
+        }
+        x = skyline[best].x;
+        y = bestY;
+
+        // the new segment replaces what it covers, a partly covered segment keeps its right part
+        Segment added = { x, y + height, width };
+        int end = x + width;
+        std::vector<Segment> updated;
+        updated.reserve(skyline.size() + 2);
+        for (const Segment& segment : skyline) {
+            int segmentEnd = segment.x + segment.width;
+            if (segmentEnd <= x || segment.x >= end) {
+                if (segment.x >= end && (updated.empty() || updated.back().x < x)) {
+                    updated.push_back(added);
+                }
+                updated.push_back(segment);
+            }
+            else if (segmentEnd > end) {
+                if (updated.empty() || updated.back().x < x) {
+                    updated.push_back(added);
+                }
+                updated.push_back({ end, segment.y, segmentEnd - end });
+            }
+        }
+        if (updated.empty() || updated.back().x < x) {
+            updated.push_back(added);
+        }
+        // neighbours at the same height merge, which keeps the skyline short
+        skyline.clear();
+        for (const Segment& segment : updated) {
+            if (!skyline.empty() && skyline.back().y == segment.y) {
+                skyline.back().width += segment.width;
+            }
+            else {
+                skyline.push_back(segment);
+            }
+        }
+        return true;
+    }
+
+    // Copies the image into its region and extends its edge texels out across the gutter
+    void blit(const Image& image, const TextureArrayRegion& region, unsigned char* layer, int layerSize) const {
+        int width = footprint(image.width), height = footprint(image.height);
+        int left = region.x - padding, bottom = region.y - padding;
+        for (int y = 0; y < height; y++) {
+            int sourceY = std::min(std::max(y - padding, 0), image.height - 1);
+            const unsigned char* in = &image.pixels[(size_t)sourceY * image.width * 4];
+            unsigned char* out = &layer[((size_t)(bottom + y) * layerSize + left) * 4];
+            for (int x = 0; x < width; x++) {
+                int sourceX = std::min(std::max(x - padding, 0), image.width - 1);
+                memcpy(&out[x * 4], &in[sourceX * 4], 4);
+            }
+        }
+    }
+};
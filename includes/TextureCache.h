@@ -0,0 +1,358 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include <filesystem>
+#include "MappedFile.h"
+#include "TextureLoader.h"
+#include "Profiler.h"
+#include "stb_image.h"
+
+/*
+* Shares textures between everything in a process that asks for the same image, keyed by path plus a hash of the
+* file's contents, so two paths to identical bytes also end up on one texture.
+*
+*     ThreadPool pool;
+*     TextureLoader textures(pool);
+*     TextureCache cache(textures, 64 * 1024 * 1024);                         // budget in bytes
+*     TextureHandle diffuseMap = cache.acquire("resources/container2.png");   // GL texture through the loader
+*     TextureHandle emission = cache.acquireImage("resources/7a9.jpg");       // decoded pixels, no GL
+*     textures.finish();
+*     glBindTexture(GL_TEXTURE_2D, diffuseMap.id());
+*
+* Handles are reference counted, copying one shares the entry. Once the last handle to an entry is gone it stays
+* resident and a later acquire is still a hit, it only goes (least recently released first) when the bytes resident
+* are over budget. Entries that are still referenced are never evicted, so the budget can be overshot while they are
+* all in use. The hash is only recomputed when a path's size or modification time changes.
+* Call everything on the GL thread. Let the handles go before the cache, and trim() before the context goes away.
+*/
+
+struct CachedImage {
+    int width = 0, height = 0, components = 0;
+    std::vector<unsigned char> pixels;
+};
+
+struct TextureCacheStats {
+    int hits;
+    int deduplicated;       // the hits whose content came in under a different path
+    int misses;
+    int evictions;
+    int failed;
+    size_t bytesResident;   // GL textures (estimated, mips included) plus decoded images
+    size_t peakBytes;
+    double hashMs;
+};
+
+struct TextureCacheEntry {
+    uint64_t key = 0;
+    std::string path;                         // the one it was first loaded from
+    unsigned int texture = 0;
+    size_t textureBytes = 0;
+    bool hasImage = false;
+    CachedImage image;
+    int references = 0;
+    std::list<uint64_t>::iterator released;   // position in the LRU list while references is 0
+};
+
+class TextureCache;
+
+class TextureHandle {
+
+public:
+    TextureHandle() = default;
+    TextureHandle(const TextureHandle& other);
+    TextureHandle(TextureHandle&& other) noexcept;
+    TextureHandle& operator=(TextureHandle other) noexcept;
+    ~TextureHandle();
+
+    // 0 for an empty handle or one from acquireImage()
+    unsigned int id() const {
+        return entry ? entry->texture : 0;
+    }
+
+    // NULL unless the entry was acquired through acquireImage()
+    const CachedImage* image() const {
+        return entry && entry->hasImage ? &entry->image : NULL;
+    }
+
+    explicit operator bool() const {
+        return entry != NULL;
+    }
+
+    void reset();
+
+private:
+    friend class TextureCache;
+
+    TextureHandle(TextureCache* cache, TextureCacheEntry* entry);
+
+    TextureCache* cache = NULL;
+    TextureCacheEntry* entry = NULL;
+};
+
+class TextureCache {
+
+public:
+    explicit TextureCache(TextureLoader& loader, size_t budget = SIZE_MAX) : loader(loader), budget(budget) {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    ~TextureCache() {
+        for (auto& item : entries) {
+            if (item.second.texture) {
+                glDeleteTextures(1, &item.second.texture);
+            }
+        }
+    }
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // GL texture for path, queued on the loader on a miss (or uploaded right away when cooked). Empty if the file can't be read
+    TextureHandle acquire(const char* path) {
+        PROFILE_ZONE("TextureCache::acquire");
+        TextureCacheEntry* entry = find(path);
+        if (!entry) {
+            return TextureHandle();
+        }
+        TextureHandle handle(this, entry);   // referenced before anything resident changes, so evict() leaves it alone
+        if (!entry->texture) {
+            int width = 0, height = 0, components = 0;
+            if (!stbi_info(path, &width, &height, &components) && !TextureFile::isCooked(path)) {
+                std::cout << "Texture failed to load at path: " << path << std::endl;
+                stats.failed++;
+                return TextureHandle();
+            }
+            size_t cookedBytes = loader.getStats().bytes;
+            entry->texture = loader.load(path);
+            cookedBytes = loader.getStats().bytes - cookedBytes;
+            // the loader only knows the size after a threaded decode, drivers pad RGB to 4 bytes
+            entry->textureBytes = cookedBytes ? cookedBytes : (size_t)width * height * (components == 3 ? 4 : components) * 4 / 3;
+            resident(entry->textureBytes);
+        }
+        return handle;
+    }
+
+    // Decoded pixels for path, flipped like the loader's textures. Empty if the file can't be decoded
+    TextureHandle acquireImage(const char* path) {
+        TextureCacheEntry* entry = find(path);
+        if (!entry) {
+            return TextureHandle();
+        }
+        TextureHandle handle(this, entry);
+        if (!entry->hasImage) {
+            CachedImage& image = entry->image;
+            stbi_set_flip_vertically_on_load_thread(loader.flipsVertically());
+            unsigned char* data = stbi_load(path, &image.width, &image.height, &image.components, 0);
+            if (!data) {
+                std::cout << "Texture failed to load at path: " << path << std::endl;
+                stats.failed++;
+                return TextureHandle();
+            }
+            image.pixels.assign(data, data + (size_t)image.width * image.height * image.components);
+            stbi_image_free(data);
+            entry->hasImage = true;
+            resident(image.pixels.size());
+        }
+        return handle;
+    }
+
+    // Evicts straight away if the new budget is already exceeded
+    void setBudget(size_t bytes) {
+        budget = bytes;
+        evict();
+    }
+
+    // Drops every entry nothing references, textures included
+    void trim() {
+        size_t saved = budget;
+        budget = 0;
+        evict();
+        budget = saved;
+    }
+
+    const TextureCacheStats& getStats() const {
+        return stats;
+    }
+
+    void report() const {
+        printf("texture cache: %d hits (%d by content), %d misses, %d evictions, %.1f KB resident (%.1f KB peak)\n", stats.hits,
+            stats.deduplicated, stats.misses, stats.evictions, stats.bytesResident / 1024.0, stats.peakBytes / 1024.0);
+    }
+
+private:
+    friend class TextureHandle;
+
+    struct PathInfo {
+        uintmax_t size;
+        std::filesystem::file_time_type modified;
+        uint64_t key;
+    };
+
+    TextureLoader& loader;
+    size_t budget;
+    std::unordered_map<std::string, PathInfo> paths;           // kept past eviction, the hash is still good
+    std::unordered_map<uint64_t, TextureCacheEntry> entries;   // nodes don't move, handles point into them
+    std::list<uint64_t> released;                              // unreferenced entries, most recently released first
+    TextureCacheStats stats;
+
+    // Entry for the contents of path, created empty on a miss. NULL when the file can't be read
+    TextureCacheEntry* find(const char* path) {
+        uint64_t key;
+        if (!contentKey(path, key)) {
+            std::cout << "Texture failed to load at path: " << path << std::endl;
+            stats.failed++;
+            return NULL;
+        }
+
+        auto found = entries.find(key);
+        if (found == entries.end()) {
+            stats.misses++;
+            TextureCacheEntry& entry = entries[key];
+            entry.key = key;
+            entry.path = path;
+            entry.released = released.end();
+            return &entry;
+        }
+        stats.hits++;
+        if (found->second.path != path) {
+            stats.deduplicated++;
+        }
+        return &found->second;
+    }
+
+    // Hash of the file's bytes, only read again when the size or modification time changed since the last lookup
+    bool contentKey(const char* path, uint64_t& key) {
+        std::error_code error;
+        // a cooked file can be all there is
+        std::string file = std::filesystem::exists(path, error) ? path : TextureFile::cookedPath(path);
+        uintmax_t size = std::filesystem::file_size(file, error);
+        if (error) {
+            return false;
+        }
+        auto modified = std::filesystem::last_write_time(file, error);
+
+        auto known = paths.find(path);
+        if (known != paths.end() && known->second.size == size && known->second.modified == modified) {
+            key = known->second.key;
+            return true;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        MappedFile mapped(file.c_str());
+        if (!mapped.isOpen()) {
+            return false;
+        }
+        key = hashBytes(mapped.data(), mapped.fileSize());
+        stats.hashMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        paths[path] = { size, modified, key };
+        return true;
+    }
+
+    // FNV-1a over 8 byte words rather than bytes, the length folded in at the end
+    static uint64_t hashBytes(const unsigned char* data, size_t size) {
+        uint64_t hash = 14695981039346656037ull;
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            hash ^= word;
+            hash *= 1099511628211ull;
+        }
+        for (; i < size; i++) {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        hash ^= size;
+        hash ^= hash >> 29;
+        hash *= 0xbf58476d1ce4e5b9ull;
+        return hash ^ (hash >> 32);
+    }
+
+    void resident(size_t bytes) {
+        stats.bytesResident += bytes;
+        stats.peakBytes = std::max(stats.peakBytes, stats.bytesResident);
+        evict();
+    }
+
+    void addReference(TextureCacheEntry* entry) {
+        if (entry->references++ == 0 && entry->released != released.end()) {
+            released.erase(entry->released);
+            entry->released = released.end();
+        }
+    }
+
+    void removeReference(TextureCacheEntry* entry) {
+        if (--entry->references > 0) {
+            return;
+        }
+        if (!entry->texture && !entry->hasImage) {
+            entries.erase(entry->key);   // a miss that failed to load
+        }
+        else {
+            released.push_front(entry->key);
+            entry->released = released.begin();
+            evict();
+        }
+    }
+
+    // Oldest released first. Textures the loader hasn't uploaded yet wait for a later call
+    void evict() {
+        auto candidate = released.end();
+        while (stats.bytesResident > budget && candidate != released.begin()) {
+            --candidate;
+            TextureCacheEntry& entry = entries[*candidate];
+            if (entry.texture && loader.isPending(entry.texture)) {
+                continue;
+            }
+            if (entry.texture) {
+                glDeleteTextures(1, &entry.texture);
+            }
+            stats.bytesResident -= entry.textureBytes + entry.image.pixels.size();
+            stats.evictions++;
+            uint64_t key = entry.key;
+            candidate = released.erase(candidate);
+            entries.erase(key);
+        }
+    }
+};
+
+inline TextureHandle::TextureHandle(TextureCache* cache, TextureCacheEntry* entry) : cache(cache), entry(entry) {
+    cache->addReference(entry);
+}
+
+inline TextureHandle::TextureHandle(const TextureHandle& other) : cache(other.cache), entry(other.entry) {
+    if (entry) {
+        cache->addReference(entry);
+    }
+}
+
+inline TextureHandle::TextureHandle(TextureHandle&& other) noexcept : cache(other.cache), entry(other.entry) {
+    other.cache = NULL;
+    other.entry = NULL;
+}
+
+inline TextureHandle& TextureHandle::operator=(TextureHandle other) noexcept {
+    std::swap(cache, other.cache);
+    std::swap(entry, other.entry);
+    return *this;
+}
+
+inline TextureHandle::~TextureHandle() {
+    reset();
+}
+
+inline void TextureHandle::reset() {
+    if (entry) {
+        cache->removeReference(entry);
+    }
+    cache = NULL;
+    entry = NULL;
+}
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include "MappedFile.h"
+#include "BlockEncoder.h"
+#include "MipGenerator.h"
+#include "GLExtensions.h"
+#include "stb_image.h"
+
+/*
+* Cooked texture container: the image already decoded with its whole mip chain, laid out so the runtime can map
+* the file and hand every level to glTexImage2D without decoding, copying or glGenerateMipmap.
+*
+*     TextureFile::cook("resources/container2.png", TextureFile::cookedPath("resources/container2.png").c_str());
+*     ...
+*     unsigned int texture;
+*     glGenTextures(1, &texture);
+*     TextureFile::upload("resources/container2.png.tex", texture);
+*
+* cook() can block compress every level (BlockEncoder), upload() then goes through glCompressedTexImage2D and fails,
+* so TextureLoader falls back to the image, when the driver lacks the format.
+*
+* Layout (little endian): TextureFileHeader, mipCount TextureFileLevel entries, then the level data, each level
+* starting on a DATA_ALIGNMENT boundary. Rows are tightly packed (GL_UNPACK_ALIGNMENT 1), compressed levels hold
+* their 4x4 blocks in row major order.
+* src/TextureCooker.cpp cooks files offline, TextureLoader picks a cooked file up when it is newer than the source.
+*/
+
+enum TextureFileFormat {
+    TEXTURE_FILE_R8 = 1,
+    TEXTURE_FILE_RG8 = 2,
+    TEXTURE_FILE_RGB8 = 3,
+    TEXTURE_FILE_RGBA8 = 4,
+    TEXTURE_FILE_BC1 = 5,
+    TEXTURE_FILE_BC3 = 6,
+    TEXTURE_FILE_BC7 = 7
+};
+
+// What cook() stores. BC_AUTO picks BC1 for opaque images and BC7 when any texel has alpha below 255
+enum TextureCompression {
+    TEXTURE_COMPRESSION_NONE,
+    TEXTURE_COMPRESSION_BC1,
+    TEXTURE_COMPRESSION_BC3,
+    TEXTURE_COMPRESSION_BC7,
+    TEXTURE_COMPRESSION_BC_AUTO
+};
+
+struct TextureCookSettings {
+    bool flipVertically = false;
+    TextureCompression compression = TEXTURE_COMPRESSION_NONE;
+    MipFilter mipFilter = MIP_FILTER_BOX;
+    bool srgb = true;       // filter the color channels in linear light, see MipGenerator; false for data (normals, masks)
+};
+
+const uint32_t TEXTURE_FILE_FLIPPED = 1; // rows were flipped at cook time (stbi_set_flip_vertically_on_load)
+
+struct TextureFileHeader {
+    char magic[4];          // "GLTX"
+    uint32_t version;
+    uint32_t format;        // TextureFileFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+struct TextureFileLevel {
+    uint64_t offset;        // from the start of the file
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+};
+
+class TextureFile {
+
+public:
+    static const uint32_t VERSION = 1;
+    static const uint64_t DATA_ALIGNMENT = 64;
+
+    // Where the cooker puts the cooked version of an image
+    static std::string cookedPath(const std::string& source) {
+        return source + ".tex";
+    }
+
+    // True when the cooked file exists and is at least as new as the source
+    static bool isCooked(const char* source) {
+        std::error_code error;
+        std::string cooked = cookedPath(source);
+        if (!std::filesystem::exists(cooked, error)) {
+            return false;
+        }
+        auto sourceTime = std::filesystem::last_write_time(source, error);
+        if (error) {
+            return true; // source gone, the cooked file is all there is
+        }
+        return std::filesystem::last_write_time(cooked, error) >= sourceTime && !error;
+    }
+
+    static int mipCount(int width, int height) {
+        return MipGenerator::levelCount(width, height);
+    }
+
+    static bool isCompressed(uint32_t format) {
+        return format >= TEXTURE_FILE_BC1 && format <= TEXTURE_FILE_BC7;
+    }
+
+    static uint64_t levelSize(uint32_t format, int width, int height) {
+        if (isCompressed(format)) {
+            return BlockEncoder::compressedSize(width, height, blockFormat(format));
+        }
+        return (uint64_t)width * height * format;
+    }
+
+    // Whether the current context can sample format, checked once per format
+    static bool isSupported(uint32_t format) {
+        static int s3tc = -1, bptc = -1;
+        if (format == TEXTURE_FILE_BC1 || format == TEXTURE_FILE_BC3) {
+            if (s3tc < 0) {
+                s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+            }
+            return s3tc == 1;
+        }
+        if (format == TEXTURE_FILE_BC7) {
+            if (bptc < 0) {
+                bptc = hasGLVersion(4, 2) || hasGLExtension("GL_ARB_texture_compression_bptc");
+            }
+            return bptc == 1;
+        }
+        return format >= TEXTURE_FILE_R8 && format <= TEXTURE_FILE_RGBA8;
+    }
+
+    // Decodes source with stb_image, builds the mip chain, optionally block compresses it and writes the container
+    // to destination. Filtering and compression are spread over pool when there is one
+    static bool cook(const char* source, const char* destination, const TextureCookSettings& settings = TextureCookSettings(),
+        ThreadPool* pool = NULL) {
+        int width, height, components;
+        stbi_set_flip_vertically_on_load_thread(settings.flipVertically);
+        unsigned char* pixels = stbi_load(source, &width, &height, &components, 0);
+        if (!pixels) {
+            std::cout << "ERROR::TEXTURE_FILE::DECODE_FAILED " << source << std::endl;
+            return false;
+        }
+        bool ok = cook(pixels, width, height, components, destination, settings, pool);
+        stbi_image_free(pixels);
+        return ok;
+    }
+
+    // Same for pixels already in memory (tightly packed rows). settings.flipVertically only sets the header flag,
+    // the rows are written in the order given
+    static bool cook(const unsigned char* pixels, int width, int height, int components, const char* destination,
+        const TextureCookSettings& settings = TextureCookSettings(), ThreadPool* pool = NULL) {
+        TextureFileHeader header;
+        memcpy(header.magic, "GLTX", 4);
+        header.version = VERSION;
+        header.format = (uint32_t)components;
+        TextureCompression compression = settings.compression;
+        if (compression == TEXTURE_COMPRESSION_BC_AUTO) {
+            compression = BlockEncoder::isOpaque(pixels, width, height, components) ? TEXTURE_COMPRESSION_BC1 : TEXTURE_COMPRESSION_BC7;
+        }
+        if (compression != TEXTURE_COMPRESSION_NONE) {
+            header.format = TEXTURE_FILE_BC1 + (compression - TEXTURE_COMPRESSION_BC1);
+        }
+        header.width = width;
+        header.height = height;
+        header.mipCount = mipCount(width, height);
+        header.flags = settings.flipVertically ? TEXTURE_FILE_FLIPPED : 0;
+        header.reserved = 0;
+
+        std::vector<std::vector<unsigned char>> levels;
+        levels.emplace_back(pixels, pixels + (size_t)width * height * components);
+        MipGenerator mips(settings.mipFilter, settings.srgb, pool);
+        for (std::vector<unsigned char>& level : mips.generate(pixels, width, height, components)) {
+            levels.push_back(std::move(level));
+        }
+
+        std::vector<TextureFileLevel> table(header.mipCount);
+        for (uint32_t level = 0; level < header.mipCount; level++) {
+            table[level].width = std::max(width >> level, 1);
+            table[level].height = std::max(height >> level, 1);
+        }
+
+        // compressed only once the whole chain is built, MipGenerator filters the uncompressed levels
+        if (isCompressed(header.format)) {
+            for (uint32_t level = 0; level < header.mipCount; level++) {
+                levels[level] = BlockEncoder::compress(levels[level].data(), table[level].width, table[level].height, components,
+                    blockFormat(header.format), pool);
+            }
+        }
+
+        uint64_t offset = alignUp(sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * header.mipCount);
+        for (uint32_t level = 0; level < header.mipCount; level++) {
+            table[level].offset = offset;
+            table[level].size = levels[level].size();
+            offset = alignUp(offset + table[level].size);
+        }
+
+        FILE* file = fopen(destination, "wb");
+        if (!file) {
+            std::cout << "ERROR::TEXTURE_FILE::WRITE_FAILED " << destination << std::endl;
+            return false;
+        }
+        fwrite(&header, sizeof(header), 1, file);
+        fwrite(table.data(), sizeof(TextureFileLevel), table.size(), file);
+        static const unsigned char padding[DATA_ALIGNMENT] = {};
+        uint64_t written = sizeof(header) + sizeof(TextureFileLevel) * table.size();
+        for (uint32_t level = 0; level < header.mipCount; level++) {
+            fwrite(padding, 1, (size_t)(table[level].offset - written), file);
+            fwrite(levels[level].data(), 1, levels[level].size(), file);
+            written = table[level].offset + table[level].size;
+        }
+        bool ok = ferror(file) == 0;
+        ok = fclose(file) == 0 && ok;
+        if (!ok) {
+            std::cout << "ERROR::TEXTURE_FILE::WRITE_FAILED " << destination << std::endl;
+        }
+        return ok;
+    }
+
+    // The header of a mapped file when every level lies inside it and has the size its dimensions call for, NULL otherwise
+    static const TextureFileHeader* read(const MappedFile& file, const char* path) {
+        const TextureFileHeader* header = (const TextureFileHeader*)file.data();
+        bool valid = file.fileSize() >= sizeof(TextureFileHeader) && memcmp(header->magic, "GLTX", 4) == 0 &&
+            header->version == VERSION && header->format >= TEXTURE_FILE_R8 && header->format <= TEXTURE_FILE_BC7 &&
+            header->mipCount >= 1 && header->mipCount <= 32 &&
+            file.fileSize() >= sizeof(TextureFileHeader) + sizeof(TextureFileLevel) * header->mipCount;
+        if (valid) {
+            const TextureFileLevel* table = levels(file);
+            for (uint32_t level = 0; level < header->mipCount && valid; level++) {
+                valid = table[level].size == levelSize(header->format, table[level].width, table[level].height) &&
+                    table[level].offset + table[level].size <= file.fileSize();
+            }
+        }
+        if (!valid) {
+            std::cout << "ERROR::TEXTURE_FILE::INVALID " << path << std::endl;
+            return NULL;
+        }
+        return header;
+    }
+    // The level table that follows the header, only valid after read() accepted the file
+    static const TextureFileLevel* levels(const MappedFile& file) {
+        return (const TextureFileLevel*)(file.data() + sizeof(TextureFileHeader));
+    }
+
+    // Format for glTexImage2D / glCompressedTexImage2D, uncompressed formats use it as the internal format too
+    static GLenum glFormat(uint32_t format) {
+        static const GLenum formats[] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA,
+            GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_RGBA_BPTC_UNORM };
+        return format <= TEXTURE_FILE_BC7 ? formats[format] : 0;
+    }
+
+    // Maps path and uploads every level into texture straight from the mapping, with loadImage()'s sampler setup.
+    // False when the file is missing, damaged, cooked with the other flip setting or in a format
+    // the driver lacks. bytes gets the level data size
+    static bool upload(const char* path, unsigned int texture, bool flipVertically = false, size_t* bytes = NULL) {
+        MappedFile file;
+        if (!file.open(path)) {
+            return false;
+        }
+        const TextureFileHeader* header = read(file, path);
+        if (!header) {
+            return false;
+        }
+        if (((header->flags & TEXTURE_FILE_FLIPPED) != 0) != flipVertically) {
+            return false;
+        }
+
+        if (!isSupported(header->format)) {
+            return false;
+        }
+
+        GLenum format = glFormat(header->format);
+        const TextureFileLevel* table = levels(file);
+
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        size_t total = 0;
+        for (uint32_t level = 0; level < header->mipCount; level++) {
+            const unsigned char* data = file.data() + table[level].offset;
+            if (isCompressed(header->format)) {
+                glCompressedTexImage2D(GL_TEXTURE_2D, level, format, table[level].width, table[level].height, 0,
+                    (GLsizei)table[level].size, data);
+            }
+            else {
+                glTexImage2D(GL_TEXTURE_2D, level, format, table[level].width, table[level].height, 0, format, GL_UNSIGNED_BYTE, data);
+            }
+            total += (size_t)table[level].size;
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, header->mipCount - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        if (bytes) {
+            *bytes = total;
+        }
+        return true;
+    }
+
+private:
+    static BlockFormat blockFormat(uint32_t format) {
+        return format == TEXTURE_FILE_BC1 ? BLOCK_BC1 : format == TEXTURE_FILE_BC3 ? BLOCK_BC3 : BLOCK_BC7;
+    }
+
+    static uint64_t alignUp(uint64_t offset) {
+        return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+    }
+
+};
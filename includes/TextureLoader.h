@@ -0,0 +1,239 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <future>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include "ThreadPool.h"
+#include "TextureFile.h"
+#include "Profiler.h"
+#include "stb_image.h"
+
+/*
+* Loads textures with the decoding spread over a ThreadPool while the GL thread keeps working.
+*
+*     ThreadPool pool;
+*     TextureLoader textures(pool);
+*     unsigned int diffuseMap = textures.load("resources/container2.png");   // texture name now, pixels later
+*     ...                                                                    // compile shaders, build buffers
+*     textures.finish();                                                     // or textures.update() once per frame
+*
+* Decoding runs on the workers (stbi_set_flip_vertically_on_load_thread, so loaders with different flip settings
+* don't race on stb_image's global). Uploads stay on the GL thread: the pixels are copied into an orphaned
+* GL_PIXEL_UNPACK_BUFFER and glTexImage2D reads from it, so the driver can do the transfer asynchronously instead of
+* copying client memory before the call returns. Textures get the old loadImage() setup: repeat wrap, trilinear, mipmapped.
+* An up to date cooked file next to the image (TextureFile::cookedPath) is uploaded from its mapping inside load()
+* instead, mip chain included.
+*/
+
+struct TextureLoaderStats {
+    int textures;
+    int cooked;         // uploaded from a TextureFile by load()
+    int failed;
+    size_t bytes;       // decoded pixels uploaded
+    double decodeMs;    // summed over the workers
+    double uploadMs;    // GL thread time spent uploading in load()/update()/finish(), waiting included
+    double waitMs;      // the part of uploadMs finish() spent blocked on decodes
+};
+
+class TextureLoader {
+
+public:
+    explicit TextureLoader(ThreadPool& pool, bool flipVertically = false) : pool(pool), flipVertically(flipVertically) {
+        memset(&stats, 0, sizeof(stats));
+    }
+
+    // Only waits for decodes still running, GL objects are released by finish()
+    ~TextureLoader() {
+        for (Pending& entry : pending) {
+            DecodedImage image = entry.decoded.get();
+            stbi_image_free(image.data);
+        }
+    }
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Returns the texture name right away and queues the file for decoding
+    unsigned int load(const char* path) {
+        PROFILE_ZONE("TextureLoader::load");
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        stats.textures++;
+
+        if (TextureFile::isCooked(path)) {
+            auto start = std::chrono::high_resolution_clock::now();
+            size_t bytes = 0;
+            bool uploaded = TextureFile::upload(TextureFile::cookedPath(path).c_str(), textureID, flipVertically, &bytes);
+            stats.uploadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            if (uploaded) {
+                stats.cooked++;
+                stats.bytes += bytes;
+                return textureID;
+            }
+        }
+
+        std::string file = path;
+        bool flip = flipVertically;
+        pending.push_back({ textureID, pool.submit([file, flip] {
+            PROFILE_ZONE("TextureLoader::decode");
+            DecodedImage image;
+            auto start = std::chrono::high_resolution_clock::now();
+            stbi_set_flip_vertically_on_load_thread(flip);
+            image.data = stbi_load(file.c_str(), &image.width, &image.height, &image.components, 0);
+            image.decodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            image.path = file;
+            return image;
+        }) });
+        return textureID;
+    }
+
+    // Uploads the decodes that are done without waiting on the others, until byteBudget is used up
+    // (at least one texture per call). Returns how many are still pending
+    int update(size_t byteBudget = SIZE_MAX) {
+        auto start = std::chrono::high_resolution_clock::now();
+        size_t uploaded = 0;
+        for (size_t ready = firstReady(); ready < pending.size() && uploaded < byteBudget; ready = firstReady()) {
+            uploaded += upload(pending[ready]);
+            pending.erase(pending.begin() + ready);
+        }
+        stats.uploadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        releaseUnpackBuffer();
+        return (int)pending.size();
+    }
+
+    // Blocks until every queued texture is uploaded, in the order they finish decoding
+    void finish() {
+        PROFILE_ZONE("TextureLoader::finish");
+        auto start = std::chrono::high_resolution_clock::now();
+        while (!pending.empty()) {
+            size_t ready = firstReady();
+            if (ready == pending.size()) {
+                auto waitStart = std::chrono::high_resolution_clock::now();
+                pending.front().decoded.wait();
+                stats.waitMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - waitStart).count();
+                ready = 0;
+            }
+            upload(pending[ready]);
+            pending.erase(pending.begin() + ready);
+        }
+        stats.uploadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        releaseUnpackBuffer();
+    }
+
+    int pendingCount() const {
+        return (int)pending.size();
+    }
+
+    // True until the texture's decode has been uploaded
+    bool isPending(unsigned int texture) const {
+        for (const Pending& entry : pending) {
+            if (entry.texture == texture) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool flipsVertically() const {
+        return flipVertically;
+    }
+
+    const TextureLoaderStats& getStats() const {
+        return stats;
+    }
+
+private:
+    struct DecodedImage {
+        unsigned char* data = NULL;
+        int width = 0, height = 0, components = 0;
+        double decodeMs = 0.0;
+        std::string path;
+    };
+
+    struct Pending {
+        unsigned int texture;
+        std::future<DecodedImage> decoded;
+    };
+
+    ThreadPool& pool;
+    bool flipVertically;
+    std::vector<Pending> pending;
+    unsigned int unpackBuffer = 0;
+    TextureLoaderStats stats;
+
+    // pending.size() when nothing has finished decoding
+    size_t firstReady() const {
+        for (size_t i = 0; i < pending.size(); i++) {
+            if (pending[i].decoded.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                return i;
+            }
+        }
+        return pending.size();
+    }
+
+    size_t upload(Pending& entry) {
+        PROFILE_ZONE("TextureLoader::upload");
+        DecodedImage image = entry.decoded.get();
+        stats.decodeMs += image.decodeMs;
+        if (!image.data) {
+            std::cout << "Texture failed to load at path: " << image.path << std::endl;
+            stats.failed++;
+            return 0;
+        }
+
+        GLenum format = GL_RGBA;
+        if (image.components == 1)
+            format = GL_RED;
+        else if (image.components == 2)
+            format = GL_RG;
+        else if (image.components == 3)
+            format = GL_RGB;
+
+        size_t size = (size_t)image.width * image.height * image.components;
+        if (!unpackBuffer) {
+            glGenBuffers(1, &unpackBuffer);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+        // orphan, a transfer still reading the previous contents keeps its own storage
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped) {
+            memcpy(mapped, image.data, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else {
+            glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, image.data);
+        }
+        stbi_image_free(image.data);
+
+        // rows of 1, 2 and 3 channel images are only 4 byte aligned for some widths
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, entry.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, (void*)0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        stats.bytes += size;
+        return size;
+    }
+
+    void releaseUnpackBuffer() {
+        if (pending.empty() && unpackBuffer) {
+            glDeleteBuffers(1, &unpackBuffer);
+            unpackBuffer = 0;
+        }
+    }
+};
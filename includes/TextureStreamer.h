@@ -0,0 +1,876 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include <algorithm>
+#include "MappedFile.h"
+#include "TextureFile.h"
+#include "ThreadPool.h"
+#include "GLExtensions.h"
+
+/*
+* Streams cooked textures (TextureFile) a page at a time instead of uploading every level up front, so texture memory
+* stays within a fixed budget however large the textures are.
+*
+*     ThreadPool pool;
+*     TextureStreamer streamer(pool, 16 * 1024 * 1024);                  // bytes of pages resident at once
+*     int terrain = streamer.add("terrain.png.tex");                      // only the mip tail is uploaded here
+*     ...
+*     streamer.beginFeedback(width, height);                              // every frame, a low resolution pass
+*     streamer.bind(terrain, feedbackShader.ID, 0);                       // shaders/virtualTextureFeedbackFrag.glsl
+*     ... draw ...
+*     streamer.endFeedback();
+*     streamer.update();                                                  // read back, page in, page out
+*     streamer.bind(terrain, shader.ID, 0);                               // shaders/virtualTextureFrag.glsl, units 0-2
+*     ... draw ...
+*     streamer.release();                                                 // before the context goes away
+*
+* Feedback: the feedback pass renders the scene at 1/FEEDBACK_SCALE resolution with a shader that writes which
+* texture, mip level and page every pixel samples. It is read back through a pixel buffer a frame later so the
+* GL thread never waits on it. update() turns it into requests. Missing pages are cut from the mapped file on the
+* pool's workers, coarse levels first, and uploaded a few per frame. A page is only made resident once its parent
+* is, so a missing page always has a resident ancestor or the tail to fall back on. When the budget is full, the
+* least recently requested page with no resident children goes.
+*
+* With ARB_sparse_texture every texture is one sparse texture: pages are committed and decommitted with
+* glTexPageCommitmentARB at the driver's page size. The page table then only tells the shader the finest level it
+* may sample (taken over neighbouring pages as well, since filtering reaches across page edges).
+* Without it, pages live in one RGBA8 pool texture of PAGE_SIZE pages with a PAGE_BORDER of neighbouring texels
+* around each, and the page table holds where. Either way the levels that fit in a single page (the mip tail) are
+* uploaded by add() and stay resident. Block compressed files need the sparse path.
+*
+* Limits: the feedback stores everything in 8 bits, so at most MAX_TEXTURES textures of at most 256 pages across.
+*/
+
+struct TextureStreamerStats {
+    int textures;
+    int capacity;           // pages the budget holds, 0 for sparse textures (their page sizes differ)
+    int resident;           // pages resident now, tails not counted
+    int requested;          // distinct pages in the last feedback read back
+    int loading;
+    int uploaded;           // from here down, totals
+    int evicted;
+    int dropped;            // finished loads thrown away because every resident page was still in use
+    size_t residentBytes;   // pool or committed pages, plus tails and page tables
+    size_t virtualBytes;    // every texture with its whole chain resident, at the same formats
+    double feedbackMs;      // GL thread, reading back and sorting the feedback
+    double uploadMs;        // GL thread, page uploads and page table updates
+};
+
+class TextureStreamer {
+
+public:
+    static constexpr int PAGE_SIZE = 128;
+    static constexpr int PAGE_BORDER = 4;
+    static constexpr int SLOT_SIZE = PAGE_SIZE + 2 * PAGE_BORDER;
+    static constexpr int FEEDBACK_SCALE = 8;
+    static constexpr int MAX_TEXTURES = 255;
+    static constexpr int MAX_UPLOADS_PER_FRAME = 16;
+
+    // allowSparse false forces the page table fallback even where ARB_sparse_texture is available
+    TextureStreamer(ThreadPool& pool, size_t budget, bool allowSparse = true) : pool(pool), budget(budget) {
+        memset(&stats, 0, sizeof(stats));
+        sparse = allowSparse && GLEXT_ARB_sparse_texture;
+    }
+
+    ~TextureStreamer() {
+        for (Load& load : loads) {
+            load.data.wait();
+        }
+    }
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    bool usesSparse() const {
+        return sparse;
+    }
+
+    // Maps a cooked file and uploads its mip tail. Returns the id for bind(), -1 on failure
+    int add(const char* path) {
+        if ((int)textures.size() >= MAX_TEXTURES) {
+            std::cout << "ERROR::TEXTURE_STREAMER::TOO_MANY_TEXTURES " << path << std::endl;
+            return -1;
+        }
+        std::unique_ptr<Texture> texture(new Texture());
+        if (!texture->file.open(path)) {
+            std::cout << "ERROR::TEXTURE_STREAMER::OPEN_FAILED " << path << std::endl;
+            return -1;
+        }
+        texture->header = TextureFile::read(texture->file, path);
+        if (!texture->header) {
+            return -1;
+        }
+        texture->levels = TextureFile::levels(texture->file);
+        uint32_t format = texture->header->format;
+        if (TextureFile::isCompressed(format) && (!sparse || !TextureFile::isSupported(format))) {
+            std::cout << "ERROR::TEXTURE_STREAMER::COMPRESSED_NEEDS_SPARSE " << path << std::endl;
+            return -1;
+        }
+
+        bool created = sparse ? createSparse(*texture) : createPaged(*texture);
+        if (!created) {
+            std::cout << "ERROR::TEXTURE_STREAMER::TOO_LARGE " << path << std::endl;
+            return -1;
+        }
+        createPageTable(*texture);
+
+        for (uint32_t level = 0; level < texture->header->mipCount; level++) {
+            stats.virtualBytes += residentLevelSize(*texture, level);
+        }
+        textures.push_back(std::move(texture));
+        stats.textures++;
+        return (int)textures.size() - 1;
+    }
+
+    // Renders into the feedback buffer until endFeedback(). width and height are the main viewport's
+    void beginFeedback(int width, int height) {
+        int feedbackWidth = std::max(width / FEEDBACK_SCALE, 1), feedbackHeight = std::max(height / FEEDBACK_SCALE, 1);
+        if (feedbackWidth != feedback.width || feedbackHeight != feedback.height) {
+            createFeedback(feedbackWidth, feedbackHeight);
+        }
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &feedback.savedFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, feedback.savedViewport);
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, feedback.savedClear);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, feedback.framebuffer);
+        glViewport(0, 0, feedback.width, feedback.height);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);   // texture id 0, nothing sampled
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    // Queues the read back into this frame's pixel buffer, update() reads the previous frame's
+    void endFeedback() {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, feedback.buffers[feedback.writes % 2]);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, feedback.width, feedback.height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        feedback.writes++;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, feedback.savedFramebuffer);
+        glViewport(feedback.savedViewport[0], feedback.savedViewport[1], feedback.savedViewport[2], feedback.savedViewport[3]);
+        glClearColor(feedback.savedClear[0], feedback.savedClear[1], feedback.savedClear[2], feedback.savedClear[3]);
+    }
+
+    // Once per frame: requests from the feedback, loads started and finished, pages evicted, page tables refreshed
+    void update() {
+        frame++;
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<PageKey> missing;
+        readFeedback(missing);
+        auto read = std::chrono::high_resolution_clock::now();
+        stats.feedbackMs += std::chrono::duration<double, std::milli>(read - start).count();
+
+        // coarse first, a child is only made resident after its parent
+        std::sort(missing.begin(), missing.end(), [](const PageKey& a, const PageKey& b) { return a.level > b.level; });
+        int maxLoads = std::max(pool.size() * 4, MAX_UPLOADS_PER_FRAME);
+        for (const PageKey& key : missing) {
+            if ((int)loads.size() >= maxLoads) {
+                break;
+            }
+            startLoad(key);
+        }
+        finishLoads();
+
+        for (std::unique_ptr<Texture>& texture : textures) {
+            if (texture->dirty) {
+                refreshPageTable(*texture);
+            }
+        }
+        stats.loading = (int)loads.size();
+        stats.uploadMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - read).count();
+    }
+
+    // Binds the page table, pages and tail to units firstUnit..firstUnit + 2 and sets the vt* uniforms of program,
+    // which has to be in use
+    void bind(int id, unsigned int program, int firstUnit) {
+        const Texture& texture = *textures[id];
+        glActiveTexture(GL_TEXTURE0 + firstUnit);
+        glBindTexture(GL_TEXTURE_2D, texture.pageTable);
+        glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+        glBindTexture(GL_TEXTURE_2D, texture.sparse ? texture.tail : pagePool);
+        glActiveTexture(GL_TEXTURE0 + firstUnit + 2);
+        glBindTexture(GL_TEXTURE_2D, texture.tail);
+
+        const ProgramUniforms& uniforms = programUniforms(program);
+        glUniform1i(uniforms.pageTable, firstUnit);
+        glUniform1i(uniforms.pages, firstUnit + 1);
+        glUniform1i(uniforms.tail, firstUnit + 2);
+        glUniform2f(uniforms.size, (float)texture.header->width, (float)texture.header->height);
+        glUniform2f(uniforms.pageSize, (float)texture.pageWidth, (float)texture.pageHeight);
+        glUniform1i(uniforms.tailLevel, texture.tailLevel);
+        glUniform1i(uniforms.tailBase, texture.sparse ? 0 : texture.tailLevel);
+        glUniform1i(uniforms.sparse, texture.sparse ? 1 : 0);
+        glUniform3f(uniforms.slot, (float)SLOT_SIZE, (float)PAGE_BORDER, (float)(poolSlotsPerRow * SLOT_SIZE));
+        glUniform1i(uniforms.id, id + 1);
+        glUniform1f(uniforms.feedbackBias, -std::log2((float)FEEDBACK_SCALE));
+    }
+
+    // Deletes every GL object, call before the context goes away
+    void release() {
+        for (Load& load : loads) {
+            load.data.wait();
+        }
+        loads.clear();
+        for (std::unique_ptr<Texture>& texture : textures) {
+            glDeleteTextures(1, &texture->tail);
+            glDeleteTextures(1, &texture->pageTable);
+        }
+        textures.clear();
+        slots.clear();
+        committed.clear();
+        if (pagePool) {
+            glDeleteTextures(1, &pagePool);
+            pagePool = 0;
+        }
+        if (feedback.framebuffer) {
+            glDeleteFramebuffers(1, &feedback.framebuffer);
+            glDeleteTextures(1, &feedback.color);
+            glDeleteRenderbuffers(1, &feedback.depth);
+            glDeleteBuffers(2, feedback.buffers);
+            feedback = Feedback();
+        }
+    }
+
+    const TextureStreamerStats& getStats() const {
+        return stats;
+    }
+
+    void report() const {
+        printf("texture streamer (%s): %d textures, %d pages resident of %d, %d requested, %d loading\n",
+            sparse ? "sparse" : "page table", stats.textures, stats.resident, stats.capacity, stats.requested, stats.loading);
+        printf("  %.1f MB resident for %.1f MB of textures, %d pages uploaded, %d evicted, %d dropped, %.2f ms feedback, %.2f ms uploads\n",
+            stats.residentBytes / (1024.0 * 1024.0), stats.virtualBytes / (1024.0 * 1024.0), stats.uploaded, stats.evicted,
+            stats.dropped, stats.feedbackMs, stats.uploadMs);
+    }
+
+private:
+    struct Page {
+        int slot = -1;              // pool slot or index into committed, -1 when not resident
+        uint32_t lastUsed = 0;      // frame it was last requested, directly or through a child
+        int residentChildren = 0;
+        bool loading = false;
+    };
+
+    struct PageKey {
+        int texture, level, x, y;
+    };
+
+    struct Texture {
+        MappedFile file;
+        const TextureFileHeader* header = NULL;
+        const TextureFileLevel* levels = NULL;
+        bool sparse = false;
+        int pageWidth = PAGE_SIZE, pageHeight = PAGE_SIZE;
+        size_t pageBytes = 0;
+        int pagesX = 1, pagesY = 1;             // at level 0, level l has them halved (rounded up) l times
+        int tailLevel = 0;                      // first level that is resident whole
+        unsigned int tail = 0;                  // the sparse texture itself, or the levels from tailLevel down
+        unsigned int pageTable = 0;
+        int pageTableWidth = 1, pageTableHeight = 1;
+        std::vector<std::vector<Page>> pages;   // per level above the tail
+        std::vector<std::vector<uint32_t>> table;
+        bool dirty = true;
+
+        int levelPagesX(int level) const {
+            return (pagesX + (1 << level) - 1) >> level;
+        }
+
+        int levelPagesY(int level) const {
+            return (pagesY + (1 << level) - 1) >> level;
+        }
+
+        Page& page(const PageKey& key) {
+            return pages[key.level][(size_t)key.y * levelPagesX(key.level) + key.x];
+        }
+    };
+
+    struct Load {
+        PageKey key;
+        std::future<std::vector<unsigned char>> data;
+    };
+
+    struct ProgramUniforms {
+        unsigned int program;
+        int pageTable, pages, tail, size, pageSize, tailLevel, tailBase, sparse, slot, id, feedbackBias;
+    };
+
+    struct Feedback {
+        int width = 0, height = 0;
+        unsigned int framebuffer = 0, color = 0, depth = 0;
+        unsigned int buffers[2] = { 0, 0 };
+        uint64_t writes = 0, reads = 0;
+        int savedFramebuffer = 0;
+        int savedViewport[4] = { 0, 0, 0, 0 };
+        float savedClear[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    };
+
+    ThreadPool& pool;
+    size_t budget;
+    bool sparse;
+    std::vector<std::unique_ptr<Texture>> textures;
+    std::vector<Load> loads;
+    uint32_t frame = 0;
+
+    // page table fallback
+    unsigned int pagePool = 0;
+    int poolSlotsPerRow = 0;
+    std::vector<PageKey> slots;         // texture -1 when free
+    // sparse
+    std::vector<PageKey> committed;
+    size_t committedBytes = 0;
+
+    Feedback feedback;
+    std::vector<ProgramUniforms> uniforms;
+    TextureStreamerStats stats;
+
+    // Bytes the level takes once resident: uncompressed formats are expanded to RGBA8
+    static size_t residentLevelSize(const Texture& texture, uint32_t level) {
+        uint32_t format = TextureFile::isCompressed(texture.header->format) ? texture.header->format : (uint32_t)TEXTURE_FILE_RGBA8;
+        return (size_t)TextureFile::levelSize(format, texture.levels[level].width, texture.levels[level].height);
+    }
+
+    // First level whose pages all collapse into one
+    static int tailLevelFor(const Texture& texture) {
+        int level = 0;
+        while (texture.levelPagesX(level) > 1 || texture.levelPagesY(level) > 1) {
+            level++;
+        }
+        return std::min(level, (int)texture.header->mipCount - 1);
+    }
+
+    static int nextPowerOfTwo(int value) {
+        int power = 1;
+        while (power < value) {
+            power *= 2;
+        }
+        return power;
+    }
+
+    bool createPaged(Texture& texture) {
+        texture.pagesX = (texture.header->width + PAGE_SIZE - 1) / PAGE_SIZE;
+        texture.pagesY = (texture.header->height + PAGE_SIZE - 1) / PAGE_SIZE;
+        if (texture.pagesX > 256 || texture.pagesY > 256) {
+            return false;
+        }
+        texture.tailLevel = tailLevelFor(texture);
+        if (!pagePool) {
+            createPagePool();
+        }
+
+        // the tail is an ordinary mipmapped texture, sampled whenever a page isn't resident
+        glGenTextures(1, &texture.tail);
+        glBindTexture(GL_TEXTURE_2D, texture.tail);
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        GLenum format = TextureFile::glFormat(texture.header->format);
+        for (uint32_t level = texture.tailLevel; level < texture.header->mipCount; level++) {
+            const TextureFileLevel& entry = texture.levels[level];
+            glTexImage2D(GL_TEXTURE_2D, level - texture.tailLevel, format, entry.width, entry.height, 0, format, GL_UNSIGNED_BYTE,
+                texture.file.data() + entry.offset);
+            stats.residentBytes += residentLevelSize(texture, level);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.header->mipCount - 1 - texture.tailLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return true;
+    }
+
+    // As many slots as the budget allows, in a square that fits the texture size limit and 8 bit slot coordinates
+    void createPagePool() {
+        GLint maxSize;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        size_t slotBytes = (size_t)SLOT_SIZE * SLOT_SIZE * 4;
+        poolSlotsPerRow = std::max(1, (int)std::sqrt((double)(budget / slotBytes)));
+        poolSlotsPerRow = std::min({ poolSlotsPerRow, maxSize / SLOT_SIZE, 256 });
+        slots.assign((size_t)poolSlotsPerRow * poolSlotsPerRow, PageKey{ -1, 0, 0, 0 });
+        stats.capacity = (int)slots.size();
+
+        int size = poolSlotsPerRow * SLOT_SIZE;
+        glGenTextures(1, &pagePool);
+        glBindTexture(GL_TEXTURE_2D, pagePool);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        stats.residentBytes += slots.size() * slotBytes;
+    }
+
+    bool createSparse(Texture& texture) {
+        bool compressed = TextureFile::isCompressed(texture.header->format);
+        GLenum internalFormat = compressed ? TextureFile::glFormat(texture.header->format) : GL_RGBA8;
+        GLint pageSizes = 0, maxSize = 0;
+        glext_glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_NUM_VIRTUAL_PAGE_SIZES_ARB, 1, &pageSizes);
+        glGetIntegerv(GL_MAX_SPARSE_TEXTURE_SIZE_ARB, &maxSize);
+        if (pageSizes < 1 || (int)texture.header->width > maxSize || (int)texture.header->height > maxSize) {
+            return false;
+        }
+        texture.sparse = true;
+        glext_glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &texture.pageWidth);
+        glext_glGetInternalformativ(GL_TEXTURE_2D, internalFormat, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &texture.pageHeight);
+        texture.pageBytes = (size_t)TextureFile::levelSize(compressed ? texture.header->format : (uint32_t)TEXTURE_FILE_RGBA8,
+            texture.pageWidth, texture.pageHeight);
+        texture.pagesX = (texture.header->width + texture.pageWidth - 1) / texture.pageWidth;
+        texture.pagesY = (texture.header->height + texture.pageHeight - 1) / texture.pageHeight;
+        if (texture.pagesX > 256 || texture.pagesY > 256) {
+            return false;
+        }
+
+        glGenTextures(1, &texture.tail);
+        glBindTexture(GL_TEXTURE_2D, texture.tail);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+        glTexParameteri(GL_TEXTURE_2D, GL_VIRTUAL_PAGE_SIZE_INDEX_ARB, 0);
+        glext_glTexStorage2D(GL_TEXTURE_2D, texture.header->mipCount, internalFormat, texture.header->width, texture.header->height);
+        GLint sparseLevels = 0;
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_NUM_SPARSE_LEVELS_ARB, &sparseLevels);
+        // levels past NUM_SPARSE_LEVELS can only be committed together
+        texture.tailLevel = std::min(tailLevelFor(texture), (int)sparseLevels);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        for (uint32_t level = texture.tailLevel; level < texture.header->mipCount; level++) {
+            const TextureFileLevel& entry = texture.levels[level];
+            glext_glTexPageCommitment(GL_TEXTURE_2D, level, 0, 0, 0, entry.width, entry.height, 1, GL_TRUE);
+            uploadSparse(texture, level, 0, 0, entry.width, entry.height, copyRegion(texture, level, 0, 0, entry.width, entry.height, false));
+            stats.residentBytes += residentLevelSize(texture, level);
+        }
+        return true;
+    }
+
+    // One texel per page and level, RGBA8: pool slot x and y, the level actually resident, 255
+    void createPageTable(Texture& texture) {
+        texture.pages.resize(texture.tailLevel);
+        texture.table.resize(texture.tailLevel);
+        for (int level = 0; level < texture.tailLevel; level++) {
+            size_t count = (size_t)texture.levelPagesX(level) * texture.levelPagesY(level);
+            texture.pages[level].assign(count, Page());
+            texture.table[level].assign(count, 0);
+        }
+
+        // power of two so every level's page grid fits inside the matching mip of the table
+        texture.pageTableWidth = nextPowerOfTwo(texture.pagesX);
+        texture.pageTableHeight = nextPowerOfTwo(texture.pagesY);
+        glGenTextures(1, &texture.pageTable);
+        glBindTexture(GL_TEXTURE_2D, texture.pageTable);
+        int levels = std::max(texture.tailLevel, 1);
+        for (int level = 0; level < levels; level++) {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, std::max(texture.pageTableWidth >> level, 1),
+                std::max(texture.pageTableHeight >> level, 1), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            stats.residentBytes += (size_t)std::max(texture.pageTableWidth >> level, 1) * std::max(texture.pageTableHeight >> level, 1) * 4;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        texture.dirty = true;
+        refreshPageTable(texture);
+    }
+
+    void createFeedback(int width, int height) {
+        if (!feedback.framebuffer) {
+            glGenFramebuffers(1, &feedback.framebuffer);
+            glGenTextures(1, &feedback.color);
+            glGenRenderbuffers(1, &feedback.depth);
+            glGenBuffers(2, feedback.buffers);
+        }
+        feedback.width = width;
+        feedback.height = height;
+        feedback.writes = feedback.reads = 0;   // what's in the buffers has the old size
+
+        glBindTexture(GL_TEXTURE_2D, feedback.color);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindRenderbuffer(GL_RENDERBUFFER, feedback.depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        GLint previous;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previous);
+        glBindFramebuffer(GL_FRAMEBUFFER, feedback.framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, feedback.color, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, feedback.depth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::TEXTURE_STREAMER::FEEDBACK_FRAMEBUFFER_INCOMPLETE" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, previous);
+
+        for (int i = 0; i < 2; i++) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, feedback.buffers[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)width * height * 4, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    const ProgramUniforms& programUniforms(unsigned int program) {
+        for (const ProgramUniforms& entry : uniforms) {
+            if (entry.program == program) {
+                return entry;
+            }
+        }
+        ProgramUniforms entry;
+        entry.program = program;
+        entry.pageTable = glGetUniformLocation(program, "vtPageTable");
+        entry.pages = glGetUniformLocation(program, "vtPages");
+        entry.tail = glGetUniformLocation(program, "vtTail");
+        entry.size = glGetUniformLocation(program, "vtSize");
+        entry.pageSize = glGetUniformLocation(program, "vtPageSize");
+        entry.tailLevel = glGetUniformLocation(program, "vtTailLevel");
+        entry.tailBase = glGetUniformLocation(program, "vtTailBase");
+        entry.sparse = glGetUniformLocation(program, "vtSparse");
+        entry.slot = glGetUniformLocation(program, "vtSlot");
+        entry.id = glGetUniformLocation(program, "vtId");
+        entry.feedbackBias = glGetUniformLocation(program, "vtFeedbackBias");
+        uniforms.push_back(entry);
+        return uniforms.back();
+    }
+
+    // Marks every page the previous frame's feedback asked for, and its ancestors, as used this frame.
+    // The ones not resident or loading go into missing
+    void readFeedback(std::vector<PageKey>& missing) {
+        stats.requested = 0;
+        if (feedback.writes < 2 || feedback.reads == feedback.writes) {
+            return;
+        }
+        feedback.reads = feedback.writes;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, feedback.buffers[feedback.writes % 2]);
+        size_t count = (size_t)feedback.width * feedback.height;
+        const uint32_t* pixels = (const uint32_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, count * 4, GL_MAP_READ_BIT);
+        std::vector<uint32_t> requests;
+        if (pixels) {
+            requests.reserve(count);
+            for (size_t i = 0; i < count; i++) {
+                if (pixels[i] != 0) {
+                    requests.push_back(pixels[i]);
+                }
+            }
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        std::sort(requests.begin(), requests.end());
+        requests.erase(std::unique(requests.begin(), requests.end()), requests.end());
+        stats.requested = (int)requests.size();
+        for (uint32_t request : requests) {
+            // bytes in memory order: texture id + 1, level, page x, page y
+            const unsigned char* bytes = (const unsigned char*)&request;
+            PageKey key = { bytes[0] - 1, bytes[1], bytes[2], bytes[3] };
+            if (key.texture >= (int)textures.size()) {
+                continue;
+            }
+            Texture& texture = *textures[key.texture];
+            for (; key.level < texture.tailLevel; key.level++, key.x >>= 1, key.y >>= 1) {
+                if (key.x >= texture.levelPagesX(key.level) || key.y >= texture.levelPagesY(key.level)) {
+                    break;
+                }
+                Page& page = texture.page(key);
+                if (page.lastUsed == frame) {
+                    break; // this page and its ancestors were already handled for another request
+                }
+                page.lastUsed = frame;
+                if (page.slot < 0 && !page.loading) {
+                    missing.push_back(key);
+                }
+            }
+        }
+    }
+
+    void startLoad(const PageKey& key) {
+        Texture& texture = *textures[key.texture];
+        texture.page(key).loading = true;
+        int x = key.x * texture.pageWidth, y = key.y * texture.pageHeight;
+        Texture* source = &texture;
+        Load load;
+        load.key = key;
+        if (texture.sparse) {
+            const TextureFileLevel& entry = texture.levels[key.level];
+            int width = std::min(texture.pageWidth, (int)entry.width - x), height = std::min(texture.pageHeight, (int)entry.height - y);
+            load.data = pool.submit([source, key, x, y, width, height] {
+                return width > 0 && height > 0 ? copyRegion(*source, key.level, x, y, width, height, false) : std::vector<unsigned char>();
+            });
+        }
+        else {
+            load.data = pool.submit([source, key, x, y] {
+                return copyRegion(*source, key.level, x - PAGE_BORDER, y - PAGE_BORDER, SLOT_SIZE, SLOT_SIZE, true);
+            });
+        }
+        loads.push_back(std::move(load));
+    }
+
+    // Makes up to MAX_UPLOADS_PER_FRAME finished loads resident. Ones whose parent isn't resident yet wait
+    void finishLoads() {
+        int uploads = 0;
+        for (size_t i = 0; i < loads.size() && uploads < MAX_UPLOADS_PER_FRAME;) {
+            Load& load = loads[i];
+            if (load.data.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                i++;
+                continue;
+            }
+            Texture& texture = *textures[load.key.texture];
+            Page* parent = parentOf(texture, load.key);
+            if (parent && parent->slot < 0) {
+                if (parent->loading) {
+                    i++;
+                    continue;
+                }
+                // the parent was dropped, the feedback asks again for both
+                texture.page(load.key).loading = false;
+                loads.erase(loads.begin() + i);
+                continue;
+            }
+            std::vector<unsigned char> data = load.data.get();
+            PageKey key = load.key;
+            loads.erase(loads.begin() + i);
+            texture.page(key).loading = false;
+            if (makeResident(texture, key, data)) {
+                uploads++;
+            }
+        }
+    }
+
+    Page* parentOf(Texture& texture, const PageKey& key) {
+        if (key.level + 1 >= texture.tailLevel) {
+            return NULL;
+        }
+        return &texture.page({ key.texture, key.level + 1, key.x >> 1, key.y >> 1 });
+    }
+
+    bool makeResident(Texture& texture, const PageKey& key, const std::vector<unsigned char>& data) {
+        Page& page = texture.page(key);
+        if (texture.sparse) {
+            while (committedBytes + texture.pageBytes > budget) {
+                if (!evict(committed, true)) {
+                    stats.dropped++;
+                    return false;
+                }
+            }
+            page.slot = (int)committed.size();
+            committed.push_back(key);
+            if (!data.empty()) {
+                // pages past the edge of a level (the grid is rounded up) have nothing to commit
+                const TextureFileLevel& entry = texture.levels[key.level];
+                int x = key.x * texture.pageWidth, y = key.y * texture.pageHeight;
+                int width = std::min(texture.pageWidth, (int)entry.width - x), height = std::min(texture.pageHeight, (int)entry.height - y);
+                glBindTexture(GL_TEXTURE_2D, texture.tail);
+                glext_glTexPageCommitment(GL_TEXTURE_2D, key.level, x, y, 0, width, height, 1, GL_TRUE);
+                uploadSparse(texture, key.level, x, y, width, height, data);
+                committedBytes += texture.pageBytes;
+                stats.residentBytes += texture.pageBytes;
+            }
+        }
+        else {
+            int slot = freeSlot();
+            if (slot < 0) {
+                stats.dropped++;
+                return false;
+            }
+            slots[slot] = key;
+            page.slot = slot;
+            glBindTexture(GL_TEXTURE_2D, pagePool);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, slot % poolSlotsPerRow * SLOT_SIZE, slot / poolSlotsPerRow * SLOT_SIZE, SLOT_SIZE, SLOT_SIZE,
+                GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+        }
+        if (Page* parent = parentOf(texture, key)) {
+            parent->residentChildren++;
+        }
+        texture.dirty = true;
+        stats.resident++;
+        stats.uploaded++;
+        return true;
+    }
+
+    int freeSlot() {
+        for (size_t slot = 0; slot < slots.size(); slot++) {
+            if (slots[slot].texture < 0) {
+                return (int)slot;
+            }
+        }
+        return evict(slots, false) ? freeSlot() : -1;
+    }
+
+    // Least recently used page without resident children, never one used this frame. False when there is none
+    bool evict(std::vector<PageKey>& resident, bool compact) {
+        int victim = -1;
+        uint32_t oldest = frame;
+        for (size_t i = 0; i < resident.size(); i++) {
+            if (resident[i].texture < 0) {
+                continue;
+            }
+            const Page& page = textures[resident[i].texture]->page(resident[i]);
+            if (page.residentChildren == 0 && page.lastUsed < oldest) {
+                oldest = page.lastUsed;
+                victim = (int)i;
+            }
+        }
+        if (victim < 0) {
+            return false;
+        }
+
+        PageKey key = resident[victim];
+        Texture& texture = *textures[key.texture];
+        texture.page(key).slot = -1;
+        if (Page* parent = parentOf(texture, key)) {
+            parent->residentChildren--;
+        }
+        if (texture.sparse) {
+            const TextureFileLevel& entry = texture.levels[key.level];
+            int x = key.x * texture.pageWidth, y = key.y * texture.pageHeight;
+            int width = std::min(texture.pageWidth, (int)entry.width - x), height = std::min(texture.pageHeight, (int)entry.height - y);
+            if (width > 0 && height > 0) {
+                glBindTexture(GL_TEXTURE_2D, texture.tail);
+                glext_glTexPageCommitment(GL_TEXTURE_2D, key.level, x, y, 0, width, height, 1, GL_FALSE);
+                committedBytes -= texture.pageBytes;
+                stats.residentBytes -= texture.pageBytes;
+            }
+        }
+        if (compact) {
+            resident[victim] = resident.back();
+            resident.pop_back();
+            if (victim < (int)resident.size()) {
+                textures[resident[victim].texture]->page(resident[victim]).slot = victim;
+            }
+        }
+        else {
+            resident[victim].texture = -1;
+        }
+        texture.dirty = true;
+        stats.resident--;
+        stats.evicted++;
+        return true;
+    }
+
+    // Texels x..x+width, y..y+height of a level, wrapping around its edges, uncompressed formats expanded to RGBA8
+    // the way GL expands them. Block compressed levels are copied a block row at a time (sparse only, never wraps)
+    static std::vector<unsigned char> copyRegion(const Texture& texture, int level, int x, int y, int width, int height, bool wrap) {
+        const TextureFileLevel& entry = texture.levels[level];
+        const unsigned char* source = texture.file.data() + entry.offset;
+        uint32_t format = texture.header->format;
+
+        if (TextureFile::isCompressed(format)) {
+            size_t blockBytes = format == TEXTURE_FILE_BC1 ? 8 : 16;
+            size_t sourceStride = (entry.width + 3) / 4 * blockBytes, rowBytes = (size_t)(width + 3) / 4 * blockBytes;
+            int blockRows = (height + 3) / 4;
+            std::vector<unsigned char> blocks(rowBytes * blockRows);
+            for (int row = 0; row < blockRows; row++) {
+                memcpy(&blocks[row * rowBytes], source + (size_t)(y / 4 + row) * sourceStride + (size_t)x / 4 * blockBytes, rowBytes);
+            }
+            return blocks;
+        }
+
+        int components = (int)format;
+        std::vector<int> columns(width);
+        for (int column = 0; column < width; column++) {
+            int sourceX = wrap ? ((x + column) % (int)entry.width + (int)entry.width) % (int)entry.width : x + column;
+            columns[column] = sourceX * components;
+        }
+        std::vector<unsigned char> pixels((size_t)width * height * 4);
+        for (int row = 0; row < height; row++) {
+            int sourceY = wrap ? ((y + row) % (int)entry.height + (int)entry.height) % (int)entry.height : y + row;
+            const unsigned char* in = source + (size_t)sourceY * entry.width * components;
+            unsigned char* out = &pixels[(size_t)row * width * 4];
+            for (int column = 0; column < width; column++, out += 4) {
+                const unsigned char* texel = in + columns[column];
+                out[0] = texel[0];
+                out[1] = components > 1 ? texel[1] : 0;
+                out[2] = components > 2 ? texel[2] : 0;
+                out[3] = components > 3 ? texel[3] : 255;
+            }
+        }
+        return pixels;
+    }
+
+    static void uploadSparse(const Texture& texture, int level, int x, int y, int width, int height, const std::vector<unsigned char>& data) {
+        if (TextureFile::isCompressed(texture.header->format)) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, TextureFile::glFormat(texture.header->format),
+                (GLsizei)data.size(), data.data());
+        }
+        else {
+            glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+        }
+    }
+
+    // Every entry points at the page itself when it is resident, otherwise at what its parent's entry points at.
+    // tailLevel as the level means nothing above the tail is resident there
+    void refreshPageTable(Texture& texture) {
+        texture.dirty = false;
+        glBindTexture(GL_TEXTURE_2D, texture.pageTable);
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (texture.tailLevel == 0) {
+            uint32_t entry = packEntry(0, 0, 0);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &entry);
+        }
+
+        std::vector<uint32_t> dilated;
+        for (int level = texture.tailLevel - 1; level >= 0; level--) {
+            int pagesX = texture.levelPagesX(level), pagesY = texture.levelPagesY(level);
+            std::vector<uint32_t>& table = texture.table[level];
+            for (int y = 0; y < pagesY; y++) {
+                for (int x = 0; x < pagesX; x++) {
+                    const Page& page = texture.pages[level][(size_t)y * pagesX + x];
+                    if (page.slot >= 0) {
+                        int slot = texture.sparse ? 0 : page.slot;
+                        table[(size_t)y * pagesX + x] = packEntry(slot % std::max(poolSlotsPerRow, 1), slot / std::max(poolSlotsPerRow, 1), level);
+                    }
+                    else if (level + 1 < texture.tailLevel) {
+                        table[(size_t)y * pagesX + x] = texture.table[level + 1][(size_t)(y >> 1) * texture.levelPagesX(level + 1) + (x >> 1)];
+                    }
+                    else {
+                        table[(size_t)y * pagesX + x] = packEntry(0, 0, texture.tailLevel);
+                    }
+                }
+            }
+
+            const std::vector<uint32_t>* upload = &table;
+            if (texture.sparse) {
+                // filtering near a page edge reads the neighbour, so the level a page may use is the coarsest around it
+                dilated.resize(table.size());
+                for (int y = 0; y < pagesY; y++) {
+                    for (int x = 0; x < pagesX; x++) {
+                        int coarsest = 0;
+                        for (int dy = -1; dy <= 1; dy++) {
+                            for (int dx = -1; dx <= 1; dx++) {
+                                int nx = (x + dx + pagesX) % pagesX, ny = (y + dy + pagesY) % pagesY;
+                                coarsest = std::max(coarsest, entryLevel(table[(size_t)ny * pagesX + nx]));
+                            }
+                        }
+                        dilated[(size_t)y * pagesX + x] = packEntry(0, 0, coarsest);
+                    }
+                }
+                upload = &dilated;
+            }
+            glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, pagesX, pagesY, GL_RGBA, GL_UNSIGNED_BYTE, upload->data());
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    }
+
+    // Memory order R, G, B, A whatever the host byte order
+    static uint32_t packEntry(int slotX, int slotY, int level) {
+        unsigned char bytes[4] = { (unsigned char)slotX, (unsigned char)slotY, (unsigned char)level, 255 };
+        uint32_t entry;
+        memcpy(&entry, bytes, 4);
+        return entry;
+    }
+
+    static int entryLevel(uint32_t entry) {
+        return ((const unsigned char*)&entry)[2];
+    }
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <atomic>
+#include <memory>
+
+/*
+* Fixed set of worker threads for the CPU side work (software rasterizer, texture decoding, ...).
+*
+* parallelFor(count, func) runs func(i) for every i in [0, count) and returns once all of them are done.
+* The calling thread helps out instead of sleeping, so a pool of N workers keeps N + 1 cores busy.
+*/
+
+class ThreadPool {
+
+public:
+    // workerCount < 0 picks one per core minus the calling thread, 0 runs everything on the caller
+    explicit ThreadPool(int workerCount = -1) {
+        if (workerCount < 0) {
+            workerCount = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+        }
+        for (int i = 0; i < workerCount; i++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Number of threads that work on a parallelFor, including the caller
+    int size() const {
+        return (int)workers.size() + 1;
+    }
+
+    template<class Function>
+    auto submit(Function func) -> std::future<decltype(func())> {
+        typedef decltype(func()) Result;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+        std::future<Result> result = task->get_future();
+        if (workers.empty()) {
+            (*task)();
+            return result;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            jobs.push_back([task] { (*task)(); });
+        }
+        wake.notify_one();
+        return result;
+    }
+
+    template<class Function>
+    void parallelFor(int count, Function func) {
+        if (count <= 0) {
+            return;
+        }
+        if (count == 1) {
+            func(0);
+            return;
+        }
+
+        // every participant pulls indices from a shared counter until they run out
+        struct Batch {
+            std::atomic<int> next{ 0 };
+            std::atomic<int> done{ 0 };
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto batch = std::make_shared<Batch>();
+
+        auto drain = [batch, count, &func] {
+            int finishedHere = 0;
+            for (int i = batch->next++; i < count; i = batch->next++) {
+                func(i);
+                finishedHere++;
+            }
+            if (finishedHere > 0 && batch->done.fetch_add(finishedHere) + finishedHere == count) {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->finished.notify_all();
+            }
+        };
+
+        int helpers = std::min((int)workers.size(), count - 1);
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (int i = 0; i < helpers; i++) {
+                jobs.push_back(drain);
+            }
+        }
+        wake.notify_all();
+
+        drain();
+
+        // func lives on this stack frame, so wait for stragglers still inside it
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->finished.wait(lock, [&batch, count] { return batch->done.load() == count; });
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex queueMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void workerLoop() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+};
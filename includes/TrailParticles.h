@@ -0,0 +1,120 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+/*
+* LineTrails' orbiting lines as structure of arrays: each line circles its centre at its radius, starting its orbit
+* at its offset. Positions along the orbit are worked out per frame by lineTrailVert.glsl from u_time.
+*
+*     TrailParticles trails;
+*     trails.generate(1000000, seed, &pool);
+*     glBindVertexArray(VAO);
+*     glBindBuffer(GL_ARRAY_BUFFER, VBO);
+*     trails.upload();
+*     trails.setAttributes();                             // per instance attributes 0-2
+*     glDrawArraysInstanced(GL_LINES, 0, 2, trails.count()); // the shader picks the line's end from gl_VertexID
+*
+* Each array goes into the buffer whole, one after the other, so a line is 16 bytes on the GPU instead of the 32
+* of storing both of its ends, and a pass over one field on the CPU touches only that field.
+* generate() splits the lines into fixed size chunks and gives every chunk its own generator seeded from the chunk
+* index, so chunks fill in parallel without sharing state and the result depends only on the seed, not on how many
+* threads the pool has.
+*/
+
+// splitmix64, a few instructions per number and no shared state, unlike rand()
+struct TrailRandom {
+    uint64_t state;
+
+    explicit TrailRandom(uint64_t seed) : state(seed) {
+    }
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // [min, max) from the top 24 bits
+    float uniform(float min, float max) {
+        return min + (float)(next() >> 40) * (1.0f / 16777216.0f) * (max - min);
+    }
+};
+
+class TrailParticles {
+
+public:
+    // where the lines go, LineTrails' original ranges
+    float minRadius = 0.1f, maxRadius = 1.0f;
+    float minOffset = 0.0f, maxOffset = glm::pi<float>();
+
+    std::vector<glm::vec2> centre; // in [-0.5, 0.5)
+    std::vector<float> radius;
+    std::vector<float> offset;     // radians
+
+    int count() const {
+        return (int)radius.size();
+    }
+
+    void generate(int lineCount, uint64_t seed = 1, ThreadPool* pool = NULL) {
+        centre.resize(lineCount);
+        radius.resize(lineCount);
+        offset.resize(lineCount);
+        int chunks = (lineCount + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        auto fill = [this, lineCount, seed](int chunk) {
+            TrailRandom random(seed * 0x2545F4914F6CDD1Dull + (uint64_t)chunk);
+            int end = std::min((chunk + 1) * CHUNK_SIZE, lineCount);
+            for (int i = chunk * CHUNK_SIZE; i < end; i++) {
+                centre[i].x = random.uniform(-0.5f, 0.5f);
+                centre[i].y = random.uniform(-0.5f, 0.5f);
+                radius[i] = random.uniform(minRadius, maxRadius);
+                offset[i] = random.uniform(minOffset, maxOffset);
+            }
+        };
+        if (pool) {
+            pool->parallelFor(chunks, fill);
+        }
+        else {
+            for (int chunk = 0; chunk < chunks; chunk++) {
+                fill(chunk);
+            }
+        }
+    }
+
+    size_t bytes() const {
+        return (size_t)count() * LINE_BYTES;
+    }
+
+    // Fills the bound GL_ARRAY_BUFFER: every centre, then every radius, then every offset
+    void upload(GLenum usage = GL_STATIC_DRAW) const {
+        size_t n = (size_t)count();
+        glBufferData(GL_ARRAY_BUFFER, bytes(), NULL, usage);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, n * sizeof(glm::vec2), centre.data());
+        glBufferSubData(GL_ARRAY_BUFFER, n * sizeof(glm::vec2), n * sizeof(float), radius.data());
+        glBufferSubData(GL_ARRAY_BUFFER, n * (sizeof(glm::vec2) + sizeof(float)), n * sizeof(float), offset.data());
+    }
+
+    // Per instance attributes 0-2 of the bound VAO from the bound GL_ARRAY_BUFFER that upload() filled
+    void setAttributes() const {
+        size_t n = (size_t)count();
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0); // centre
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(n * sizeof(glm::vec2))); // radius
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(n * (sizeof(glm::vec2) + sizeof(float)))); // offset
+        for (int i = 0; i < 3; i++) {
+            glEnableVertexAttribArray(i);
+            glVertexAttribDivisor(i, 1);
+        }
+    }
+
+private:
+    static const int CHUNK_SIZE = 1 << 16;
+    static const size_t LINE_BYTES = sizeof(glm::vec2) + 2 * sizeof(float);
+};
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <iostream>
+#include <cstddef>
+#include <algorithm>
+#include "Shader.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+
+/*
+* LineTrails' orbiting lines simulated entirely on the GPU. Particle state lives in a shader storage buffer that
+* trailSimulateComp.glsl integrates each frame; the same dispatch writes both ends of every particle's line into
+* the vertex buffer draw() reads, so nothing goes through the CPU after create().
+*
+*     TrailSimulation simulation;
+*     if (simulation.create(10000000)) {        // needs GLEXT_ARB_compute_shader, call loadGLExtensions first
+*         simulation.aspect = aspect;
+*         simulation.simulate(dt);              // dispatch, then a barrier before the vertex fetch
+*         simulation.draw();                    // GL_LINES, premultiplied
+*     }
+*     simulation.release();
+*
+* Particles respawn with a new centre, radius and lifetime when their life runs out, seeded from their index and
+* the frame, and fade out over their last second. A particle is 32 bytes and its line 24, so 10M particles take
+* 560 MB; drivers only have to allow 16 MB in one storage block (llvmpipe allows 128 MB), so the buffers are bound
+* and dispatched in batches that fit.
+*/
+
+class TrailSimulation {
+
+public:
+    float trailTime = 0.1f;                         // seconds of motion between a line's ends
+    float minLifetime = 4.0f, maxLifetime = 12.0f;  // seconds
+    float aspect = 1.0f;
+
+    bool create(int particleCount,
+        const char* computePath = "shaders/trailSimulateComp.glsl",
+        const char* vertexPath = "shaders/trailParticleVert.glsl",
+        const char* fragmentPath = "shaders/trailParticleFrag.glsl") {
+        release();
+        if (!GLEXT_ARB_compute_shader) {
+            std::cout << "ERROR::TRAIL_SIMULATION::NO_COMPUTE_SHADERS" << std::endl;
+            return false;
+        }
+        particles = std::max(particleCount, 0);
+
+        // Shader only prints compile and link errors, a program that didn't link would dispatch nothing every frame
+        simulateProgram = Shader::compute(computePath).ID;
+        drawProgram = Shader(vertexPath, fragmentPath).ID;
+        if (!linked(simulateProgram) || !linked(drawProgram)) {
+            std::cout << "ERROR::TRAIL_SIMULATION::PROGRAM_NOT_LINKED" << std::endl;
+            glDeleteProgram(simulateProgram);
+            glDeleteProgram(drawProgram);
+            simulateProgram = drawProgram = 0;
+            particles = 0;
+            return false;
+        }
+        baseUniform = glGetUniformLocation(simulateProgram, "u_base");
+        countUniform = glGetUniformLocation(simulateProgram, "u_count");
+        frameUniform = glGetUniformLocation(simulateProgram, "u_frame");
+        spawnAllUniform = glGetUniformLocation(simulateProgram, "u_spawn_all");
+        dtUniform = glGetUniformLocation(simulateProgram, "u_dt");
+        trailTimeUniform = glGetUniformLocation(simulateProgram, "u_trail_time");
+        aspectUniform = glGetUniformLocation(simulateProgram, "u_aspect_ratio");
+        lifetimeUniform = glGetUniformLocation(simulateProgram, "u_lifetime");
+
+        // the largest batch whose two ranges fit one storage block, in whole work groups
+        GLint maxBlock = 0, alignment = 1;
+        glGetIntegerv(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &maxBlock);
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        batchSize = (int)((size_t)maxBlock / PARTICLE_BYTES) / LOCAL_SIZE * LOCAL_SIZE;
+        while (batchSize > LOCAL_SIZE && ((size_t)batchSize * VERTEX_BYTES * 2) % alignment != 0) {
+            batchSize -= LOCAL_SIZE;
+        }
+        batchSize = std::max(batchSize, LOCAL_SIZE);
+
+        glGenBuffers(1, &particleBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, particleBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, std::max(particleBytes(), (size_t)PARTICLE_BYTES), NULL, GL_DYNAMIC_COPY);
+
+        glGenBuffers(1, &vertexBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, vertexBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, std::max(vertexBytes(), (size_t)VERTEX_BYTES), NULL, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, VERTEX_BYTES, (void*)0);                  // position
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, VERTEX_BYTES, (void*)(2 * sizeof(float))); // intensity
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+
+        frame = 0;
+        glUseProgram(simulateProgram);
+        dispatch(0.0f, true);
+        return true;
+    }
+
+    void release() {
+        if (VAO) {
+            glDeleteVertexArrays(1, &VAO);
+            glDeleteBuffers(1, &particleBuffer);
+            glDeleteBuffers(1, &vertexBuffer);
+            glDeleteProgram(simulateProgram);
+            glDeleteProgram(drawProgram);
+        }
+        VAO = particleBuffer = vertexBuffer = simulateProgram = drawProgram = 0;
+        particles = 0;
+    }
+
+    // Advances every particle by dt seconds and rewrites the vertex buffer
+    void simulate(float dt) {
+        if (VAO) {
+            glUseProgram(simulateProgram);
+            dispatch(dt, false);
+        }
+    }
+
+    // Same, binding the program through the render loop's state cache
+    void simulate(float dt, GLStateCache& state) {
+        if (VAO) {
+            state.useProgram(simulateProgram);
+            dispatch(dt, false);
+        }
+    }
+
+    // Draws into the bound framebuffer with whatever blending is set
+    void draw() const {
+        if (VAO && particles > 0) {
+            glUseProgram(drawProgram);
+            glBindVertexArray(VAO);
+            glDrawArrays(GL_LINES, 0, particles * 2);
+        }
+    }
+
+    void draw(GLStateCache& state) const {
+        if (VAO && particles > 0) {
+            state.useProgram(drawProgram);
+            state.bindVertexArray(VAO);
+            glDrawArrays(GL_LINES, 0, particles * 2);
+        }
+    }
+
+    int count() const {
+        return particles;
+    }
+
+    int batches() const {
+        return (particles + batchSize - 1) / batchSize;
+    }
+
+    size_t bytes() const {
+        return particleBytes() + vertexBytes();
+    }
+
+private:
+    static constexpr int LOCAL_SIZE = 256;       // trailSimulateComp.glsl's local_size_x
+    static constexpr int MAX_GROUPS_X = 65535;   // the minimum every driver allows per dimension
+    static const size_t PARTICLE_BYTES = 32;
+    static const size_t VERTEX_BYTES = 3 * sizeof(float);
+
+    int particles = 0, batchSize = LOCAL_SIZE;
+    unsigned int frame = 0;
+    unsigned int particleBuffer = 0, vertexBuffer = 0, VAO = 0;
+    unsigned int simulateProgram = 0, drawProgram = 0;
+    int baseUniform = -1, countUniform = -1, frameUniform = -1, spawnAllUniform = -1;
+    int dtUniform = -1, trailTimeUniform = -1, aspectUniform = -1, lifetimeUniform = -1;
+
+    static bool linked(unsigned int program) {
+        GLint status = GL_FALSE;
+        if (program) {
+            glGetProgramiv(program, GL_LINK_STATUS, &status);
+        }
+        return status == GL_TRUE;
+    }
+
+    size_t particleBytes() const {
+        return (size_t)particles * PARTICLE_BYTES;
+    }
+
+    size_t vertexBytes() const {
+        return (size_t)particles * 2 * VERTEX_BYTES;
+    }
+
+    // simulateProgram must be current
+    void dispatch(float dt, bool spawnAll) {
+        glUniform1ui(frameUniform, frame++);
+        glUniform1i(spawnAllUniform, spawnAll);
+        glUniform1f(dtUniform, dt);
+        glUniform1f(trailTimeUniform, trailTime);
+        glUniform1f(aspectUniform, aspect);
+        glUniform2f(lifetimeUniform, minLifetime, maxLifetime);
+
+        for (int base = 0; base < particles; base += batchSize) {
+            int n = std::min(batchSize, particles - base);
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, particleBuffer, (size_t)base * PARTICLE_BYTES, (size_t)n * PARTICLE_BYTES);
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, vertexBuffer, (size_t)base * 2 * VERTEX_BYTES, (size_t)n * 2 * VERTEX_BYTES);
+            glUniform1ui(baseUniform, (unsigned int)base);
+            glUniform1ui(countUniform, (unsigned int)n);
+
+            // wide enough in x for every group, then as many rows as that needs
+            int groups = (n + LOCAL_SIZE - 1) / LOCAL_SIZE;
+            int groupsX = std::min(groups, MAX_GROUPS_X);
+            int groupsY = (groups + groupsX - 1) / groupsX;
+            glext_glDispatchCompute(groupsX, groupsY, 1);
+        }
+        // the vertex fetch reads what the shader wrote, and the next dispatch reads the particles back
+        glext_glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+};
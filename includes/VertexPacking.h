@@ -0,0 +1,230 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+/*
+* Packs the demos' 8 float vertices (32 bytes: pos, normal, uv) into 16 bytes for lightingMapVert.glsl.
+*
+*     position   3 x unorm16 across the mesh bounds, + 2 bytes padding   8 bytes
+*     normal     octahedral, 2 x 10 bit in a GL_INT_2_10_10_10_REV       4 bytes
+*     texCoords  2 x half float                                          4 bytes
+*
+*     MeshBuilder cube(8);
+*     ...
+*     PackedMesh packed(cube.getVertices().data(), cube.vertexCount());
+*     glBindBuffer(GL_ARRAY_BUFFER, VBO);
+*     packed.upload();
+*     PackedMesh::setAttributes();
+*     model = model * packed.positionTransform();   // the unorm -> object space decode rides along in the model matrix
+*
+* Half float uvs step by 1/2048 in [0.5, 1], a texel at 2048, and get coarser for tiled coordinates past 1.
+* The normal matrix must still come from the model matrix without positionTransform(), it has a non uniform scale.
+* The octahedral normal goes in as plain integers (normalized = GL_FALSE) and the shader divides by 511: GL 3.3 and
+* GL 4.2+ disagree on how normalized signed integers map to floats, this way both decode the same.
+*/
+
+struct PackedVertex {
+    uint16_t position[4]; // [3] is padding, keeps the normal 4 byte aligned
+    uint32_t normal;
+    uint32_t texCoords;
+};
+
+// How far the packed mesh is from the float one
+struct PackingError {
+    float maxPosition;      // object space units
+    float rmsPosition;
+    float maxNormalDegrees;
+    float meanNormalDegrees;
+    float maxTexCoord;      // uv units, times the texture size for texels
+};
+
+class PackedMesh {
+
+public:
+    // stride in floats, position at 0, normal at 3 and uv at 6 like the MeshBuilder / demo layout
+    PackedMesh(const float* vertices, int count, int stride = 8) {
+        glm::vec3 boundsMax(-INFINITY);
+        boundsMin = glm::vec3(INFINITY);
+        for (int i = 0; i < count; i++) {
+            glm::vec3 position = glm::make_vec3(&vertices[(size_t)i * stride]);
+            boundsMin = glm::min(boundsMin, position);
+            boundsMax = glm::max(boundsMax, position);
+        }
+        boundsSize = count ? boundsMax - boundsMin : glm::vec3(1.0f);
+        for (int c = 0; c < 3; c++) {
+            if (boundsSize[c] <= 0.0f) {
+                boundsSize[c] = 1.0f; // flat along this axis, everything packs to 0
+            }
+        }
+
+        packed.resize(count);
+        for (int i = 0; i < count; i++) {
+            const float* vertex = &vertices[(size_t)i * stride];
+            glm::vec3 position = (glm::make_vec3(vertex) - boundsMin) / boundsSize;
+            glm::uint64 positionBits = glm::packUnorm4x16(glm::vec4(position, 0.0f));
+            memcpy(packed[i].position, &positionBits, sizeof(positionBits));
+            packed[i].normal = packNormal(glm::make_vec3(vertex + 3));
+            packed[i].texCoords = glm::packHalf2x16(glm::make_vec2(vertex + 6));
+        }
+    }
+
+    int vertexCount() const {
+        return (int)packed.size();
+    }
+
+    int vertexSize() const {
+        return (int)sizeof(PackedVertex);
+    }
+
+    const std::vector<PackedVertex>& getVertices() const {
+        return packed;
+    }
+
+    // unorm [0, 1] positions back to object space
+    glm::mat4 positionTransform() const {
+        return glm::scale(glm::translate(glm::mat4(1.0f), boundsMin), boundsSize);
+    }
+
+    // The same decode the GPU does
+    glm::vec3 unpackPosition(int i) const {
+        glm::uint64 positionBits;
+        memcpy(&positionBits, packed[i].position, sizeof(positionBits));
+        return boundsMin + glm::vec3(glm::unpackUnorm4x16(positionBits)) * boundsSize;
+    }
+
+    glm::vec3 unpackNormal(int i) const {
+        return unpackNormal(packed[i].normal);
+    }
+
+    glm::vec2 unpackTexCoords(int i) const {
+        return glm::unpackHalf2x16(packed[i].texCoords);
+    }
+
+    // Fills the bound GL_ARRAY_BUFFER
+    void upload(GLenum usage = GL_STATIC_DRAW) const {
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(PackedVertex), packed.data(), usage);
+    }
+
+    // Vertex attributes 0-2 of the bound VAO from the bound GL_ARRAY_BUFFER, pass false for the lamp's position only VAO
+    static void setAttributes(bool normalAndTexCoords = true) {
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position)); // position
+        glEnableVertexAttribArray(0);
+        if (!normalAndTexCoords) {
+            return;
+        }
+
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal)); // octahedral normal
+        glEnableVertexAttribArray(1);
+
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoords)); // texture uv coord
+        glEnableVertexAttribArray(2);
+    }
+
+    // Against the float vertices the mesh was packed from
+    PackingError measureError(const float* vertices, int stride = 8) const {
+        PackingError error = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        double positionSquares = 0.0, normalDegrees = 0.0;
+        for (int i = 0; i < vertexCount(); i++) {
+            const float* vertex = &vertices[(size_t)i * stride];
+            float position = glm::length(unpackPosition(i) - glm::make_vec3(vertex));
+            error.maxPosition = std::max(error.maxPosition, position);
+            positionSquares += (double)position * position;
+
+            glm::vec3 normal = glm::make_vec3(vertex + 3);
+            if (glm::dot(normal, normal) > 0.0f) {
+                float cosine = glm::clamp(glm::dot(unpackNormal(i), glm::normalize(normal)), -1.0f, 1.0f);
+                float degrees = glm::degrees(std::acos(cosine));
+                error.maxNormalDegrees = std::max(error.maxNormalDegrees, degrees);
+                normalDegrees += degrees;
+            }
+
+            glm::vec2 texCoords = glm::abs(unpackTexCoords(i) - glm::make_vec2(vertex + 6));
+            error.maxTexCoord = std::max(error.maxTexCoord, std::max(texCoords.x, texCoords.y));
+        }
+        if (vertexCount()) {
+            error.rmsPosition = (float)std::sqrt(positionSquares / vertexCount());
+            error.meanNormalDegrees = (float)(normalDegrees / vertexCount());
+        }
+        return error;
+    }
+
+    // Octahedral encoding (Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors"):
+    // the unit sphere maps onto an octahedron, its lower half folds over the upper half's square
+    static glm::vec2 octahedralEncode(glm::vec3 n) {
+        float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (sum == 0.0f) {
+            return glm::vec2(0.0f);
+        }
+        glm::vec2 e = glm::vec2(n.x, n.y) / sum;
+        if (n.z < 0.0f) {
+            e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) * signNotZero(e);
+        }
+        return e;
+    }
+
+    // Matches octahedralDecode in lightingMapVert.glsl
+    static glm::vec3 octahedralDecode(glm::vec2 e) {
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        if (n.z < 0.0f) {
+            glm::vec2 folded = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signNotZero(glm::vec2(n.x, n.y));
+            n.x = folded.x;
+            n.y = folded.y;
+        }
+        return glm::normalize(n);
+    }
+
+    // Of the 4 roundings around the encoded point, keeps the one that decodes closest to n
+    static uint32_t packNormal(glm::vec3 n) {
+        glm::vec2 scaled = glm::clamp(octahedralEncode(n), -1.0f, 1.0f) * 511.0f;
+        if (glm::dot(n, n) == 0.0f) {
+            return packNormalBits((int)scaled.x, (int)scaled.y);
+        }
+        n = glm::normalize(n);
+
+        int bestX = 0, bestY = 0;
+        float bestCosine = -2.0f;
+        for (int corner = 0; corner < 4; corner++) {
+            int x = (int)((corner & 1) ? std::ceil(scaled.x) : std::floor(scaled.x));
+            int y = (int)((corner & 2) ? std::ceil(scaled.y) : std::floor(scaled.y));
+            float cosine = glm::dot(octahedralDecode(glm::vec2(x, y) / 511.0f), n);
+            if (cosine > bestCosine) {
+                bestCosine = cosine;
+                bestX = x;
+                bestY = y;
+            }
+        }
+        return packNormalBits(bestX, bestY);
+    }
+
+    static glm::vec3 unpackNormal(uint32_t bits) {
+        // sign extend the 10 bit x and y fields
+        int x = (int)(bits << 22) >> 22;
+        int y = (int)(bits << 12) >> 22;
+        return octahedralDecode(glm::vec2(x, y) / 511.0f);
+    }
+
+private:
+    std::vector<PackedVertex> packed;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsSize;
+
+    static glm::vec2 signNotZero(glm::vec2 v) {
+        return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    // x in bits 0-9, y in bits 10-19, z and w stay 0
+    static uint32_t packNormalBits(int x, int y) {
+        return ((uint32_t)x & 0x3FFu) | (((uint32_t)y & 0x3FFu) << 10);
+    }
+};
@@ -0,0 +1,26 @@
+#version 330 core
+// lightingMapVert.glsl for the unpacked 8 float vertex layout, kept as the baseline for VertexFormatBenchmark
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal; 
+layout (location = 2) in vec2 aTexCoords;
+
+// per instance attributes (glVertexAttribDivisor 1), or constant values set with glVertexAttrib* for a single object
+layout (location = 3) in mat4 aModel;        // locations 3-6
+layout (location = 7) in mat3 aNormalMatrix; // locations 7-9, transpose(inverse(model)) computed once on the CPU
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec2 TexCoords;
+
+void main()
+{
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    Normal = aNormalMatrix * aNormal; // forward normal vector to fragment
+    TexCoords = aTexCoords;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+
+} 
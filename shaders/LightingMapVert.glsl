@@ -1,9 +1,12 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal; 
-layout (location = 2) in vec2 aTexCoords;
+layout (location = 0) in vec3 aPos;       // unorm16 across the mesh bounds, aModel includes the decode (PackedMesh)
+layout (location = 1) in vec2 aNormal;    // octahedral, 10 bit integers in -511..511
+layout (location = 2) in vec2 aTexCoords; // half floats
+
+// per instance attributes (glVertexAttribDivisor 1), or constant values set with glVertexAttrib* for a single object
+layout (location = 3) in mat4 aModel;        // locations 3-6
+layout (location = 7) in mat3 aNormalMatrix; // locations 7-9, transpose(inverse(model)) computed once on the CPU
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
@@ -11,12 +14,22 @@ out vec3 Normal;
 out vec3 FragPos;
 out vec2 TexCoords;
 
+// the octahedron's lower half is folded over the upper half's square, unfold it
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal; // forward normal vector to fragment
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    Normal = aNormalMatrix * octahedralDecode(aNormal / 511.0); // forward normal vector to fragment
     TexCoords = aTexCoords;
 
     gl_Position = projection * view * vec4(FragPos, 1.0);
 
-} 
\ No newline at end of file
+} 
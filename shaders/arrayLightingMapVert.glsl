@@ -0,0 +1,51 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;       // unorm16 across the mesh bounds, aModel includes the decode (PackedMesh)
+layout (location = 1) in vec2 aNormal;    // octahedral, 10 bit integers in -511..511
+layout (location = 2) in vec2 aTexCoords; // half floats
+
+// per instance attributes (glVertexAttribDivisor 1)
+layout (location = 3) in mat4 aModel;        // locations 3-6
+layout (location = 7) in mat3 aNormalMatrix; // locations 7-9, transpose(inverse(model)) computed once on the CPU
+layout (location = 10) in int aMaterial;     // index into the material table, glVertexAttribIPointer
+
+const int MAX_MATERIALS = 32;
+
+// TextureArray regions of every material's maps: diffuse, specular and emission scale/offset, then their layers
+uniform vec4 materialRegions[3 * MAX_MATERIALS];
+uniform vec3 materialLayers[MAX_MATERIALS];
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 Normal;
+out vec3 FragPos;
+out vec2 TexCoords;
+
+// looked up once per vertex, constant across the triangle
+flat out vec4 DiffuseRegion;
+flat out vec4 SpecularRegion;
+flat out vec4 EmissionRegion;
+flat out vec3 Layers;
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+void main()
+{
+    FragPos = vec3(aModel * vec4(aPos, 1.0));
+    Normal = aNormalMatrix * octahedralDecode(aNormal / 511.0);
+    TexCoords = aTexCoords;
+
+    DiffuseRegion = materialRegions[aMaterial * 3];
+    SpecularRegion = materialRegions[aMaterial * 3 + 1];
+    EmissionRegion = materialRegions[aMaterial * 3 + 2];
+    Layers = materialLayers[aMaterial];
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
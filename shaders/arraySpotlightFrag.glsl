@@ -0,0 +1,90 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// spotlightFrag.glsl with every map in one TextureArray, see arrayLightingMapVert.glsl for the regions
+struct Material {
+    sampler2DArray maps;
+    float shininess;
+    float emmisiveness;
+};
+
+uniform Material material;
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+uniform SpotLight light;
+uniform vec3 viewPos;
+
+in vec3 Normal;
+in vec3 FragPos;
+in vec2 TexCoords;
+
+flat in vec4 DiffuseRegion;
+flat in vec4 SpecularRegion;
+flat in vec4 EmissionRegion;
+flat in vec3 Layers;
+
+// repeats the region like GL_REPEAT would, the gradients come from the unwrapped uv so the seam keeps its mip level
+vec3 sampleRegion(vec4 region, float layer)
+{
+    vec2 uv = region.zw + fract(TexCoords) * region.xy;
+    return vec3(textureGrad(material.maps, vec3(uv, layer), dFdx(TexCoords) * region.xy, dFdy(TexCoords) * region.xy));
+}
+
+void main()
+{
+    vec3 diffuseMap = sampleRegion(DiffuseRegion, Layers.x);
+    vec3 specularMap = sampleRegion(SpecularRegion, Layers.y);
+    vec3 emissionMap = sampleRegion(EmissionRegion, Layers.z);
+
+    vec3 lightDir = normalize(light.position - FragPos);
+
+    // Ambient Lighting Componenent
+    vec3 ambient = diffuseMap * light.ambient;
+
+    // Emission Lighting Component
+    vec3 emission = emissionMap * material.emmisiveness;
+
+    // Diffuse Lighting Component
+    vec3 norm = normalize(Normal);
+
+    float diff = max(dot(norm, lightDir), 0.0);
+
+    vec3 diffuse = diff * light.diffuse * diffuseMap;
+
+    // Specular Lighting Component
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 128);
+
+    vec3 specular = specularMap * spec * light.specular;
+
+    // Attenuation calculation
+    float distance = length(light.position - FragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    diffuse *= attenuation;
+    specular *= attenuation;
+
+    // Smoothing radius
+    float theta = dot(lightDir, normalize(-light.direction));
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity =  clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    vec3 final = ambient + intensity * (diffuse + specular + emission);
+    FragColor = vec4(final, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal; // this is needed for diffuse lighting
+
+// lightVert.glsl with its matrices in uniform blocks, ranges of LightCasters' ring buffer
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+};
+
+layout (std140) uniform Object {
+    mat4 model;
+};
+
+out vec3 Normal;
+out vec3 FragPos;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+} 
@@ -6,12 +6,14 @@ layout (location = 2) in float aOffset;
 
 uniform float u_time;
 uniform float u_aspect_ratio;
+uniform float u_trail_length; // radians between a line's ends
 
 out vec2 FragPos;
 
 void main()
 {
-    float t = u_time + aOffset;
+    // one instance per line, vertex 0 is its head and vertex 1 its tail
+    float t = u_time + aOffset + float(gl_VertexID) * u_trail_length;
     vec2 pos = aPos + vec2(aRadius * cos(t), u_aspect_ratio * aRadius * sin(t));
     gl_Position = vec4(pos, 0.0, 1.0);
     FragPos = gl_Position.xy;
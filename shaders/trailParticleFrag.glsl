@@ -0,0 +1,12 @@
+#version 330 core
+
+in float Intensity;
+
+out vec4 FragColor;
+
+
+void main()
+{
+    // premultiplied, LineTrails blends with GL_ONE, GL_ONE_MINUS_SRC_ALPHA
+    FragColor = vec4(Intensity);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in float aIntensity;
+
+out float Intensity;
+
+void main()
+{
+    // trailSimulateComp.glsl has already placed both ends in clip space
+    gl_Position = vec4(aPos, 0.0, 1.0);
+    Intensity = aIntensity;
+}
@@ -0,0 +1,107 @@
+#version 430 core
+
+layout (local_size_x = 256) in;
+
+// 32 bytes per particle, position and velocity relative to the orbit's centre
+struct Particle {
+    vec2 centre;
+    vec2 position;
+    vec2 velocity;
+    float life;   // seconds left
+    float radius;
+};
+
+layout (std430, binding = 0) buffer Particles {
+    Particle particles[];
+};
+
+// x, y, intensity for the head then the tail of every particle's line, read straight back as the line VBO
+layout (std430, binding = 1) buffer Vertices {
+    float vertices[];
+};
+
+uniform uint u_base;        // first particle of this batch, the buffers are bound from here on
+uniform uint u_count;       // particles in this batch
+uniform uint u_frame;
+uniform bool u_spawn_all;   // first dispatch, every particle is spawned with a random amount of its life used up
+uniform float u_dt;
+uniform float u_trail_time; // seconds of motion between a line's ends
+uniform float u_aspect_ratio;
+uniform vec2 u_lifetime;    // min, max seconds
+
+uint pcg(uint v)
+{
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float random(inout uint seed)
+{
+    seed = pcg(seed);
+    return float(seed >> 8) * (1.0 / 16777216.0);
+}
+
+// LineTrails' ranges: centre in [-0.5, 0.5), radius in [0.1, 1), a revolution every 2 pi seconds
+Particle spawn(uint index)
+{
+    uint seed = pcg((u_base + index) ^ pcg(u_frame));
+    Particle p;
+    p.centre = vec2(random(seed), random(seed)) - 0.5;
+    p.radius = mix(0.1, 1.0, random(seed));
+    float angle = random(seed) * 6.2831853;
+    vec2 direction = vec2(cos(angle), sin(angle));
+    p.position = p.radius * direction;
+    p.velocity = p.radius * vec2(-direction.y, direction.x);
+    p.life = mix(u_lifetime.x, u_lifetime.y, random(seed));
+    if (u_spawn_all) {
+        p.life *= random(seed);
+    }
+    return p;
+}
+
+void main()
+{
+    // 2D dispatch so counts past 65535 groups still fit
+    uint index = gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x + gl_GlobalInvocationID.x;
+    if (index >= u_count) {
+        return;
+    }
+
+    Particle p;
+    if (u_spawn_all) {
+        p = spawn(index);
+    }
+    else {
+        p = particles[index];
+        p.life -= u_dt;
+        if (p.life <= 0.0) {
+            p = spawn(index);
+        }
+        else {
+            // semi-implicit Euler under the centripetal acceleration that keeps it on its circle,
+            // then projected back onto the circle so the orbit does not drift over long runs
+            float speed = length(p.velocity);
+            vec2 acceleration = -p.position * (speed * speed) / dot(p.position, p.position);
+            p.velocity += acceleration * u_dt;
+            p.position += p.velocity * u_dt;
+            vec2 direction = normalize(p.position);
+            p.position = p.radius * direction;
+            p.velocity = speed * normalize(p.velocity - dot(p.velocity, direction) * direction);
+        }
+    }
+    particles[index] = p;
+
+    // the orbit is stretched by the aspect ratio like lineTrailVert.glsl's, and fades out over its last second
+    vec2 stretch = vec2(1.0, u_aspect_ratio);
+    vec2 head = p.centre + stretch * p.position;
+    vec2 tail = p.centre + stretch * (p.position - p.velocity * u_trail_time);
+    float intensity = clamp(p.life, 0.0, 1.0);
+    uint base = index * 6u;
+    vertices[base + 0u] = head.x;
+    vertices[base + 1u] = head.y;
+    vertices[base + 2u] = intensity;
+    vertices[base + 3u] = tail.x;
+    vertices[base + 4u] = tail.y;
+    vertices[base + 5u] = intensity;
+}
@@ -0,0 +1,26 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+// Which page of which level this pixel samples, read back by TextureStreamer::update()
+uniform vec2 vtSize;
+uniform vec2 vtPageSize;
+uniform int vtTailLevel;
+uniform int vtId;               // texture id + 1, 0 is nothing
+uniform float vtFeedbackBias;   // the feedback buffer is smaller, its derivatives larger
+
+void main()
+{
+    vec2 texel = TexCoord * vtSize;
+    vec2 dx = dFdx(texel), dy = dFdy(texel);
+    float lod = max(0.5 * log2(max(dot(dx, dx), dot(dy, dy))) + vtFeedbackBias, 0.0);
+    int level = int(floor(lod));
+    if (level >= vtTailLevel) {
+        FragColor = vec4(0.0); // the tail is always resident
+        return;
+    }
+    vec2 levelSize = max(floor(vtSize / exp2(float(level))), vec2(1.0));
+    vec2 page = floor(fract(TexCoord) * levelSize / vtPageSize);
+    FragColor = vec4(float(vtId), float(level), page.x, page.y) / 255.0;
+}
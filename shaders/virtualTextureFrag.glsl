@@ -0,0 +1,48 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+// TextureStreamer::bind() sets all of these
+uniform sampler2D vtPageTable;  // per page and level: pool slot x, y and the level actually resident, all * 255
+uniform sampler2D vtPages;      // page pool, or the sparse texture itself
+uniform sampler2D vtTail;       // levels from vtTailBase down
+uniform vec2 vtSize;            // level 0 in texels
+uniform vec2 vtPageSize;
+uniform int vtTailLevel;
+uniform int vtTailBase;
+uniform int vtSparse;
+uniform vec3 vtSlot;            // slot size, border, pool size in texels
+
+vec4 sampleLevel(vec2 uv, int level)
+{
+    if (level >= vtTailLevel) {
+        return textureLod(vtTail, uv, float(level - vtTailBase));
+    }
+    vec2 wrapped = fract(uv);
+    vec2 levelSize = max(floor(vtSize / exp2(float(level))), vec2(1.0));
+    ivec2 page = ivec2(wrapped * levelSize / vtPageSize);
+    vec4 entry = floor(texelFetch(vtPageTable, page, level) * 255.0 + 0.5);
+    int resident = int(entry.b);
+    if (resident >= vtTailLevel) {
+        return textureLod(vtTail, uv, float(vtTailLevel - vtTailBase));
+    }
+    if (vtSparse != 0) {
+        return textureLod(vtPages, uv, float(resident));
+    }
+
+    // the resident ancestor's page, found the same way the streamer walks up: page index halved per level
+    vec2 residentSize = max(floor(vtSize / exp2(float(resident))), vec2(1.0));
+    vec2 ancestor = floor(vec2(page) / exp2(float(resident - level)));
+    vec2 inPage = wrapped * residentSize - ancestor * vtPageSize;
+    return textureLod(vtPages, (entry.rg * vtSlot.x + vtSlot.y + inPage) / vtSlot.z, 0.0);
+}
+
+void main()
+{
+    vec2 texel = TexCoord * vtSize;
+    vec2 dx = dFdx(texel), dy = dFdy(texel);
+    float lod = max(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0.0);
+    int level = int(floor(lod));
+    FragColor = mix(sampleLevel(TexCoord, level), sampleLevel(TexCoord, level + 1), fract(lod));
+}
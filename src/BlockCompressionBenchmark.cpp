@@ -0,0 +1,150 @@
+// BlockEncoder on the images in resources/ (or the ones given): encode throughput on one thread and on the whole
+// pool, quality as PSNR against the source after the driver decodes the uploaded blocks (glCompressedTexImage2D,
+// read back with glGetTexImage), and the texture memory saved. Build with SIMD_FORCE_SCALAR for the plain C++ numbers.
+//
+//   BlockCompressionBenchmark [image ...]
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include "BlockEncoder.h"
+#include "GLExtensions.h"
+#include "stb_image.h"
+
+const int REPEATS = 3;
+
+// Fastest of REPEATS, in ms
+template <typename Function>
+double bestTime(Function function)
+{
+    double best = 1e30;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+// Over the channels the source has, alpha only when it isn't all 255
+double psnr(const unsigned char* source, int components, const std::vector<unsigned char>& decoded, int width, int height, bool alpha)
+{
+    int channels = std::min(components, alpha ? 4 : 3);
+    double squared = 0.0;
+    for (size_t i = 0; i < (size_t)width * height; i++) {
+        for (int c = 0; c < channels; c++) {
+            double difference = (double)source[i * components + c] - decoded[i * 4 + c];
+            squared += difference * difference;
+        }
+    }
+    double mean = squared / ((double)width * height * channels);
+    return mean > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mean) : 99.0;
+}
+
+int main(int argc, char** argv)
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 600, "Block Compression Benchmark", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    bool s3tc = hasGLExtension("GL_EXT_texture_compression_s3tc");
+    bool bptc = hasGLVersion(4, 2) || hasGLExtension("GL_ARB_texture_compression_bptc");
+
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        files.push_back(argv[i]);
+    }
+    if (files.empty()) {
+        for (const auto& entry : std::filesystem::directory_iterator("resources")) {
+            std::string extension = entry.path().extension().string();
+            if (extension == ".png" || extension == ".jpg") {
+                files.push_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    ThreadPool single(0), pool;
+    static const char* names[] = { "BC1", "BC3", "BC7" };
+    static const GLenum internalFormats[] = { GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_RGBA_BPTC_UNORM };
+#ifdef SIMD_SSE2
+    const char* simd = "SSE2";
+#else
+    const char* simd = "scalar";
+#endif
+    printf("%s index search, pool of %d threads\n", simd, pool.size());
+    printf("%-34s %5s %12s %14s %14s %8s %11s %11s\n", "", "", "1 thread ms", "MPix/s/core", "pool MPix/s", "PSNR", "raw KB", "blocks KB");
+
+    size_t totalRaw = 0, totalCompressed = 0;
+    for (const std::string& file : files) {
+        int width, height, components;
+        unsigned char* pixels = stbi_load(file.c_str(), &width, &height, &components, 0);
+        if (!pixels) {
+            std::cout << "Texture failed to load at path: " << file << std::endl;
+            continue;
+        }
+        bool opaque = BlockEncoder::isOpaque(pixels, width, height, components);
+        double megapixels = (double)width * height / 1e6;
+        // what glTexImage2D with the demos' formats stores, drivers pad RGB to 4 bytes
+        size_t raw = (size_t)width * height * (components == 3 ? 4 : components);
+
+        for (int format = BLOCK_BC1; format <= BLOCK_BC7; format++) {
+            BlockFormat blockFormat = (BlockFormat)format;
+            std::vector<uint8_t> blocks;
+            double singleMs = bestTime([&] { blocks = BlockEncoder::compress(pixels, width, height, components, blockFormat, &single); });
+            double poolMs = bestTime([&] { blocks = BlockEncoder::compress(pixels, width, height, components, blockFormat, &pool); });
+
+            double quality = 0.0;
+            if (format == BLOCK_BC7 ? bptc : s3tc) {
+                unsigned int texture;
+                glGenTextures(1, &texture);
+                glBindTexture(GL_TEXTURE_2D, texture);
+                glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormats[format], width, height, 0, (GLsizei)blocks.size(), blocks.data());
+                std::vector<unsigned char> decoded((size_t)width * height * 4);
+                glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data());
+                glDeleteTextures(1, &texture);
+                quality = psnr(pixels, components, decoded, width, height, !opaque);
+            }
+
+            // the cooker's --bc choice is what counts towards the totals
+            bool chosen = format == (opaque ? BLOCK_BC1 : BLOCK_BC7);
+            if (chosen) {
+                totalRaw += raw;
+                totalCompressed += blocks.size();
+            }
+            printf("%-34s %5s %12.2f %14.2f %14.2f %8.2f %11.1f %11.1f%s\n", format == BLOCK_BC1 ? file.c_str() : "", names[format],
+                singleMs, megapixels / (singleMs / 1000.0), megapixels / (poolMs / 1000.0), quality, raw / 1024.0,
+                blocks.size() / 1024.0, chosen ? "  <- --bc" : "");
+        }
+        stbi_image_free(pixels);
+    }
+    if (totalCompressed > 0) {
+        printf("--bc: %.1f KB -> %.1f KB of level 0 texture memory, %.1fx smaller, %.1f KB saved\n", totalRaw / 1024.0,
+            totalCompressed / 1024.0, (double)totalRaw / totalCompressed, (totalRaw - totalCompressed) / 1024.0);
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -6,7 +6,11 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include "Shader.h"
+#include "ShaderLibrary.h"
+#include "GLExtensions.h"
 #include "Camera.h"
+#include "MeshBuilder.h"
+#include "RenderQueue.h"
 #include "stb_image.h"
 
 #include <glm/glm.hpp>
@@ -101,13 +105,15 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);
 
 
-    //Instantiate shader programs
+    //Instantiate shader programs, the files are read in the background while the buffers are set up
 
-    Shader shader("shaders/lightVert.glsl", "shaders/lightFrag.glsl");
-    Shader gourad("shaders/gouradVert.glsl", "shaders/gouradFrag.glsl");
-    Shader lightShader("shaders/lightVert.glsl", "shaders/lightSourceFrag.glsl");
+    ShaderLibrary shaders;
+    int shaderProgram = shaders.add("shaders/lightVert.glsl", "shaders/lightFrag.glsl");
+    int gouradProgram = shaders.add("shaders/gouradVert.glsl", "shaders/gouradFrag.glsl");
+    int lightProgram = shaders.add("shaders/lightVert.glsl", "shaders/lightSourceFrag.glsl");
 
  
     // Lighted up object VBO
@@ -118,11 +124,14 @@ int main()
 
     glBindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // the cube's 36 vertices weld down to 24 unique ones plus an index buffer
+    MeshBuilder cube(6);
+    cube.addTriangles(vertices, 36);
+    cube.optimize();
 
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    //glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    cube.upload();
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*) 0); // position
     glEnableVertexAttribArray(0);
@@ -135,13 +144,18 @@ int main()
     unsigned int lightVAO;
     glGenVertexArrays(1, &lightVAO);
     glBindVertexArray(lightVAO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    // we only need to bind to the VBO, the container's VBO's data already contains the data.
+    // we only need to bind to the VBO and EBO, the container's buffers already contain the data.
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     // set the vertex attribute 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0); // just position
     glEnableVertexAttribArray(0);
 
+    shaders.submit();
+    Shader shader = shaders.get(shaderProgram);
+    Shader gourad = shaders.get(gouradProgram);
+    Shader lightShader = shaders.get(lightProgram);
+
     //model matrix
     glm::mat4 model = glm::mat4(1.0f);
     //model = glm::rotate(model, glm::radians(55.0f), glm::vec3(1.0f, 0.0f, 0.0f));
@@ -178,6 +192,27 @@ int main()
     //Swap color buffer then polls for events like keyboard or mouse input
     glEnable(GL_DEPTH_TEST);
 
+    // the three cubes are recorded into the queue and submitted grouped by program and VAO, front to back
+    GLStateCache glState;
+    RenderQueue queue;
+    queue.setDepthRange(0.1f, 100.0f);
+
+    // resolve uniforms once so the render loop never looks names up, lightShader shares lightVert.glsl with shader
+    Shader* litShaders[] = { &shader, &gourad };
+    UniformHandle litModel[2], litView[2], litProjection[2], litObjectColor[2], litLightColor[2], litLightPos[2], litViewPos[2];
+    for (int i = 0; i < 2; i++) {
+        litModel[i] = litShaders[i]->getUniform("model");
+        litView[i] = litShaders[i]->getUniform("view");
+        litProjection[i] = litShaders[i]->getUniform("projection");
+        litObjectColor[i] = litShaders[i]->getUniform("objectColor");
+        litLightColor[i] = litShaders[i]->getUniform("lightColor");
+        litLightPos[i] = litShaders[i]->getUniform("lightPos");
+        litViewPos[i] = litShaders[i]->getUniform("viewPos");
+    }
+    UniformHandle lightModelUniform = lightShader.getUniform("model");
+    UniformHandle lightViewUniform = lightShader.getUniform("view");
+    UniformHandle lightProjectionUniform = lightShader.getUniform("projection");
+
     while (!glfwWindowShouldClose(window))
     {
         float currentFrame = static_cast<float>(glfwGetTime());
@@ -194,40 +229,38 @@ int main()
 
         view = camera.generateView();
 
-        shader.use();
-        shader.setMat4("model", model);
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-        shader.setVec3("objectColor", glm::vec3(1.0f, 0.5f, 0.31f));
-        shader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
-        shader.setVec3("lightPos", lightPos);
-        shader.setVec3("viewPos", camera.Pos);
-
-        glBindVertexArray(VAO);   
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        gourad.use();
-        gourad.setMat4("model", gouradModel);
-        gourad.setMat4("view", view);
-        gourad.setMat4("projection", projection);
-        gourad.setVec3("objectColor", glm::vec3(1.0f, 0.5f, 0.31f));
-        gourad.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
-        gourad.setVec3("lightPos", lightPos);
-        gourad.setVec3("viewPos", camera.Pos);
-
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        lightShader.use();
-        lightShader.setMat4("model", lightModel);
-        lightShader.setMat4("view", view);
-        lightShader.setMat4("projection", projection);
-
-        glBindVertexArray(lightVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        for (int i = 0; i < 2; i++) {
+            GLuint program = litShaders[i]->ID;
+            queue.frameUniform(program, litView[i], view);
+            queue.frameUniform(program, litProjection[i], projection);
+            queue.frameUniform(program, litObjectColor[i], glm::vec3(1.0f, 0.5f, 0.31f));
+            queue.frameUniform(program, litLightColor[i], glm::vec3(1.0f, 1.0f, 1.0f));
+            queue.frameUniform(program, litLightPos[i], lightPos);
+            queue.frameUniform(program, litViewPos[i], camera.Pos);
+        }
+
+        queue.begin(shader.ID, VAO, glm::length(camera.Pos));
+        queue.uniform(litModel[0], model);
+        queue.drawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType());
+
+        queue.begin(gourad.ID, VAO, glm::length(gouradPos - camera.Pos));
+        queue.uniform(litModel[1], gouradModel);
+        queue.drawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType());
+
+        queue.frameUniform(lightShader.ID, lightViewUniform, view);
+        queue.frameUniform(lightShader.ID, lightProjectionUniform, projection);
+        queue.begin(lightShader.ID, lightVAO, glm::length(lightPos - camera.Pos));
+        queue.uniform(lightModelUniform, lightModel);
+        queue.drawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType());
+
+        queue.flush(glState);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+        glState.endFrame();
     }
+    glState.report();
+    queue.report();
 
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
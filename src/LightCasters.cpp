@@ -3,8 +3,19 @@
 #include <glad/glad.h> 
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstddef>
 #include "Shader.h"
+#include "GLExtensions.h"
 #include "Camera.h"
+#include "MeshBuilder.h"
+#include "VertexPacking.h"
+#include "RenderQueue.h"
+#include "TextureCache.h"
+#include "Profiler.h"
+#include "RingBuffer.h"
 #include "stb_image.h"
 
 #include <glm/glm.hpp>
@@ -15,7 +26,25 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouseCallback(GLFWwindow* window, double xpos, double ypos);
-unsigned int loadImage(char const* path);
+
+// Per instance vertex data for lightingMapVert.glsl
+struct CubeInstance {
+    glm::mat4 model;
+    glm::mat3 normalMatrix; // transpose(inverse(model)), so the vertex shader doesn't invert a matrix per vertex
+};
+
+// Frame uniform block of lightingMapBlockVert.glsl and lightBlockVert.glsl, std140
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+};
+
+// uniform block binding points
+const int FRAME_BLOCK = 0;
+const int OBJECT_BLOCK = 1;
+
+CubeInstance makeCubeInstance(glm::vec3 position, float angle, const glm::mat4& positionTransform);
+void instancingBenchmark(GLFWwindow* window, Shader& shader, const MeshBuilder& cube, const glm::mat4& positionTransform, unsigned int VAO, unsigned int instanceVBO, int maxInstances);
 
 float vertices[] = {
     // positions          // normals           // texture coords
@@ -66,9 +95,30 @@ float lastX = 400, lastY = 300;
 float lastFrame = 0, deltaTime = 0;
 Camera camera;
 GLboolean firstMouse = true;
-
-int main()
+GLStateCache glState;
+
+//   LightCasters                         interactive scene
+//   LightCasters --bench [maxInstances]   frame time versus cube count, per cube draws against one instanced draw
+//   LightCasters --trace [file]           interactive scene, profiled, Chrome trace written on exit (LightCasters.json)
+//   LightCasters --uniforms               view, projection and model through glUniform* instead of the ring buffer
+// CPU submission time per frame is printed on exit.
+int main(int argc, char** argv)
 {
+    bool benchmark = argc > 1 && std::string(argv[1]) == "--bench";
+    int maxInstances = argc > 2 ? atoi(argv[2]) : 1000000;
+    bool trace = argc > 1 && std::string(argv[1]) == "--trace";
+    const char* tracePath = argc > 2 && argv[2][0] != '-' ? argv[2] : "LightCasters.json";
+    bool uniforms = false;
+    for (int i = 1; i < argc; i++) {
+        uniforms = uniforms || std::string(argv[i]) == "--uniforms";
+    }
+    // the instancing benchmark sets its matrices with glUniform*
+    bool streamed = !uniforms && !benchmark;
+
+    // from the start, so shader and texture loading are in the trace too
+    Profiler::setEnabled(trace);
+    Profiler::setThreadName("GL thread");
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
@@ -100,28 +150,57 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+
+    // the maps decode on the workers while the shaders compile and the buffers are built
+    ThreadPool pool;
+    TextureLoader textures(pool);
+    TextureCache textureCache(textures, 64 * 1024 * 1024);
+    TextureHandle diffuseMap = textureCache.acquire("resources/container2.png");
+    TextureHandle specularMap = textureCache.acquire("resources/container2_specular.png");
+    TextureHandle emissionMap = textureCache.acquire("resources/7a9.jpg");
+
+    // the handles and the cache delete GL textures, so every exit releases them before glfwTerminate
+    auto releaseTextures = [&] {
+        diffuseMap.reset();
+        specularMap.reset();
+        emissionMap.reset();
+        textureCache.trim();
+    };
 
 
     // Instantiate shader programs
+    auto shaderStart = std::chrono::high_resolution_clock::now();
 
     //Shader shader("shaders/lightingMapVert.glsl", "shaders/directionalLightFrag.glsl"); // Directional Light
     //Shader shader("shaders/lightingMapVert.glsl", "shaders/pointLightFrag.glsl"); // Point Light
-    Shader shader("shaders/lightingMapVert.glsl", "shaders/spotlightFrag.glsl"); // Spotlight
-
-    Shader lightShader("shaders/lightVert.glsl", "shaders/lightSourceFrag.glsl");
+    // Spotlight, the matrices come from uniform blocks in the ring buffer unless --uniforms
+    Shader shader(streamed ? "shaders/lightingMapBlockVert.glsl" : "shaders/lightingMapVert.glsl", "shaders/spotlightFrag.glsl");
+
+    Shader lightShader(streamed ? "shaders/lightBlockVert.glsl" : "shaders/lightVert.glsl", "shaders/lightSourceFrag.glsl");
+    if (streamed) {
+        glUniformBlockBinding(shader.ID, glGetUniformBlockIndex(shader.ID, "Frame"), FRAME_BLOCK);
+        glUniformBlockBinding(lightShader.ID, glGetUniformBlockIndex(lightShader.ID, "Frame"), FRAME_BLOCK);
+        glUniformBlockBinding(lightShader.ID, glGetUniformBlockIndex(lightShader.ID, "Object"), OBJECT_BLOCK);
+    }
 
+    auto shaderEnd = std::chrono::high_resolution_clock::now();
+    printf("startup: 2 shader programs in %.3f ms\n", std::chrono::duration<double, std::milli>(shaderEnd - shaderStart).count());
+    ShaderCache::report();
 
-    // load maps
-    unsigned int diffuseMap = loadImage("resources/container2.png");
-    unsigned int specularMap = loadImage("resources/container2_specular.png");
-    unsigned int emissionMap = loadImage("resources/7a9.jpg");
+    // upload the maps, only waits if a decode is still running
+    textures.finish();
+    const TextureLoaderStats& textureStats = textures.getStats();
+    printf("textures: %d ready after %.3f ms on the GL thread (%.3f ms waiting), %.3f ms decoding on %d threads\n", textureStats.textures,
+        textureStats.uploadMs, textureStats.waitMs, textureStats.decodeMs, pool.size());
+    textureCache.report();
 
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, diffuseMap);
+    glBindTexture(GL_TEXTURE_2D, diffuseMap.id());
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, specularMap);
+    glBindTexture(GL_TEXTURE_2D, specularMap.id());
     glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, emissionMap);
+    glBindTexture(GL_TEXTURE_2D, emissionMap.id());
 
     // Lighted up object VBO
     unsigned int VAO, VBO, EBO;
@@ -131,30 +210,47 @@ int main()
 
     glBindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0); // position
-    glEnableVertexAttribArray(0);
+    // the cube's 36 vertices weld down to 24 unique ones plus an index buffer
+    MeshBuilder cube(8);
+    cube.addTriangles(vertices, 36);
+    cube.optimize();
+    printf("cube mesh: %d vertices, %d indices, ACMR %.2f\n", cube.vertexCount(), cube.indexCount(), cube.acmr());
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float))); // normal vectors
-    glEnableVertexAttribArray(1);
+    // 16 byte vertices instead of 32, see VertexPacking.h
+    PackedMesh packedCube(cube.getVertices().data(), cube.vertexCount());
 
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float))); // texture uv coord
-    glEnableVertexAttribArray(2);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    packedCube.upload();
+    cube.uploadIndices();
+    PackedMesh::setAttributes(); // position, octahedral normal, texture uv coord
+
+    // Instance VBO, attributes advance once per cube instead of once per vertex
+    unsigned int instanceVBO;
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    for (int i = 0; i < 4; i++) { // model matrix columns
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)(offsetof(CubeInstance, model) + i * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1);
+    }
+    for (int i = 0; i < 3; i++) { // normal matrix columns
+        glVertexAttribPointer(7 + i, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)(offsetof(CubeInstance, normalMatrix) + i * sizeof(glm::vec3)));
+        glEnableVertexAttribArray(7 + i);
+        glVertexAttribDivisor(7 + i, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
     //Creating LightVAO
     unsigned int lightVAO;
     glGenVertexArrays(1, &lightVAO);
     glBindVertexArray(lightVAO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    // we only need to bind to the VBO, the container's VBO's data already contains the data.
+    // we only need to bind to the VBO and EBO, the container's buffers already contain the data.
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     // set the vertex attribute 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0); // just position
-    glEnableVertexAttribArray(0);
+    PackedMesh::setAttributes(false); // just position
 
 
     //view matrix
@@ -165,6 +261,7 @@ int main()
     glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
     lightModel = glm::translate(lightModel, lightPos);
     lightModel = glm::scale(lightModel, glm::vec3(0.2f));
+    lightModel = lightModel * packedCube.positionTransform();
 
     //camera
     camera = Camera(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 1.0f, 0.0f));
@@ -222,8 +319,18 @@ int main()
     shader.setFloat("material.emmisiveness", 0.0f);
    
 
-    glEnable(GL_DEPTH_TEST);
+    glState.setEnabled(GL_DEPTH_TEST, true);
+
+    // resolve per frame uniforms once so the render loop never looks names up
+    UniformHandle viewUniform = shader.getUniform("view");
+    UniformHandle projectionUniform = shader.getUniform("projection");
+    UniformHandle viewPosUniform = shader.getUniform("viewPos");
+    UniformHandle lightPositionUniform = shader.getUniform("light.position");
+    UniformHandle lightDirectionUniform = shader.getUniform("light.direction");
 
+    UniformHandle lightModelUniform = lightShader.getUniform("model");
+    UniformHandle lightViewUniform = lightShader.getUniform("view");
+    UniformHandle lightProjectionUniform = lightShader.getUniform("projection");
 
     glm::vec3 positions[] = {
         glm::vec3(0.0f,0.0f, 0.0f),
@@ -241,6 +348,39 @@ int main()
         printf("x %f, y %f, z %f \n", positions[i].x, positions[i].y, positions[i].z);
     }*/
 
+    // the cubes never move, so their matrices are built and uploaded once
+    std::vector<CubeInstance> instances;
+    for (int i = 0; i < 10; i++) {
+        instances.push_back(makeCubeInstance(positions[i], 20.0f * i, packedCube.positionTransform()));
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(CubeInstance), instances.data(), GL_STATIC_DRAW);
+
+    if (benchmark) {
+        instancingBenchmark(window, shader, cube, packedCube.positionTransform(), VAO, instanceVBO, maxInstances);
+        releaseTextures();
+        glfwTerminate();
+        return 0;
+    }
+
+    // the render loop records its draws here and submits them sorted by state
+    RenderQueue queue;
+    queue.setDepthRange(0.1f, 100.0f);
+
+    // per frame matrices, three frames in flight
+    RingBuffer ring;
+    if (streamed && !ring.create(16 * 1024)) {
+        releaseTextures();
+        glfwTerminate();
+        return -1;
+    }
+    double submitMs = 0.0, frameMs = 0.0;
+    long long submitted = 0;
+
+    // only count the render loop's calls
+    glState.invalidate();
+    glState.resetCounters();
+
     //Render Loop
     while (!glfwWindowShouldClose(window))
     {
@@ -250,6 +390,7 @@ int main()
 
         processInput(window);
 
+        auto submitStart = std::chrono::high_resolution_clock::now();
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         /*matAmbient.x = cos(glfwGetTime() * 1.0f);
@@ -262,53 +403,192 @@ int main()
 
         view = camera.generateView();
 
-        shader.use();
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-        shader.setVec3("viewPos", camera.Pos);
+        if (streamed) {
+            // one memcpy each into the mapped ring, then a range bind per block instead of a glUniform per program
+            ring.beginFrame();
+            RingAllocation frameBlock = ring.push(FrameBlock{ view, projection }, ring.uniformAlignment());
+            RingAllocation lightBlock = ring.push(lightModel, ring.uniformAlignment());
+            ring.flush();
+            glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK, ring.buffer(), frameBlock.offset, frameBlock.size);
+            glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK, ring.buffer(), lightBlock.offset, lightBlock.size);
+        }
+        else {
+            queue.frameUniform(shader.ID, viewUniform, view);
+            queue.frameUniform(shader.ID, projectionUniform, projection);
+        }
+        queue.frameUniform(shader.ID, viewPosUniform, camera.Pos);
 
         // Spot Light properties
-        shader.setVec3("light.position", camera.Pos);
-        shader.setVec3("light.direction", camera.Front);
+        queue.frameUniform(shader.ID, lightPositionUniform, camera.Pos);
+        queue.frameUniform(shader.ID, lightDirectionUniform, camera.Front);
 
-        glBindVertexArray(VAO);
-        // drawing multiple cubes
-        for (int i = 0; i < 10; i++) {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, positions[i]);
-            
-            float angle = 20.0f * i;
-            model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            shader.setMat4("model", model);
+        // drawing multiple cubes, one draw for all of them
+        queue.begin(shader.ID, VAO);
+        queue.name("cubes");
+        queue.texture(0, diffuseMap.id());
+        queue.texture(1, specularMap.id());
+        queue.texture(2, emissionMap.id());
+        queue.drawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType(), (int)instances.size());
 
-            glDrawArrays(GL_TRIANGLES, 0, 36);
 
+        if (!streamed) {
+            queue.frameUniform(lightShader.ID, lightViewUniform, view);
+            queue.frameUniform(lightShader.ID, lightProjectionUniform, projection);
         }
-       
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
 
+        queue.begin(lightShader.ID, lightVAO, glm::length(lightPos - camera.Pos));
+        queue.name("light");
+        if (!streamed) {
+            queue.uniform(lightModelUniform, lightModel);
+        }
+        queue.drawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType());
+
+        queue.flush(glState);
+        auto submitEnd = std::chrono::high_resolution_clock::now();
+        submitMs += std::chrono::duration<double, std::milli>(submitEnd - submitStart).count();
+        // the fence flushes the frame's commands, software drivers render right there
+        if (streamed) {
+            ring.endFrame();
+        }
 
-        lightShader.use();
-        lightShader.setMat4("model", lightModel);
-        lightShader.setMat4("view", view);
-        lightShader.setMat4("projection", projection);
-        
-        glBindVertexArray(lightVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        frameMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - submitStart).count();
+        submitted++;
+        glState.endFrame();
+        Profiler::endFrame();
+    }
+    glState.report();
+    queue.report();
+    long long divisor = submitted > 0 ? submitted : 1;
+    printf("submission, %s: %.3f ms of CPU per frame recording and flushing the queue, %.3f ms per frame through swap, %lld frames\n",
+        streamed ? "ring buffer" : "glUniform", submitMs / divisor, frameMs / divisor, submitted);
+    if (streamed) {
+        ring.report();
+        ring.release();
+    }
+    Profiler::release();
+    if (trace) {
+        Profiler::report();
+        Profiler::exportTrace(tracePath);
     }
 
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
     glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &instanceVBO);
+    releaseTextures();
 
     glfwTerminate();
     return 0;
 }
 
+// positionTransform is the packed mesh's decode, it goes into the model matrix but not the normal matrix
+CubeInstance makeCubeInstance(glm::vec3 position, float angle, const glm::mat4& positionTransform)
+{
+    CubeInstance instance;
+    instance.model = glm::mat4(1.0f);
+    instance.model = glm::translate(instance.model, position);
+    instance.model = glm::rotate(instance.model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
+    instance.normalMatrix = glm::mat3(glm::transpose(glm::inverse(instance.model)));
+    instance.model = instance.model * positionTransform;
+    return instance;
+}
+
+struct FrameTiming {
+    double submitMs; // CPU time spent issuing the draws
+    double frameMs;  // until the GPU finished the frame
+};
+
+// Averages at least 5 frames and half a second, after 2 warm up frames
+template<class Submit>
+FrameTiming timeFrames(GLFWwindow* window, Submit submit)
+{
+    FrameTiming total = { 0.0, 0.0 };
+    int frames = 0;
+    for (int frame = -2; frame < 5 || total.frameMs < 500.0; frame++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        submit();
+        auto submitted = std::chrono::high_resolution_clock::now();
+        glFinish();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+
+        if (frame >= 0) {
+            total.submitMs += std::chrono::duration<double, std::milli>(submitted - start).count();
+            total.frameMs += std::chrono::duration<double, std::milli>(end - start).count();
+            frames++;
+        }
+    }
+    total.submitMs /= frames;
+    total.frameMs /= frames;
+    return total;
+}
+
+// Cubes on a grid that starts in front of the camera and runs down -z
+std::vector<CubeInstance> benchmarkInstances(int count, const glm::mat4& positionTransform)
+{
+    int side = (int)std::ceil(std::cbrt((double)count));
+    const float spacing = 1.5f;
+
+    std::vector<CubeInstance> instances(count);
+    for (int i = 0; i < count; i++) {
+        int x = i % side, y = (i / side) % side, z = i / (side * side);
+        glm::vec3 position((x - side * 0.5f) * spacing, (y - side * 0.5f) * spacing, -z * spacing);
+        instances[i] = makeCubeInstance(position, 20.0f * i, positionTransform);
+    }
+    return instances;
+}
+
+void instancingBenchmark(GLFWwindow* window, Shader& shader, const MeshBuilder& cube, const glm::mat4& positionTransform, unsigned int VAO, unsigned int instanceVBO, int maxInstances)
+{
+    glfwSwapInterval(0);
+
+    shader.use();
+    shader.setMat4("view", camera.generateView());
+    shader.setMat4("projection", glm::perspective(glm::radians(camera.Fov), 800.0f / 600.0f, 0.1f, 1000.0f));
+    shader.setVec3("viewPos", camera.Pos);
+    shader.setVec3("light.position", camera.Pos);
+    shader.setVec3("light.direction", camera.Front);
+    glBindVertexArray(VAO);
+
+    // a draw per cube through base instance costs the same API calls as the old uniform per cube loop
+    const int maxPerCubeDraws = 100000;
+    if (!GLEXT_ARB_base_instance) {
+        printf("ARB_base_instance missing, only timing the instanced path\n");
+    }
+
+    printf("instances    per cube draws: submit ms  frame ms    instanced: submit ms  frame ms    speedup\n");
+    for (int count = 10; count <= maxInstances; count *= 10) {
+        std::vector<CubeInstance> instances = benchmarkInstances(count, positionTransform);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(CubeInstance), instances.data(), GL_STATIC_DRAW);
+
+        FrameTiming instanced = timeFrames(window, [&cube, count] {
+            glDrawElementsInstanced(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0, count);
+        });
+
+        if (GLEXT_ARB_base_instance && count <= maxPerCubeDraws) {
+            FrameTiming perCube = timeFrames(window, [&cube, count] {
+                for (int i = 0; i < count; i++) {
+                    glext_glDrawElementsInstancedBaseInstance(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0, 1, i);
+                }
+            });
+            printf("%9d    %25.3f %9.3f    %20.3f %9.3f    %6.2fx\n", count, perCube.submitMs, perCube.frameMs,
+                instanced.submitMs, instanced.frameMs, perCube.frameMs / instanced.frameMs);
+        }
+        else {
+            printf("%9d    %25s %9s    %20.3f %9.3f\n", count, "-", "-", instanced.submitMs, instanced.frameMs);
+        }
+    }
+}
+
 
 
 
@@ -370,40 +650,3 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         glfwSetWindowShouldClose(window, true);
     }
 }
-
-unsigned int loadImage(char const* path)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
@@ -0,0 +1,167 @@
+// Throughput of the SIMD lighting kernels in LightingKernels.h. Shades the same random SoA fragments
+// with every lane width this build has, checks each result bit for bit against the 1 wide reference,
+// then reports fragments/s on one core and across the thread pool.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstring>
+#include "LightingKernels.h"
+#include "ThreadPool.h"
+
+#include <glm/glm.hpp>
+
+const int FRAGMENTS = 1 << 20;
+const int REPEATS = 10;
+
+// 3 components each: fragPos, normal, diffuseMap, specularMap, emissionMap
+struct FragmentData {
+    std::vector<float> inputs[15];
+    std::vector<float> color[3];
+
+    LightingFragments view(int begin, int count) {
+        LightingFragments fragments;
+        for (int c = 0; c < 3; c++) {
+            fragments.fragPos[c] = &inputs[c][begin];
+            fragments.normal[c] = &inputs[3 + c][begin];
+            fragments.diffuseMap[c] = &inputs[6 + c][begin];
+            fragments.specularMap[c] = &inputs[9 + c][begin];
+            fragments.emissionMap[c] = &inputs[12 + c][begin];
+            fragments.color[c] = &color[c][begin];
+        }
+        fragments.count = count;
+        return fragments;
+    }
+};
+
+enum Kernel {
+    DIRECTIONAL,
+    POINT,
+    SPOT,
+    MATERIAL_PHONG
+};
+
+const char* kernelNames[] = { "directional", "point", "spot", "materialPhong" };
+
+// Light values from LightCasters.cpp / MaterialLighting.cpp, camera at (0, 0, 3)
+DirectionalLightParams directionalLight = { glm::vec3(1.0f, -1.0f, -1.0f), glm::vec3(0.2f), glm::vec3(0.5f), glm::vec3(1.0f) };
+PointLightParams pointLight = { glm::vec3(1.2f, 1.0f, 2.0f), glm::vec3(0.2f), glm::vec3(0.5f), glm::vec3(1.0f), 1.0f, 0.09f, 0.032f };
+SpotLightParams spotLight = { glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+    0.97630f, 0.95372f, glm::vec3(0.2f), glm::vec3(0.5f), glm::vec3(1.0f), 1.0f, 0.09f, 0.032f };
+PhongMaterialParams phongMaterial = { glm::vec3(1.0f, 0.5f, 0.31f), glm::vec3(1.0f, 0.5f, 0.31f), glm::vec3(0.5f), 32.0f };
+PhongLightParams phongLight = { glm::vec3(0.2f), glm::vec3(0.5f), glm::vec3(1.0f) };
+glm::vec3 viewPos(0.0f, 0.0f, 3.0f);
+glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
+
+template<class Lanes>
+void shade(Kernel kernel, const LightingFragments& fragments) {
+    switch (kernel) {
+    case DIRECTIONAL:
+        shadeDirectionalLight<Lanes>(directionalLight, viewPos, 0.1f, fragments);
+        break;
+    case POINT:
+        shadePointLight<Lanes>(pointLight, viewPos, 0.1f, fragments);
+        break;
+    case SPOT:
+        shadeSpotLight<Lanes>(spotLight, viewPos, 0.1f, fragments);
+        break;
+    case MATERIAL_PHONG:
+        shadeMaterialPhong<Lanes>(phongMaterial, phongLight, lightPos, viewPos, fragments);
+        break;
+    }
+}
+
+// Best of REPEATS, in fragments per second
+template<class Lanes>
+double measure(Kernel kernel, FragmentData& data, ThreadPool* pool) {
+    const int chunkSize = 16384;
+    double best = 1e30;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (pool) {
+            pool->parallelFor(FRAGMENTS / chunkSize, [&](int chunk) {
+                shade<Lanes>(kernel, data.view(chunk * chunkSize, chunkSize));
+            });
+        }
+        else {
+            shade<Lanes>(kernel, data.view(0, FRAGMENTS));
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return FRAGMENTS / best;
+}
+
+template<class Lanes>
+void run(const char* label, Kernel kernel, FragmentData& data, const std::vector<float> reference[3], double scalarRate) {
+    for (int c = 0; c < 3; c++) {
+        std::fill(data.color[c].begin(), data.color[c].end(), 0.0f);
+    }
+    double rate = measure<Lanes>(kernel, data, NULL);
+
+    // compared as bits, the random normals include some the GLSL would turn into NaN too
+    long long mismatches = 0;
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < FRAGMENTS; i++) {
+            mismatches += memcmp(&data.color[c][i], &reference[c][i], sizeof(float)) != 0;
+        }
+    }
+
+    if (mismatches) {
+        printf("  %-14s %-8s %9.1f Mfrag/s   %5.2fx   %lld components differ from scalar\n", kernelNames[kernel], label, rate / 1e6, rate / scalarRate, mismatches);
+    }
+    else {
+        printf("  %-14s %-8s %9.1f Mfrag/s   %5.2fx   bit exact\n", kernelNames[kernel], label, rate / 1e6, rate / scalarRate);
+    }
+}
+
+int main()
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-5.0f, 5.0f), direction(-1.0f, 1.0f), color(0.0f, 1.0f);
+
+    FragmentData data;
+    for (int i = 0; i < 15; i++) {
+        data.inputs[i].resize(FRAGMENTS);
+    }
+    for (int c = 0; c < 3; c++) {
+        data.color[c].resize(FRAGMENTS);
+    }
+    for (int i = 0; i < FRAGMENTS; i++) {
+        for (int c = 0; c < 3; c++) {
+            data.inputs[c][i] = position(random);
+            data.inputs[3 + c][i] = direction(random);
+            data.inputs[6 + c][i] = color(random);
+            data.inputs[9 + c][i] = color(random);
+            data.inputs[12 + c][i] = color(random);
+        }
+    }
+
+    printf("%d fragments, best of %d\n", FRAGMENTS, REPEATS);
+    printf("single core:\n");
+    std::vector<float> reference[4][3];
+    double scalarRates[4];
+    for (int kernel = DIRECTIONAL; kernel <= MATERIAL_PHONG; kernel++) {
+        scalarRates[kernel] = measure<Lanes1>((Kernel)kernel, data, NULL);
+        for (int c = 0; c < 3; c++) {
+            reference[kernel][c] = data.color[c];
+        }
+        printf("  %-14s %-8s %9.1f Mfrag/s   %5.2fx   reference\n", kernelNames[kernel], "scalar", scalarRates[kernel] / 1e6, 1.0);
+#if defined(SIMD_SSE2)
+        run<Lanes4>("sse2", (Kernel)kernel, data, reference[kernel], scalarRates[kernel]);
+#endif
+#if defined(SIMD_AVX2)
+        run<Lanes8>("avx2", (Kernel)kernel, data, reference[kernel], scalarRates[kernel]);
+#endif
+    }
+
+    ThreadPool pool;
+    printf("%d threads, %d wide:\n", pool.size(), LightingLanes::width);
+    for (int kernel = DIRECTIONAL; kernel <= MATERIAL_PHONG; kernel++) {
+        double rate = measure<LightingLanes>((Kernel)kernel, data, &pool);
+        printf("  %-14s %9.1f Mfrag/s   %9.1f Mfrag/s/core\n", kernelNames[kernel], rate / 1e6, rate / pool.size() / 1e6);
+    }
+
+    return 0;
+}
@@ -5,6 +5,9 @@
 #include <iostream>
 #include "Shader.h"
 #include "Camera.h"
+#include "MeshBuilder.h"
+#include "VertexPacking.h"
+#include "TextureLoader.h"
 #include "stb_image.h"
 
 #include <glm/glm.hpp>
@@ -15,7 +18,6 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void mouseCallback(GLFWwindow* window, double xpos, double ypos);
-unsigned int loadImage(char const* path);
 
 float vertices[] = {
     // positions          // normals           // texture coords
@@ -101,6 +103,13 @@ int main()
         return -1;
     }
 
+    // the maps decode on the workers while the shaders compile
+    ThreadPool pool;
+    TextureLoader textures(pool);
+    unsigned int diffuseMap = textures.load("resources/container2.png");
+    unsigned int specularMap = textures.load("resources/gator.png");
+    unsigned int emissionMap = textures.load("resources/7a9.jpg");
+
 
     // Instantiate shader programs
 
@@ -109,10 +118,8 @@ int main()
     
     
 
-    // load maps
-    unsigned int diffuseMap = loadImage("resources/container2.png");
-    unsigned int specularMap = loadImage("resources/gator.png");
-    unsigned int emissionMap = loadImage("resources/7a9.jpg");
+    // upload the maps, only waits if a decode is still running
+    textures.finish();
 
     shader.use();
     shader.setInt("material.diffuse", 0);
@@ -134,30 +141,29 @@ int main()
 
     glBindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0); // position
-    glEnableVertexAttribArray(0);
+    // the cube's 36 vertices weld down to 24 unique ones plus an index buffer
+    MeshBuilder cube(8);
+    cube.addTriangles(vertices, 36);
+    cube.optimize();
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float))); // normal vectors
-    glEnableVertexAttribArray(1);
+    // 16 byte vertices instead of 32, see VertexPacking.h
+    PackedMesh packedCube(cube.getVertices().data(), cube.vertexCount());
 
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float))); // texture uv coord
-    glEnableVertexAttribArray(2);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    packedCube.upload();
+    cube.uploadIndices();
+    PackedMesh::setAttributes(); // position, octahedral normal, texture uv coord
 
     //Creating LightVAO
     unsigned int lightVAO;
     glGenVertexArrays(1, &lightVAO);
     glBindVertexArray(lightVAO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    // we only need to bind to the VBO, the container's VBO's data already contains the data.
+    // we only need to bind to the VBO and EBO, the container's buffers already contain the data.
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     // set the vertex attribute 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0); // just position
-    glEnableVertexAttribArray(0);
+    PackedMesh::setAttributes(false); // just position
 
     //model matrix
     glm::mat4 model = glm::mat4(1.0f);
@@ -167,6 +173,7 @@ int main()
     glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
     lightModel = glm::translate(lightModel, lightPos);
     lightModel = glm::scale(lightModel, glm::vec3(0.2f));
+    lightModel = lightModel * packedCube.positionTransform();
     //view matrix
     glm::mat4 view = glm::mat4(1.0f);
 
@@ -219,7 +226,16 @@ int main()
         view = camera.generateView();
 
         shader.use();
-        shader.setMat4("model", model);
+        // lightingMapVert.glsl reads the model and normal matrices as (instance) attributes, with the arrays
+        // disabled every vertex sees these constant values instead
+        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+        glm::mat4 packedModel = model * packedCube.positionTransform();
+        for (int i = 0; i < 4; i++) {
+            glVertexAttrib4fv(3 + i, glm::value_ptr(packedModel[i]));
+        }
+        for (int i = 0; i < 3; i++) {
+            glVertexAttrib3fv(7 + i, glm::value_ptr(normalMatrix[i]));
+        }
         shader.setMat4("view", view);
         shader.setMat4("projection", projection);
         shader.setVec3("objectColor", glm::vec3(1.0f, 0.5f, 0.31f));
@@ -237,7 +253,7 @@ int main()
         shader.setVec3("light.specular", lightSpecular);
 
         glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glDrawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0);
 
 
         lightShader.use();
@@ -246,7 +262,7 @@ int main()
         lightShader.setMat4("projection", projection);
 
         glBindVertexArray(lightVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glDrawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -321,40 +337,3 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         glfwSetWindowShouldClose(window, true);
     }
 }
-
-unsigned int loadImage(char const* path)
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
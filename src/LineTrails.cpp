@@ -3,10 +3,18 @@
 #include <glad/glad.h> 
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <string>
 #include <vector>
-#include <thread>
 #include <chrono>
 #include "Shader.h"
+#include "ShaderLibrary.h"
+#include "GLExtensions.h"
+#include "Profiler.h"
+#include "FramePacer.h"
+#include "ThreadPool.h"
+#include "TrailParticles.h"
+#include "TrailSimulation.h"
+#include "ResizableTarget.h"
 
 int view_width = 800;
 int view_height = 600;
@@ -15,16 +23,71 @@ float aspect = (float)view_width / (float)view_height;
 float speed = 1;
 float uOpacity = 0.1f;
 float uFloor = 0.1f;
+float trailLength = 0.1f; // radians between a line's ends
 
-unsigned int FBO;
-unsigned int texture;
+// every per frame bind goes through here, redundant ones never reach the driver
+GLStateCache glState;
+
+// the trails accumulate here, resizes only reallocate it once they settle and outgrow its bucket
+ResizableTarget trailTarget;
 
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
-int main()
+//   LineTrails                  interactive, paced to 140 fps
+//   LineTrails --trace [file]   profiled, Chrome trace written on exit (LineTrails.json)
+//   LineTrails --fps N          paced to N fps
+//   LineTrails --uncapped       as fast as it renders, for benchmarking
+//   LineTrails --sleep          the old fixed sleep after every frame, to compare pacing against
+//   LineTrails --frames N       exits after N frames
+//   LineTrails --lines N        draws N lines instead of 10
+//   LineTrails --compute        simulates the lines as particles in a compute shader (GL 4.3), nothing per frame on the CPU
+//   LineTrails --exact-resize   reallocates the trail texture on every resize event, the old way, to compare against
+// Frame time stats are printed on exit.
+int main(int argc, char** argv)
 {
+    bool trace = false;
+    const char* tracePath = "LineTrails.json";
+    double fps = 140.0;
+    FramePacer::Mode pacing = FramePacer::Paced;
+    long long frameLimit = 0;
+    int lineCount = 10;
+    bool compute = false;
+    ResizableTarget::Policy resizePolicy = ResizableTarget::Bucketed;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--trace") {
+            trace = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                tracePath = argv[++i];
+            }
+        }
+        else if (arg == "--fps" && i + 1 < argc) {
+            fps = atof(argv[++i]);
+        }
+        else if (arg == "--uncapped") {
+            pacing = FramePacer::Uncapped;
+        }
+        else if (arg == "--sleep") {
+            pacing = FramePacer::FixedSleep;
+        }
+        else if (arg == "--frames" && i + 1 < argc) {
+            frameLimit = atoll(argv[++i]);
+        }
+        else if (arg == "--lines" && i + 1 < argc) {
+            lineCount = std::max(atoi(argv[++i]), 0);
+        }
+        else if (arg == "--compute") {
+            compute = true;
+        }
+        else if (arg == "--exact-resize") {
+            resizePolicy = ResizableTarget::Exact;
+        }
+    }
+    Profiler::setEnabled(trace);
+    Profiler::setThreadName("GL thread");
+
     /*
     * Instantiating GLFW Window
     * Initialize GLFW
@@ -60,70 +123,49 @@ int main()
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
-
-    Shader lineShader("shaders/lineTrailVert.glsl", "shaders/lineTrailFrag.glsl");
-    int timeUniformLocation = glGetUniformLocation(lineShader.ID, "u_time");
-    int aspectUniformLocation = glGetUniformLocation(lineShader.ID, "u_aspect_ratio");
-
-    Shader clearShader("shaders/vertex2d.glsl", "shaders/fade.frag");
-    int opacityUniformLocation = glGetUniformLocation(clearShader.ID, "u_opacity");
-
-    Shader quadShader("shaders/texVert.glsl", "shaders/texFragFloor.glsl");
-    int textureUniformLocation = glGetUniformLocation(quadShader.ID, "u_Texture");
-    int floorUniformLocation = glGetUniformLocation(quadShader.ID, "u_floor");
-
-    // setup array for storing line vertices
-    // array format: x, y, r, offset
-    int lineCount = 10;
-    float minOffset = 0;
-    float maxOffset = glm::pi<float>();
-    float minR = 0.1, maxR = 1;
-    std::vector<float> lines(lineCount * 4 * 2);
-    for (int i = 0; i < lineCount; i++) {
-        float x = (((float)rand() / (float)RAND_MAX)) - 0.5f;
-        float y = (((float)rand() / (float)RAND_MAX)) - 0.5f;
-        float radius = (((float) rand() / (float)RAND_MAX) * (float)(maxR - minR)) + minR;
-        float offset = (((float)rand() / (float)RAND_MAX) * (float)(maxOffset - minOffset)) + minOffset;
-
-        int index = i * 8;
-
-        lines[index] = x;
-        lines[index + 1] = y;
-        lines[index + 2] = radius;
-        lines[index + 3] = offset;
-
-        lines[index + 4] = x;
-        lines[index + 5] = y;
-        lines[index + 6] = radius;
-        lines[index + 7] = offset + 0.1 * speed;
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+
+    // Startup timing, warm runs load all three programs from the binary cache
+    auto shaderStart = std::chrono::high_resolution_clock::now();
+
+    // Queue every program up front, the GLSL files are read in the background while the buffers are set up
+    ShaderLibrary shaders;
+    int lineProgram = shaders.add("shaders/lineTrailVert.glsl", "shaders/lineTrailFrag.glsl");
+    int clearProgram = shaders.add("shaders/vertex2d.glsl", "shaders/fade.frag");
+    int quadProgram = shaders.add("shaders/texVertRegion.glsl", "shaders/texFragFloor.glsl");
+
+    // Orbiting lines, either generated in parallel straight into their arrays or spawned on the GPU
+    auto linesStart = std::chrono::high_resolution_clock::now();
+    ThreadPool pool;
+    TrailParticles trails;
+    TrailSimulation simulation;
+    if (compute && simulation.create(lineCount)) {
+        simulation.aspect = aspect;
+        simulation.trailTime = trailLength;
+        glFinish();
+        auto linesEnd = std::chrono::high_resolution_clock::now();
+        printf("startup: %d particles spawned on the GPU in %.3f ms, %.1f MB\n", simulation.count(),
+            std::chrono::duration<double, std::milli>(linesEnd - linesStart).count(), simulation.bytes() / 1048576.0);
     }
-
-    for (int i = 0; i < lines.size(); i+=4) {
-        printf("%1.3f, %1.3f, %1.3f, %1.3f\n", lines[i], lines[i + 1], lines[i + 2], lines[i + 3]);
+    else {
+        compute = false;
+        trails.generate(lineCount, 1, &pool);
+        auto linesEnd = std::chrono::high_resolution_clock::now();
+        printf("startup: %d lines generated in %.3f ms on %d threads, %.1f MB\n", trails.count(),
+            std::chrono::duration<double, std::milli>(linesEnd - linesStart).count(), pool.size(), trails.bytes() / 1048576.0);
     }
 
-
-
     unsigned int lineVBO;
     glGenBuffers(1, &lineVBO);
     glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-    glBufferData(GL_ARRAY_BUFFER, lineCount * 8 * sizeof(float), &lines[0], GL_STATIC_DRAW);
+    trails.upload();
 
     unsigned int lineVAO;
     glGenVertexArrays(1, &lineVAO);
     glBindVertexArray(lineVAO);
-    
-    // position attribute
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // radius attribute
-    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-    glEnableVertexAttribArray(1);
 
-    // offset attribute
-    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // centre, radius and offset attributes, one set per line
+    trails.setAttributes();
 
     // Clear quad
     float clear[] = {
@@ -166,25 +208,28 @@ int main()
     glEnableVertexAttribArray(1);
 
 
-    // Create FrameBuffer
-    glGenFramebuffers(1, &FBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    // FrameBuffer and its texture, sized in buckets
+    bool targetComplete = trailTarget.create(view_width, view_height, glState, resizePolicy);
 
-    // Setup FrameBuffer Texture
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    // Compile everything that has been read, then block on the programs in the order they are needed
+    shaders.submit();
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, view_width, view_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    Shader lineShader = shaders.get(lineProgram);
+    int timeUniformLocation = glGetUniformLocation(lineShader.ID, "u_time");
+    int aspectUniformLocation = glGetUniformLocation(lineShader.ID, "u_aspect_ratio");
+    int trailLengthUniformLocation = glGetUniformLocation(lineShader.ID, "u_trail_length");
 
+    Shader clearShader = shaders.get(clearProgram);
+    int opacityUniformLocation = glGetUniformLocation(clearShader.ID, "u_opacity");
 
-    //Configuring Texture wrapping
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    Shader quadShader = shaders.get(quadProgram);
+    int textureUniformLocation = glGetUniformLocation(quadShader.ID, "u_Texture");
+    int floorUniformLocation = glGetUniformLocation(quadShader.ID, "u_floor");
+    int regionUniformLocation = glGetUniformLocation(quadShader.ID, "u_region");
 
-    //Configure Texture Filtering
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    auto shaderEnd = std::chrono::high_resolution_clock::now();
+    printf("startup: 3 shader programs ready after %.3f ms\n", std::chrono::duration<double, std::milli>(shaderEnd - shaderStart).count());
+    ShaderCache::report();
 
     //Wireframe rendering
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -194,11 +239,11 @@ int main()
     * Swap color buffer then polls for events like keyboard or mouse input
     */
 
-    glEnable(GL_BLEND);
+    glState.setEnabled(GL_BLEND, true);
 
     //glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); //Straight Opacity
     //glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA); //Premult opacity
-    glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+    glState.blendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
     glBlendColor(0.0, 0.0, 0.0, 0.0);
         
     //Sets clear color
@@ -210,6 +255,7 @@ int main()
     glClear(GL_COLOR_BUFFER_BIT);*/
     
     float time;
+    float lastTime = 0.0f;
 
     // ##### DEBUG
     //glClear(GL_COLOR_BUFFER_BIT);
@@ -230,13 +276,21 @@ int main()
 
     //glDrawArrays(GL_LINES, 0, lineCount);
     // ##### DEBUG
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    if (!targetComplete) {
         printf("Framebuffer not complete");
         std::cout << glGetError() << std::endl;
         glfwSetWindowShouldClose(window, true);
     }
 
 
+    // the pacer sets the frame rate, not vsync
+    glfwSwapInterval(0);
+    FramePacer pacer(fps > 0.0 ? 1000.0 / fps : 0.0, pacing);
+    long long frames = 0;
+
+    // only count the render loop's calls
+    glState.resetCounters();
+
     while (!glfwWindowShouldClose(window))
     {
         glClear(GL_COLOR_BUFFER_BIT);
@@ -245,39 +299,101 @@ int main()
             time -= glm::two_pi<float>() / speed;
             glfwSetTime(time);
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, FBO);
-        clearShader.use();
-        glUniform1f(opacityUniformLocation, uOpacity);
-        glBindBuffer(GL_ARRAY_BUFFER, clearVBO);
-        glBindVertexArray(clearVAO);
-
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-        lineShader.use();
-        glUniform1f(timeUniformLocation, time * speed);
-        glUniform1f(aspectUniformLocation, aspect);
-        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
-        glBindVertexArray(lineVAO);
+        // the VAOs captured their vertex buffers when the attributes were set up, no GL_ARRAY_BUFFER binds needed here
+        {
+            PROFILE_ZONE("resize");
+            trailTarget.update(glState);
+        }
+        trailTarget.bind(glState);
+        {
+            PROFILE_GPU_ZONE("fade");
+            clearShader.use(glState);
+            {
+                PROFILE_ZONE("uniforms");
+                glUniform1f(opacityUniformLocation, uOpacity);
+            }
+            glState.bindVertexArray(clearVAO);
+
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
 
-        glDrawArrays(GL_LINES, 0, lineCount * 2);
+        if (compute) {
+            // the time wraps every revolution, the step across the wrap is still one frame's worth
+            float dt = time - lastTime;
+            if (dt < 0.0f) {
+                dt += glm::two_pi<float>() / speed;
+            }
+            {
+                PROFILE_GPU_ZONE("simulate");
+                simulation.aspect = aspect;
+                simulation.simulate(dt * speed, glState);
+            }
+            {
+                PROFILE_GPU_ZONE("lines");
+                simulation.draw(glState);
+            }
+        }
+        else {
+            PROFILE_GPU_ZONE("lines");
+            lineShader.use(glState);
+            {
+                PROFILE_ZONE("uniforms");
+                glUniform1f(timeUniformLocation, time * speed);
+                glUniform1f(aspectUniformLocation, aspect);
+                glUniform1f(trailLengthUniformLocation, trailLength);
+            }
+            glState.bindVertexArray(lineVAO);
+
+            glDrawArraysInstanced(GL_LINES, 0, 2, trails.count());
+        }
+        lastTime = time;
 
         //std::cout << glGetError() << std::endl;
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        quadShader.use();
-        glUniform1f(floorUniformLocation, uFloor);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-        glBindVertexArray(quadVAO);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000 / 140));
+        glState.bindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, view_width, view_height);
+        {
+            PROFILE_GPU_ZONE("threshold");
+            quadShader.use(glState);
+            {
+                PROFILE_ZONE("uniforms");
+                glUniform1f(floorUniformLocation, uFloor);
+                glm::vec2 region = trailTarget.region();
+                glUniform2f(regionUniformLocation, region.x, region.y);
+            }
+            glState.bindTexture(0, GL_TEXTURE_2D, trailTarget.texture());
+            glState.bindVertexArray(quadVAO);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+
+        {
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
+        glState.endFrame();
+        Profiler::endFrame();
+        {
+            PROFILE_ZONE("pace");
+            pacer.wait();
+        }
+        if (frameLimit > 0 && ++frames >= frameLimit) {
+            glfwSetWindowShouldClose(window, true);
+        }
+    }
+    glState.report();
+    pacer.report();
+    trailTarget.report();
+    Profiler::release();
+    if (trace) {
+        Profiler::report();
+        Profiler::exportTrace(tracePath);
     }
     lineShader.free();
     clearShader.free();
-    glDeleteFramebuffers(1, &FBO);
+    quadShader.free();
+    simulation.release();
+    trailTarget.release();
     glDeleteVertexArrays(1, &lineVAO);
     glDeleteVertexArrays(1, &clearVAO);
     glDeleteBuffers(1, &lineVBO);
@@ -294,14 +410,14 @@ int main()
 */
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
+    if (width <= 0 || height <= 0) {
+        return; // minimised
+    }
     view_width = width;
     view_height = height;
-    glViewport(0, 0, width, height);
     aspect = (float)width / (float)height;
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
-
+    // just the new size, the render loop reallocates if and when it needs to
+    trailTarget.resize(width, height);
 }
 
 /*
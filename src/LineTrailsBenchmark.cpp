@@ -0,0 +1,244 @@
+// LineTrails with 10 up to 10 million lines: how long generating them takes the old way (rand() into interleaved
+// floats, both ends of every line) against TrailParticles on one thread and on the pool, and how long a frame of
+// LineTrails' three passes (fade, lines, threshold) at 800x600 takes drawing the old per vertex buffer against one
+// instanced draw from the structure of arrays buffer. Lines at 60 Hz is how many lines fit in a 16.7 ms frame at the
+// measured rate. Runs headless, no window or GPU needed.
+//
+//   LineTrailsBenchmark [maxLines]      (default 10000000)
+
+#include <glad/glad.h>
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include "HeadlessContext.h"
+#include "Shader.h"
+#include "GLExtensions.h"
+#include "ThreadPool.h"
+#include "TrailParticles.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+const int SCREEN_WIDTH = 800, SCREEN_HEIGHT = 600;
+const double FRAME_BUDGET_MS = 1000.0 / 60.0;
+const float TRAIL_LENGTH = 0.1f;
+
+// LineTrails' original setup, x, y, radius, offset for both ends of every line
+std::vector<float> randLines(int lineCount)
+{
+    srand(1);
+    float minOffset = 0;
+    float maxOffset = glm::pi<float>();
+    float minR = 0.1f, maxR = 1;
+    std::vector<float> lines((size_t)lineCount * 4 * 2);
+    for (int i = 0; i < lineCount; i++) {
+        float x = (((float)rand() / (float)RAND_MAX)) - 0.5f;
+        float y = (((float)rand() / (float)RAND_MAX)) - 0.5f;
+        float radius = (((float)rand() / (float)RAND_MAX) * (float)(maxR - minR)) + minR;
+        float offset = (((float)rand() / (float)RAND_MAX) * (float)(maxOffset - minOffset)) + minOffset;
+
+        size_t index = (size_t)i * 8;
+        lines[index] = x;
+        lines[index + 1] = y;
+        lines[index + 2] = radius;
+        lines[index + 3] = offset;
+
+        lines[index + 4] = x;
+        lines[index + 5] = y;
+        lines[index + 6] = radius;
+        lines[index + 7] = offset + TRAIL_LENGTH;
+    }
+    return lines;
+}
+
+template<class Function>
+double timeMs(Function func)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Averages at least 5 frames and half a second, after 2 warm up frames
+template<class Render>
+double timeFrames(Render render)
+{
+    double totalMs = 0.0;
+    int frames = 0;
+    for (int frame = -2; frame < 5 || totalMs < 500.0; frame++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        render(frame / 60.0f);
+        glFinish();
+        auto end = std::chrono::high_resolution_clock::now();
+        if (frame >= 0) {
+            totalMs += std::chrono::duration<double, std::milli>(end - start).count();
+            frames++;
+        }
+    }
+    return totalMs / frames;
+}
+
+int main(int argc, char** argv)
+{
+    int maxLines = argc > 1 ? atoi(argv[1]) : 10000000;
+
+    HeadlessContext context;
+    if (!context.create(4, 5) || !gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    loadGLExtensions((GLADloadproc)HeadlessContext::getProcAddress);
+    printf("%s, %dx%d\n", (const char*)glGetString(GL_RENDERER), SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    Shader lineShader("shaders/lineTrailVert.glsl", "shaders/lineTrailFrag.glsl");
+    Shader clearShader("shaders/vertex2d.glsl", "shaders/fade.frag");
+    Shader quadShader("shaders/texVert.glsl", "shaders/texFragFloor.glsl");
+
+    float clear[] = { -1, -1, -1, 1, 1, -1, 1, 1 };
+    unsigned int clearVAO, clearVBO;
+    glGenVertexArrays(1, &clearVAO);
+    glBindVertexArray(clearVAO);
+    glGenBuffers(1, &clearVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, clearVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(clear), clear, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+    glEnableVertexAttribArray(0);
+
+    float quad[] = { -1, -1, 0, 0, -1, 1, 0, 1, 1, -1, 1, 0, 1, 1, 1, 1 };
+    unsigned int quadVAO, quadVBO;
+    glGenVertexArrays(1, &quadVAO);
+    glBindVertexArray(quadVAO);
+    glGenBuffers(1, &quadVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    // the trails accumulate in a texture that is thresholded into a renderbuffer standing in for the window
+    unsigned int trailFBO, trailTexture, screenFBO, screenColor;
+    glGenTextures(1, &trailTexture);
+    glBindTexture(GL_TEXTURE_2D, trailTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenFramebuffers(1, &trailFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, trailFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, trailTexture, 0);
+    glGenRenderbuffers(1, &screenColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, screenColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glGenFramebuffers(1, &screenFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, screenFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, screenColor);
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    lineShader.use();
+    lineShader.setFloat("u_aspect_ratio", (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT);
+    clearShader.use();
+    clearShader.setFloat("u_opacity", 0.1f);
+    quadShader.use();
+    quadShader.setFloat("u_floor", 0.1f);
+    quadShader.setInt("u_Texture", 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, trailTexture);
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // One LineTrails frame, drawLines issues the lines pass
+    auto frame = [&](float time, auto drawLines) {
+        glBindFramebuffer(GL_FRAMEBUFFER, trailFBO);
+        clearShader.use();
+        glBindVertexArray(clearVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        lineShader.use();
+        lineShader.setFloat("u_time", time);
+        drawLines();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, screenFBO);
+        glClear(GL_COLOR_BUFFER_BIT);
+        quadShader.use();
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    };
+
+    ThreadPool pool;
+    printf("generating: rand() into interleaved ends, TrailParticles on 1 and %d threads\n", pool.size());
+    printf("frame: fade + lines + threshold, per vertex buffer (32 B/line) against instanced SoA (16 B/line)\n\n");
+    printf("%10s %10s %10s %10s %11s %11s %11s %14s %6s\n",
+        "lines", "rand ms", "1 thread", "pool", "vertex ms", "SoA ms", "Mlines/s", "lines @ 60 Hz", "60 Hz");
+
+    for (long long count = 10; count <= maxLines; count *= 10) {
+        int lineCount = (int)count;
+        std::vector<float> lines;
+        TrailParticles trails, serial;
+        double randMs = timeMs([&] { lines = randLines(lineCount); });
+        // each timing fills its own empty arrays, so both pay the allocation and first touch of their pages
+        double serialMs = timeMs([&] { serial.generate(lineCount, 1, NULL); });
+        double parallelMs = timeMs([&] { trails.generate(lineCount, 1, &pool); });
+        serial = TrailParticles();
+
+        unsigned int buffers[2], arrays[2];
+        glGenBuffers(2, buffers);
+        glGenVertexArrays(2, arrays);
+
+        glBindVertexArray(arrays[0]);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+        glBufferData(GL_ARRAY_BUFFER, lines.size() * sizeof(float), lines.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        lines = std::vector<float>();
+
+        glBindVertexArray(arrays[1]);
+        glBindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+        trails.upload();
+        trails.setAttributes();
+
+        // the per vertex buffer has the tail's offset baked in, so no trail length from gl_VertexID
+        double vertexMs = timeFrames([&](float time) {
+            frame(time, [&] {
+                lineShader.setFloat("u_trail_length", 0.0f);
+                glBindVertexArray(arrays[0]);
+                glDrawArrays(GL_LINES, 0, lineCount * 2);
+            });
+        });
+        double instancedMs = timeFrames([&](float time) {
+            frame(time, [&] {
+                lineShader.setFloat("u_trail_length", TRAIL_LENGTH);
+                glBindVertexArray(arrays[1]);
+                glDrawArraysInstanced(GL_LINES, 0, 2, lineCount);
+            });
+        });
+
+        double linesPerSecond = lineCount / (instancedMs / 1000.0);
+        printf("%10d %10.3f %10.3f %10.3f %11.3f %11.3f %11.2f %14.0f %6s\n", lineCount, randMs, serialMs, parallelMs,
+            vertexMs, instancedMs, linesPerSecond / 1e6, linesPerSecond * FRAME_BUDGET_MS / 1000.0,
+            instancedMs <= FRAME_BUDGET_MS ? "yes" : "no");
+
+        glDeleteVertexArrays(2, arrays);
+        glDeleteBuffers(2, buffers);
+    }
+
+    lineShader.free();
+    clearShader.free();
+    quadShader.free();
+    glDeleteVertexArrays(1, &clearVAO);
+    glDeleteVertexArrays(1, &quadVAO);
+    glDeleteBuffers(1, &clearVBO);
+    glDeleteBuffers(1, &quadVBO);
+    glDeleteFramebuffers(1, &trailFBO);
+    glDeleteFramebuffers(1, &screenFBO);
+    glDeleteTextures(1, &trailTexture);
+    glDeleteRenderbuffers(1, &screenColor);
+    context.release();
+    return 0;
+}
@@ -0,0 +1,248 @@
+// LineTrails on the CPU with SoftwareLineTrails. Times the three passes per frame from 10 lines up to maxLines on
+// one thread and on the pool, then plays the same lines for a few seconds of frames both on the CPU and through GL
+// (headless) and compares the two screens pixel by pixel. The fade and threshold are exact in 8 bit, so the pixels
+// that differ are where the two rasterizers put a line's pixels differently (float rounding of the line ends, the
+// GPU's sin/cos, GL's diamond exit rule at the ends) and the trail those pixels leave.
+//
+//   LineTrailsReference [maxLines] [verifyLines] [--antialias]   (defaults 1000000, 10000)
+//   writes LineTrailsCPU.ppm and LineTrailsGL.ppm
+
+#include <glad/glad.h>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include "HeadlessContext.h"
+#include "Shader.h"
+#include "GLExtensions.h"
+#include "ThreadPool.h"
+#include "TrailParticles.h"
+#include "SoftwareLineTrails.h"
+
+const int SCREEN_WIDTH = 800, SCREEN_HEIGHT = 600;
+const float TIMESTEP = 1.0f / 60.0f;
+const int VERIFY_FRAMES = 180;
+
+// Per pass ms, averaged over at least 5 frames and half a second after 2 warm up frames
+SoftwareLineTrailsStats timeFrames(SoftwareLineTrails& effect, const TrailParticles& trails)
+{
+    effect.clear();
+    for (int frame = -2; frame < 0; frame++) {
+        effect.frame(trails, frame * TIMESTEP);
+    }
+    SoftwareLineTrailsStats total = {};
+    int frames = 0;
+    for (double elapsed = 0.0; frames < 5 || elapsed < 500.0; frames++) {
+        SoftwareLineTrailsStats before = effect.getStats();
+        effect.frame(trails, frames * TIMESTEP);
+        const SoftwareLineTrailsStats& after = effect.getStats();
+        total.fadeMs += after.fadeMs - before.fadeMs;
+        total.linesMs += after.linesMs - before.linesMs;
+        total.thresholdMs += after.thresholdMs - before.thresholdMs;
+        total.linePixels += after.linePixels - before.linePixels;
+        elapsed = total.fadeMs + total.linesMs + total.thresholdMs;
+    }
+    total.frames = frames;
+    total.fadeMs /= frames;
+    total.linesMs /= frames;
+    total.thresholdMs /= frames;
+    total.linePixels /= frames;
+    return total;
+}
+
+// LineTrails' GL passes into offscreen buffers, drawn with the instanced TrailParticles buffer
+class GLLineTrails {
+
+public:
+    explicit GLLineTrails(const TrailParticles& trails)
+        : lineShader("shaders/lineTrailVert.glsl", "shaders/lineTrailFrag.glsl"),
+          clearShader("shaders/vertex2d.glsl", "shaders/fade.frag"),
+          quadShader("shaders/texVert.glsl", "shaders/texFragFloor.glsl"),
+          lineCount(trails.count()) {
+        glGenVertexArrays(1, &lineVAO);
+        glBindVertexArray(lineVAO);
+        glGenBuffers(1, &lineVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+        trails.upload();
+        trails.setAttributes();
+
+        float clear[] = { -1, -1, -1, 1, 1, -1, 1, 1 };
+        glGenVertexArrays(1, &clearVAO);
+        glBindVertexArray(clearVAO);
+        glGenBuffers(1, &clearVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, clearVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(clear), clear, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+        glEnableVertexAttribArray(0);
+
+        float quad[] = { -1, -1, 0, 0, -1, 1, 0, 1, 1, -1, 1, 0, 1, 1, 1, 1 };
+        glGenVertexArrays(1, &quadVAO);
+        glBindVertexArray(quadVAO);
+        glGenBuffers(1, &quadVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        glGenTextures(1, &trailTexture);
+        glBindTexture(GL_TEXTURE_2D, trailTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glGenFramebuffers(1, &trailFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, trailFBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, trailTexture, 0);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        glGenRenderbuffers(1, &screenColor);
+        glBindRenderbuffer(GL_RENDERBUFFER, screenColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SCREEN_WIDTH, SCREEN_HEIGHT);
+        glGenFramebuffers(1, &screenFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, screenFBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, screenColor);
+        glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+
+    ~GLLineTrails() {
+        lineShader.free();
+        clearShader.free();
+        quadShader.free();
+        glDeleteVertexArrays(1, &lineVAO);
+        glDeleteVertexArrays(1, &clearVAO);
+        glDeleteVertexArrays(1, &quadVAO);
+        glDeleteBuffers(1, &lineVBO);
+        glDeleteBuffers(1, &clearVBO);
+        glDeleteBuffers(1, &quadVBO);
+        glDeleteFramebuffers(1, &trailFBO);
+        glDeleteFramebuffers(1, &screenFBO);
+        glDeleteTextures(1, &trailTexture);
+        glDeleteRenderbuffers(1, &screenColor);
+    }
+
+    void frame(const SoftwareLineTrails& settings, float time) {
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, trailFBO);
+        clearShader.use();
+        clearShader.setFloat("u_opacity", settings.opacity);
+        glBindVertexArray(clearVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        lineShader.use();
+        lineShader.setFloat("u_time", time);
+        lineShader.setFloat("u_aspect_ratio", settings.aspect);
+        lineShader.setFloat("u_trail_length", settings.trailLength);
+        glBindVertexArray(lineVAO);
+        glDrawArraysInstanced(GL_LINES, 0, 2, lineCount);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, screenFBO);
+        glClear(GL_COLOR_BUFFER_BIT);
+        quadShader.use();
+        quadShader.setFloat("u_floor", settings.floor);
+        quadShader.setInt("u_Texture", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, trailTexture);
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    void readScreen(SoftwareFramebuffer& target) {
+        glBindFramebuffer(GL_FRAMEBUFFER, screenFBO);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, target.color.data());
+    }
+
+private:
+    Shader lineShader, clearShader, quadShader;
+    int lineCount;
+    unsigned int lineVAO = 0, lineVBO = 0, clearVAO = 0, clearVBO = 0, quadVAO = 0, quadVBO = 0;
+    unsigned int trailFBO = 0, trailTexture = 0, screenFBO = 0, screenColor = 0;
+};
+
+int main(int argc, char** argv)
+{
+    int maxLines = 1000000, verifyLines = 10000;
+    bool antialias = false;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--antialias") {
+            antialias = true;
+        }
+        else if (positional++ == 0) {
+            maxLines = atoi(argv[i]);
+        }
+        else {
+            verifyLines = atoi(argv[i]);
+        }
+    }
+
+    ThreadPool single(0), pool;
+    printf("CPU line trails at %dx%d, %s lines, per frame ms on 1 and %d threads\n\n", SCREEN_WIDTH, SCREEN_HEIGHT,
+        antialias ? "antialiased" : "aliased", pool.size());
+    printf("%10s %12s | %9s %9s %9s %9s | %9s %9s %9s %9s %8s\n", "lines", "pixels", "fade", "lines", "threshold", "frame",
+        "fade", "lines", "threshold", "frame", "speedup");
+    for (long long count = 10; count <= maxLines; count *= 10) {
+        TrailParticles trails;
+        trails.generate((int)count, 1, &pool);
+        SoftwareLineTrails serialEffect(SCREEN_WIDTH, SCREEN_HEIGHT, single), parallelEffect(SCREEN_WIDTH, SCREEN_HEIGHT, pool);
+        serialEffect.antialias = parallelEffect.antialias = antialias;
+        SoftwareLineTrailsStats serial = timeFrames(serialEffect, trails);
+        SoftwareLineTrailsStats parallel = timeFrames(parallelEffect, trails);
+        double serialMs = serial.fadeMs + serial.linesMs + serial.thresholdMs;
+        double parallelMs = parallel.fadeMs + parallel.linesMs + parallel.thresholdMs;
+        printf("%10lld %12lld | %9.3f %9.3f %9.3f %9.3f | %9.3f %9.3f %9.3f %9.3f %7.2fx\n", count, parallel.linePixels,
+            serial.fadeMs, serial.linesMs, serial.thresholdMs, serialMs,
+            parallel.fadeMs, parallel.linesMs, parallel.thresholdMs, parallelMs, serialMs / parallelMs);
+    }
+
+    HeadlessContext context;
+    if (!context.create(4, 5) || !gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    loadGLExtensions((GLADloadproc)HeadlessContext::getProcAddress);
+
+    TrailParticles trails;
+    trails.generate(verifyLines, 1, &pool);
+    SoftwareLineTrails effect(SCREEN_WIDTH, SCREEN_HEIGHT, pool);
+    effect.antialias = antialias;
+    SoftwareFramebuffer gpuScreen(SCREEN_WIDTH, SCREEN_HEIGHT);
+    {
+        GLLineTrails gl(trails);
+        for (int frame = 0; frame < VERIFY_FRAMES; frame++) {
+            effect.frame(trails, frame * TIMESTEP);
+            gl.frame(effect, frame * TIMESTEP);
+        }
+        gl.readScreen(gpuScreen);
+    }
+
+    // differing pixels, and how many of them are lit on only one side
+    long long differing = 0, onlyOne = 0, lit = 0;
+    int maxDifference = 0;
+    for (size_t i = 0; i < gpuScreen.color.size(); i++) {
+        uint32_t cpu = effect.screen.color[i], gpu = gpuScreen.color[i];
+        lit += (cpu & 0xffffff) != 0;
+        if (cpu == gpu) {
+            continue;
+        }
+        differing++;
+        onlyOne += ((cpu & 0xffffff) == 0) != ((gpu & 0xffffff) == 0);
+        for (int shift = 0; shift < 32; shift += 8) {
+            maxDifference = std::max(maxDifference, std::abs((int)((cpu >> shift) & 0xff) - (int)((gpu >> shift) & 0xff)));
+        }
+    }
+    printf("\n%s against the CPU, %d lines after %d frames: %lld pixels lit (%.2f%% of the screen), %lld differ (%.2f%% of the lit ones), "
+        "%lld lit on one side only, max channel difference %d\n", (const char*)glGetString(GL_RENDERER), verifyLines, VERIFY_FRAMES,
+        lit, 100.0 * lit / gpuScreen.color.size(), differing, 100.0 * differing / std::max(lit, 1ll), onlyOne, maxDifference);
+    effect.screen.savePPM("LineTrailsCPU.ppm");
+    gpuScreen.savePPM("LineTrailsGL.ppm");
+    effect.report();
+    context.release();
+    return 0;
+}
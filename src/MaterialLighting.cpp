@@ -7,6 +7,7 @@
 #include <iostream>
 #include "Shader.h"
 #include "Camera.h"
+#include "MeshBuilder.h"
 #include "stb_image.h"
 
 #include <glm/glm.hpp>
@@ -117,11 +118,14 @@ int main()
 
     glBindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    // the cube's 36 vertices weld down to 24 unique ones plus an index buffer
+    MeshBuilder cube(6);
+    cube.addTriangles(vertices, 36);
+    cube.optimize();
 
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    //glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    cube.upload();
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0); // position
     glEnableVertexAttribArray(0);
@@ -134,9 +138,9 @@ int main()
     unsigned int lightVAO;
     glGenVertexArrays(1, &lightVAO);
     glBindVertexArray(lightVAO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    // we only need to bind to the VBO, the container's VBO's data already contains the data.
+    // we only need to bind to the VBO and EBO, the container's buffers already contain the data.
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
     // set the vertex attribute 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0); // just position
     glEnableVertexAttribArray(0);
@@ -223,7 +227,7 @@ int main()
         shader.setVec3("light.specular", lightSpecular);
 
         glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glDrawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0);
 
 
         lightShader.use();
@@ -232,7 +236,7 @@ int main()
         lightShader.setMat4("projection", projection);
 
         glBindVertexArray(lightVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        glDrawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -0,0 +1,158 @@
+// Vertex reuse report for MeshBuilder. Every mesh starts as a glDrawArrays triangle list like the demos' cube,
+// then gets welded into an indexed mesh and reordered for the post transform cache.
+// Prints vertex shader invocations and ACMR for each step with a 16 and a 32 entry FIFO cache.
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "MeshBuilder.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+float cubeVertices[] = {
+    // positions          // normals           // texture coords
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+};
+
+// pos, normal, uv per vertex, same layout as the cube
+void pushVertex(std::vector<float>& soup, glm::vec3 position, glm::vec3 normal, glm::vec2 uv) {
+    soup.insert(soup.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z, uv.x, uv.y });
+}
+
+// Each grid cell becomes two triangles, vertex(u, v) gives position and normal
+template<class Surface>
+std::vector<float> gridSoup(int columns, int rows, Surface surface) {
+    std::vector<float> soup;
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            glm::vec2 corners[4] = {
+                glm::vec2(column, row), glm::vec2(column + 1, row), glm::vec2(column + 1, row + 1), glm::vec2(column, row + 1)
+            };
+            int order[6] = { 0, 1, 2, 2, 3, 0 };
+            for (int k : order) {
+                glm::vec2 uv = corners[k] / glm::vec2(columns, rows);
+                glm::vec3 position, normal;
+                surface(uv, position, normal);
+                pushVertex(soup, position, normal, uv);
+            }
+        }
+    }
+    return soup;
+}
+
+std::vector<float> planeSoup(int size) {
+    return gridSoup(size, size, [](glm::vec2 uv, glm::vec3& position, glm::vec3& normal) {
+        position = glm::vec3(uv.x, 0.0f, uv.y);
+        normal = glm::vec3(0.0f, 1.0f, 0.0f);
+    });
+}
+
+std::vector<float> sphereSoup(int slices, int stacks) {
+    return gridSoup(slices, stacks, [](glm::vec2 uv, glm::vec3& position, glm::vec3& normal) {
+        float phi = uv.x * glm::two_pi<float>(), theta = uv.y * glm::pi<float>();
+        normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+        position = normal;
+    });
+}
+
+std::vector<float> torusSoup(int slices, int rings) {
+    return gridSoup(slices, rings, [](glm::vec2 uv, glm::vec3& position, glm::vec3& normal) {
+        float phi = uv.x * glm::two_pi<float>(), theta = uv.y * glm::two_pi<float>();
+        glm::vec3 ring(std::cos(phi), 0.0f, std::sin(phi));
+        normal = ring * std::cos(theta) + glm::vec3(0.0f, std::sin(theta), 0.0f);
+        position = ring + 0.3f * normal;
+    });
+}
+
+// Triangle order of a mesh loaded from a file, nothing like the scanline order of the generators
+std::vector<float> shuffleTriangles(std::vector<float> soup) {
+    const int triangleFloats = 3 * 8;
+    int triangles = (int)soup.size() / triangleFloats;
+    std::mt19937 random(1234);
+    for (int t = triangles - 1; t > 0; t--) {
+        int other = std::uniform_int_distribution<int>(0, t)(random);
+        std::swap_ranges(soup.begin() + t * triangleFloats, soup.begin() + (t + 1) * triangleFloats, soup.begin() + other * triangleFloats);
+    }
+    return soup;
+}
+
+void printRow(const char* step, int vertices, int invocations16, int invocations32, int triangles, int indexBytes) {
+    printf("  %-16s %9d %12d %7.3f %12d %7.3f %12d\n", step, vertices, invocations16, (double)invocations16 / triangles,
+        invocations32, (double)invocations32 / triangles, indexBytes);
+}
+
+void report(const char* name, const std::vector<float>& soup) {
+    int soupVertices = (int)soup.size() / 8;
+    printf("%s, %d triangles\n", name, soupVertices / 3);
+    printf("  %-16s %9s %12s %7s %12s %7s %12s\n", "", "vertices", "VS runs/16", "ACMR", "VS runs/32", "ACMR", "index bytes");
+
+    // glDrawArrays shades every vertex
+    printRow("drawArrays", soupVertices, soupVertices, soupVertices, soupVertices / 3, 0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    MeshBuilder mesh(8);
+    mesh.addTriangles(soup.data(), soupVertices);
+    auto welded = std::chrono::high_resolution_clock::now();
+    printRow("welded", mesh.vertexCount(), mesh.vertexShaderInvocations(16), mesh.vertexShaderInvocations(32),
+        mesh.triangleCount(), mesh.indexCount() * mesh.indexSize());
+
+    auto optimizeStart = std::chrono::high_resolution_clock::now();
+    mesh.optimize();
+    auto optimized = std::chrono::high_resolution_clock::now();
+    printRow("forsyth", mesh.vertexCount(), mesh.vertexShaderInvocations(16), mesh.vertexShaderInvocations(32),
+        mesh.triangleCount(), mesh.indexCount() * mesh.indexSize());
+
+    printf("  weld %.2f ms, optimize %.2f ms\n\n", std::chrono::duration<double, std::milli>(welded - start).count(),
+        std::chrono::duration<double, std::milli>(optimized - optimizeStart).count());
+}
+
+int main()
+{
+    report("cube", std::vector<float>(cubeVertices, cubeVertices + sizeof(cubeVertices) / sizeof(float)));
+    report("plane 256x256", planeSoup(256));
+    report("sphere 128x64", sphereSoup(128, 64));
+    report("torus 512x256, shuffled", shuffleTriangles(torusSoup(512, 256)));
+    return 0;
+}
@@ -0,0 +1,174 @@
+// MipGenerator against glGenerateMipmap on the images in resources/, plus 2048x2048 RGB and RGBA images tiled from
+// gator.png since nothing in resources/ is 2K yet. Times the whole chain below level 0 (best of REPEATS) and shows what
+// filtering as stored costs: the linear light brightness of the 1x1 level against the average of level 0.
+// Build with SIMD_FORCE_SCALAR for the plain C++ numbers.
+//
+//   MipmapBenchmark [image ...]
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include "MipGenerator.h"
+#include "stb_image.h"
+
+const int REPEATS = 3;
+
+struct Image {
+    std::string name;
+    int width, height, components;
+    std::vector<unsigned char> pixels;
+};
+
+template <typename Function>
+double bestTime(Function function)
+{
+    double best = 1e30;
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+    return best;
+}
+
+// Average linear light value over the color channels
+double linearBrightness(const unsigned char* pixels, size_t texels, int components)
+{
+    int colors = std::min(components, 3);
+    double sum = 0.0;
+    for (size_t i = 0; i < texels; i++) {
+        for (int c = 0; c < colors; c++) {
+            double value = pixels[i * components + c] / 255.0;
+            sum += value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+        }
+    }
+    return sum / ((double)texels * colors);
+}
+
+Image tiled(const Image& source, int size, int components)
+{
+    Image image = { source.name + " tiled", size, size, components, std::vector<unsigned char>((size_t)size * size * components) };
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            const unsigned char* in = &source.pixels[((size_t)(y % source.height) * source.width + x % source.width) * source.components];
+            unsigned char* out = &image.pixels[((size_t)y * size + x) * components];
+            for (int c = 0; c < components; c++) {
+                out[c] = c < source.components ? in[c] : (unsigned char)(x * 255 / (size - 1)); // alpha ramp
+            }
+        }
+    }
+    return image;
+}
+
+int main(int argc, char** argv)
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 600, "Mipmap Benchmark", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        files.push_back(argv[i]);
+    }
+    if (files.empty()) {
+        for (const auto& entry : std::filesystem::directory_iterator("resources")) {
+            std::string extension = entry.path().extension().string();
+            if (extension == ".png" || extension == ".jpg") {
+                files.push_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    std::vector<Image> images;
+    for (const std::string& file : files) {
+        Image image;
+        image.name = file;
+        unsigned char* data = stbi_load(file.c_str(), &image.width, &image.height, &image.components, 0);
+        if (!data) {
+            std::cout << "Texture failed to load at path: " << file << std::endl;
+            continue;
+        }
+        image.pixels.assign(data, data + (size_t)image.width * image.height * image.components);
+        stbi_image_free(data);
+        images.push_back(image);
+    }
+    for (size_t i = 0, count = images.size(); i < count; i++) {
+        if (images[i].name.find("gator") != std::string::npos) {
+            images.push_back(tiled(images[i], 2048, 3));
+            images.push_back(tiled(images[i], 2048, 4));
+        }
+    }
+
+    ThreadPool single(0), pool;
+    MipGenerator boxStored(MIP_FILTER_BOX, false, &single), boxSrgb(MIP_FILTER_BOX, true, &single);
+    MipGenerator kaiserSrgb(MIP_FILTER_KAISER, true, &single), boxSrgbPool(MIP_FILTER_BOX, true, &pool);
+#ifdef SIMD_AVX2
+    const char* simd = "AVX2";
+#elif defined(SIMD_SSE2)
+    const char* simd = "SSE2";
+#else
+    const char* simd = "scalar";
+#endif
+    printf("%s, pool of %d threads, ms for the whole chain (best of %d)\n", simd, pool.size(), REPEATS);
+    printf("%-34s %12s %9s %9s %9s %9s %9s %11s %9s %9s\n", "", "size", "GL", "box", "box sRGB", "kaiser", "pool",
+        "pool MPix/s", "1x1 box", "sRGB");
+
+    for (const Image& image : images) {
+        static const GLenum formats[] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+        GLenum format = formats[image.components];
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels.data());
+        glFinish();
+        double glMs = bestTime([&] {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glFinish();
+        });
+        glDeleteTextures(1, &texture);
+
+        const unsigned char* pixels = image.pixels.data();
+        std::vector<std::vector<unsigned char>> stored, srgb;
+        double boxMs = bestTime([&] { stored = boxStored.generate(pixels, image.width, image.height, image.components); });
+        double srgbMs = bestTime([&] { srgb = boxSrgb.generate(pixels, image.width, image.height, image.components); });
+        double kaiserMs = bestTime([&] { kaiserSrgb.generate(pixels, image.width, image.height, image.components); });
+        double poolMs = bestTime([&] { boxSrgbPool.generate(pixels, image.width, image.height, image.components); });
+
+        // 1x1 level against the true average, negative is darker
+        double reference = linearBrightness(pixels, (size_t)image.width * image.height, image.components);
+        double storedError = (linearBrightness(stored.back().data(), 1, image.components) / reference - 1.0) * 100.0;
+        double srgbError = (linearBrightness(srgb.back().data(), 1, image.components) / reference - 1.0) * 100.0;
+
+        char size[32];
+        snprintf(size, sizeof(size), "%dx%dx%d", image.width, image.height, image.components);
+        printf("%-34s %12s %9.2f %9.2f %9.2f %9.2f %9.2f %11.1f %8.1f%% %8.1f%%\n", image.name.c_str(), size, glMs, boxMs, srgbMs,
+            kaiserMs, poolMs, (double)image.width * image.height / 1e6 / (poolMs / 1000.0), storedError, srgbError);
+    }
+
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,182 @@
+// RenderQueue against immediate submission. Records thousands of small draws that mix 4 programs, 8 texture
+// sets and 2 VAOs in scene order, then submits them once as they come (raw GL, like the demos did) and once
+// through the sorted queue. Reports state switches and CPU time per frame for both.
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "Shader.h"
+#include "MeshBuilder.h"
+#include "RenderQueue.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+const int FRAMES = 20;
+const int PROGRAMS = 4;
+const int TEXTURE_SETS = 8;
+
+float vertices[] = {
+    -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f,  0.5f, -0.5f,   0.5f,  0.5f, -0.5f,  -0.5f,  0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,
+    -0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,   0.5f,  0.5f,  0.5f,   0.5f,  0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,  -0.5f, -0.5f,  0.5f,
+    -0.5f,  0.5f,  0.5f,  -0.5f,  0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,  -0.5f, -0.5f, -0.5f,  -0.5f, -0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,
+     0.5f,  0.5f,  0.5f,   0.5f,  0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f, -0.5f,  0.5f,   0.5f,  0.5f,  0.5f,
+    -0.5f, -0.5f, -0.5f,   0.5f, -0.5f, -0.5f,   0.5f, -0.5f,  0.5f,   0.5f, -0.5f,  0.5f,  -0.5f, -0.5f,  0.5f,  -0.5f, -0.5f, -0.5f,
+    -0.5f,  0.5f, -0.5f,   0.5f,  0.5f, -0.5f,   0.5f,  0.5f,  0.5f,   0.5f,  0.5f,  0.5f,  -0.5f,  0.5f,  0.5f,  -0.5f,  0.5f, -0.5f
+};
+
+struct SceneObject {
+    int program;
+    int textureSet;
+    int vertexArray;
+    glm::vec3 position;
+};
+
+struct FrameResult {
+    double cpuMs;   // recording, sorting and issuing
+    double frameMs; // until glFinish
+};
+
+int main(int argc, char** argv)
+{
+    int objectCount = argc > 1 ? atoi(argv[1]) : 10000;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 600, "Render Queue Benchmark", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // the same source linked several times stands in for different materials
+    std::vector<Shader> programs;
+    std::vector<UniformHandle> modelUniforms;
+    for (int i = 0; i < PROGRAMS; i++) {
+        programs.push_back(Shader("shaders/transVert.glsl", "shaders/transFrag.glsl"));
+        modelUniforms.push_back(programs[i].getUniform("model"));
+        programs[i].use();
+        programs[i].setMat4("view", glm::mat4(1.0f));
+        programs[i].setMat4("projection", glm::mat4(1.0f));
+    }
+
+    std::vector<unsigned int> textures(TEXTURE_SETS);
+    glGenTextures(TEXTURE_SETS, textures.data());
+    for (int i = 0; i < TEXTURE_SETS; i++) {
+        unsigned char texel[4] = { (unsigned char)(i * 32), 128, 255, 255 };
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+
+    MeshBuilder cube(3);
+    cube.addTriangles(vertices, 36);
+    cube.optimize();
+    unsigned int VAOs[2], VBO, EBO;
+    glGenVertexArrays(2, VAOs);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    for (int i = 0; i < 2; i++) {
+        glBindVertexArray(VAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        if (i == 0) {
+            cube.upload();
+        }
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+    }
+
+    // scene order: random materials, like objects placed by hand
+    std::mt19937 random(1234);
+    std::vector<SceneObject> scene(objectCount);
+    for (SceneObject& object : scene) {
+        object.program = random() % PROGRAMS;
+        object.textureSet = random() % TEXTURE_SETS;
+        object.vertexArray = random() % 2;
+        object.position = glm::vec3(std::uniform_real_distribution<float>(-0.9f, 0.9f)(random),
+            std::uniform_real_distribution<float>(-0.9f, 0.9f)(random), std::uniform_real_distribution<float>(0.0f, 1.0f)(random));
+    }
+
+    glEnable(GL_DEPTH_TEST);
+    glViewport(0, 0, 800, 600);
+
+    GLStateCache glState;
+    RenderQueue queue;
+    queue.setDepthRange(0.0f, 1.0f);
+
+    // Averages FRAMES frames after one warm up frame
+    auto timeFrames = [&](auto submit) {
+        FrameResult total = { 0.0, 0.0 };
+        for (int frame = -1; frame < FRAMES; frame++) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            auto start = std::chrono::high_resolution_clock::now();
+            submit();
+            auto submitted = std::chrono::high_resolution_clock::now();
+            glFinish();
+            auto end = std::chrono::high_resolution_clock::now();
+            if (frame >= 0) {
+                total.cpuMs += std::chrono::duration<double, std::milli>(submitted - start).count() / FRAMES;
+                total.frameMs += std::chrono::duration<double, std::milli>(end - start).count() / FRAMES;
+            }
+        }
+        return total;
+    };
+
+    auto transform = [](const SceneObject& object) {
+        return glm::scale(glm::translate(glm::mat4(1.0f), object.position), glm::vec3(0.02f));
+    };
+
+    FrameResult immediate = timeFrames([&] {
+        for (const SceneObject& object : scene) {
+            programs[object.program].use();
+            glUniformMatrix4fv(modelUniforms[object.program].location, 1, GL_FALSE, glm::value_ptr(transform(object)));
+            glBindVertexArray(VAOs[object.vertexArray]);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, textures[object.textureSet]);
+            glDrawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0);
+        }
+    });
+
+    glState.invalidate();
+    glState.resetCounters();
+    FrameResult queued = timeFrames([&] {
+        for (const SceneObject& object : scene) {
+            queue.begin(programs[object.program].ID, VAOs[object.vertexArray], object.position.z);
+            queue.texture(0, textures[object.textureSet]);
+            queue.uniform(modelUniforms[object.program], transform(object));
+            queue.drawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType());
+        }
+        queue.flush(glState);
+        glState.endFrame();
+    });
+
+    const RenderQueueStats& stats = queue.lastStats();
+    printf("%d draws, %d programs, %d texture sets, 2 VAOs, %d frames\n", objectCount, PROGRAMS, TEXTURE_SETS, FRAMES);
+    printf("%-12s %10s %10s %10s %10s %10s\n", "", "programs", "VAOs", "textures", "cpu ms", "frame ms");
+    printf("%-12s %10d %10d %10d %10.3f %10.3f\n", "immediate", stats.recordedProgramSwitches, stats.recordedVertexArraySwitches,
+        stats.recordedTextureBinds, immediate.cpuMs, immediate.frameMs);
+    printf("%-12s %10d %10d %10d %10.3f %10.3f\n", "queue", stats.programSwitches, stats.vertexArraySwitches,
+        stats.textureBinds, queued.cpuMs, queued.frameMs);
+    printf("sort %.1f us, submit %.1f us, arena %zu bytes\n", stats.sortMicroseconds, stats.submitMicroseconds, stats.arenaBytes);
+    glState.report();
+
+    glfwTerminate();
+    return 0;
+}
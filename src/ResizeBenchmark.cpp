@@ -0,0 +1,208 @@
+// A scripted drag resize of LineTrails' trail framebuffer: the window is dragged from 800x600 out to 1920x1080,
+// down to 640x480 and back to 1280x720, with a few resize events between frames the way a window system sends them,
+// then left alone long enough for any debounced reallocation. Every frame is LineTrails' fade, lines and threshold,
+// timed up to a glFinish. The old policy (glTexImage2D on every event) is compared against bucketed immutable
+// storage with a debounce; hitches are frames over twice the median. Runs headless.
+//
+//   ResizeBenchmark [lines] [eventsPerFrame]      (default 10000 lines, 3 events per frame)
+
+#include <glad/glad.h>
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include "HeadlessContext.h"
+#include "Shader.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "ThreadPool.h"
+#include "TrailParticles.h"
+#include "ResizableTarget.h"
+
+#include <glm/glm.hpp>
+
+const int MAX_WIDTH = 1920, MAX_HEIGHT = 1080;
+const int DRAG_FRAMES = 60;    // per leg of the drag
+const int SETTLE_FRAMES = 30;  // after it, no events
+const float TIMESTEP = 1.0f / 60.0f;
+
+struct Size {
+    int width, height;
+};
+
+// Every resize event of the drag, frame by frame
+std::vector<std::vector<Size>> dragScript(int eventsPerFrame)
+{
+    Size legs[] = { { 800, 600 }, { 1920, 1080 }, { 640, 480 }, { 1280, 720 } };
+    std::vector<std::vector<Size>> frames;
+    for (int leg = 0; leg + 1 < 4; leg++) {
+        for (int frame = 0; frame < DRAG_FRAMES; frame++) {
+            std::vector<Size> events;
+            for (int event = 1; event <= eventsPerFrame; event++) {
+                float t = (frame + (float)event / eventsPerFrame) / DRAG_FRAMES;
+                events.push_back({ (int)(legs[leg].width + t * (legs[leg + 1].width - legs[leg].width)),
+                    (int)(legs[leg].height + t * (legs[leg + 1].height - legs[leg].height)) });
+            }
+            frames.push_back(events);
+        }
+    }
+    for (int frame = 0; frame < SETTLE_FRAMES; frame++) {
+        frames.push_back(std::vector<Size>());
+    }
+    return frames;
+}
+
+int main(int argc, char** argv)
+{
+    int lineCount = argc > 1 ? atoi(argv[1]) : 10000;
+    int eventsPerFrame = argc > 2 ? std::max(atoi(argv[2]), 1) : 3;
+
+    HeadlessContext context;
+    if (!context.create(4, 5) || !gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    loadGLExtensions((GLADloadproc)HeadlessContext::getProcAddress);
+    printf("%s, %d lines, %d resize events per frame, immutable storage %s\n", (const char*)glGetString(GL_RENDERER),
+        lineCount, eventsPerFrame, GLEXT_ARB_texture_storage ? "available" : "unavailable");
+
+    GLStateCache glState;
+    Shader lineShader("shaders/lineTrailVert.glsl", "shaders/lineTrailFrag.glsl");
+    Shader clearShader("shaders/vertex2d.glsl", "shaders/fade.frag");
+    Shader quadShader("shaders/texVertRegion.glsl", "shaders/texFragFloor.glsl");
+
+    float clear[] = { -1, -1, -1, 1, 1, -1, 1, 1 };
+    unsigned int clearVAO, clearVBO;
+    glGenVertexArrays(1, &clearVAO);
+    glBindVertexArray(clearVAO);
+    glGenBuffers(1, &clearVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, clearVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(clear), clear, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+    glEnableVertexAttribArray(0);
+
+    float quad[] = { -1, -1, 0, 0, -1, 1, 0, 1, 1, -1, 1, 0, 1, 1, 1, 1 };
+    unsigned int quadVAO, quadVBO;
+    glGenVertexArrays(1, &quadVAO);
+    glBindVertexArray(quadVAO);
+    glGenBuffers(1, &quadVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    ThreadPool pool;
+    TrailParticles trails;
+    trails.generate(lineCount, 1, &pool);
+    unsigned int lineVAO, lineVBO;
+    glGenVertexArrays(1, &lineVAO);
+    glBindVertexArray(lineVAO);
+    glGenBuffers(1, &lineVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+    trails.upload();
+    trails.setAttributes();
+
+    // a renderbuffer as big as the drag gets stands in for the window
+    unsigned int screenFBO, screenColor;
+    glGenRenderbuffers(1, &screenColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, screenColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, MAX_WIDTH, MAX_HEIGHT);
+    glGenFramebuffers(1, &screenFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, screenFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, screenColor);
+
+    glState.invalidate();
+    glState.setEnabled(GL_BLEND, true);
+    glState.blendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    lineShader.use(glState);
+    lineShader.setFloat("u_trail_length", 0.1f);
+    clearShader.use(glState);
+    clearShader.setFloat("u_opacity", 0.1f);
+    quadShader.use(glState);
+    quadShader.setFloat("u_floor", 0.1f);
+    quadShader.setInt("u_Texture", 0);
+    int regionUniformLocation = glGetUniformLocation(quadShader.ID, "u_region");
+
+    std::vector<std::vector<Size>> script = dragScript(eventsPerFrame);
+    printf("%d frames, %d events\n\n", (int)script.size(), (int)(DRAG_FRAMES * 3 * eventsPerFrame));
+    printf("%10s %12s %12s %10s %10s %10s %10s %10s %9s %12s\n", "policy", "allocations", "alloc MB", "alloc ms",
+        "median ms", "p99 ms", "max ms", "total ms", "hitches", "final");
+
+    ResizableTarget::Policy policies[] = { ResizableTarget::Exact, ResizableTarget::Bucketed };
+    for (ResizableTarget::Policy policy : policies) {
+        ResizableTarget target;
+        target.create(800, 600, glState, policy);
+        int windowWidth = 800, windowHeight = 600;
+        std::vector<double> frameMs;
+        glFinish();
+
+        for (size_t frame = 0; frame < script.size(); frame++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const Size& size : script[frame]) {
+                windowWidth = size.width;
+                windowHeight = size.height;
+                target.resize(size.width, size.height);
+            }
+            target.update(glState);
+
+            target.bind(glState);
+            clearShader.use(glState);
+            glState.bindVertexArray(clearVAO);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+            lineShader.use(glState);
+            lineShader.setFloat("u_time", frame * TIMESTEP);
+            lineShader.setFloat("u_aspect_ratio", (float)windowWidth / (float)windowHeight);
+            glState.bindVertexArray(lineVAO);
+            glDrawArraysInstanced(GL_LINES, 0, 2, trails.count());
+
+            glState.bindFramebuffer(GL_FRAMEBUFFER, screenFBO);
+            glViewport(0, 0, windowWidth, windowHeight);
+            glClear(GL_COLOR_BUFFER_BIT);
+            quadShader.use(glState);
+            glm::vec2 region = target.region();
+            glUniform2f(regionUniformLocation, region.x, region.y);
+            glState.bindTexture(0, GL_TEXTURE_2D, target.texture());
+            glState.bindVertexArray(quadVAO);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            glFinish();
+            frameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        }
+
+        std::vector<double> sorted = frameMs;
+        std::sort(sorted.begin(), sorted.end());
+        double median = sorted[sorted.size() / 2];
+        double total = 0.0;
+        int hitches = 0;
+        for (double ms : frameMs) {
+            total += ms;
+            hitches += ms > 2.0 * median;
+        }
+        const ResizableTargetStats& stats = target.getStats();
+        char final[32];
+        snprintf(final, sizeof(final), "%dx%d", target.width(), target.height());
+        printf("%10s %12lld %12.1f %10.3f %10.3f %10.3f %10.3f %10.1f %9d %12s\n", policy == ResizableTarget::Exact ? "exact" : "bucketed",
+            stats.allocations, stats.allocatedBytes / 1048576.0, stats.allocationMs, median,
+            sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)], sorted.back(), total, hitches, final);
+        target.release();
+        glState.invalidate();
+    }
+
+    lineShader.free();
+    clearShader.free();
+    quadShader.free();
+    glDeleteVertexArrays(1, &clearVAO);
+    glDeleteVertexArrays(1, &quadVAO);
+    glDeleteVertexArrays(1, &lineVAO);
+    glDeleteBuffers(1, &clearVBO);
+    glDeleteBuffers(1, &quadVBO);
+    glDeleteBuffers(1, &lineVBO);
+    glDeleteFramebuffers(1, &screenFBO);
+    glDeleteRenderbuffers(1, &screenColor);
+    context.release();
+    return 0;
+}
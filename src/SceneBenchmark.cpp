@@ -0,0 +1,812 @@
+// Plays the demo scenes for a fixed number of frames and writes their frame time statistics as JSON, so runs can be
+// compared across commits. Nothing depends on the wall clock or on input: scene time advances by a fixed timestep
+// per frame, the camera follows a scripted path, and every frame renders into an offscreen target and is finished
+// before the next starts. The gl backend needs no window or display (HeadlessContext: EGL surfaceless on Linux, so
+// Mesa's llvmpipe runs it in a GPU-less container), the cpu backend runs the cube scenes on the SoftwareRasterizer
+// and linetrails on SoftwareLineTrails without any GL at all. auto tries gl and falls back to cpu.
+// Each scene reports min/median/p99/mean/max frame ms, frames and triangles per second, and a checksum of the last
+// frame's pixels, which stays the same between runs as long as the rendering does.
+//
+//   SceneBenchmark [--backend auto|gl|cpu] [--frames N] [--warmup N] [--size WxH] [--scene name]... [--label text]
+//                  [--output file.json]        (defaults auto, 300, 10, 800x600, every scene, SceneBenchmark.json)
+//   scenes: lightcasters, cubes10k, linetrails
+
+#include <glad/glad.h>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "HeadlessContext.h"
+#include "GLExtensions.h"
+#include "Shader.h"
+#include "MeshBuilder.h"
+#include "VertexPacking.h"
+#include "TextureLoader.h"
+#include "SoftwareRasterizer.h"
+#include "LightingKernels.h"
+#include "TrailParticles.h"
+#include "SoftwareLineTrails.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+const float TIMESTEP = 1.0f / 60.0f;
+const float ORBIT_SECONDS = 10.0f;
+
+float vertices[] = {
+    // positions          // normals           // texture coords
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+};
+
+// LightCasters' cubes
+glm::vec3 positions[] = {
+    glm::vec3(0.0f,0.0f, 0.0f),
+    glm::vec3(0.0f,2.0f, 1.0f),
+    glm::vec3(3.0f,0.0f, 1.0f),
+    glm::vec3(1.0f,5.0f, 0.0f),
+    glm::vec3(1.0f,1.0f, -1.0f),
+    glm::vec3(0.0f,1.0f, 0.0f),
+    glm::vec3(0.0f,10.0f, 0.5f),
+    glm::vec3(-1.0f,0.0f, 0.0f),
+    glm::vec3(0.0f,5.0f, 0.5f),
+    glm::vec3(10.0f,1.0f, 1.0f)
+};
+
+const glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
+
+// LineTrails' lines, seeded so every run draws the same ones
+const int TRAIL_LINES = 10;
+const uint64_t TRAIL_SEED = 1234;
+
+// Per instance vertex data for lightingMapVert.glsl
+struct CubeInstance {
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+};
+
+// Where the cubes are and where the camera circles
+struct CubeLayout {
+    std::vector<glm::mat4> models;
+    glm::vec3 centre;
+    float radius;
+};
+
+// The ten LightCasters cubes, or count of them on a grid like LightCasters --bench
+CubeLayout cubeLayout(int count)
+{
+    CubeLayout layout;
+    if (count <= 10) {
+        for (int i = 0; i < count; i++) {
+            layout.models.push_back(glm::rotate(glm::translate(glm::mat4(1.0f), positions[i]), glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f)));
+        }
+        layout.centre = glm::vec3(2.0f, 3.0f, 0.0f);
+        layout.radius = 12.0f;
+        return layout;
+    }
+    int side = (int)std::ceil(std::cbrt((double)count));
+    const float spacing = 1.5f;
+    for (int i = 0; i < count; i++) {
+        int x = i % side, y = (i / side) % side, z = i / (side * side);
+        glm::vec3 position((x - side * 0.5f) * spacing, (y - side * 0.5f) * spacing, -z * spacing);
+        layout.models.push_back(glm::rotate(glm::translate(glm::mat4(1.0f), position), glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f)));
+    }
+    layout.centre = glm::vec3(0.0f, 0.0f, -side * spacing * 0.5f);
+    layout.radius = side * spacing * 1.2f;
+    return layout;
+}
+
+// The scripted camera: one orbit around the centre every ORBIT_SECONDS, bobbing up and down, looking at the centre
+struct CameraPose {
+    glm::vec3 position, front;
+    glm::mat4 view;
+};
+
+CameraPose cameraAt(float time, glm::vec3 centre, float radius)
+{
+    float angle = time / ORBIT_SECONDS * glm::two_pi<float>();
+    CameraPose pose;
+    pose.position = centre + glm::vec3(std::sin(angle) * radius, std::sin(angle * 2.0f) * radius * 0.25f, std::cos(angle) * radius);
+    pose.front = glm::normalize(centre - pose.position);
+    pose.view = glm::lookAt(pose.position, centre, glm::vec3(0.0f, 1.0f, 0.0f));
+    return pose;
+}
+
+// LightCasters' spot light, held by the camera
+SpotLightParams cameraSpotLight(const CameraPose& pose)
+{
+    SpotLightParams light;
+    light.position = pose.position;
+    light.direction = pose.front;
+    light.cutOff = glm::cos(glm::radians(12.5f));
+    light.outerCutOff = glm::cos(glm::radians(17.5f));
+    light.ambient = glm::vec3(0.2f);
+    light.diffuse = glm::vec3(0.5f);
+    light.specular = glm::vec3(1.0f);
+    light.constant = 1.0f;
+    light.linear = 0.09f;
+    light.quadratic = 0.032f;
+    return light;
+}
+
+uint64_t hashPixels(const unsigned char* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+class BenchmarkScene {
+
+public:
+    virtual ~BenchmarkScene() {
+    }
+
+    virtual bool init(int width, int height) = 0;
+    // Renders the frame at time and returns once it is finished
+    virtual void render(float time) = 0;
+    virtual long long triangles() const = 0; // submitted per frame
+    virtual uint64_t checksum() = 0;         // of the last frame
+};
+
+// Offscreen color and depth target for the GL scenes
+class GLTarget {
+
+public:
+    int width = 0, height = 0;
+    unsigned int framebuffer = 0, color = 0, depth = 0;
+
+    bool create(int targetWidth, int targetHeight) {
+        width = targetWidth;
+        height = targetHeight;
+        glGenFramebuffers(1, &framebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glGenRenderbuffers(1, &color);
+        glBindRenderbuffer(GL_RENDERBUFFER, color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+        glGenRenderbuffers(1, &depth);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cout << "ERROR::BENCHMARK::FRAMEBUFFER_INCOMPLETE" << std::endl;
+            return false;
+        }
+        glViewport(0, 0, width, height);
+        return true;
+    }
+
+    void bind() {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(0, 0, width, height);
+    }
+
+    uint64_t checksum() {
+        std::vector<unsigned char> pixels((size_t)width * height * 4);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        return hashPixels(pixels.data(), pixels.size());
+    }
+
+    ~GLTarget() {
+        glDeleteRenderbuffers(1, &color);
+        glDeleteRenderbuffers(1, &depth);
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+};
+
+// LightCasters: instanced lighting mapped cubes under the camera's spot light, plus the lamp
+class GLCubeScene : public BenchmarkScene {
+
+public:
+    explicit GLCubeScene(int count) : layout(cubeLayout(count)) {
+    }
+
+    ~GLCubeScene() {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteVertexArrays(1, &lightVAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &instanceVBO);
+        glDeleteTextures(3, maps);
+        if (shader) {
+            shader->free();
+            lightShader->free();
+        }
+    }
+
+    bool init(int width, int height) override {
+        if (!target.create(width, height)) {
+            return false;
+        }
+        ThreadPool pool;
+        TextureLoader textures(pool);
+        maps[0] = textures.load("resources/container2.png");
+        maps[1] = textures.load("resources/container2_specular.png");
+        maps[2] = textures.load("resources/7a9.jpg");
+
+        shader.reset(new Shader("shaders/LightingMapVert.glsl", "shaders/spotlightFrag.glsl"));
+        lightShader.reset(new Shader("shaders/lightVert.glsl", "shaders/lightSourceFrag.glsl"));
+        textures.finish();
+        if (textures.getStats().failed) {
+            return false;
+        }
+
+        cube.addTriangles(vertices, 36);
+        cube.optimize();
+        PackedMesh packedCube(cube.getVertices().data(), cube.vertexCount());
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        packedCube.upload();
+        cube.uploadIndices();
+        PackedMesh::setAttributes();
+
+        std::vector<CubeInstance> instances;
+        for (const glm::mat4& model : layout.models) {
+            instances.push_back({ model * packedCube.positionTransform(), glm::mat3(glm::transpose(glm::inverse(model))) });
+        }
+        glGenBuffers(1, &instanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(CubeInstance), instances.data(), GL_STATIC_DRAW);
+        for (int i = 0; i < 4; i++) { // model matrix columns
+            glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)(offsetof(CubeInstance, model) + i * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(3 + i);
+            glVertexAttribDivisor(3 + i, 1);
+        }
+        for (int i = 0; i < 3; i++) { // normal matrix columns
+            glVertexAttribPointer(7 + i, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)(offsetof(CubeInstance, normalMatrix) + i * sizeof(glm::vec3)));
+            glEnableVertexAttribArray(7 + i);
+            glVertexAttribDivisor(7 + i, 1);
+        }
+
+        glGenVertexArrays(1, &lightVAO);
+        glBindVertexArray(lightVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        PackedMesh::setAttributes(false);
+        lightModel = glm::scale(glm::translate(glm::mat4(1.0f), lightPos), glm::vec3(0.2f)) * packedCube.positionTransform();
+
+        projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 1000.0f);
+        shader->use();
+        shader->setInt("material.diffuse", 0);
+        shader->setInt("material.specular", 1);
+        shader->setInt("material.emission", 2);
+        shader->setFloat("material.shininess", 64.0f);
+        shader->setFloat("material.emmisiveness", 0.0f);
+        shader->setMat4("projection", projection);
+        lightShader->use();
+        lightShader->setMat4("projection", projection);
+        return true;
+    }
+
+    void render(float time) override {
+        CameraPose pose = cameraAt(time, layout.centre, layout.radius);
+        SpotLightParams light = cameraSpotLight(pose);
+
+        target.bind();
+        glEnable(GL_DEPTH_TEST);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        shader->use();
+        shader->setMat4("view", pose.view);
+        shader->setVec3("viewPos", pose.position);
+        shader->setVec3("light.position", light.position);
+        shader->setVec3("light.direction", light.direction);
+        shader->setFloat("light.cutOff", light.cutOff);
+        shader->setFloat("light.outerCutOff", light.outerCutOff);
+        shader->setVec3("light.ambient", light.ambient);
+        shader->setVec3("light.diffuse", light.diffuse);
+        shader->setVec3("light.specular", light.specular);
+        shader->setFloat("light.constant", light.constant);
+        shader->setFloat("light.linear", light.linear);
+        shader->setFloat("light.quadratic", light.quadratic);
+        for (int i = 0; i < 3; i++) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, maps[i]);
+        }
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0, (int)layout.models.size());
+
+        lightShader->use();
+        lightShader->setMat4("view", pose.view);
+        lightShader->setMat4("model", lightModel);
+        glBindVertexArray(lightVAO);
+        glDrawElements(GL_TRIANGLES, cube.indexCount(), cube.indexType(), 0);
+        glFinish();
+    }
+
+    long long triangles() const override {
+        return (long long)(layout.models.size() + 1) * 12;
+    }
+
+    uint64_t checksum() override {
+        return target.checksum();
+    }
+
+private:
+    CubeLayout layout;
+    GLTarget target;
+    MeshBuilder cube{ 8 };
+    std::unique_ptr<Shader> shader, lightShader;
+    unsigned int maps[3] = { 0, 0, 0 };
+    unsigned int VAO = 0, VBO = 0, EBO = 0, instanceVBO = 0, lightVAO = 0;
+    glm::mat4 lightModel, projection;
+};
+
+// LineTrails: fade the trail texture, draw the lines into it, threshold it onto the target
+class GLLineTrailsScene : public BenchmarkScene {
+
+public:
+    ~GLLineTrailsScene() {
+        glDeleteVertexArrays(1, &lineVAO);
+        glDeleteVertexArrays(1, &clearVAO);
+        glDeleteVertexArrays(1, &quadVAO);
+        glDeleteBuffers(1, &lineVBO);
+        glDeleteBuffers(1, &clearVBO);
+        glDeleteBuffers(1, &quadVBO);
+        glDeleteFramebuffers(1, &trailFBO);
+        glDeleteTextures(1, &trailTexture);
+        if (lineShader) {
+            lineShader->free();
+            clearShader->free();
+            quadShader->free();
+        }
+    }
+
+    bool init(int width, int height) override {
+        if (!target.create(width, height)) {
+            return false;
+        }
+        lineShader.reset(new Shader("shaders/lineTrailVert.glsl", "shaders/lineTrailFrag.glsl"));
+        clearShader.reset(new Shader("shaders/vertex2d.glsl", "shaders/fade.frag"));
+        quadShader.reset(new Shader("shaders/texVert.glsl", "shaders/texFragFloor.glsl"));
+        aspect = (float)width / (float)height;
+
+        TrailParticles trails;
+        trails.generate(TRAIL_LINES, TRAIL_SEED);
+        glGenVertexArrays(1, &lineVAO);
+        glBindVertexArray(lineVAO);
+        glGenBuffers(1, &lineVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, lineVBO);
+        trails.upload();
+        trails.setAttributes();
+
+        float clear[] = { -1, -1, -1, 1, 1, -1, 1, 1 };
+        glGenVertexArrays(1, &clearVAO);
+        glBindVertexArray(clearVAO);
+        glGenBuffers(1, &clearVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, clearVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(clear), clear, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0);
+        glEnableVertexAttribArray(0);
+
+        float quad[] = { -1, -1, 0, 0, -1, 1, 0, 1, 1, -1, 1, 0, 1, 1, 1, 1 };
+        glGenVertexArrays(1, &quadVAO);
+        glBindVertexArray(quadVAO);
+        glGenBuffers(1, &quadVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        glGenFramebuffers(1, &trailFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, trailFBO);
+        glGenTextures(1, &trailTexture);
+        glBindTexture(GL_TEXTURE_2D, trailTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, trailTexture, 0);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    void render(float time) override {
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, trailFBO);
+        glViewport(0, 0, target.width, target.height);
+        clearShader->use();
+        clearShader->setFloat("u_opacity", 0.1f);
+        glBindVertexArray(clearVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        lineShader->use();
+        lineShader->setFloat("u_time", std::fmod(time, glm::two_pi<float>()));
+        lineShader->setFloat("u_aspect_ratio", aspect);
+        lineShader->setFloat("u_trail_length", 0.1f);
+        glBindVertexArray(lineVAO);
+        glDrawArraysInstanced(GL_LINES, 0, 2, TRAIL_LINES);
+
+        target.bind();
+        glClear(GL_COLOR_BUFFER_BIT);
+        quadShader->use();
+        quadShader->setFloat("u_floor", 0.1f);
+        quadShader->setInt("u_Texture", 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, trailTexture);
+        glBindVertexArray(quadVAO);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glDisable(GL_BLEND);
+        glFinish();
+    }
+
+    long long triangles() const override {
+        return 4; // the two full screen strips, the lines aren't triangles
+    }
+
+    uint64_t checksum() override {
+        return target.checksum();
+    }
+
+private:
+    GLTarget target;
+    std::unique_ptr<Shader> lineShader, clearShader, quadShader;
+    unsigned int lineVAO = 0, lineVBO = 0, clearVAO = 0, clearVBO = 0, quadVAO = 0, quadVBO = 0;
+    unsigned int trailFBO = 0, trailTexture = 0;
+    float aspect = 1.0f;
+};
+
+// GLCubeScene on the SoftwareRasterizer, shaded with LightingKernels like SoftwareRenderer
+class CPUCubeScene : public BenchmarkScene {
+
+public:
+    CPUCubeScene(int count, ThreadPool& pool) : layout(cubeLayout(count)), rasterizer(pool) {
+    }
+
+    bool init(int width, int height) override {
+        framebuffer.reset(new SoftwareFramebuffer(width, height));
+        rasterizer.setFramebuffer(framebuffer.get());
+        projection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 1000.0f);
+        return diffuseMap.load("resources/container2.png") && specularMap.load("resources/container2_specular.png")
+            && emissionMap.load("resources/7a9.jpg");
+    }
+
+    void render(float time) override {
+        CameraPose pose = cameraAt(time, layout.centre, layout.radius);
+        SpotLightParams light = cameraSpotLight(pose);
+        glm::mat4 viewProjection = projection * pose.view;
+        framebuffer->clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+        for (const glm::mat4& model : layout.models) {
+            glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+
+            // lightingMapVert.glsl: varyings are FragPos, Normal, TexCoords
+            auto vertexShader = [&](const float* vertex, float* varyings) {
+                glm::vec3 fragPos = glm::vec3(model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f));
+                glm::vec3 normal = normalMatrix * glm::vec3(vertex[3], vertex[4], vertex[5]);
+                varyings[0] = fragPos.x; varyings[1] = fragPos.y; varyings[2] = fragPos.z;
+                varyings[3] = normal.x; varyings[4] = normal.y; varyings[5] = normal.z;
+                varyings[6] = vertex[6]; varyings[7] = vertex[7];
+                return viewProjection * glm::vec4(fragPos, 1.0f);
+            };
+
+            // spotlightFrag.glsl
+            auto fragmentShader = [&](SoftwareRasterizer::FragmentBatch& batch) {
+                alignas(32) float maps[9][RASTER_FRAGMENT_BATCH];
+                for (int lane = 0; lane < batch.count; lane++) {
+                    glm::vec2 texCoords(batch.varyings[6][lane], batch.varyings[7][lane]);
+                    glm::vec4 diffuseColor = diffuseMap.sample(texCoords);
+                    glm::vec4 specularColor = specularMap.sample(texCoords);
+                    glm::vec4 emissionColor = emissionMap.sample(texCoords);
+                    for (int c = 0; c < 3; c++) {
+                        maps[c][lane] = diffuseColor[c];
+                        maps[3 + c][lane] = specularColor[c];
+                        maps[6 + c][lane] = emissionColor[c];
+                    }
+                    batch.color[3][lane] = 1.0f;
+                }
+                LightingFragments fragments = {
+                    { batch.varyings[0], batch.varyings[1], batch.varyings[2] },
+                    { batch.varyings[3], batch.varyings[4], batch.varyings[5] },
+                    { maps[0], maps[1], maps[2] },
+                    { maps[3], maps[4], maps[5] },
+                    { maps[6], maps[7], maps[8] },
+                    { batch.color[0], batch.color[1], batch.color[2] },
+                    batch.count
+                };
+                shadeSpotLight(light, pose.position, 0.0f, fragments);
+            };
+
+            rasterizer.drawArraysBatched(vertices, 8, 0, 36, 8, vertexShader, fragmentShader);
+        }
+
+        // lamp cube, lightSourceFrag.glsl is plain white
+        glm::mat4 lightMVP = viewProjection * glm::scale(glm::translate(glm::mat4(1.0f), lightPos), glm::vec3(0.2f));
+        rasterizer.drawArrays(vertices, 8, 0, 36, 0,
+            [&](const float* vertex, float*) { return lightMVP * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f); },
+            [](const float*) { return glm::vec4(1.0f); });
+    }
+
+    long long triangles() const override {
+        return (long long)(layout.models.size() + 1) * 12;
+    }
+
+    uint64_t checksum() override {
+        return hashPixels((const unsigned char*)framebuffer->color.data(), framebuffer->color.size() * sizeof(uint32_t));
+    }
+
+private:
+    CubeLayout layout;
+    SoftwareRasterizer rasterizer;
+    std::unique_ptr<SoftwareFramebuffer> framebuffer;
+    SoftwareTexture diffuseMap, specularMap, emissionMap;
+    glm::mat4 projection;
+};
+
+// GLLineTrailsScene's passes on SoftwareLineTrails
+class CPULineTrailsScene : public BenchmarkScene {
+
+public:
+    explicit CPULineTrailsScene(ThreadPool& pool) : pool(pool) {
+    }
+
+    bool init(int width, int height) override {
+        trails.generate(TRAIL_LINES, TRAIL_SEED);
+        effect.reset(new SoftwareLineTrails(width, height, pool));
+        return true;
+    }
+
+    void render(float time) override {
+        effect->frame(trails, std::fmod(time, glm::two_pi<float>()));
+    }
+
+    long long triangles() const override {
+        return 4; // counted like the GL scene's two full screen strips
+    }
+
+    uint64_t checksum() override {
+        return hashPixels((const unsigned char*)effect->screen.color.data(), effect->screen.color.size() * sizeof(uint32_t));
+    }
+
+private:
+    ThreadPool& pool;
+    TrailParticles trails;
+    std::unique_ptr<SoftwareLineTrails> effect;
+};
+
+struct SceneResult {
+    std::string name;
+    int frames;
+    double minMs, medianMs, p99Ms, meanMs, maxMs;
+    double framesPerSecond, trianglesPerSecond;
+    uint64_t checksum;
+};
+
+// Nearest rank percentile of sorted times
+double percentile(const std::vector<double>& sorted, double p)
+{
+    size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[std::min(std::max(rank, (size_t)1), sorted.size()) - 1];
+}
+
+SceneResult runScene(const std::string& name, BenchmarkScene& scene, int frames, int warmup)
+{
+    SceneResult result = { name, frames, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0 };
+    // the warm up frames run before scene time 0, the measured ones always cover the same stretch of the path
+    for (int frame = -warmup; frame < 0; frame++) {
+        scene.render(frame * TIMESTEP);
+    }
+    std::vector<double> times(frames);
+    for (int frame = 0; frame < frames; frame++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        scene.render(frame * TIMESTEP);
+        times[frame] = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+    result.checksum = scene.checksum();
+
+    std::vector<double> sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double time : times) {
+        total += time;
+    }
+    result.minMs = sorted.front();
+    result.medianMs = frames % 2 ? sorted[frames / 2] : (sorted[frames / 2 - 1] + sorted[frames / 2]) * 0.5;
+    result.p99Ms = percentile(sorted, 99.0);
+    result.meanMs = total / frames;
+    result.maxMs = sorted.back();
+    result.framesPerSecond = 1000.0 / result.meanMs;
+    result.trianglesPerSecond = scene.triangles() * result.framesPerSecond;
+    return result;
+}
+
+bool writeJson(const char* path, const std::string& label, const std::string& backend, const std::string& renderer,
+    int width, int height, int frames, int warmup, const std::vector<SceneResult>& results)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        std::cout << "ERROR::BENCHMARK::FILE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    fprintf(file, "{\n  \"label\": \"%s\",\n  \"backend\": \"%s\",\n  \"renderer\": \"%s\",\n", label.c_str(), backend.c_str(), renderer.c_str());
+    fprintf(file, "  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %d,\n  \"warmup\": %d,\n  \"timestep\": %.6f,\n  \"scenes\": [\n",
+        width, height, frames, warmup, TIMESTEP);
+    for (size_t i = 0; i < results.size(); i++) {
+        const SceneResult& r = results[i];
+        fprintf(file, "    { \"name\": \"%s\", \"frames\": %d, \"min_ms\": %.4f, \"median_ms\": %.4f, \"p99_ms\": %.4f, \"mean_ms\": %.4f, "
+            "\"max_ms\": %.4f, \"fps\": %.2f, \"triangles_per_second\": %.0f, \"checksum\": \"%016llx\" }", r.name.c_str(), r.frames,
+            r.minMs, r.medianMs, r.p99Ms, r.meanMs, r.maxMs, r.framesPerSecond, r.trianglesPerSecond, (unsigned long long)r.checksum);
+        fprintf(file, i + 1 < results.size() ? ",\n" : "\n");
+    }
+    fprintf(file, "  ]\n}\n");
+    bool written = !ferror(file);
+    fclose(file);
+    return written;
+}
+
+// Keeps the JSON strings valid whatever the driver or the user put in them
+std::string jsonSafe(const std::string& text)
+{
+    std::string safe;
+    for (char c : text) {
+        safe += (c == '"' || c == '\\' || (unsigned char)c < 0x20) ? '_' : c;
+    }
+    return safe;
+}
+
+int main(int argc, char** argv)
+{
+    std::string backend = "auto", label, output = "SceneBenchmark.json";
+    int frames = 300, warmup = 10, width = 800, height = 600;
+    std::vector<std::string> scenes;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--backend" && hasValue) {
+            backend = argv[++i];
+        }
+        else if (arg == "--frames" && hasValue) {
+            frames = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--warmup" && hasValue) {
+            warmup = std::max(0, atoi(argv[++i]));
+        }
+        else if (arg == "--size" && hasValue && sscanf(argv[i + 1], "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+            i++;
+        }
+        else if (arg == "--scene" && hasValue) {
+            scenes.push_back(argv[++i]);
+        }
+        else if (arg == "--label" && hasValue) {
+            label = argv[++i];
+        }
+        else if (arg == "--output" && hasValue) {
+            output = argv[++i];
+        }
+        else {
+            std::cout << "ERROR::BENCHMARK::UNKNOWN_ARGUMENT " << arg << std::endl;
+            return -1;
+        }
+    }
+    if (scenes.empty()) {
+        scenes = { "lightcasters", "cubes10k", "linetrails" };
+    }
+
+    HeadlessContext context;
+    std::string renderer;
+    if (backend == "gl" || backend == "auto") {
+        if (context.create(4, 5) && gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+            loadGLExtensions((GLADloadproc)HeadlessContext::getProcAddress);
+            backend = "gl";
+            renderer = std::string((const char*)glGetString(GL_RENDERER)) + " through " + HeadlessContext::api();
+        }
+        else if (backend == "gl") {
+            return -1;
+        }
+        else {
+            context.release();
+            backend = "cpu";
+        }
+    }
+    if (backend != "gl" && backend != "cpu") {
+        std::cout << "ERROR::BENCHMARK::UNKNOWN_BACKEND " << backend << std::endl;
+        return -1;
+    }
+    ThreadPool pool;
+    if (backend == "cpu") {
+        renderer = "SoftwareRasterizer on " + std::to_string(pool.size()) + " threads";
+    }
+    printf("%s, %dx%d, %d frames after %d warm up, %.4f s timestep\n", renderer.c_str(), width, height, frames, warmup, TIMESTEP);
+    printf("%-14s %9s %9s %9s %9s %9s %9s %12s  %s\n", "scene", "min ms", "median", "p99", "mean", "max", "fps", "Mtri/s", "checksum");
+
+    std::vector<SceneResult> results;
+    for (const std::string& name : scenes) {
+        std::unique_ptr<BenchmarkScene> scene;
+        int cubes = name == "lightcasters" ? 10 : name == "cubes10k" ? 10000 : 0;
+        if (cubes && backend == "gl") {
+            scene.reset(new GLCubeScene(cubes));
+        }
+        else if (cubes) {
+            scene.reset(new CPUCubeScene(cubes, pool));
+        }
+        else if (name == "linetrails" && backend == "gl") {
+            scene.reset(new GLLineTrailsScene());
+        }
+        else if (name == "linetrails") {
+            scene.reset(new CPULineTrailsScene(pool));
+        }
+        else {
+            std::cout << "ERROR::BENCHMARK::UNKNOWN_SCENE " << name << std::endl;
+            return -1;
+        }
+        if (!scene->init(width, height)) {
+            std::cout << "ERROR::BENCHMARK::SCENE_INIT_FAILED " << name << std::endl;
+            return -1;
+        }
+        SceneResult result = runScene(name, *scene, frames, warmup);
+        printf("%-14s %9.3f %9.3f %9.3f %9.3f %9.3f %9.1f %12.2f  %016llx\n", name.c_str(), result.minMs, result.medianMs, result.p99Ms,
+            result.meanMs, result.maxMs, result.framesPerSecond, result.trianglesPerSecond / 1e6, (unsigned long long)result.checksum);
+        results.push_back(result);
+    }
+
+    if (!writeJson(output.c_str(), jsonSafe(label), backend, jsonSafe(renderer), width, height, frames, warmup, results)) {
+        return -1;
+    }
+    printf("wrote %s\n", output.c_str());
+    context.release();
+    return 0;
+}
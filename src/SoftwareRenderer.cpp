@@ -0,0 +1,261 @@
+// Runs the Light Casters scene on the CPU with the software rasterizer, no window or GL context needed.
+//
+//   SoftwareRenderer [output.ppm]   renders one frame to a file
+//   SoftwareRenderer --bench        triangle throughput per thread count
+
+#include <glad/glad.h>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include "Camera.h"
+#include "SoftwareRasterizer.h"
+#include "LightingKernels.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+float vertices[] = {
+    // positions          // normals           // texture coords
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+};
+
+glm::vec3 positions[] = {
+    glm::vec3(0.0f,0.0f, 0.0f),
+    glm::vec3(0.0f,2.0f, 1.0f),
+    glm::vec3(3.0f,0.0f, 1.0f),
+    glm::vec3(1.0f,5.0f, 0.0f),
+    glm::vec3(1.0f,1.0f, -1.0f),
+    glm::vec3(0.0f,1.0f, 0.0f),
+    glm::vec3(0.0f,10.0f, 0.5f),
+    glm::vec3(-1.0f,0.0f, 0.0f),
+    glm::vec3(0.0f,5.0f, 0.5f),
+    glm::vec3(10.0f,1.0f, 1.0f)
+};
+
+int renderScene(const char* outputPath);
+void triangleBenchmark();
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        triangleBenchmark();
+        return 0;
+    }
+    return renderScene(argc > 1 ? argv[1] : "softwareRender.ppm");
+}
+
+int renderScene(const char* outputPath)
+{
+    const int width = 800, height = 600;
+
+    SoftwareTexture diffuseMap, specularMap, emissionMap;
+    diffuseMap.load("resources/container2.png");
+    specularMap.load("resources/container2_specular.png");
+    emissionMap.load("resources/7a9.jpg");
+
+    Camera camera(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 view = camera.generateView();
+    glm::mat4 projection = glm::perspective(glm::radians(camera.Fov), (float)width / (float)height, 0.1f, 100.0f);
+
+    // same light setup as LightCasters.cpp
+    SpotLightParams light;
+    light.position = camera.Pos;
+    light.direction = camera.Front;
+    light.cutOff = glm::cos(glm::radians(12.5f));
+    light.outerCutOff = glm::cos(glm::radians(17.5f));
+    light.ambient = glm::vec3(0.2f);
+    light.diffuse = glm::vec3(0.5f);
+    light.specular = glm::vec3(1.0f);
+    light.constant = 1.0f;
+    light.linear = 0.09f;
+    light.quadratic = 0.032f;
+    float emmisiveness = 0.0f;
+
+    glm::mat4 lightModel = glm::mat4(1.0f);
+    lightModel = glm::translate(lightModel, glm::vec3(1.2f, 1.0f, 2.0f));
+    lightModel = glm::scale(lightModel, glm::vec3(0.2f));
+
+    ThreadPool pool;
+    SoftwareRasterizer rasterizer(pool);
+    SoftwareFramebuffer framebuffer(width, height);
+    rasterizer.setFramebuffer(&framebuffer);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    framebuffer.clear(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+
+    for (int i = 0; i < 10; i++) {
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, positions[i]);
+        model = glm::rotate(model, glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+        glm::mat4 viewProjection = projection * view;
+
+        // lightingMapVert.glsl: varyings are FragPos, Normal, TexCoords
+        auto vertexShader = [&](const float* vertex, float* varyings) {
+            glm::vec3 fragPos = glm::vec3(model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f));
+            glm::vec3 normal = normalMatrix * glm::vec3(vertex[3], vertex[4], vertex[5]);
+            varyings[0] = fragPos.x; varyings[1] = fragPos.y; varyings[2] = fragPos.z;
+            varyings[3] = normal.x; varyings[4] = normal.y; varyings[5] = normal.z;
+            varyings[6] = vertex[6]; varyings[7] = vertex[7];
+            return viewProjection * glm::vec4(fragPos, 1.0f);
+        };
+
+        // spotlightFrag.glsl, textures are sampled per fragment and the lighting runs SIMD wide over the batch
+        auto fragmentShader = [&](SoftwareRasterizer::FragmentBatch& batch) {
+            alignas(32) float maps[9][RASTER_FRAGMENT_BATCH];
+            for (int lane = 0; lane < batch.count; lane++) {
+                glm::vec2 texCoords(batch.varyings[6][lane], batch.varyings[7][lane]);
+                glm::vec4 diffuseColor = diffuseMap.sample(texCoords);
+                glm::vec4 specularColor = specularMap.sample(texCoords);
+                glm::vec4 emissionColor = emissionMap.sample(texCoords);
+                for (int c = 0; c < 3; c++) {
+                    maps[c][lane] = diffuseColor[c];
+                    maps[3 + c][lane] = specularColor[c];
+                    maps[6 + c][lane] = emissionColor[c];
+                }
+                batch.color[3][lane] = 1.0f;
+            }
+
+            LightingFragments fragments = {
+                { batch.varyings[0], batch.varyings[1], batch.varyings[2] },
+                { batch.varyings[3], batch.varyings[4], batch.varyings[5] },
+                { maps[0], maps[1], maps[2] },
+                { maps[3], maps[4], maps[5] },
+                { maps[6], maps[7], maps[8] },
+                { batch.color[0], batch.color[1], batch.color[2] },
+                batch.count
+            };
+            shadeSpotLight(light, camera.Pos, emmisiveness, fragments);
+        };
+
+        rasterizer.drawArraysBatched(vertices, 8, 0, 36, 8, vertexShader, fragmentShader);
+    }
+
+    // lamp cube, lightSourceFrag.glsl is plain white
+    glm::mat4 lightMVP = projection * view * lightModel;
+    rasterizer.drawArrays(vertices, 8, 0, 36, 0,
+        [&](const float* vertex, float*) { return lightMVP * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f); },
+        [](const float*) { return glm::vec4(1.0f); });
+
+    auto end = std::chrono::high_resolution_clock::now();
+    printf("rendered %dx%d in %.3f ms on %d threads: %lld triangles, %lld rasterized, %lld fragments\n",
+        width, height, std::chrono::duration<double, std::milli>(end - start).count(), pool.size(),
+        rasterizer.stats.triangles, rasterizer.stats.rasterized, rasterizer.stats.fragments);
+
+    if (!framebuffer.savePPM(outputPath)) {
+        std::cout << "Failed to write " << outputPath << std::endl;
+        return -1;
+    }
+    std::cout << "wrote " << outputPath << std::endl;
+    return 0;
+}
+
+// Random small triangles over a 1080p target with a Gouraud colored fragment shader
+void triangleBenchmark()
+{
+    const int width = 1920, height = 1080;
+    const int triangleCount = 1000000;
+    const float triangleSize = 0.02f; // NDC units, roughly 20x10 pixels
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-1.0f, 1.0f), offset(-triangleSize, triangleSize), unit(0.0f, 1.0f);
+
+    // x, y, z, r, g, b
+    std::vector<float> triangleVertices(triangleCount * 3 * 6);
+    for (int t = 0; t < triangleCount; t++) {
+        float cx = position(random), cy = position(random), z = unit(random) * 2.0f - 1.0f;
+        for (int k = 0; k < 3; k++) {
+            float* v = &triangleVertices[(t * 3 + k) * 6];
+            v[0] = cx + offset(random);
+            v[1] = cy + offset(random);
+            v[2] = z;
+            v[3] = unit(random);
+            v[4] = unit(random);
+            v[5] = unit(random);
+        }
+    }
+
+    auto vertexShader = [](const float* vertex, float* varyings) {
+        varyings[0] = vertex[3]; varyings[1] = vertex[4]; varyings[2] = vertex[5];
+        return glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f);
+    };
+    auto fragmentShader = [](const float* varyings) {
+        return glm::vec4(varyings[0], varyings[1], varyings[2], 1.0f);
+    };
+
+    printf("%d triangles, %dx%d\n", triangleCount, width, height);
+    printf("threads   ms/frame   Mtri/s   Mtri/s/thread   Mfrag/s\n");
+
+    // 1, 2, 4, ... below the core count, then the core count itself
+    int maxThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    for (int threads : threadCounts) {
+        ThreadPool pool(threads - 1);
+        SoftwareRasterizer rasterizer(pool);
+        SoftwareFramebuffer framebuffer(width, height);
+        rasterizer.setFramebuffer(&framebuffer);
+
+        const int frames = 3;
+        double best = 1e30;
+        for (int frame = 0; frame < frames; frame++) {
+            framebuffer.clear(glm::vec4(0.0f));
+            rasterizer.stats = SoftwareRasterizer::Stats();
+            auto start = std::chrono::high_resolution_clock::now();
+            rasterizer.drawArrays(triangleVertices.data(), 6, 0, triangleCount * 3, 3, vertexShader, fragmentShader);
+            auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double>(end - start).count());
+        }
+
+        double mtris = triangleCount / best / 1e6;
+        printf("%7d   %8.2f   %6.2f   %13.2f   %7.1f\n", threads, best * 1000.0, mtris, mtris / threads,
+            rasterizer.stats.fragments / best / 1e6);
+    }
+}
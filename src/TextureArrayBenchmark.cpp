@@ -0,0 +1,407 @@
+// TextureArray batching against binding every material's maps separately. Cubes on a grid cycle through materials
+// made of the resources' images (diffuse, specular, emission), drawn with spotlightFrag.glsl's lighting three ways:
+// a draw per cube with its three maps bound, instances sorted by material with a draw per material, and all of
+// them in one instanced draw reading the maps from a TextureArray. Also packs a few hundred small random sized
+// images to show what the gutters cost, and compares the one draw's frame against the per material frame.
+//
+//   TextureArrayBenchmark [maxInstances] [materials]      (defaults 100000, 32)
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include "Shader.h"
+#include "GLExtensions.h"
+#include "MeshBuilder.h"
+#include "VertexPacking.h"
+#include "TextureLoader.h"
+#include "TextureArray.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+const int MAX_MATERIALS = 32; // arrayLightingMapVert.glsl's table
+const int SCREEN_WIDTH = 800, SCREEN_HEIGHT = 600;
+
+float vertices[] = {
+    // positions          // normals           // texture coords
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f, 1.0f,   0.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+};
+
+const char* images[] = {
+    "resources/container2.png",
+    "resources/container2_specular.png",
+    "resources/7a9.jpg",
+    "resources/gator.png",
+    "resources/ap.png",
+    "resources/094C.png",
+    "resources/drake.jpg",
+};
+const int IMAGE_COUNT = sizeof(images) / sizeof(images[0]);
+
+// Per instance vertex data for lightingMapVert.glsl, plus the material arrayLightingMapVert.glsl looks up
+struct CubeInstance {
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+    int material;
+};
+
+// Indices into images for each map
+struct Material {
+    int diffuse, specular, emission;
+};
+
+struct FrameTiming {
+    int draws;
+    double submitMs; // CPU time spent binding and issuing the draws
+    double frameMs;  // until the GPU finished the frame
+};
+
+// Averages at least 5 frames and half a second, after 2 warm up frames
+template<class Submit>
+FrameTiming timeFrames(GLFWwindow* window, int draws, Submit submit)
+{
+    FrameTiming total = { draws, 0.0, 0.0 };
+    int frames = 0;
+    for (int frame = -2; frame < 5 || total.frameMs < 500.0; frame++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        submit();
+        auto submitted = std::chrono::high_resolution_clock::now();
+        glFinish();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+
+        if (frame >= 0) {
+            total.submitMs += std::chrono::duration<double, std::milli>(submitted - start).count();
+            total.frameMs += std::chrono::duration<double, std::milli>(end - start).count();
+            frames++;
+        }
+    }
+    total.submitMs /= frames;
+    total.frameMs /= frames;
+    return total;
+}
+
+// Cubes on a grid that starts in front of the camera and runs down -z, sorted by material
+std::vector<CubeInstance> benchmarkInstances(int count, int materials, const glm::mat4& positionTransform)
+{
+    int side = (int)std::ceil(std::cbrt((double)count));
+    const float spacing = 1.5f;
+
+    std::vector<CubeInstance> instances(count);
+    for (int i = 0; i < count; i++) {
+        int x = i % side, y = (i / side) % side, z = i / (side * side);
+        glm::vec3 position((x - side * 0.5f) * spacing, (y - side * 0.5f) * spacing, -z * spacing);
+        glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), position), glm::radians(20.0f * i), glm::vec3(1.0f, 0.3f, 0.5f));
+        instances[i].normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
+        instances[i].model = model * positionTransform;
+        instances[i].material = i % materials;
+    }
+    std::stable_sort(instances.begin(), instances.end(), [](const CubeInstance& a, const CubeInstance& b) {
+        return a.material < b.material;
+    });
+    return instances;
+}
+
+void setLighting(Shader& shader)
+{
+    shader.use();
+    shader.setMat4("view", glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    shader.setMat4("projection", glm::perspective(glm::radians(45.0f), (float)SCREEN_WIDTH / SCREEN_HEIGHT, 0.1f, 1000.0f));
+    shader.setVec3("viewPos", glm::vec3(0.0f, 0.0f, 3.0f));
+    shader.setVec3("light.position", glm::vec3(0.0f, 0.0f, 3.0f));
+    shader.setVec3("light.direction", glm::vec3(0.0f, 0.0f, -1.0f));
+    shader.setVec3("light.ambient", glm::vec3(0.2f));
+    shader.setVec3("light.diffuse", glm::vec3(0.5f));
+    shader.setVec3("light.specular", glm::vec3(1.0f));
+    shader.setFloat("light.constant", 1.0f);
+    shader.setFloat("light.linear", 0.09f);
+    shader.setFloat("light.quadratic", 0.032f);
+    // wider than LightCasters' so most of the grid is lit
+    shader.setFloat("light.cutOff", glm::cos(glm::radians(30.0f)));
+    shader.setFloat("light.outerCutOff", glm::cos(glm::radians(40.0f)));
+    shader.setFloat("material.shininess", 64.0f);
+    shader.setFloat("material.emmisiveness", 0.3f);
+}
+
+// Random 16 to 128 texel images, to see how well small textures pack at a few gutter widths
+void packingEfficiency(ThreadPool& pool)
+{
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<int> side(16, 128);
+    std::vector<std::vector<unsigned char>> sprites(400);
+    std::vector<glm::ivec2> sizes(sprites.size());
+    for (size_t i = 0; i < sprites.size(); i++) {
+        sizes[i] = glm::ivec2(side(random), side(random));
+        sprites[i].assign((size_t)sizes[i].x * sizes[i].y * 3, (unsigned char)(i * 37));
+    }
+    printf("%d small images, 1024 x 1024 layers\n", (int)sprites.size());
+    for (int padding : { 1, 4, 8 }) {
+        TextureArray atlas(1024, padding);
+        for (size_t i = 0; i < sprites.size(); i++) {
+            atlas.add(sprites[i].data(), sizes[i].x, sizes[i].y, 3);
+        }
+        atlas.build(&pool);
+        printf("  gutter %d: ", padding);
+        atlas.report();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int maxInstances = argc > 1 ? std::max(1, atoi(argv[1])) : 100000;
+    int materialCount = argc > 2 ? std::min(std::max(1, atoi(argv[2])), MAX_MATERIALS) : MAX_MATERIALS;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Texture Array Benchmark", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+    if (!GLEXT_ARB_base_instance) {
+        std::cout << "ERROR::BENCHMARK::ARB_BASE_INSTANCE_MISSING" << std::endl;
+        return -1;
+    }
+
+    ThreadPool pool;
+    packingEfficiency(pool);
+
+    // every image as its own texture, and all of them in one array
+    TextureLoader loader(pool);
+    std::vector<unsigned int> textures;
+    TextureArray atlas;
+    std::vector<int> regions;
+    for (const char* path : images) {
+        textures.push_back(loader.load(path));
+        regions.push_back(atlas.add(path));
+        if (regions.back() < 0) {
+            return -1;
+        }
+    }
+    loader.finish();
+    if (!atlas.build(&pool)) {
+        return -1;
+    }
+    printf("resources, %dx%d layers\n  ", atlas.getStats().layerSize, atlas.getStats().layerSize);
+    atlas.report();
+
+    // the images combined differently for every material
+    std::vector<Material> materials(materialCount);
+    for (int m = 0; m < materialCount; m++) {
+        materials[m] = { m % IMAGE_COUNT, (m + 1 + m / IMAGE_COUNT) % IMAGE_COUNT, (m + 2 + 2 * (m / IMAGE_COUNT)) % IMAGE_COUNT };
+    }
+
+    Shader shader("shaders/LightingMapVert.glsl", "shaders/spotlightFrag.glsl");
+    Shader arrayShader("shaders/arrayLightingMapVert.glsl", "shaders/arraySpotlightFrag.glsl");
+    setLighting(shader);
+    shader.setInt("material.diffuse", 0);
+    shader.setInt("material.specular", 1);
+    shader.setInt("material.emission", 2);
+    setLighting(arrayShader);
+    arrayShader.setInt("material.maps", 3);
+
+    std::vector<glm::vec4> materialRegions;
+    std::vector<glm::vec3> materialLayers;
+    for (const Material& material : materials) {
+        const TextureArrayRegion& diffuse = atlas.region(regions[material.diffuse]);
+        const TextureArrayRegion& specular = atlas.region(regions[material.specular]);
+        const TextureArrayRegion& emission = atlas.region(regions[material.emission]);
+        materialRegions.push_back(diffuse.scaleOffset);
+        materialRegions.push_back(specular.scaleOffset);
+        materialRegions.push_back(emission.scaleOffset);
+        materialLayers.push_back(glm::vec3((float)diffuse.layer, (float)specular.layer, (float)emission.layer));
+    }
+    glUniform4fv(glGetUniformLocation(arrayShader.ID, "materialRegions"), (GLsizei)materialRegions.size(), glm::value_ptr(materialRegions[0]));
+    glUniform3fv(glGetUniformLocation(arrayShader.ID, "materialLayers"), (GLsizei)materialLayers.size(), glm::value_ptr(materialLayers[0]));
+
+    MeshBuilder cube(8);
+    cube.addTriangles(vertices, 36);
+    cube.optimize();
+    PackedMesh packedCube(cube.getVertices().data(), cube.vertexCount());
+
+    unsigned int VAO, VBO, EBO, instanceVBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glGenBuffers(1, &instanceVBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    packedCube.upload();
+    cube.uploadIndices();
+    PackedMesh::setAttributes();
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (int i = 0; i < 4; i++) { // model matrix columns
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)(offsetof(CubeInstance, model) + i * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1);
+    }
+    for (int i = 0; i < 3; i++) { // normal matrix columns
+        glVertexAttribPointer(7 + i, 3, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)(offsetof(CubeInstance, normalMatrix) + i * sizeof(glm::vec3)));
+        glEnableVertexAttribArray(7 + i);
+        glVertexAttribDivisor(7 + i, 1);
+    }
+    glVertexAttribIPointer(10, 1, GL_INT, sizeof(CubeInstance), (void*)offsetof(CubeInstance, material));
+    glEnableVertexAttribArray(10);
+    glVertexAttribDivisor(10, 1);
+
+    glActiveTexture(GL_TEXTURE3);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, atlas.id());
+    glEnable(GL_DEPTH_TEST);
+
+    auto bindMaterial = [&](int m) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, textures[materials[m].diffuse]);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, textures[materials[m].specular]);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, textures[materials[m].emission]);
+    };
+
+    // a draw per cube stops here, past it the submission alone takes seconds
+    const int maxPerCubeDraws = 100000;
+    int indexCount = cube.indexCount();
+    GLenum indexType = cube.indexType();
+
+    printf("\n%d materials from %d images, per cube and per material draws bind 3 textures each\n", materialCount, IMAGE_COUNT);
+    printf("instances      per cube: draws submit ms  frame ms    per material: draws submit ms  frame ms    array: draws submit ms  frame ms    fewer draws  speedup\n");
+    for (int count = 10; count <= maxInstances; count *= 10) {
+        std::vector<CubeInstance> instances = benchmarkInstances(count, materialCount, packedCube.positionTransform());
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(CubeInstance), instances.data(), GL_STATIC_DRAW);
+
+        // first instance and count of every material's run
+        std::vector<std::pair<int, int>> runs;
+        for (int i = 0; i < count; i++) {
+            if (runs.empty() || instances[runs.back().first].material != instances[i].material) {
+                runs.push_back({ i, 0 });
+            }
+            runs.back().second++;
+        }
+
+        FrameTiming perCube = { 0, 0.0, 0.0 };
+        if (count <= maxPerCubeDraws) {
+            shader.use();
+            perCube = timeFrames(window, count, [&] {
+                for (int i = 0; i < count; i++) {
+                    bindMaterial(instances[i].material);
+                    glext_glDrawElementsInstancedBaseInstance(GL_TRIANGLES, indexCount, indexType, 0, 1, i);
+                }
+            });
+        }
+
+        shader.use();
+        FrameTiming perMaterial = timeFrames(window, (int)runs.size(), [&] {
+            for (const std::pair<int, int>& run : runs) {
+                bindMaterial(instances[run.first].material);
+                glext_glDrawElementsInstancedBaseInstance(GL_TRIANGLES, indexCount, indexType, 0, run.second, run.first);
+            }
+        });
+        std::vector<unsigned char> perMaterialPixels((size_t)SCREEN_WIDTH * SCREEN_HEIGHT * 3);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, perMaterialPixels.data());
+
+        arrayShader.use();
+        FrameTiming array = timeFrames(window, 1, [&] {
+            glDrawElementsInstanced(GL_TRIANGLES, indexCount, indexType, 0, count);
+        });
+        std::vector<unsigned char> arrayPixels(perMaterialPixels.size());
+        glReadPixels(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, arrayPixels.data());
+
+        if (perCube.draws) {
+            printf("%9d    %15d %9.3f %9.3f    %19d %9.3f %9.3f    %12d %9.3f %9.3f    %10.0fx %7.2fx\n", count, perCube.draws,
+                perCube.submitMs, perCube.frameMs, perMaterial.draws, perMaterial.submitMs, perMaterial.frameMs, array.draws,
+                array.submitMs, array.frameMs, (double)perCube.draws / array.draws, perCube.frameMs / array.frameMs);
+        }
+        else {
+            printf("%9d    %15s %9s %9s    %19d %9.3f %9.3f    %12d %9.3f %9.3f    %10.0fx %7.2fx\n", count, "-", "-", "-",
+                perMaterial.draws, perMaterial.submitMs, perMaterial.frameMs, array.draws, array.submitMs, array.frameMs,
+                (double)perMaterial.draws / array.draws, perMaterial.frameMs / array.frameMs);
+        }
+
+        // the array's chain stops at the gutter's level, distant cubes are sharper (and noisier) than the full chains
+        int maxDifference = 0;
+        double totalDifference = 0.0;
+        for (size_t i = 0; i < arrayPixels.size(); i++) {
+            int difference = std::abs(arrayPixels[i] - perMaterialPixels[i]);
+            maxDifference = std::max(maxDifference, difference);
+            totalDifference += difference;
+        }
+        printf("             array frame against per material frame: mean difference %.3f, max %d\n",
+            totalDifference / arrayPixels.size(), maxDifference);
+    }
+
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteTextures((GLsizei)textures.size(), textures.data());
+    atlas.release();
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,135 @@
+// TextureCache against loading every scene's textures from scratch. The scenes are the texture sets of the demos,
+// plus one that reaches 7a9.jpg through a copy under another name, switched between round robin SWITCHES times
+// with only the current scene's textures referenced. The cache runs without a budget and with half of the
+// unlimited run's peak, which forces evictions.
+//
+//   TextureCacheBenchmark [switches]
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include "TextureCache.h"
+
+struct Scene {
+    const char* name;
+    std::vector<std::string> textures;
+};
+
+struct Run {
+    double ms;
+    TextureLoaderStats loader;
+    TextureCacheStats cache;
+};
+
+Run runUncached(const std::vector<Scene>& scenes, int switches, ThreadPool& pool)
+{
+    TextureLoader textures(pool);
+    std::vector<unsigned int> current;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < switches; i++) {
+        std::vector<unsigned int> next;
+        for (const std::string& path : scenes[i % scenes.size()].textures) {
+            next.push_back(textures.load(path.c_str()));
+        }
+        textures.finish();
+        glDeleteTextures((GLsizei)current.size(), current.data());
+        current = next;
+    }
+    glFinish();
+    Run run = { std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count(), textures.getStats(), {} };
+    glDeleteTextures((GLsizei)current.size(), current.data());
+    return run;
+}
+
+Run runCached(const std::vector<Scene>& scenes, int switches, ThreadPool& pool, size_t budget)
+{
+    TextureLoader textures(pool);
+    TextureCache cache(textures, budget);
+    std::vector<TextureHandle> current;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < switches; i++) {
+        std::vector<TextureHandle> next;
+        for (const std::string& path : scenes[i % scenes.size()].textures) {
+            next.push_back(cache.acquire(path.c_str()));
+        }
+        textures.finish();
+        current = next; // the last scene's handles go here, what they leave unreferenced becomes evictable
+    }
+    glFinish();
+    Run run = { std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count(), textures.getStats(), cache.getStats() };
+    current.clear();
+    cache.trim();
+    return run;
+}
+
+void printRun(const char* name, const Run& run, int switches)
+{
+    printf("%-22s %9.2f %9.3f %9d %9.1f %7d %7d %7d %7d %10.1f %8.3f\n", name, run.ms, run.ms / switches, run.loader.textures,
+        run.loader.bytes / (1024.0 * 1024.0), run.cache.hits, run.cache.deduplicated, run.cache.misses, run.cache.evictions,
+        run.cache.peakBytes / 1024.0, run.cache.hashMs);
+}
+
+int main(int argc, char** argv)
+{
+    int switches = argc > 1 ? std::max(1, atoi(argv[1])) : 50;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 600, "Texture Cache Benchmark", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // same bytes, different path
+    std::error_code error;
+    std::string copy = (std::filesystem::temp_directory_path() / "OpenGLearn 7a9 copy.jpg").string();
+    std::filesystem::copy_file("resources/7a9.jpg", copy, std::filesystem::copy_options::overwrite_existing, error);
+    if (error) {
+        std::cout << "ERROR::BENCHMARK::COPY_FAILED " << copy << std::endl;
+        return -1;
+    }
+
+    std::vector<Scene> scenes = {
+        { "Transformations", { "resources/7a9.jpg" } },
+        { "LightingMap", { "resources/container2.png", "resources/gator.png", "resources/7a9.jpg" } },
+        { "TextureTest", { "resources/ap.png" } },
+        { "LightCasters", { "resources/container2.png", "resources/container2_specular.png", "resources/7a9.jpg" } },
+        { "CameraTest (copy)", { copy } },
+    };
+
+    ThreadPool pool;
+    // warm the file cache so the first run isn't the only one reading from disk
+    runUncached(scenes, (int)scenes.size(), pool);
+
+    printf("%d scene switches over %d scenes, pool of %d threads\n", switches, (int)scenes.size(), pool.size());
+    printf("%-22s %9s %9s %9s %9s %7s %7s %7s %7s %10s %8s\n", "", "ms", "ms/switch", "textures", "MB upload", "hits",
+        "content", "misses", "evicted", "peak KB", "hash ms");
+    printRun("no cache", runUncached(scenes, switches, pool), switches);
+    Run unlimited = runCached(scenes, switches, pool, SIZE_MAX);
+    printRun("cache, no budget", unlimited, switches);
+    char name[64];
+    size_t budget = unlimited.cache.peakBytes / 2;
+    snprintf(name, sizeof(name), "cache, %.0f KB budget", budget / 1024.0);
+    printRun(name, runCached(scenes, switches, pool, budget), switches);
+
+    std::filesystem::remove(copy, error);
+    glfwTerminate();
+    return 0;
+}
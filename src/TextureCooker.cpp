@@ -0,0 +1,77 @@
+// Offline step for TextureFile: decodes images once and writes <image>.tex next to each, full mip chain included.
+// TextureLoader uploads those instead of decoding as long as they are newer than the image.
+// --bc1/--bc3/--bc7 block compress every level, --bc picks BC1 for opaque images and BC7 for the rest.
+// Mips are box filtered in linear light by default, --linear filters data textures (normals, masks) as stored
+// and --kaiser sharpens (MipGenerator).
+//
+//   TextureCooker [--flip] [--linear] [--kaiser] [--bc | --bc1 | --bc3 | --bc7] [image ...]   (no images: all of resources/)
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include "TextureFile.h"
+
+int main(int argc, char** argv)
+{
+    TextureCookSettings settings;
+    std::vector<std::string> sources;
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--flip") {
+            settings.flipVertically = true;
+        }
+        else if (argument == "--linear") {
+            settings.srgb = false;
+        }
+        else if (argument == "--kaiser") {
+            settings.mipFilter = MIP_FILTER_KAISER;
+        }
+        else if (argument == "--bc") {
+            settings.compression = TEXTURE_COMPRESSION_BC_AUTO;
+        }
+        else if (argument == "--bc1") {
+            settings.compression = TEXTURE_COMPRESSION_BC1;
+        }
+        else if (argument == "--bc3") {
+            settings.compression = TEXTURE_COMPRESSION_BC3;
+        }
+        else if (argument == "--bc7") {
+            settings.compression = TEXTURE_COMPRESSION_BC7;
+        }
+        else {
+            sources.push_back(argv[i]);
+        }
+    }
+    if (sources.empty()) {
+        for (const auto& entry : std::filesystem::directory_iterator("resources")) {
+            std::string extension = entry.path().extension().string();
+            if (extension == ".png" || extension == ".jpg") {
+                sources.push_back(entry.path().string());
+            }
+        }
+        std::sort(sources.begin(), sources.end());
+    }
+
+    ThreadPool pool;
+    int failed = 0;
+    printf("%-32s %12s %12s %8s %10s\n", "", "source KB", "cooked KB", "levels", "ms");
+    for (const std::string& source : sources) {
+        std::string destination = TextureFile::cookedPath(source);
+        auto start = std::chrono::high_resolution_clock::now();
+        if (!TextureFile::cook(source.c_str(), destination.c_str(), settings, &pool)) {
+            failed++;
+            continue;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        int width, height, components;
+        stbi_info(source.c_str(), &width, &height, &components);
+        printf("%-32s %12.1f %12.1f %8d %10.2f\n", source.c_str(), std::filesystem::file_size(source) / 1024.0,
+            std::filesystem::file_size(destination) / 1024.0, TextureFile::mipCount(width, height), ms);
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+// Load time of resources/*.png|jpg through stb_image + glGenerateMipmap (the demos' loadImage) against cooked
+// TextureFile containers mapped and uploaded level by level. Cold runs drop both sets of files from the page cache
+// first (posix_fadvise, Linux only), warm runs read them from memory. Median of REPEATS runs each.
+// Also checks the cooked mip chain against what glGenerateMipmap makes from the same image.
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include "TextureFile.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const int REPEATS = 5;
+
+// False where the platform can't do it, the cold rows are skipped then
+bool evictFromPageCache(const std::string& path)
+{
+#ifdef __linux__
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    bool evicted = posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(descriptor);
+    return evicted;
+#else
+    return false;
+#endif
+}
+
+unsigned int loadImage(char const* path)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrComponents;
+    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+    if (data)
+    {
+        GLenum format = GL_RGBA;
+        if (nrComponents == 1)
+            format = GL_RED;
+        else if (nrComponents == 2)
+            format = GL_RG;
+        else if (nrComponents == 3)
+            format = GL_RGB;
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        stbi_image_free(data);
+    }
+    else
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+    }
+
+    return textureID;
+}
+
+// Largest channel difference between level of two RGBA readbacks
+int levelDifference(unsigned int a, unsigned int b, int level)
+{
+    int width, height;
+    glBindTexture(GL_TEXTURE_2D, a);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+    std::vector<unsigned char> pixelsA((size_t)width * height * 4), pixelsB(pixelsA.size());
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, pixelsA.data());
+    glBindTexture(GL_TEXTURE_2D, b);
+    glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, pixelsB.data());
+    int difference = 0;
+    for (size_t i = 0; i < pixelsA.size(); i++) {
+        difference = std::max(difference, std::abs(pixelsA[i] - pixelsB[i]));
+    }
+    return difference;
+}
+
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 600, "Texture File Benchmark", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // cooked into the temp directory so the benchmark leaves resources/ alone
+    std::filesystem::path cookedDirectory = std::filesystem::temp_directory_path() / "OpenGLearnCooked";
+    std::filesystem::create_directories(cookedDirectory);
+    std::vector<std::string> sources, cooked;
+    for (const auto& entry : std::filesystem::directory_iterator("resources")) {
+        std::string extension = entry.path().extension().string();
+        if (extension == ".png" || extension == ".jpg") {
+            sources.push_back(entry.path().string());
+        }
+    }
+    std::sort(sources.begin(), sources.end());
+    size_t sourceBytes = 0, cookedBytes = 0;
+    for (const std::string& source : sources) {
+        std::string destination = TextureFile::cookedPath((cookedDirectory / std::filesystem::path(source).filename()).string());
+        if (!TextureFile::cook(source.c_str(), destination.c_str())) {
+            glfwTerminate();
+            return -1;
+        }
+        cooked.push_back(destination);
+        sourceBytes += std::filesystem::file_size(source);
+        cookedBytes += std::filesystem::file_size(destination);
+    }
+
+    auto loadSources = [&](std::vector<unsigned int>& textures) {
+        for (const std::string& source : sources) {
+            textures.push_back(loadImage(source.c_str()));
+        }
+    };
+    auto loadCooked = [&](std::vector<unsigned int>& textures) {
+        for (const std::string& file : cooked) {
+            unsigned int texture;
+            glGenTextures(1, &texture);
+            TextureFile::upload(file.c_str(), texture);
+            textures.push_back(texture);
+        }
+    };
+
+    bool canEvict = true;
+    auto median = [&](auto load, bool cold) {
+        std::vector<double> times;
+        for (int repeat = 0; repeat < REPEATS; repeat++) {
+            if (cold) {
+                for (const std::string& file : sources) {
+                    canEvict = evictFromPageCache(file) && canEvict;
+                }
+                for (const std::string& file : cooked) {
+                    canEvict = evictFromPageCache(file) && canEvict;
+                }
+            }
+            std::vector<unsigned int> textures;
+            auto start = std::chrono::high_resolution_clock::now();
+            load(textures);
+            glFinish();
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+            glDeleteTextures((GLsizei)textures.size(), textures.data());
+        }
+        std::sort(times.begin(), times.end());
+        return times[REPEATS / 2];
+    };
+
+    double sourceWarm = median(loadSources, false);
+    double cookedWarm = median(loadCooked, false);
+    double sourceCold = median(loadSources, true);
+    double cookedCold = median(loadCooked, true);
+
+    printf("%zu images, %.1f KB as png/jpg, %.1f KB cooked with mips, median of %d\n", sources.size(), sourceBytes / 1024.0,
+        cookedBytes / 1024.0, REPEATS);
+    printf("%-34s %10s %10s\n", "", "warm ms", "cold ms");
+    if (canEvict) {
+        printf("%-34s %10.2f %10.2f\n", "stbi_load + glGenerateMipmap", sourceWarm, sourceCold);
+        printf("%-34s %10.2f %10.2f\n", "mapped TextureFile", cookedWarm, cookedCold);
+    }
+    else {
+        printf("%-34s %10.2f %10s\n", "stbi_load + glGenerateMipmap", sourceWarm, "-");
+        printf("%-34s %10.2f %10s\n", "mapped TextureFile", cookedWarm, "-");
+        printf("(no page cache eviction on this platform, cold runs measured warm)\n");
+    }
+    printf("speedup warm %.2fx\n", sourceWarm / cookedWarm);
+
+    // the cooked chain should match the driver's up to rounding, except where a level has an odd size: there the
+    // spec leaves the filter to the implementation: MipGenerator averages the covered area, llvmpipe for one resamples
+    printf("%-34s %10s\n", "max difference to glGenerateMipmap", "level 1");
+    for (size_t i = 0; i < sources.size(); i++) {
+        std::vector<unsigned int> textures;
+        textures.push_back(loadImage(sources[i].c_str()));
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        TextureFile::upload(cooked[i].c_str(), texture);
+        textures.push_back(texture);
+        printf("%-34s %10d\n", sources[i].c_str(), levelDifference(textures[0], textures[1], 1));
+        glDeleteTextures(2, textures.data());
+    }
+
+    glfwTerminate();
+    return 0;
+}
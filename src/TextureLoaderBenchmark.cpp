@@ -0,0 +1,162 @@
+// Startup cost of loading every image in resources/ (several copies of each, to stand in for a bigger scene).
+// The serial baseline is the demos' old loadImage(): stbi_load and glTexImage2D one after the other on the GL thread.
+// TextureLoader then runs with 0 workers up to one per core, reporting wall time and how long the GL thread was busy.
+//
+//   TextureLoaderBenchmark [copies]
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <filesystem>
+#include "TextureLoader.h"
+
+double millisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+unsigned int loadImage(char const* path, size_t& bytes)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    int width, height, nrComponents;
+    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+    if (data)
+    {
+        GLenum format = GL_RGBA;
+        if (nrComponents == 1)
+            format = GL_RED;
+        else if (nrComponents == 2)
+            format = GL_RG;
+        else if (nrComponents == 3)
+            format = GL_RGB;
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        bytes += (size_t)width * height * nrComponents;
+        stbi_image_free(data);
+    }
+    else
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+    }
+
+    return textureID;
+}
+
+int main(int argc, char** argv)
+{
+    int copies = argc > 1 ? std::max(atoi(argv[1]), 1) : 4;
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 600, "Texture Loader Benchmark", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    std::vector<std::string> files;
+    for (const auto& entry : std::filesystem::directory_iterator("resources")) {
+        std::string extension = entry.path().extension().string();
+        if (extension == ".png" || extension == ".jpg") {
+            files.push_back(entry.path().string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    std::vector<std::string> paths;
+    for (int copy = 0; copy < copies; copy++) {
+        paths.insert(paths.end(), files.begin(), files.end());
+    }
+    if (files.empty()) {
+        std::cout << "ERROR::BENCHMARK::NO_IMAGES_IN_RESOURCES" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    std::vector<unsigned int> textures;
+    auto deleteTextures = [&textures] {
+        glFinish();
+        glDeleteTextures((GLsizei)textures.size(), textures.data());
+        textures.clear();
+    };
+
+    printf("%zu textures (%zu files x %d)\n", paths.size(), files.size(), copies);
+    printf("%-22s %10s %12s %12s %12s %9s\n", "", "wall ms", "GL thread ms", "waiting ms", "decode ms", "MB/s");
+
+    // untimed pass so every row reads the files from the page cache
+    size_t bytes = 0;
+    for (const std::string& path : files) {
+        textures.push_back(loadImage(path.c_str(), bytes));
+    }
+    deleteTextures();
+
+    bytes = 0;
+    auto serialStart = std::chrono::high_resolution_clock::now();
+    for (const std::string& path : paths) {
+        textures.push_back(loadImage(path.c_str(), bytes));
+    }
+    glFinish();
+    double serialMs = millisecondsSince(serialStart);
+    printf("%-22s %10.2f %12.2f %12s %12s %9.1f\n", "loadImage, serial", serialMs, serialMs, "-", "-", bytes / serialMs / 1000.0);
+    deleteTextures();
+
+    // 0 workers decodes inline inside load(), then powers of two up to one worker per spare core
+    int maxWorkers = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+    std::vector<int> workerCounts = { 0 };
+    for (int workers = 1; workers < maxWorkers; workers *= 2) {
+        workerCounts.push_back(workers);
+    }
+    workerCounts.push_back(maxWorkers);
+
+    for (int workers : workerCounts) {
+        ThreadPool pool(workers);
+        TextureLoader loader(pool);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const std::string& path : paths) {
+            textures.push_back(loader.load(path.c_str()));
+        }
+        double queueMs = millisecondsSince(start);
+        loader.finish();
+        glFinish();
+        double wallMs = millisecondsSince(start);
+
+        const TextureLoaderStats& stats = loader.getStats();
+        char label[64];
+        snprintf(label, sizeof(label), "TextureLoader, %d+1", workers);
+        printf("%-22s %10.2f %12.2f %12.2f %12.2f %9.1f\n", label, wallMs, queueMs + stats.uploadMs - stats.waitMs, stats.waitMs,
+            stats.decodeMs, stats.bytes / wallMs / 1000.0);
+        deleteTextures();
+    }
+
+    glfwTerminate();
+    return 0;
+}
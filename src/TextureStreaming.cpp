@@ -0,0 +1,200 @@
+// TextureStreamer on one huge texture: gator.png tiled (and tinted per tile) up to size x size, cooked once into the
+// temp directory, on a ground plane the camera flies low over. Only the pages the feedback pass asks for are
+// resident, so texture memory stays at the budget whatever size is. Prints the streamer's counters every second.
+//
+//   TextureStreaming [size] [budget MB] [--no-sparse]      (defaults 8192, 16)
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <filesystem>
+#include "Shader.h"
+#include "GLExtensions.h"
+#include "TextureStreamer.h"
+#include "stb_image.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+
+const float PLANE_SIZE = 200.0f;
+
+// ground plane, the whole texture across it once
+float vertices[] = {
+    -0.5f, 0.0f, -0.5f,  0.0f, 1.0f,
+     0.5f, 0.0f, -0.5f,  1.0f, 1.0f,
+     0.5f, 0.0f,  0.5f,  1.0f, 0.0f,
+     0.5f, 0.0f,  0.5f,  1.0f, 0.0f,
+    -0.5f, 0.0f,  0.5f,  0.0f, 0.0f,
+    -0.5f, 0.0f, -0.5f,  0.0f, 1.0f
+};
+
+int screenWidth = 800, screenHeight = 600;
+
+// Tiles source over size x size RGB, every tile a little differently tinted so the levels are told apart
+bool cookTiled(const char* source, int size, const char* destination, ThreadPool& pool)
+{
+    int width, height, components;
+    unsigned char* pixels = stbi_load(source, &width, &height, &components, 3);
+    if (!pixels) {
+        std::cout << "Texture failed to load at path: " << source << std::endl;
+        return false;
+    }
+    std::vector<unsigned char> tiled((size_t)size * size * 3);
+    pool.parallelFor(size, [&](int y) {
+        for (int x = 0; x < size; x++) {
+            int tile = (y / height) * 7 + (x / width) * 3;
+            const unsigned char* in = &pixels[((size_t)(y % height) * width + x % width) * 3];
+            unsigned char* out = &tiled[((size_t)y * size + x) * 3];
+            for (int c = 0; c < 3; c++) {
+                out[c] = (unsigned char)std::min(255, in[c] * (160 + (tile * (c + 5)) % 96) / 224);
+            }
+        }
+    });
+    stbi_image_free(pixels);
+    return TextureFile::cook(tiled.data(), size, size, 3, destination, TextureCookSettings(), &pool);
+}
+
+int main(int argc, char** argv)
+{
+    int size = 8192, budgetMB = 16;
+    bool allowSparse = true;
+    std::vector<int> numbers;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--no-sparse") {
+            allowSparse = false;
+        }
+        else {
+            numbers.push_back(atoi(argv[i]));
+        }
+    }
+    if (numbers.size() > 0 && numbers[0] > 0) {
+        size = numbers[0];
+    }
+    if (numbers.size() > 1 && numbers[1] > 0) {
+        budgetMB = numbers[1];
+    }
+
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow* window = glfwCreateWindow(screenWidth, screenHeight, "Texture Streaming", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetKeyCallback(window, key_callback);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+
+    ThreadPool pool;
+    std::string cooked = (std::filesystem::temp_directory_path() / ("OpenGLearnStreaming" + std::to_string(size) + ".tex")).string();
+    if (!std::filesystem::exists(cooked)) {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (!cookTiled("resources/gator.png", size, cooked.c_str(), pool)) {
+            return -1;
+        }
+        printf("cooked %s in %.0f ms\n", cooked.c_str(),
+            std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+    }
+
+    TextureStreamer streamer(pool, (size_t)budgetMB * 1024 * 1024, allowSparse);
+    int terrain = streamer.add(cooked.c_str());
+    if (terrain < 0) {
+        return -1;
+    }
+
+    Shader shader("shaders/transVert.glsl", "shaders/virtualTextureFrag.glsl");
+    Shader feedbackShader("shaders/transVert.glsl", "shaders/virtualTextureFeedbackFrag.glsl");
+
+    unsigned int VAO, VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+
+    glm::mat4 model = glm::scale(glm::mat4(1.0f), glm::vec3(PLANE_SIZE));
+    glEnable(GL_DEPTH_TEST);
+
+    double lastReport = glfwGetTime();
+    while (!glfwWindowShouldClose(window))
+    {
+        // low over the plane on a slow circle, looking ahead and down
+        float time = static_cast<float>(glfwGetTime());
+        glm::vec3 position(std::cos(time * 0.05f) * PLANE_SIZE * 0.3f, 2.0f, std::sin(time * 0.05f) * PLANE_SIZE * 0.3f);
+        glm::vec3 ahead(-std::sin(time * 0.05f), -0.35f, std::cos(time * 0.05f));
+        glm::mat4 view = glm::lookAt(position, position + ahead, glm::vec3(0.0f, 1.0f, 0.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)screenWidth / (float)screenHeight, 0.1f, 500.0f);
+
+        streamer.beginFeedback(screenWidth, screenHeight);
+        feedbackShader.use();
+        feedbackShader.setMat4("model", model);
+        feedbackShader.setMat4("view", view);
+        feedbackShader.setMat4("projection", projection);
+        streamer.bind(terrain, feedbackShader.ID, 0);
+        glBindVertexArray(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        streamer.endFeedback();
+        streamer.update();
+
+        glClearColor(0.5f, 0.7f, 0.9f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        shader.use();
+        shader.setMat4("model", model);
+        shader.setMat4("view", view);
+        shader.setMat4("projection", projection);
+        streamer.bind(terrain, shader.ID, 0);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+
+        if (glfwGetTime() - lastReport >= 1.0) {
+            streamer.report();
+            lastReport = glfwGetTime();
+        }
+    }
+    streamer.report();
+
+    streamer.release();
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glfwTerminate();
+    return 0;
+}
+
+//Resizes viewport when window is resized
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    screenWidth = width;
+    screenHeight = height;
+    glViewport(0, 0, width, height);
+}
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (key == GLFW_KEY_ESCAPE && action == GLFW_RELEASE) {
+        glfwSetWindowShouldClose(window, true);
+    }
+}
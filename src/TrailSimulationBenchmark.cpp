@@ -0,0 +1,145 @@
+// TrailSimulation from 10 thousand up to 10 million particles: what the compute pass that integrates the particles
+// and writes their lines costs against drawing those lines, each timed with GL_TIME_ELAPSED queries, next to
+// drawing the same number of lines with LineTrails' instanced vertex shader path that works out positions in the
+// vertex shader from TrailParticles. Every pass is also timed on the wall clock up to a glFinish, since some
+// drivers (software ones especially) answer timer queries coarsely. Runs headless at 800x600.
+//
+//   TrailSimulationBenchmark [maxParticles]      (default 10000000)
+
+#include <glad/glad.h>
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include "HeadlessContext.h"
+#include "Shader.h"
+#include "GLExtensions.h"
+#include "ThreadPool.h"
+#include "TrailParticles.h"
+#include "TrailSimulation.h"
+
+const int SCREEN_WIDTH = 800, SCREEN_HEIGHT = 600;
+const float TIMESTEP = 1.0f / 60.0f;
+const float TRAIL_LENGTH = 0.1f;
+
+struct PassTiming {
+    double gpuMs = 0.0;
+    double wallMs = 0.0;
+};
+
+// Averages at least 5 runs and half a second of pass, after 2 warm up runs
+template<class Pass>
+PassTiming timePass(unsigned int query, Pass pass)
+{
+    PassTiming total;
+    int runs = 0;
+    for (int run = -2; run < 5 || total.wallMs < 500.0; run++) {
+        glFinish();
+        auto start = std::chrono::high_resolution_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        pass();
+        glEndQuery(GL_TIME_ELAPSED);
+        glFinish();
+        auto end = std::chrono::high_resolution_clock::now();
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        if (run >= 0) {
+            total.gpuMs += elapsed / 1e6;
+            total.wallMs += std::chrono::duration<double, std::milli>(end - start).count();
+            runs++;
+        }
+    }
+    total.gpuMs /= runs;
+    total.wallMs /= runs;
+    return total;
+}
+
+int main(int argc, char** argv)
+{
+    int maxParticles = argc > 1 ? atoi(argv[1]) : 10000000;
+
+    HeadlessContext context;
+    if (!context.create(4, 5) || !gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    loadGLExtensions((GLADloadproc)HeadlessContext::getProcAddress);
+    printf("%s, %dx%d\n", (const char*)glGetString(GL_RENDERER), SCREEN_WIDTH, SCREEN_HEIGHT);
+    if (!GLEXT_ARB_compute_shader) {
+        std::cout << "ERROR::TRAIL_SIMULATION::NO_COMPUTE_SHADERS" << std::endl;
+        return -1;
+    }
+
+    // the lines accumulate in a texture, as in LineTrails' lines pass
+    unsigned int trailFBO, trailTexture;
+    glGenTextures(1, &trailTexture);
+    glBindTexture(GL_TEXTURE_2D, trailTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SCREEN_WIDTH, SCREEN_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glGenFramebuffers(1, &trailFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, trailFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, trailTexture, 0);
+    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    glEnable(GL_BLEND);
+    glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
+
+    float aspect = (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT;
+    Shader lineShader("shaders/lineTrailVert.glsl", "shaders/lineTrailFrag.glsl");
+    lineShader.use();
+    lineShader.setFloat("u_aspect_ratio", aspect);
+    lineShader.setFloat("u_trail_length", TRAIL_LENGTH);
+
+    unsigned int query;
+    glGenQueries(1, &query);
+
+    ThreadPool pool;
+    printf("compute: integrate + write lines into the VBO, draw: GL_LINES from that VBO (56 B/particle)\n");
+    printf("vertex shader: instanced lines from TrailParticles (16 B/line), positions from u_time\n");
+    printf("gpu ms from GL_TIME_ELAPSED, wall ms up to glFinish\n\n");
+    printf("%10s %8s %12s %12s %12s %12s %14s %14s\n",
+        "particles", "batches", "compute gpu", "compute wall", "draw gpu", "draw wall", "instanced gpu", "instanced wall");
+
+    for (long long count = 10000; count <= maxParticles; count *= 10) {
+        int particleCount = (int)count;
+
+        TrailSimulation simulation;
+        if (!simulation.create(particleCount)) {
+            return -1;
+        }
+        simulation.aspect = aspect;
+        simulation.trailTime = TRAIL_LENGTH;
+        PassTiming compute = timePass(query, [&] { simulation.simulate(TIMESTEP); });
+        PassTiming draw = timePass(query, [&] { simulation.draw(); });
+        int batches = simulation.batches();
+        simulation.release();
+
+        // the same lines the old way, generated then uploaded once, nothing to simulate per frame
+        TrailParticles trails;
+        trails.generate(particleCount, 1, &pool);
+        unsigned int VAO, VBO;
+        glGenVertexArrays(1, &VAO);
+        glBindVertexArray(VAO);
+        glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        trails.upload();
+        trails.setAttributes();
+        float time = 0.0f;
+        PassTiming instanced = timePass(query, [&] {
+            lineShader.use();
+            lineShader.setFloat("u_time", time += TIMESTEP);
+            glBindVertexArray(VAO);
+            glDrawArraysInstanced(GL_LINES, 0, 2, trails.count());
+        });
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+
+        printf("%10d %8d %12.3f %12.3f %12.3f %12.3f %14.3f %14.3f\n", particleCount, batches,
+            compute.gpuMs, compute.wallMs, draw.gpuMs, draw.wallMs, instanced.gpuMs, instanced.wallMs);
+    }
+
+    lineShader.free();
+    glDeleteQueries(1, &query);
+    glDeleteFramebuffers(1, &trailFBO);
+    glDeleteTextures(1, &trailTexture);
+    context.release();
+    return 0;
+}
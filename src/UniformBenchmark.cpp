@@ -0,0 +1,216 @@
+// Microbenchmark for uniform uploads. Replays the per frame uniform traffic of LightCasters.cpp
+// four ways and counts the GL calls each one makes by hooking glad's function pointers.
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include "Shader.h"
+#include "GLExtensions.h"
+#include "RingBuffer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+const int FRAMES = 10000;
+const int CUBES = 10;
+
+// GL call counters
+long long locationCalls = 0;
+long long uniformCalls = 0;
+long long rangeCalls = 0;
+
+PFNGLGETUNIFORMLOCATIONPROC realGetUniformLocation;
+PFNGLUNIFORMMATRIX4FVPROC realUniformMatrix4fv;
+PFNGLUNIFORM3FVPROC realUniform3fv;
+PFNGLBINDBUFFERRANGEPROC realBindBufferRange;
+
+GLint APIENTRY countGetUniformLocation(GLuint program, const GLchar* name) {
+    locationCalls++;
+    return realGetUniformLocation(program, name);
+}
+
+void APIENTRY countUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+    uniformCalls++;
+    realUniformMatrix4fv(location, count, transpose, value);
+}
+
+void APIENTRY countUniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+    uniformCalls++;
+    realUniform3fv(location, count, value);
+}
+
+void APIENTRY countBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+    rangeCalls++;
+    realBindBufferRange(target, index, buffer, offset, size);
+}
+
+enum UploadMode {
+    DRIVER_LOOKUP,  // what Shader::set* did before reflection, one glGetUniformLocation per set
+    TABLE_LOOKUP,   // Shader::set* by name, hashed table
+    HANDLES,        // precomputed UniformHandle
+    RING_BUFFER     // the matrices memcpy'd into a persistently mapped RingBuffer, bound as uniform block ranges
+};
+
+// uniform block binding points of lightingMapBlockVert.glsl and lightBlockVert.glsl, as in LightCasters.cpp
+const int FRAME_BLOCK = 0;
+const int OBJECT_BLOCK = 1;
+
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+};
+
+void runFrames(UploadMode mode, Shader& shader, Shader& lightShader, RingBuffer& ring, const char* label) {
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    glm::vec3 cameraPos(0.0f, 0.0f, 3.0f), cameraFront(0.0f, 0.0f, -1.0f);
+    glm::mat4 lightModel = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(1.2f, 1.0f, 2.0f)), glm::vec3(0.2f));
+
+    UniformHandle viewUniform = shader.getUniform("view");
+    UniformHandle projectionUniform = shader.getUniform("projection");
+    UniformHandle viewPosUniform = shader.getUniform("viewPos");
+    UniformHandle lightPositionUniform = shader.getUniform("light.position");
+    UniformHandle lightDirectionUniform = shader.getUniform("light.direction");
+    UniformHandle lightModelUniform = lightShader.getUniform("model");
+    UniformHandle lightViewUniform = lightShader.getUniform("view");
+    UniformHandle lightProjectionUniform = lightShader.getUniform("projection");
+
+    locationCalls = 0;
+    uniformCalls = 0;
+    rangeCalls = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < FRAMES; frame++) {
+        if (mode == RING_BUFFER) {
+            ring.beginFrame();
+            RingAllocation frameBlock = ring.push(FrameBlock{ view, projection }, ring.uniformAlignment());
+            glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK, ring.buffer(), frameBlock.offset, frameBlock.size);
+        }
+        shader.use();
+        if (mode == DRIVER_LOOKUP) {
+            glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glUniform3fv(glGetUniformLocation(shader.ID, "viewPos"), 1, glm::value_ptr(cameraPos));
+            glUniform3fv(glGetUniformLocation(shader.ID, "light.position"), 1, glm::value_ptr(cameraPos));
+            glUniform3fv(glGetUniformLocation(shader.ID, "light.direction"), 1, glm::value_ptr(cameraFront));
+        }
+        else if (mode == TABLE_LOOKUP) {
+            shader.setMat4("view", view);
+            shader.setMat4("projection", projection);
+            shader.setVec3("viewPos", cameraPos);
+            shader.setVec3("light.position", cameraPos);
+            shader.setVec3("light.direction", cameraFront);
+        }
+        else if (mode == HANDLES) {
+            shader.setMat4(viewUniform, view);
+            shader.setMat4(projectionUniform, projection);
+            shader.setVec3(viewPosUniform, cameraPos);
+            shader.setVec3(lightPositionUniform, cameraPos);
+            shader.setVec3(lightDirectionUniform, cameraFront);
+        }
+        else {
+            // the fragment shader's vectors stay plain uniforms
+            shader.setVec3(viewPosUniform, cameraPos);
+            shader.setVec3(lightPositionUniform, cameraPos);
+            shader.setVec3(lightDirectionUniform, cameraFront);
+        }
+
+        // the cubes' model matrices are instance attributes uploaded once, LightCasters draws all of them
+        // with one instanced draw and sets no per cube uniforms, in any mode
+
+        lightShader.use();
+        if (mode == DRIVER_LOOKUP) {
+            glUniformMatrix4fv(glGetUniformLocation(lightShader.ID, "model"), 1, GL_FALSE, glm::value_ptr(lightModel));
+            glUniformMatrix4fv(glGetUniformLocation(lightShader.ID, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(lightShader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        }
+        else if (mode == TABLE_LOOKUP) {
+            lightShader.setMat4("model", lightModel);
+            lightShader.setMat4("view", view);
+            lightShader.setMat4("projection", projection);
+        }
+        else if (mode == HANDLES) {
+            lightShader.setMat4(lightModelUniform, lightModel);
+            lightShader.setMat4(lightViewUniform, view);
+            lightShader.setMat4(lightProjectionUniform, projection);
+        }
+        else {
+            RingAllocation objectBlock = ring.push(lightModel, ring.uniformAlignment());
+            glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK, ring.buffer(), objectBlock.offset, objectBlock.size);
+            ring.endFrame();
+        }
+    }
+    glFinish();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double microseconds = std::chrono::duration<double, std::micro>(end - start).count();
+    printf("%-16s glGetUniformLocation/frame %5.1f  glUniform*/frame %5.1f  glBindBufferRange/frame %5.1f  cpu %7.3f us/frame\n",
+        label, (double)locationCalls / FRAMES, (double)uniformCalls / FRAMES, (double)rangeCalls / FRAMES, microseconds / FRAMES);
+}
+
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 600, "Uniform Benchmark", NULL, NULL);
+
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+    loadGLExtensions((GLADloadproc)glfwGetProcAddress);
+
+    // hook the loaded entry points so every call through glad is counted
+    realGetUniformLocation = glad_glGetUniformLocation;
+    realUniformMatrix4fv = glad_glUniformMatrix4fv;
+    realUniform3fv = glad_glUniform3fv;
+    realBindBufferRange = glad_glBindBufferRange;
+    glad_glGetUniformLocation = countGetUniformLocation;
+    glad_glUniformMatrix4fv = countUniformMatrix4fv;
+    glad_glUniform3fv = countUniform3fv;
+    glad_glBindBufferRange = countBindBufferRange;
+
+    Shader shader("shaders/lightingMapVert.glsl", "shaders/spotlightFrag.glsl");
+    Shader lightShader("shaders/lightVert.glsl", "shaders/lightSourceFrag.glsl");
+    printf("reflection: %d + %d uniforms, %lld glGetUniformLocation calls once at startup\n\n",
+        shader.uniformCount(), lightShader.uniformCount(), locationCalls);
+
+    // the block shaders take view, projection and model from ring buffer ranges
+    Shader blockShader("shaders/lightingMapBlockVert.glsl", "shaders/spotlightFrag.glsl");
+    Shader lightBlockShader("shaders/lightBlockVert.glsl", "shaders/lightSourceFrag.glsl");
+    glUniformBlockBinding(blockShader.ID, glGetUniformBlockIndex(blockShader.ID, "Frame"), FRAME_BLOCK);
+    glUniformBlockBinding(lightBlockShader.ID, glGetUniformBlockIndex(lightBlockShader.ID, "Frame"), FRAME_BLOCK);
+    glUniformBlockBinding(lightBlockShader.ID, glGetUniformBlockIndex(lightBlockShader.ID, "Object"), OBJECT_BLOCK);
+    RingBuffer ring;
+    ring.create(16 * 1024);
+
+    printf("%d frames, %d instanced cubes and a light per frame\n", FRAMES, CUBES);
+    runFrames(DRIVER_LOOKUP, shader, lightShader, ring, "driver lookup");
+    runFrames(TABLE_LOOKUP, shader, lightShader, ring, "reflected table");
+    runFrames(HANDLES, shader, lightShader, ring, "handles");
+    runFrames(RING_BUFFER, blockShader, lightBlockShader, ring, "ring buffer");
+    ring.report();
+
+    ring.release();
+    shader.free();
+    lightShader.free();
+    blockShader.free();
+    lightBlockShader.free();
+    glfwTerminate();
+    return 0;
+}
@@ -0,0 +1,191 @@
+// Vertex fetch cost of the packed 16 byte vertex from VertexPacking.h against the 32 byte float layout.
+// Draws indexed spheres of growing size with GL_RASTERIZER_DISCARD so only index/vertex fetch and the
+// vertex shader run, timed up to glFinish, then reports how far the packed attributes are from the floats.
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include "Shader.h"
+#include "VertexPacking.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+const int DRAWS = 10;
+
+// pos, normal, uv per vertex like the demos, indexed directly instead of welded by MeshBuilder so the big ones stay cheap
+struct GridMesh {
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+};
+
+GridMesh sphereGrid(int slices, int stacks)
+{
+    GridMesh mesh;
+    for (int row = 0; row <= stacks; row++) {
+        for (int column = 0; column <= slices; column++) {
+            glm::vec2 uv((float)column / slices, (float)row / stacks);
+            float phi = uv.x * glm::two_pi<float>(), theta = uv.y * glm::pi<float>();
+            glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            mesh.vertices.insert(mesh.vertices.end(), { normal.x, normal.y, normal.z, normal.x, normal.y, normal.z, uv.x, uv.y });
+        }
+    }
+    for (int row = 0; row < stacks; row++) {
+        for (int column = 0; column < slices; column++) {
+            uint32_t corner = row * (slices + 1) + column;
+            mesh.indices.insert(mesh.indices.end(), { corner, corner + 1, corner + slices + 2, corner + slices + 2, corner + slices + 1, corner });
+        }
+    }
+    return mesh;
+}
+
+struct GpuMesh {
+    unsigned int VAO, VBO, EBO;
+    int indexCount;
+    size_t vertexBytes;
+};
+
+GpuMesh uploadMesh(const GridMesh& mesh, const PackedMesh* packed)
+{
+    GpuMesh gpu;
+    glGenVertexArrays(1, &gpu.VAO);
+    glGenBuffers(1, &gpu.VBO);
+    glGenBuffers(1, &gpu.EBO);
+    glBindVertexArray(gpu.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, gpu.VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint32_t), mesh.indices.data(), GL_STATIC_DRAW);
+
+    if (packed) {
+        packed->upload();
+        PackedMesh::setAttributes();
+        gpu.vertexBytes = packed->getVertices().size() * sizeof(PackedVertex);
+    }
+    else {
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        gpu.vertexBytes = mesh.vertices.size() * sizeof(float);
+    }
+    gpu.indexCount = (int)mesh.indices.size();
+    return gpu;
+}
+
+void deleteMesh(GpuMesh& gpu)
+{
+    glDeleteVertexArrays(1, &gpu.VAO);
+    glDeleteBuffers(1, &gpu.VBO);
+    glDeleteBuffers(1, &gpu.EBO);
+}
+
+// Milliseconds per draw until glFinish returns, after one warm up draw
+double timeDraws(Shader& shader, const GpuMesh& gpu, const glm::mat4& model)
+{
+    shader.use();
+    // the model and normal matrices are constant attributes, like LightingMap.cpp sets them
+    glm::mat3 normalMatrix(1.0f);
+    for (int i = 0; i < 4; i++) {
+        glVertexAttrib4fv(3 + i, glm::value_ptr(model[i]));
+    }
+    for (int i = 0; i < 3; i++) {
+        glVertexAttrib3fv(7 + i, glm::value_ptr(normalMatrix[i]));
+    }
+    glBindVertexArray(gpu.VAO);
+    glDrawElements(GL_TRIANGLES, gpu.indexCount, GL_UNSIGNED_INT, 0);
+    glFinish();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int draw = 0; draw < DRAWS; draw++) {
+        glDrawElements(GL_TRIANGLES, gpu.indexCount, GL_UNSIGNED_INT, 0);
+    }
+    glFinish();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / DRAWS;
+}
+
+int main()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow* window = glfwCreateWindow(800, 600, "Vertex Format Benchmark", NULL, NULL);
+    if (window == NULL) {
+        std::cout << "Failed to create GLFW Window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    Shader floatShader("shaders/LightingMapFloatVert.glsl", "shaders/spotlightFrag.glsl");
+    Shader packedShader("shaders/lightingMapVert.glsl", "shaders/spotlightFrag.glsl");
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    for (Shader* shader : { &floatShader, &packedShader }) {
+        shader->use();
+        shader->setMat4("view", view);
+        shader->setMat4("projection", projection);
+    }
+
+    // nothing reaches the fragment shader, the draws measure fetch and vertex shading only
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    printf("%d draws per mesh, GL_RASTERIZER_DISCARD, 32 bit indices\n", DRAWS);
+    printf("%-10s %9s   %10s %9s %9s   %10s %9s %9s   %7s %8s\n", "sphere", "vertices",
+        "float MB", "ms/draw", "GB/s", "packed MB", "ms/draw", "GB/s", "bytes", "speedup");
+
+    int sizes[][2] = { { 64, 32 }, { 256, 128 }, { 1024, 512 }, { 2048, 1024 } };
+    std::vector<PackingError> errors;
+    std::vector<double> packMs;
+    for (auto& size : sizes) {
+        GridMesh mesh = sphereGrid(size[0], size[1]);
+        int vertexCount = (int)mesh.vertices.size() / 8;
+
+        auto packStart = std::chrono::high_resolution_clock::now();
+        PackedMesh packed(mesh.vertices.data(), vertexCount);
+        auto packEnd = std::chrono::high_resolution_clock::now();
+        packMs.push_back(std::chrono::duration<double, std::milli>(packEnd - packStart).count());
+        errors.push_back(packed.measureError(mesh.vertices.data()));
+
+        GpuMesh floatMesh = uploadMesh(mesh, NULL);
+        GpuMesh packedMesh = uploadMesh(mesh, &packed);
+        double floatMs = timeDraws(floatShader, floatMesh, glm::mat4(1.0f));
+        double packedMs = timeDraws(packedShader, packedMesh, packed.positionTransform());
+
+        // vertex bytes the draw has to read at least once
+        printf("%4dx%-5d %9d   %10.2f %9.3f %9.2f   %10.2f %9.3f %9.2f   %6.0f%% %7.2fx\n", size[0], size[1], vertexCount,
+            floatMesh.vertexBytes / 1e6, floatMs, floatMesh.vertexBytes / floatMs / 1e6,
+            packedMesh.vertexBytes / 1e6, packedMs, packedMesh.vertexBytes / packedMs / 1e6,
+            100.0 * packedMesh.vertexBytes / floatMesh.vertexBytes, floatMs / packedMs);
+
+        deleteMesh(floatMesh);
+        deleteMesh(packedMesh);
+    }
+
+    printf("\nquantization error, unit sphere\n");
+    printf("%-10s %12s %12s %12s %12s %12s %10s\n", "sphere", "max pos", "rms pos", "max deg", "mean deg", "max uv", "pack ms");
+    for (size_t i = 0; i < errors.size(); i++) {
+        printf("%4dx%-5d %12.2e %12.2e %12.4f %12.4f %12.2e %10.2f\n", sizes[i][0], sizes[i][1], errors[i].maxPosition, errors[i].rmsPosition,
+            errors[i].maxNormalDegrees, errors[i].meanNormalDegrees, errors[i].maxTexCoord, packMs[i]);
+    }
+
+    glfwTerminate();
+    return 0;
+}